@@ -0,0 +1,219 @@
+#include "audio_gain.h"
+
+static int32_t percent_to_q31(uint32_t percent)
+{
+    return (int32_t)((int64_t)AUDIO_GAIN_UNITY * percent / AUDIO_GAIN_MAX_VOLUME);
+}
+
+static void update_targets(Audio_Gain *gain)
+{
+    int32_t volume = gain->is_muted ? 0 : (int32_t)((int64_t)AUDIO_GAIN_UNITY * gain->volume * gain->volume / (AUDIO_GAIN_MAX_VOLUME * AUDIO_GAIN_MAX_VOLUME));
+
+    // Balance only ever takes away from the other side, centered is full volume on both
+    int32_t left = gain->balance > 0 ? percent_to_q31(AUDIO_GAIN_MAX_BALANCE - gain->balance) : AUDIO_GAIN_UNITY;
+    int32_t right = gain->balance < 0 ? percent_to_q31(AUDIO_GAIN_MAX_BALANCE + gain->balance) : AUDIO_GAIN_UNITY;
+
+    gain->target[0] = (int32_t)(((int64_t)volume * left) >> 31);
+    gain->target[1] = (int32_t)(((int64_t)volume * right) >> 31);
+
+    // Multiplying unity by unity loses a bit, full volume has to stay exactly unity to take the fast path
+    if (volume == AUDIO_GAIN_UNITY)
+    {
+        gain->target[0] = left;
+        gain->target[1] = right;
+    }
+}
+
+void audio_gain_init(Audio_Gain *gain)
+{
+    gain->volume = AUDIO_GAIN_MAX_VOLUME;
+    gain->balance = 0;
+    gain->is_muted = false;
+
+    update_targets(gain);
+
+    // No rate yet, until configured changes take effect at once
+    audio_gain_configure(gain, 0, 2);
+}
+
+void audio_gain_configure(Audio_Gain *gain, uint32_t sample_rate, uint32_t channels)
+{
+    gain->channels = channels;
+    gain->ramp_samples = sample_rate * AUDIO_GAIN_RAMP_MS / 1000;
+    gain->ramp_remaining = 0;
+
+    if (gain->ramp_samples == 0)
+    {
+        gain->ramp_samples = 1;
+    }
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        gain->ramp_target[i] = gain->target[i];
+        gain->current[i] = gain->target[i];
+        gain->step[i] = 0;
+    }
+}
+
+void audio_gain_set_volume(Audio_Gain *gain, uint8_t volume)
+{
+    gain->volume = volume > AUDIO_GAIN_MAX_VOLUME ? AUDIO_GAIN_MAX_VOLUME : volume;
+    update_targets(gain);
+}
+
+void audio_gain_set_balance(Audio_Gain *gain, int8_t balance)
+{
+    if (balance > AUDIO_GAIN_MAX_BALANCE)
+    {
+        balance = AUDIO_GAIN_MAX_BALANCE;
+    }
+    else if (balance < -AUDIO_GAIN_MAX_BALANCE)
+    {
+        balance = -AUDIO_GAIN_MAX_BALANCE;
+    }
+
+    gain->balance = balance;
+    update_targets(gain);
+}
+
+void audio_gain_set_mute(Audio_Gain *gain, bool is_muted)
+{
+    gain->is_muted = is_muted;
+    update_targets(gain);
+}
+
+// Start a new ramp when a setter moved the targets, from wherever the gain is right now
+static void pick_up_targets(Audio_Gain *gain)
+{
+    int32_t left = gain->target[0];
+    int32_t right = gain->target[1];
+
+    if (left == gain->ramp_target[0] && right == gain->ramp_target[1])
+    {
+        return;
+    }
+
+    gain->ramp_target[0] = left;
+    gain->ramp_target[1] = right;
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        gain->step[i] = (int32_t)(((int64_t)gain->ramp_target[i] - gain->current[i]) / gain->ramp_samples);
+    }
+
+    gain->ramp_remaining = gain->ramp_samples;
+}
+
+bool audio_gain_is_unity(Audio_Gain *gain)
+{
+    pick_up_targets(gain);
+
+    return gain->ramp_remaining == 0 && gain->current[0] == AUDIO_GAIN_UNITY && gain->current[1] == AUDIO_GAIN_UNITY;
+}
+
+bool audio_gain_is_silent(Audio_Gain *gain)
+{
+    pick_up_targets(gain);
+
+    return gain->ramp_remaining == 0 && gain->current[0] == 0 && gain->current[1] == 0;
+}
+
+// Step every channel along the ramp by one frame, landing exactly on the target at the end
+static inline void ramp_frame(Audio_Gain *gain)
+{
+    if (--gain->ramp_remaining == 0)
+    {
+        gain->current[0] = gain->ramp_target[0];
+        gain->current[1] = gain->ramp_target[1];
+    }
+    else
+    {
+        gain->current[0] += gain->step[0];
+        gain->current[1] += gain->step[1];
+    }
+}
+
+void audio_gain_apply_s16(Audio_Gain *gain, int16_t *samples, uint32_t frames)
+{
+    if (audio_gain_is_unity(gain))
+    {
+        return;
+    }
+
+    // Mono follows the left gain
+    uint32_t right = gain->channels == 2 ? 1 : 0;
+
+    for (; frames > 0 && gain->ramp_remaining > 0; frames--)
+    {
+        ramp_frame(gain);
+
+        for (uint32_t channel = 0; channel < gain->channels; channel++)
+        {
+            int32_t q15 = gain->current[channel == 1 ? right : 0] >> 16;
+
+            *samples = (int16_t)((*samples * q15) >> 15);
+            samples++;
+        }
+    }
+
+    // Settled, the hot loop is a multiply & a shift per sample
+    int32_t left_q15 = gain->current[0] >> 16;
+    int32_t right_q15 = gain->current[right] >> 16;
+
+    if (gain->channels == 2)
+    {
+        for (; frames > 0; frames--, samples += 2)
+        {
+            samples[0] = (int16_t)((samples[0] * left_q15) >> 15);
+            samples[1] = (int16_t)((samples[1] * right_q15) >> 15);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < frames * gain->channels; i++)
+        {
+            samples[i] = (int16_t)((samples[i] * left_q15) >> 15);
+        }
+    }
+}
+
+void audio_gain_apply_s32(Audio_Gain *gain, int32_t *samples, uint32_t frames)
+{
+    if (audio_gain_is_unity(gain))
+    {
+        return;
+    }
+
+    uint32_t right = gain->channels == 2 ? 1 : 0;
+
+    for (; frames > 0 && gain->ramp_remaining > 0; frames--)
+    {
+        ramp_frame(gain);
+
+        for (uint32_t channel = 0; channel < gain->channels; channel++)
+        {
+            *samples = (int32_t)(((int64_t)*samples * gain->current[channel == 1 ? right : 0]) >> 31);
+            samples++;
+        }
+    }
+
+    // A single MULSH & MULL pair per sample on the ESP32
+    int32_t left_gain = gain->current[0];
+    int32_t right_gain = gain->current[right];
+
+    if (gain->channels == 2)
+    {
+        for (; frames > 0; frames--, samples += 2)
+        {
+            samples[0] = (int32_t)(((int64_t)samples[0] * left_gain) >> 31);
+            samples[1] = (int32_t)(((int64_t)samples[1] * right_gain) >> 31);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < frames * gain->channels; i++)
+        {
+            samples[i] = (int32_t)(((int64_t)samples[i] * left_gain) >> 31);
+        }
+    }
+}
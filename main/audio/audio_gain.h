@@ -0,0 +1,68 @@
+#ifndef AUDIO_GAIN_H
+#define AUDIO_GAIN_H
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Volume, balance & mute in fixed point, applied in place to 16 or 32 bit PCM on its way to the sink.
+ * Gains are Q31, 16 bit samples are scaled by the top half (Q15) so the product fits a 32 bit multiply.
+ * A change never jumps: the gain slides to its new value over AUDIO_GAIN_RAMP_MS, sample by sample, so
+ * turning the volume, muting for a pause & unmuting don't click.
+ *
+ * The setters may be called from any task, the consumer picks up new targets at its next `audio_gain_apply_*`.
+ */
+
+#define AUDIO_GAIN_RAMP_MS 5
+
+#define AUDIO_GAIN_UNITY INT32_MAX // ~1.0 in Q31
+
+#define AUDIO_GAIN_MAX_VOLUME 100
+#define AUDIO_GAIN_MAX_BALANCE 100
+
+typedef struct
+{
+    // Settings, written by whoever controls playback
+    uint8_t volume;  // 0 - AUDIO_GAIN_MAX_VOLUME
+    int8_t balance;  // -AUDIO_GAIN_MAX_BALANCE (left only) - AUDIO_GAIN_MAX_BALANCE (right only)
+    bool is_muted;
+    volatile int32_t target[2]; // Left & right, what the settings work out to
+
+    // Consumer side
+    uint32_t channels;
+    uint32_t ramp_samples; // Frames a ramp takes
+    uint32_t ramp_remaining;
+    int32_t ramp_target[2];
+    int32_t current[2];
+    int32_t step[2];
+} Audio_Gain;
+
+/**
+ * Full volume, centered, not muted.
+ */
+void audio_gain_init(Audio_Gain *gain);
+
+/**
+ * Start of a track: the ramp length follows the sample rate. The gain jumps straight to its target,
+ * there is nothing playing yet to click.
+ */
+void audio_gain_configure(Audio_Gain *gain, uint32_t sample_rate, uint32_t channels);
+
+// Perceived loudness goes roughly with the square of the percentage
+void audio_gain_set_volume(Audio_Gain *gain, uint8_t volume);
+
+void audio_gain_set_balance(Audio_Gain *gain, int8_t balance);
+
+void audio_gain_set_mute(Audio_Gain *gain, bool is_muted);
+
+// Settled at unity, i.e. applying it would change nothing
+bool audio_gain_is_unity(Audio_Gain *gain);
+
+// Settled at zero, e.g. a mute finished ramping down
+bool audio_gain_is_silent(Audio_Gain *gain);
+
+void audio_gain_apply_s16(Audio_Gain *gain, int16_t *samples, uint32_t frames);
+
+void audio_gain_apply_s32(Audio_Gain *gain, int32_t *samples, uint32_t frames);
+
+#endif
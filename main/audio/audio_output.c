@@ -0,0 +1,1126 @@
+#include "audio_output.h"
+#include "pcm_ring.h"
+#include "pcm_convert.h"
+
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+// A seek is handed back & forth: the consumer takes what it needs of the old position & keeps off the ring,
+// the producer repositions & refills it, the consumer goes on from there
+typedef enum
+{
+    SEEK_NONE = 0,
+    SEEK_REQUESTED, // Consumer's turn
+    SEEK_FLUSHING,  // Producer's turn
+    SEEK_REFILLING,
+    SEEK_REFILLED, // Consumer's turn
+} Seek_State;
+
+// How a track's PCM gets from the ring to the sink
+typedef struct
+{
+    Audio_Format sink_format;
+    pcm_convert_func convert; // NULL when the ring's samples go on as they are
+    uint32_t input_frame_size;
+    uint32_t channels;
+    uint32_t sample_rate; // The file's
+    bool is_resampling;
+} Output_Path;
+
+static const char *TAG = "AUDIO_OUTPUT";
+static const Audio_Sink *output_sink = NULL;
+
+// Sector reads land here straight from the card
+DMA_ATTR static uint8_t ring_storage[AUDIO_OUTPUT_RING_SIZE] __attribute__((aligned(PCM_RING_ALIGNMENT)));
+static PCM_Ring ring;
+
+// Converted, resampled or scaled samples on their way to the sink, unused when the ring's PCM goes out as it is
+static uint8_t staging[AUDIO_OUTPUT_STAGING_SIZE] __attribute__((aligned(4)));
+static uint32_t staging_length = 0;
+static uint32_t staging_offset = 0;
+
+static Output_Path path; // Consumer's, of the track it's reading out of the ring
+
+// Old position's sound after a seek, faded out under the new one. In the sink's format, gain applied
+static uint8_t crossfade[AUDIO_OUTPUT_CROSSFADE_FRAMES * 2 * sizeof(int32_t)] __attribute__((aligned(4)));
+static uint32_t crossfade_frames = 0;
+static uint32_t crossfade_position = 0;
+
+static Resampler resampler;
+static bool is_resampler_flushed = false;
+
+static Audio_Gain gain;
+static volatile bool is_paused = false;
+static bool was_held = false; // Consumer only, the sink was left to run dry on purpose last time round
+
+static TaskHandle_t producer_handle = NULL;
+static TaskHandle_t consumer_handle = NULL;
+
+static SemaphoreHandle_t producer_start = NULL;
+static SemaphoreHandle_t primed = NULL;        // Producer buffered enough to start or ran out of data
+static SemaphoreHandle_t producer_idle = NULL; // Producer is done with the files
+static SemaphoreHandle_t idle = NULL;          // Held while playing
+static SemaphoreHandle_t seek_done = NULL;
+
+// The producer reads one slot while the next track waits in the other
+static FAT_File files[2];
+static WAV_Info infos[2];
+static uint32_t slot = 0;
+static uint32_t track_remaining = 0;
+static bool is_primed = false;
+static uint32_t prime_size = 0; // Buffered before the consumer is let go, after a start or a seek
+
+static audio_output_next_track_func next_track_func = NULL;
+static bool is_next_requested = false;
+static bool is_next_ready = false; // Opened in the other slot, not read yet
+
+// Where the producer moved on to the next track: ring position & how to play it
+static Output_Path next_path;
+static uint32_t boundary = 0;
+static atomic_bool has_boundary = false;
+
+static volatile bool is_playing = false;
+static volatile bool stop_requested = false;
+static volatile bool producer_done = false;
+
+static atomic_uint buffers_sent = 0; // Counted by the sink callback, taken by the consumer
+static int32_t sink_queued = 0;      // Handed to the sink & not played yet, consumer only
+static uint32_t sink_buffer_size = 0;
+
+static int64_t start_requested_at = 0; // Until its first sample reached the sink
+
+static atomic_uint seek_state = SEEK_NONE;
+static uint32_t seek_ms = 0;
+static uint32_t seek_frame = 0;
+static int64_t seek_requested_at = 0;
+
+static Audio_Output_Stats stats;
+
+static bool on_buffer_sent(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    atomic_fetch_add(&buffers_sent, 1);
+    vTaskNotifyGiveFromISR(consumer_handle, &woken);
+
+    return woken == pdTRUE;
+}
+
+static esp_err_t plan_path(const WAV_Info *info, Output_Path *plan)
+{
+    memset(plan, 0, sizeof(Output_Path));
+
+    plan->input_frame_size = info->block_align;
+    plan->channels = info->channels;
+    plan->sample_rate = info->sample_rate;
+    plan->is_resampling = info->sample_rate != AUDIO_OUTPUT_SAMPLE_RATE;
+
+    plan->sink_format.sample_rate = AUDIO_OUTPUT_SAMPLE_RATE;
+    plan->sink_format.channels = info->channels;
+    plan->sink_format.bits_per_sample = info->bits_per_sample;
+
+    if (plan->input_frame_size > AUDIO_OUTPUT_MAX_FRAME)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (plan->is_resampling)
+    {
+        if (info->channels > RESAMPLER_MAX_CHANNELS || info->sample_rate > AUDIO_OUTPUT_SAMPLE_RATE * RESAMPLER_MAX_RATIO)
+        {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        // The resampler only takes 32 bit
+        plan->sink_format.bits_per_sample = 32;
+
+        if (info->bits_per_sample == 8)
+        {
+            plan->convert = pcm_u8_to_s32;
+        }
+        else if (info->bits_per_sample == 16)
+        {
+            plan->convert = pcm_s16_to_s32;
+        }
+        else if (info->bits_per_sample == 24)
+        {
+            plan->convert = pcm_s24_to_s32;
+        }
+    }
+    else if (info->bits_per_sample == 8)
+    {
+        plan->convert = pcm_u8_to_s16;
+        plan->sink_format.bits_per_sample = 16;
+    }
+    else if (info->bits_per_sample == 24)
+    {
+        plan->convert = pcm_s24_to_s32;
+        plan->sink_format.bits_per_sample = 32;
+    }
+
+    return ESP_OK;
+}
+
+// Ask for the next track into the other slot
+static void open_next(void)
+{
+    uint32_t next = slot ^ 1;
+
+    is_next_requested = true;
+    is_next_ready = next_track_func != NULL && next_track_func(&files[next], &infos[next]) &&
+                    plan_path(&infos[next], &next_path) == ESP_OK;
+}
+
+// Enough is buffered: the start waits for this, so does the consumer after a seek
+static void mark_primed(void)
+{
+    if (is_primed)
+    {
+        return;
+    }
+
+    is_primed = true;
+
+    if (atomic_load(&seek_state) == SEEK_REFILLING)
+    {
+        atomic_store(&seek_state, SEEK_REFILLED);
+        xTaskNotifyGive(consumer_handle);
+    }
+    else
+    {
+        xSemaphoreGive(primed);
+    }
+}
+
+// Move to `seek_frame` of the consumer's track & start the ring over, the consumer keeps off it meanwhile
+static void seek_file(void)
+{
+    // Reading the next track already, the consumer's is in the other slot. Back to it, the next one waits its turn again
+    if (atomic_load(&has_boundary))
+    {
+        slot ^= 1;
+        fat_file_seek(&files[slot ^ 1], infos[slot ^ 1].data_offset);
+        is_next_requested = true;
+        is_next_ready = true;
+        atomic_store(&has_boundary, false);
+    }
+
+    WAV_Info *info = &infos[slot];
+    uint32_t frames = info->data_size / info->block_align;
+    uint32_t position = info->data_offset + (seek_frame < frames ? seek_frame : frames) * info->block_align;
+
+    if (fat_file_seek(&files[slot], position) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Seek to %d failed", (unsigned int)position);
+        position = files[slot].position;
+    }
+
+    track_remaining = info->data_offset + info->data_size - position;
+    producer_done = false;
+
+    // The old position's bytes are dropped, offsets follow the file's sector offsets again
+    pcm_ring_reset(&ring, position % BLOCKDEV_SECTOR_SIZE);
+}
+
+// Carry on reading the next track right behind the current one in the ring
+static void enter_next_file(void)
+{
+    slot ^= 1;
+    track_remaining = infos[slot].data_offset + infos[slot].data_size - files[slot].position;
+    is_next_requested = false;
+    is_next_ready = false;
+
+    boundary = pcm_ring_write_count(&ring);
+    atomic_store(&has_boundary, true);
+}
+
+static void producer_task(void *arg)
+{
+    while (1)
+    {
+        xSemaphoreTake(producer_start, portMAX_DELAY);
+
+        uint32_t buffered = 0;
+
+        is_primed = false;
+        prime_size = AUDIO_OUTPUT_PRIME_SIZE;
+
+        while (!stop_requested)
+        {
+            if (atomic_load(&seek_state) == SEEK_FLUSHING)
+            {
+                seek_file();
+
+                buffered = 0;
+                is_primed = false;
+                prime_size = AUDIO_OUTPUT_REFILL_SIZE;
+                atomic_store(&seek_state, SEEK_REFILLING);
+            }
+
+            // The consumer hasn't reached the last track change, next_path is still its own
+            bool is_switching = atomic_load(&has_boundary);
+
+            if (!is_next_requested && !is_switching && track_remaining <= AUDIO_OUTPUT_PREOPEN_SIZE)
+            {
+                open_next();
+            }
+
+            if (track_remaining == 0)
+            {
+                // A track shorter than the ring, wait until the consumer is into it
+                if (is_switching)
+                {
+                    mark_primed();
+                    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                    continue;
+                }
+
+                // All read, stay around for a seek back into the track until stopped
+                if (!is_next_ready)
+                {
+                    if (!producer_done)
+                    {
+                        producer_done = true;
+                        mark_primed();
+                        xTaskNotifyGive(consumer_handle);
+                    }
+
+                    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                    continue;
+                }
+
+                enter_next_file();
+                continue;
+            }
+
+            FAT_File *file = &files[slot];
+            uint8_t *region;
+            uint32_t length = pcm_ring_acquire_write(&ring, &region);
+
+            if (pcm_ring_free(&ring) < AUDIO_OUTPUT_MIN_READ && length < track_remaining)
+            {
+                mark_primed();
+
+                // The consumer notifies after every drain
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+
+            if (length > AUDIO_OUTPUT_READ_SIZE)
+            {
+                length = AUDIO_OUTPUT_READ_SIZE;
+            }
+
+            if (length >= track_remaining)
+            {
+                length = track_remaining;
+            }
+            else if (length > (file->position + length) % BLOCKDEV_SECTOR_SIZE)
+            {
+                // End on a sector boundary so the next read starts on one
+                length -= (file->position + length) % BLOCKDEV_SECTOR_SIZE;
+            }
+
+            uint32_t bytes_read = 0;
+            esp_err_t err = fat_file_read(file, region, length, &bytes_read);
+
+            if (err != ESP_OK || bytes_read == 0)
+            {
+                ESP_LOGE(TAG, "Read failed, %d bytes short", (unsigned int)track_remaining);
+                break;
+            }
+
+            track_remaining -= bytes_read;
+            buffered += bytes_read;
+            pcm_ring_commit_write(&ring, bytes_read);
+
+            if (buffered >= prime_size)
+            {
+                mark_primed();
+            }
+
+            xTaskNotifyGive(consumer_handle);
+        }
+
+        producer_done = true;
+        mark_primed();
+
+        xTaskNotifyGive(consumer_handle);
+        xSemaphoreGive(producer_idle);
+    }
+}
+
+static void update_watermarks(void)
+{
+    uint32_t buffered = pcm_ring_used(&ring) + staging_length - staging_offset + (sink_queued > 0 ? sink_queued : 0);
+
+    stats.buffered = buffered;
+
+    if (buffered < stats.low_watermark)
+    {
+        stats.low_watermark = buffered;
+    }
+
+    if (buffered > stats.high_watermark)
+    {
+        stats.high_watermark = buffered;
+    }
+}
+
+// Bytes of the current track in the ring, the next one's are off limits until the switch
+static uint32_t track_bytes_available(void)
+{
+    uint32_t used = pcm_ring_used(&ring);
+
+    if (atomic_load(&has_boundary))
+    {
+        uint32_t left = boundary - pcm_ring_read_count(&ring);
+
+        return left < used ? left : used;
+    }
+
+    return used;
+}
+
+static uint32_t acquire_track_bytes(const uint8_t **region)
+{
+    uint32_t length = pcm_ring_acquire_read(&ring, region);
+    uint32_t available = track_bytes_available();
+
+    return length < available ? length : available;
+}
+
+static bool is_at_boundary(void)
+{
+    return atomic_load(&has_boundary) && pcm_ring_read_count(&ring) == boundary;
+}
+
+// The next track carries on in the same resampler, no flush in between
+static bool is_resampler_kept(void)
+{
+    return path.is_resampling && next_path.is_resampling && path.sample_rate == next_path.sample_rate && path.channels == next_path.channels;
+}
+
+static void note_sink_write(uint32_t written)
+{
+    sink_queued += written;
+
+    if (written > 0 && start_requested_at != 0)
+    {
+        stats.start_latency_us = (uint32_t)(esp_timer_get_time() - start_requested_at);
+        start_requested_at = 0;
+    }
+}
+
+// Hand the ring's contents over as they are, until the sink is full or the track's bytes ran out. Twice covers the wrap
+static void feed_sink_direct(void)
+{
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        const uint8_t *region;
+        uint32_t length = acquire_track_bytes(&region);
+        uint32_t written = 0;
+
+        if (length == 0)
+        {
+            break;
+        }
+
+        audio_sink_write(output_sink, region, length, &written);
+
+        pcm_ring_commit_read(&ring, written);
+        note_sink_write(written);
+
+        if (written < length)
+        {
+            break;
+        }
+    }
+}
+
+// Convert up to `max_frames` whole frames from the ring into `destination`, returns how many (0 when the ring has none)
+static uint32_t take_frames(uint8_t *destination, uint32_t max_frames)
+{
+    uint8_t frame[AUDIO_OUTPUT_MAX_FRAME] __attribute__((aligned(4)));
+    const uint8_t *region;
+    uint32_t length = acquire_track_bytes(&region);
+    uint32_t frames = length / path.input_frame_size;
+
+    if (frames > max_frames)
+    {
+        frames = max_frames;
+    }
+
+    if (frames == 0)
+    {
+        // Ring size isn't a multiple of e.g. 6 byte frames, so one can straddle the wrap. Put it together first
+        if (length == 0 || max_frames == 0 || track_bytes_available() < path.input_frame_size)
+        {
+            return 0;
+        }
+
+        memcpy(frame, region, length);
+        pcm_ring_commit_read(&ring, length);
+        pcm_ring_acquire_read(&ring, &region);
+        memcpy(&frame[length], region, path.input_frame_size - length);
+        pcm_ring_commit_read(&ring, path.input_frame_size - length);
+
+        region = frame;
+        frames = 1;
+    }
+
+    if (path.convert != NULL)
+    {
+        path.convert(region, destination, frames * path.channels);
+    }
+    else
+    {
+        memcpy(destination, region, frames * path.input_frame_size);
+    }
+
+    if (region != frame)
+    {
+        pcm_ring_commit_read(&ring, frames * path.input_frame_size);
+    }
+
+    return frames;
+}
+
+// Run the resampler until it has output, feeding it from the ring & with silence once the track ran out
+static uint32_t resample_frames(int32_t *destination, uint32_t max_frames)
+{
+    while (1)
+    {
+        uint32_t frames = resampler_read(&resampler, destination, max_frames);
+
+        if (frames > 0)
+        {
+            return frames;
+        }
+
+        int32_t *input;
+        uint32_t room = resampler_acquire_input(&resampler, &input);
+        uint32_t taken = take_frames((uint8_t *)input, room);
+
+        bool is_input_done = (producer_done && pcm_ring_used(&ring) == 0) || (is_at_boundary() && !is_resampler_kept());
+
+        // Its window reaches past the last frame, the tail only comes out followed by silence
+        if (taken == 0 && is_input_done && !is_resampler_flushed)
+        {
+            taken = resampler_latency(&resampler);
+            memset(input, 0, taken * path.channels * sizeof(int32_t));
+            is_resampler_flushed = true;
+        }
+
+        if (taken == 0)
+        {
+            return 0;
+        }
+
+        resampler_commit_input(&resampler, taken);
+    }
+}
+
+// Switch the consumer over to the next track's path, false while the old format is still playing out of the sink
+static bool enter_next_track(void)
+{
+    if (memcmp(&path.sink_format, &next_path.sink_format, sizeof(Audio_Format)) != 0)
+    {
+        if (sink_queued > 0)
+        {
+            return false;
+        }
+
+        // A short gap, the DMA plays silence while the sink is reopened
+        audio_sink_close(output_sink);
+
+        if (audio_sink_open(output_sink, &next_path.sink_format, on_buffer_sent, NULL) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Sink won't take the next track's format");
+            stop_requested = true;
+            return false;
+        }
+
+        sink_buffer_size = audio_sink_buffer_size(output_sink);
+        atomic_store(&buffers_sent, 0);
+        audio_gain_configure(&gain, next_path.sink_format.sample_rate, next_path.channels);
+
+        // A seek ran off the end into here, what was left of the old position is in the wrong format
+        crossfade_frames = 0;
+        crossfade_position = 0;
+    }
+
+    if (next_path.is_resampling && !is_resampler_kept())
+    {
+        resampler_init(&resampler, AUDIO_OUTPUT_RESAMPLER_QUALITY, next_path.sample_rate, AUDIO_OUTPUT_SAMPLE_RATE, next_path.channels);
+    }
+
+    path = next_path;
+    is_resampler_flushed = false;
+    stats.tracks++;
+
+    atomic_store(&has_boundary, false);
+    xTaskNotifyGive(producer_handle);
+
+    return true;
+}
+
+// Paused & faded out, the sink is left to run dry on silence
+static bool is_held(void)
+{
+    return is_paused && audio_gain_is_silent(&gain);
+}
+
+static uint32_t stage_track_frames(uint8_t *destination, uint32_t max_frames)
+{
+    return path.is_resampling ? resample_frames((int32_t *)destination, max_frames) : take_frames(destination, max_frames);
+}
+
+static void apply_gain(uint8_t *samples, uint32_t frames)
+{
+    if (path.sink_format.bits_per_sample == 16)
+    {
+        audio_gain_apply_s16(&gain, (int16_t *)samples, frames);
+    }
+    else
+    {
+        audio_gain_apply_s32(&gain, (int32_t *)samples, frames);
+    }
+}
+
+// Blend the start of a seek's new position in over the old one, linearly, in Q15
+static void mix_crossfade(uint32_t frames)
+{
+    uint32_t count = crossfade_frames - crossfade_position;
+    uint32_t channels = path.sink_format.channels;
+
+    if (count > frames)
+    {
+        count = frames;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t frame = crossfade_position + i;
+        int64_t weight = ((int64_t)frame << 15) / crossfade_frames;
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            uint32_t index = i * channels + c;
+            uint32_t old_index = frame * channels + c;
+
+            if (path.sink_format.bits_per_sample == 16)
+            {
+                int16_t *samples = (int16_t *)staging;
+                int16_t old = ((int16_t *)crossfade)[old_index];
+
+                samples[index] = (int16_t)((samples[index] * weight + old * (32768 - weight)) >> 15);
+            }
+            else
+            {
+                int32_t *samples = (int32_t *)staging;
+                int32_t old = ((int32_t *)crossfade)[old_index];
+
+                samples[index] = (int32_t)((samples[index] * weight + old * (32768 - weight)) >> 15);
+            }
+        }
+    }
+
+    crossfade_position += count;
+}
+
+// What's next at the old position, before the ring is dropped. Nothing when paused, there's nothing to hear
+static void capture_crossfade(void)
+{
+    uint32_t frame_size = audio_format_frame_size(&path.sink_format);
+    uint32_t max_frames = sizeof(crossfade) / frame_size;
+
+    crossfade_frames = 0;
+    crossfade_position = 0;
+
+    if (is_held())
+    {
+        return;
+    }
+
+    if (max_frames > AUDIO_OUTPUT_CROSSFADE_FRAMES)
+    {
+        max_frames = AUDIO_OUTPUT_CROSSFADE_FRAMES;
+    }
+
+    while (crossfade_frames < max_frames)
+    {
+        uint32_t frames = stage_track_frames(&crossfade[crossfade_frames * frame_size], max_frames - crossfade_frames);
+
+        if (frames == 0)
+        {
+            break;
+        }
+
+        crossfade_frames += frames;
+    }
+
+    apply_gain(crossfade, crossfade_frames);
+}
+
+// Convert, resample & scale the next run of frames into the staging buffer, false when there's nothing to stage
+static bool stage_frames(void)
+{
+    uint32_t max_frames = AUDIO_OUTPUT_STAGING_SIZE / audio_format_frame_size(&path.sink_format);
+    uint32_t frames = stage_track_frames(staging, max_frames);
+
+    // The old track is all out, resampler tail included
+    if (frames == 0 && is_at_boundary() && (!path.is_resampling || is_resampler_flushed || is_resampler_kept()) && enter_next_track())
+    {
+        max_frames = AUDIO_OUTPUT_STAGING_SIZE / audio_format_frame_size(&path.sink_format);
+        frames = stage_track_frames(staging, max_frames);
+    }
+
+    if (frames == 0)
+    {
+        return false;
+    }
+
+    apply_gain(staging, frames);
+
+    if (crossfade_position < crossfade_frames)
+    {
+        mix_crossfade(frames);
+    }
+
+    staging_length = frames * audio_format_frame_size(&path.sink_format);
+    staging_offset = 0;
+
+    return true;
+}
+
+// As much of the staging buffer as the sink takes, false when it's full
+static bool write_staged(void)
+{
+    uint32_t written = 0;
+
+    audio_sink_write(output_sink, &staging[staging_offset], staging_length - staging_offset, &written);
+
+    staging_offset += written;
+    note_sink_write(written);
+
+    return staging_offset == staging_length;
+}
+
+static void feed_sink_staged(void)
+{
+    while (staging_offset < staging_length || (!is_held() && stage_frames()))
+    {
+        if (!write_staged())
+        {
+            break;
+        }
+    }
+}
+
+static void feed_sink(void)
+{
+    // Straight from the ring while there's nothing to do to the samples & the track goes on
+    bool is_direct = path.convert == NULL && !path.is_resampling && staging_offset == staging_length &&
+                     audio_gain_is_unity(&gain) && !is_at_boundary() && crossfade_position == crossfade_frames;
+
+    if (is_direct)
+    {
+        feed_sink_direct();
+    }
+
+    // Also picks up at a boundary the direct path ran into
+    if (!is_direct || is_at_boundary())
+    {
+        feed_sink_staged();
+    }
+
+    // Room in the ring for the producer
+    xTaskNotifyGive(producer_handle);
+}
+
+// Consumer's turns of a seek, false while it has to keep off the ring
+static bool step_seek(void)
+{
+    switch (atomic_load(&seek_state))
+    {
+    case SEEK_NONE:
+        return true;
+
+    case SEEK_REQUESTED:
+        capture_crossfade();
+
+        seek_frame = (uint64_t)seek_ms * path.sample_rate / 1000;
+        atomic_store(&seek_state, SEEK_FLUSHING);
+        xTaskNotifyGive(producer_handle);
+
+        return false;
+
+    case SEEK_REFILLED:
+        // Its history is of the old position
+        if (path.is_resampling)
+        {
+            resampler_init(&resampler, AUDIO_OUTPUT_RESAMPLER_QUALITY, path.sample_rate, AUDIO_OUTPUT_SAMPLE_RATE, path.channels);
+        }
+
+        is_resampler_flushed = false;
+        start_requested_at = seek_requested_at;
+
+        atomic_store(&seek_state, SEEK_NONE);
+        xSemaphoreGive(seek_done);
+
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static void finish_track(void)
+{
+    audio_sink_close(output_sink);
+
+    stop_requested = true;
+    xTaskNotifyGive(producer_handle);
+    xSemaphoreTake(producer_idle, portMAX_DELAY);
+
+    sink_queued = 0;
+    staging_length = 0;
+    staging_offset = 0;
+    stats.buffered = 0;
+    is_playing = false;
+
+    // Whoever waits on a seek that won't happen now
+    if (atomic_load(&seek_state) != SEEK_NONE)
+    {
+        xSemaphoreGive(seek_done);
+    }
+
+    xSemaphoreGive(idle);
+}
+
+static void consumer_task(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (!is_playing)
+        {
+            continue;
+        }
+
+        int32_t sent = atomic_exchange(&buffers_sent, 0) * sink_buffer_size;
+
+        // The DMA went through everything it had & then some, it filled the gap with silence.
+        // Not at a track boundary, where a change of format lets the sink run dry before it's reopened, nor mid seek
+        if (sent > 0 && sink_queued - sent < 0 && !producer_done && !is_paused && !was_held && !is_at_boundary() &&
+            atomic_load(&seek_state) == SEEK_NONE)
+        {
+            stats.underruns++;
+        }
+
+        sink_queued -= sent;
+
+        if (sink_queued < 0)
+        {
+            sink_queued = 0;
+        }
+
+        // Measured right after the DMA took its share, so the low mark is the real margin
+        update_watermarks();
+
+        if (step_seek())
+        {
+            feed_sink();
+        }
+        else if (staging_offset < staging_length)
+        {
+            // What was staged before the seek still plays, ahead of the crossfade
+            write_staged();
+        }
+
+        was_held = is_held();
+
+        update_watermarks();
+
+        bool is_drained = producer_done && atomic_load(&seek_state) == SEEK_NONE && !atomic_load(&has_boundary) && pcm_ring_used(&ring) == 0 &&
+                          (!path.is_resampling || is_resampler_flushed) && staging_offset == staging_length && sink_queued == 0;
+
+        if (stop_requested || is_drained)
+        {
+            finish_track();
+        }
+    }
+}
+
+esp_err_t audio_output_init(const Audio_Sink *sink)
+{
+    output_sink = sink;
+
+    producer_start = xSemaphoreCreateBinary();
+    primed = xSemaphoreCreateBinary();
+    producer_idle = xSemaphoreCreateBinary();
+    idle = xSemaphoreCreateBinary();
+    seek_done = xSemaphoreCreateBinary();
+
+    if (producer_start == NULL || primed == NULL || producer_idle == NULL || idle == NULL || seek_done == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pcm_ring_init(&ring, ring_storage, sizeof(ring_storage));
+    audio_gain_init(&gain);
+    xSemaphoreGive(idle);
+
+    if (xTaskCreatePinnedToCore(producer_task, "audio_producer", AUDIO_OUTPUT_PRODUCER_STACK, NULL, AUDIO_OUTPUT_PRODUCER_PRIORITY,
+                                &producer_handle, AUDIO_OUTPUT_PRODUCER_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(consumer_task, "audio_consumer", AUDIO_OUTPUT_CONSUMER_STACK, NULL, AUDIO_OUTPUT_CONSUMER_PRIORITY,
+                                &consumer_handle, AUDIO_OUTPUT_CONSUMER_CORE) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+void audio_output_set_next_track(audio_output_next_track_func next_track)
+{
+    next_track_func = next_track;
+}
+
+// Play the track in `slot`, the producer is idle
+static esp_err_t start_slot(int64_t requested_at)
+{
+    if (xSemaphoreTake(idle, 0) != pdTRUE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = plan_path(&infos[slot], &path);
+
+    if (err == ESP_OK && path.is_resampling)
+    {
+        err = resampler_init(&resampler, AUDIO_OUTPUT_RESAMPLER_QUALITY, path.sample_rate, AUDIO_OUTPUT_SAMPLE_RATE, path.channels);
+    }
+
+    if (err != ESP_OK)
+    {
+        xSemaphoreGive(idle);
+        return err;
+    }
+
+    is_resampler_flushed = false;
+    is_paused = false;
+    was_held = false;
+    audio_gain_set_mute(&gain, false);
+    audio_gain_configure(&gain, path.sink_format.sample_rate, path.channels);
+
+    track_remaining = infos[slot].data_offset + infos[slot].data_size - files[slot].position;
+    is_next_requested = false;
+    is_next_ready = false;
+    atomic_store(&has_boundary, false);
+    atomic_store(&seek_state, SEEK_NONE);
+    crossfade_frames = 0;
+    crossfade_position = 0;
+    stop_requested = false;
+    producer_done = false;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.tracks = 1;
+    atomic_store(&buffers_sent, 0);
+
+    // Ring offsets follow the file's sector offsets, every read after the first is whole sectors, wrap or not
+    pcm_ring_reset(&ring, files[slot].position % BLOCKDEV_SECTOR_SIZE);
+
+    xSemaphoreGive(producer_start);
+    xSemaphoreTake(primed, portMAX_DELAY);
+
+    err = audio_sink_open(output_sink, &path.sink_format, on_buffer_sent, NULL);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Sink open failed: %s", esp_err_to_name(err));
+
+        // Nothing is playing, let the consumer clean up as if it was stopped
+        is_playing = true;
+        stop_requested = true;
+        audio_output_stop();
+
+        return err;
+    }
+
+    sink_buffer_size = audio_sink_buffer_size(output_sink);
+    stats.low_watermark = UINT32_MAX;
+    start_requested_at = requested_at;
+    is_playing = true;
+
+    // First fill, from then on the sink's callbacks drive the consumer
+    xTaskNotifyGive(consumer_handle);
+
+    return ESP_OK;
+}
+
+esp_err_t audio_output_start(const FAT_File *file, const WAV_Info *info)
+{
+    int64_t requested_at = esp_timer_get_time();
+
+    if (is_playing)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    files[slot] = *file;
+    infos[slot] = *info;
+
+    return start_slot(requested_at);
+}
+
+esp_err_t audio_output_skip(void)
+{
+    int64_t requested_at = esp_timer_get_time();
+
+    audio_output_fade_out();
+
+    // The producer got to the next track already: it's either waiting in the other slot or being read
+    if (is_next_ready)
+    {
+        slot ^= 1;
+    }
+    else if (!atomic_load(&has_boundary))
+    {
+        slot ^= 1;
+
+        if (next_track_func == NULL || !next_track_func(&files[slot], &infos[slot]))
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    esp_err_t err = fat_file_seek(&files[slot], infos[slot].data_offset);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    return start_slot(requested_at);
+}
+
+esp_err_t audio_output_seek(uint32_t position_ms)
+{
+    int64_t requested_at = esp_timer_get_time();
+
+    if (!is_playing || atomic_load(&seek_state) != SEEK_NONE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Left over from a seek the end of the track got in the way of
+    xSemaphoreTake(seek_done, 0);
+
+    seek_ms = position_ms;
+    seek_requested_at = requested_at;
+    atomic_store(&seek_state, SEEK_REQUESTED);
+    xTaskNotifyGive(consumer_handle);
+
+    // The track may end before the consumer got to it, then nobody answers
+    while (xSemaphoreTake(seek_done, 1) != pdTRUE && is_playing)
+    {
+    }
+
+    return atomic_load(&seek_state) == SEEK_NONE ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void audio_output_stop(void)
+{
+    if (!is_playing)
+    {
+        return;
+    }
+
+    stop_requested = true;
+    xTaskNotifyGive(consumer_handle);
+
+    xSemaphoreTake(idle, portMAX_DELAY);
+    xSemaphoreGive(idle);
+}
+
+void audio_output_fade_out(void)
+{
+    if (!is_playing)
+    {
+        return;
+    }
+
+    // Cutting off mid waveform clicks
+    audio_output_pause();
+
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(4 * AUDIO_GAIN_RAMP_MS) + 1;
+
+    while (is_playing && !was_held && xTaskGetTickCount() < deadline)
+    {
+        vTaskDelay(1);
+    }
+
+    audio_output_stop();
+}
+
+bool audio_output_is_playing(void)
+{
+    return is_playing;
+}
+
+void audio_output_pause(void)
+{
+    is_paused = true;
+    audio_gain_set_mute(&gain, true);
+}
+
+void audio_output_resume(void)
+{
+    audio_gain_set_mute(&gain, false);
+    is_paused = false;
+}
+
+bool audio_output_is_paused(void)
+{
+    return is_paused;
+}
+
+void audio_output_set_volume(uint8_t volume)
+{
+    audio_gain_set_volume(&gain, volume);
+}
+
+void audio_output_set_balance(int8_t balance)
+{
+    audio_gain_set_balance(&gain, balance);
+}
+
+void audio_output_get_stats(Audio_Output_Stats *out)
+{
+    *out = stats;
+
+    if (out->low_watermark == UINT32_MAX)
+    {
+        out->low_watermark = 0;
+    }
+}
+
+void audio_output_log_stats(void)
+{
+    Audio_Output_Stats current;
+
+    audio_output_get_stats(&current);
+
+    ESP_LOGI(TAG, "Track %d, underruns: %d, buffered: %d bytes, low: %d, high: %d, start latency: %d us", (unsigned int)current.tracks,
+             (unsigned int)current.underruns, (unsigned int)current.buffered, (unsigned int)current.low_watermark,
+             (unsigned int)current.high_watermark, (unsigned int)current.start_latency_us);
+}
@@ -0,0 +1,147 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "audio_sink.h"
+#include "audio_gain.h"
+#include "resampler.h"
+#include "wav.h"
+#include "fat/fat_file.h"
+#include "task_layout.h"
+
+/**
+ * Streams the PCM of a WAV file into a sink. A producer task reads the file straight into a PCM ring,
+ * a consumer task hands the ring's contents to the sink, woken every time the sink's DMA finished a buffer.
+ * The consumer never waits on the producer: whatever the card hasn't delivered yet is an underrun, not a stall.
+ *
+ * Tracks follow each other without a gap: near the end of a track the producer asks for the next one, already
+ * opened & parsed, & carries on reading it into the ring right behind the current one. The consumer switches
+ * over at the exact byte. Only a change of the sink's format (16 <-> 32 bit, channels) reopens the sink.
+ *
+ * A seek doesn't stop the sink either: the consumer keeps the next few ms of the old position, the producer
+ * drops the ring, moves the file to the new frame & refills, the consumer crossfades from old to new.
+ */
+
+// Ring between the file & the sink, ~93 ms of 16 bit stereo at 44.1 kHz. Power of two, whole sectors
+#define AUDIO_OUTPUT_RING_SIZE 16384
+
+// Largest single read off the card & the least free room worth waking the producer for
+#define AUDIO_OUTPUT_READ_SIZE 4096
+#define AUDIO_OUTPUT_MIN_READ BLOCKDEV_SECTOR_SIZE
+
+// Buffered before the sink starts, less than the whole ring so a start or skip is heard sooner
+#define AUDIO_OUTPUT_PRIME_SIZE 8192
+
+// Buffered after a seek before the consumer goes on, less than a start as the sink keeps playing meanwhile
+#define AUDIO_OUTPUT_REFILL_SIZE 4096
+
+// Old & new position overlap this long after a seek, ~5.8 ms at 44.1 kHz. Fewer past stereo
+#define AUDIO_OUTPUT_CROSSFADE_FRAMES 256
+
+// Bytes left in a track when the next one is opened, it's ready long before the ring gets there
+#define AUDIO_OUTPUT_PREOPEN_SIZE (2 * AUDIO_OUTPUT_RING_SIZE)
+
+// Formats the sink can't take are widened on the way out: 8 bit to 16, packed 24 bit to 32.
+// Converted or gain adjusted samples wait here until the sink has room, about a DMA buffer's worth
+#define AUDIO_OUTPUT_STAGING_SIZE 2048
+
+// Everything plays at this rate, files at other rates go through the resampler (as 32 bit)
+// so the I2S clock never has to change between tracks
+#define AUDIO_OUTPUT_SAMPLE_RATE 44100
+#define AUDIO_OUTPUT_RESAMPLER_QUALITY RESAMPLER_QUALITY_MEDIUM
+
+// Largest frame that can be staged, 8 channels of 32 bit
+#define AUDIO_OUTPUT_MAX_FRAME 32
+
+// The consumer only shuffles memory & must never miss a buffer, the producer waits on the card
+#define AUDIO_OUTPUT_PRODUCER_STACK 4096
+#define AUDIO_OUTPUT_PRODUCER_PRIORITY 6
+#define AUDIO_OUTPUT_PRODUCER_CORE TASK_CORE_IO
+#define AUDIO_OUTPUT_CONSUMER_STACK 3072
+#define AUDIO_OUTPUT_CONSUMER_PRIORITY 12
+#define AUDIO_OUTPUT_CONSUMER_CORE TASK_CORE_AUDIO
+
+typedef struct
+{
+    uint32_t underruns;        // Sink buffers that went out short or silent mid track
+    uint32_t buffered;         // Bytes ahead of the DAC right now, the PCM ring & the sink's DMA ring
+    uint32_t low_watermark;    // Least bytes ever ahead of the DAC since the track started
+    uint32_t high_watermark;   // Most bytes ever ahead of the DAC
+    uint32_t tracks;           // Played since the start, counting the one playing
+    uint32_t start_latency_us; // From the last start, skip or seek to its first sample handed to the sink
+} Audio_Output_Stats;
+
+/**
+ * Asked for the track after the current one, from the producer task. Open `file` & parse it into `info`,
+ * return false when there is nothing more to play.
+ */
+typedef bool (*audio_output_next_track_func)(FAT_File *file, WAV_Info *info);
+
+/**
+ * Create the tasks & queues, once, for the sink all tracks are played to.
+ */
+esp_err_t audio_output_init(const Audio_Sink *sink);
+
+/**
+ * Where tracks after the current one come from, NULL to stop after it.
+ */
+void audio_output_set_next_track(audio_output_next_track_func next_track);
+
+/**
+ * Play a file that went through `wav_parse`, from its current position to the end of the data, then whatever
+ * the next track function hands out. The file is copied, the caller's copy is free once this returns.
+ * Returns once AUDIO_OUTPUT_PRIME_SIZE is buffered & the sink is playing.
+ * ESP_ERR_INVALID_STATE if something is playing already.
+ */
+esp_err_t audio_output_start(const FAT_File *file, const WAV_Info *info);
+
+/**
+ * Fade out, drop what's buffered & start the track after the current one. It may have been opened already,
+ * otherwise the next track function is asked. ESP_ERR_NOT_FOUND, & stopped, when there is none.
+ */
+esp_err_t audio_output_skip(void);
+
+/**
+ * Go to a position in the track the sink is playing, to the frame: data offset + frame x block align.
+ * Returns once the ring is refilled from there, past the end the next track plays.
+ * ESP_ERR_INVALID_STATE when nothing is playing or the track ended first.
+ */
+esp_err_t audio_output_seek(uint32_t position_ms);
+
+/**
+ * Stop playing & close the sink, returns once both tasks are idle. Does nothing when idle.
+ */
+void audio_output_stop(void);
+
+/**
+ * Stop after fading out over AUDIO_GAIN_RAMP_MS, for stops the listener hears.
+ */
+void audio_output_fade_out(void);
+
+// Until the last byte was played out or stopped
+bool audio_output_is_playing(void);
+
+/**
+ * Fade out over AUDIO_GAIN_RAMP_MS & hold the position, the sink keeps running on silence.
+ * Resuming fades back in from where it stopped.
+ */
+void audio_output_pause(void);
+
+void audio_output_resume(void);
+
+bool audio_output_is_paused(void);
+
+// 0 - AUDIO_GAIN_MAX_VOLUME, kept across tracks
+void audio_output_set_volume(uint8_t volume);
+
+// -AUDIO_GAIN_MAX_BALANCE (left only) - AUDIO_GAIN_MAX_BALANCE (right only)
+void audio_output_set_balance(int8_t balance);
+
+void audio_output_get_stats(Audio_Output_Stats *stats);
+
+void audio_output_log_stats(void);
+
+#endif
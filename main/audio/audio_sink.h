@@ -0,0 +1,74 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Where PCM ends up: the I2S peripheral on the board, a WAV file or nothing at all on a host.
+ * A sink plays out of a ring of DMA buffers at the sample rate & reports every buffer it finished,
+ * writes only ever fill whatever room there is & never block. Same idea as the block device, ops & a context.
+ */
+
+typedef struct
+{
+    uint32_t sample_rate;
+    uint16_t channels;
+    uint16_t bits_per_sample; // Interleaved little endian integer samples
+} Audio_Format;
+
+/**
+ * Called every time a DMA buffer was played out, from an ISR on real hardware.
+ * Return true if a higher priority task was woken.
+ */
+typedef bool (*audio_sink_sent_callback)(void *arg);
+
+typedef struct
+{
+    // Start playing, silence until data is written. `on_sent` is called for every buffer played
+    esp_err_t (*open)(void *context, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg);
+
+    // Queue up to `size` bytes, `written` tells how many fit. Never blocks
+    esp_err_t (*write)(void *context, const uint8_t *source, uint32_t size, uint32_t *written);
+
+    // Stop playing & let go of the output
+    void (*close)(void *context);
+
+    // Bytes played per DMA buffer, i.e. per `on_sent`
+    uint32_t (*buffer_size)(void *context);
+} Audio_Sink_Ops;
+
+typedef struct
+{
+    const Audio_Sink_Ops *ops;
+    void *context;
+} Audio_Sink;
+
+static inline esp_err_t audio_sink_open(const Audio_Sink *sink, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg)
+{
+    return sink->ops->open(sink->context, format, on_sent, arg);
+}
+
+static inline esp_err_t audio_sink_write(const Audio_Sink *sink, const uint8_t *source, uint32_t size, uint32_t *written)
+{
+    return sink->ops->write(sink->context, source, size, written);
+}
+
+static inline void audio_sink_close(const Audio_Sink *sink)
+{
+    sink->ops->close(sink->context);
+}
+
+static inline uint32_t audio_sink_buffer_size(const Audio_Sink *sink)
+{
+    return sink->ops->buffer_size(sink->context);
+}
+
+// Bytes per frame, every channel of a single sample
+static inline uint32_t audio_format_frame_size(const Audio_Format *format)
+{
+    return format->channels * (format->bits_per_sample / 8);
+}
+
+#endif
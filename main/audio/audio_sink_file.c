@@ -0,0 +1,240 @@
+#include "audio_sink_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "utils.h"
+
+#define WAV_HEADER_LENGTH 44
+
+static const char *TAG = "AUDIO_SINK_FILE";
+
+// Plain PCM header, sizes are filled in on close
+static void write_wav_header(Audio_Sink_File *sink)
+{
+    uint8_t header[WAV_HEADER_LENGTH] = {0};
+    uint32_t frame_size = audio_format_frame_size(&sink->format);
+
+    memcpy(&header[0], "RIFF", 4);
+    insert_uint32_le(header, 4, WAV_HEADER_LENGTH - 8 + sink->data_bytes);
+    memcpy(&header[8], "WAVEfmt ", 8);
+    insert_uint32_le(header, 16, 16);
+    insert_uint32_le(header, 20, 1 | (sink->format.channels << 16)); // PCM & channels
+    insert_uint32_le(header, 24, sink->format.sample_rate);
+    insert_uint32_le(header, 28, sink->format.sample_rate * frame_size);
+    insert_uint32_le(header, 32, frame_size | (sink->format.bits_per_sample << 16)); // Block align & bits
+    memcpy(&header[36], "data", 4);
+    insert_uint32_le(header, 40, sink->data_bytes);
+
+    fseek(sink->file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), sink->file);
+    fseek(sink->file, 0, SEEK_END);
+}
+
+// Take a buffer worth out of the ring, topped up with silence when short
+static void play_buffer(Audio_Sink_File *sink, uint8_t *buffer)
+{
+    uint32_t capacity = sink->buffer_size * AUDIO_SINK_FILE_BUFFERS;
+
+    xSemaphoreTake(sink->lock, portMAX_DELAY);
+
+    uint32_t length = sink->used < sink->buffer_size ? sink->used : sink->buffer_size;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        buffer[i] = sink->ring[(sink->head + i) % capacity];
+    }
+
+    sink->head = (sink->head + length) % capacity;
+    sink->used -= length;
+
+    xSemaphoreGive(sink->lock);
+
+    memset(&buffer[length], 0, sink->buffer_size - length);
+
+    if (length < sink->buffer_size)
+    {
+        sink->silent_buffers++;
+    }
+
+    sink->buffers_played++;
+}
+
+static void clock_task(void *arg)
+{
+    Audio_Sink_File *sink = (Audio_Sink_File *)arg;
+    uint8_t *buffer = malloc(sink->buffer_size);
+
+    int64_t period = (int64_t)AUDIO_SINK_FILE_FRAMES * 1000000 / sink->format.sample_rate;
+    int64_t next = esp_timer_get_time();
+
+    while (sink->is_open && buffer != NULL)
+    {
+        next += period;
+
+        int64_t wait = next - esp_timer_get_time();
+
+        // Behind schedule buffers go out back to back until it caught up
+        if (wait > 0)
+        {
+            TickType_t ticks = pdMS_TO_TICKS(wait / 1000);
+            vTaskDelay(ticks > 0 ? ticks : 1);
+        }
+
+        play_buffer(sink, buffer);
+
+        if (sink->file != NULL)
+        {
+            fwrite(buffer, 1, sink->buffer_size, sink->file);
+            sink->data_bytes += sink->buffer_size;
+        }
+
+        sink->on_sent(sink->arg);
+    }
+
+    free(buffer);
+    xSemaphoreGive(sink->stopped);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t file_open(void *context, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg)
+{
+    Audio_Sink_File *sink = (Audio_Sink_File *)context;
+
+    sink->format = *format;
+    sink->buffer_size = AUDIO_SINK_FILE_FRAMES * audio_format_frame_size(format);
+    sink->ring = malloc(sink->buffer_size * AUDIO_SINK_FILE_BUFFERS);
+    sink->head = 0;
+    sink->used = 0;
+    sink->on_sent = on_sent;
+    sink->arg = arg;
+    sink->buffers_played = 0;
+    sink->silent_buffers = 0;
+    sink->data_bytes = 0;
+    sink->file = NULL;
+
+    if (sink->ring == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (sink->lock == NULL)
+    {
+        sink->lock = xSemaphoreCreateMutex();
+        sink->stopped = xSemaphoreCreateBinary();
+    }
+
+    if (sink->path != NULL)
+    {
+        sink->file = fopen(sink->path, "wb");
+
+        if (sink->file == NULL)
+        {
+            ESP_LOGE(TAG, "Failed to open %s", sink->path);
+            free(sink->ring);
+            sink->ring = NULL;
+            return ESP_FAIL;
+        }
+
+        write_wav_header(sink);
+    }
+
+    sink->is_open = true;
+
+    if (xTaskCreatePinnedToCore(clock_task, "audio_sink_file", AUDIO_SINK_FILE_TASK_STACK, sink, AUDIO_SINK_FILE_TASK_PRIORITY, NULL,
+                                AUDIO_SINK_FILE_TASK_CORE) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to start the clock task");
+        sink->is_open = false;
+
+        if (sink->file != NULL)
+        {
+            fclose(sink->file);
+            sink->file = NULL;
+        }
+
+        free(sink->ring);
+        sink->ring = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t file_write(void *context, const uint8_t *source, uint32_t size, uint32_t *written)
+{
+    Audio_Sink_File *sink = (Audio_Sink_File *)context;
+    uint32_t capacity = sink->buffer_size * AUDIO_SINK_FILE_BUFFERS;
+
+    xSemaphoreTake(sink->lock, portMAX_DELAY);
+
+    uint32_t length = capacity - sink->used;
+
+    if (length > size)
+    {
+        length = size;
+    }
+
+    uint32_t tail = (sink->head + sink->used) % capacity;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        sink->ring[(tail + i) % capacity] = source[i];
+    }
+
+    sink->used += length;
+
+    xSemaphoreGive(sink->lock);
+
+    *written = length;
+
+    return ESP_OK;
+}
+
+static void file_close(void *context)
+{
+    Audio_Sink_File *sink = (Audio_Sink_File *)context;
+
+    if (!sink->is_open)
+    {
+        return;
+    }
+
+    sink->is_open = false;
+    xSemaphoreTake(sink->stopped, portMAX_DELAY);
+
+    if (sink->file != NULL)
+    {
+        write_wav_header(sink);
+        fclose(sink->file);
+        sink->file = NULL;
+    }
+
+    free(sink->ring);
+    sink->ring = NULL;
+
+    ESP_LOGI(TAG, "Played %d buffers, %d of them short", (unsigned int)sink->buffers_played, (unsigned int)sink->silent_buffers);
+}
+
+static uint32_t file_buffer_size(void *context)
+{
+    return ((Audio_Sink_File *)context)->buffer_size;
+}
+
+static const Audio_Sink_Ops file_ops = {
+    .open = file_open,
+    .write = file_write,
+    .close = file_close,
+    .buffer_size = file_buffer_size,
+};
+
+void audio_sink_file_init(Audio_Sink_File *file, const char *path, Audio_Sink *sink)
+{
+    memset(file, 0, sizeof(Audio_Sink_File));
+    file->path = path;
+
+    sink->ops = &file_ops;
+    sink->context = file;
+}
@@ -0,0 +1,53 @@
+#ifndef AUDIO_SINK_FILE_H
+#define AUDIO_SINK_FILE_H
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "audio_sink.h"
+#include "task_layout.h"
+
+/**
+ * Stand-in for I2S on a host: a task plays the buffers out in real time, same pace & same `on_sent` calls,
+ * but into a WAV file. Without a path it is a null sink that only keeps time.
+ */
+
+#define AUDIO_SINK_FILE_BUFFERS 4
+#define AUDIO_SINK_FILE_FRAMES 240
+
+#define AUDIO_SINK_FILE_TASK_STACK 3072
+#define AUDIO_SINK_FILE_TASK_PRIORITY 10
+#define AUDIO_SINK_FILE_TASK_CORE TASK_CORE_AUDIO
+
+typedef struct
+{
+    const char *path; // NULL for a null sink
+    FILE *file;
+    Audio_Format format;
+
+    // Byte ring of AUDIO_SINK_FILE_BUFFERS buffers
+    uint8_t *ring;
+    uint32_t buffer_size;
+    uint32_t head;
+    uint32_t used;
+    SemaphoreHandle_t lock;
+
+    audio_sink_sent_callback on_sent;
+    void *arg;
+
+    volatile bool is_open;
+    SemaphoreHandle_t stopped; // Given by the clock task once it is out
+
+    uint32_t buffers_played;
+    uint32_t silent_buffers; // Played with nothing (or not enough) written, i.e. underruns
+    uint32_t data_bytes;     // Written to the file
+} Audio_Sink_File;
+
+/**
+ * Set up a file (or null, `path` NULL) sink, it is opened through the sink ops like any other.
+ */
+void audio_sink_file_init(Audio_Sink_File *file, const char *path, Audio_Sink *sink);
+
+#endif
@@ -0,0 +1,143 @@
+#include "audio_sink_i2s.h"
+
+#include "sdkconfig.h"
+
+// The host build has no I2S peripheral, it plays into an Audio_Sink_File instead
+#if !CONFIG_IDF_TARGET_LINUX
+
+#include "driver/i2s_std.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "AUDIO_I2S";
+
+static i2s_chan_handle_t channel = NULL;
+static uint32_t dma_buffer_size = 0;
+
+static audio_sink_sent_callback sent_callback = NULL;
+static void *sent_arg = NULL;
+
+static IRAM_ATTR bool i2s_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    return sent_callback(sent_arg);
+}
+
+static esp_err_t i2s_open(void *context, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg)
+{
+    if (format->bits_per_sample != 16 && format->bits_per_sample != 32)
+    {
+        ESP_LOGE(TAG, "%d bit samples need converting first", (unsigned int)format->bits_per_sample);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (format->channels != 1 && format->channels != 2)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = AUDIO_I2S_DMA_BUFFERS;
+    chan_cfg.dma_frame_num = AUDIO_I2S_DMA_FRAMES;
+    chan_cfg.auto_clear = true; // Underruns play silence instead of the last buffer over & over
+
+    esp_err_t err = i2s_new_channel(&chan_cfg, &channel, NULL);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(format->sample_rate),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(format->bits_per_sample == 16 ? I2S_DATA_BIT_WIDTH_16BIT : I2S_DATA_BIT_WIDTH_32BIT,
+                                                        format->channels == 1 ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = AUDIO_I2S_BCLK,
+            .ws = AUDIO_I2S_WS,
+            .dout = AUDIO_I2S_DOUT,
+            .din = I2S_GPIO_UNUSED,
+        },
+    };
+
+    err = i2s_channel_init_std_mode(channel, &std_cfg);
+
+    sent_callback = on_sent;
+    sent_arg = arg;
+
+    i2s_event_callbacks_t callbacks = {
+        .on_sent = i2s_on_sent,
+    };
+
+    if (err == ESP_OK)
+    {
+        err = i2s_channel_register_event_callback(channel, &callbacks, NULL);
+    }
+
+    if (err == ESP_OK)
+    {
+        err = i2s_channel_enable(channel);
+    }
+
+    if (err != ESP_OK)
+    {
+        i2s_del_channel(channel);
+        channel = NULL;
+        return err;
+    }
+
+    dma_buffer_size = AUDIO_I2S_DMA_FRAMES * audio_format_frame_size(format);
+
+    ESP_LOGI(TAG, "%d Hz, %d ch, %d bit", (unsigned int)format->sample_rate,
+             (unsigned int)format->channels, (unsigned int)format->bits_per_sample);
+
+    return ESP_OK;
+}
+
+static esp_err_t i2s_write(void *context, const uint8_t *source, uint32_t size, uint32_t *written)
+{
+    size_t bytes_written = 0;
+
+    // No timeout: copies into whatever DMA buffers are free & returns
+    esp_err_t err = i2s_channel_write(channel, source, size, &bytes_written, 0);
+
+    *written = bytes_written;
+
+    return err == ESP_ERR_TIMEOUT ? ESP_OK : err;
+}
+
+static void i2s_close(void *context)
+{
+    if (channel == NULL)
+    {
+        return;
+    }
+
+    i2s_channel_disable(channel);
+    i2s_del_channel(channel);
+    channel = NULL;
+}
+
+static uint32_t i2s_buffer_size(void *context)
+{
+    return dma_buffer_size;
+}
+
+static const Audio_Sink_Ops i2s_ops = {
+    .open = i2s_open,
+    .write = i2s_write,
+    .close = i2s_close,
+    .buffer_size = i2s_buffer_size,
+};
+
+static const Audio_Sink i2s_sink = {
+    .ops = &i2s_ops,
+    .context = NULL,
+};
+
+const Audio_Sink *audio_sink_i2s_get(void)
+{
+    return &i2s_sink;
+}
+
+#endif
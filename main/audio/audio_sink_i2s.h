@@ -0,0 +1,21 @@
+#ifndef AUDIO_SINK_I2S_H
+#define AUDIO_SINK_I2S_H
+
+#include "audio_sink.h"
+
+// Philips I2S to an external DAC, pins clear of the SD card's SPI bus
+#define AUDIO_I2S_BCLK 26
+#define AUDIO_I2S_WS 25
+#define AUDIO_I2S_DOUT 22
+
+// DMA ring: descriptors & frames per descriptor. 4 x 240 frames is ~22 ms at 44.1 kHz
+#define AUDIO_I2S_DMA_BUFFERS 4
+#define AUDIO_I2S_DMA_FRAMES 240
+
+/**
+ * The I2S peripheral as a sink. The DMA keeps sending silence when nothing was written in time.
+ * 16 & 32 bit samples, mono or stereo.
+ */
+const Audio_Sink *audio_sink_i2s_get(void);
+
+#endif
@@ -0,0 +1,313 @@
+#include "pcm_convert.h"
+
+#include <string.h>
+
+// Little endian only, like the ESP32
+#define IS_WORD_ALIGNED(pointer) (((uintptr_t)(pointer) & 3) == 0)
+
+static uint32_t dither_state = 1;
+
+// Numerical Recipes LCG, the low bits are poor but both halves only need to be roughly uniform
+static inline uint32_t dither_next(void)
+{
+    dither_state = dither_state * 1664525 + 1013904223;
+    return dither_state;
+}
+
+// Sum of two uniform 16 bit values, centered: triangular over +-1 LSB of the 16 bit result
+static inline int32_t dither_noise(void)
+{
+    uint32_t random = dither_next();
+
+    return (int32_t)(random & 0xFFFF) + (int32_t)(random >> 16) - 0xFFFF;
+}
+
+static inline int16_t dither_sample(int32_t sample)
+{
+    int32_t dithered;
+
+    // Loud samples can't go past full scale, they don't need dither anyway
+    if (__builtin_add_overflow(sample, dither_noise(), &dithered))
+    {
+        dithered = sample;
+    }
+
+    return (int16_t)(dithered >> 16);
+}
+
+void pcm_dither_seed(uint32_t seed)
+{
+    dither_state = seed;
+}
+
+void pcm_u8_to_s16_scalar(const void *source, void *destination, uint32_t samples)
+{
+    const uint8_t *in = source;
+    int16_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        out[i] = (int16_t)((in[i] ^ 0x80) << 8);
+    }
+}
+
+void pcm_u8_to_s16(const void *source, void *destination, uint32_t samples)
+{
+    const uint8_t *in = source;
+    int16_t *out = destination;
+
+    while (samples > 0 && !IS_WORD_ALIGNED(in))
+    {
+        *out++ = (int16_t)((*in++ ^ 0x80) << 8);
+        samples--;
+    }
+
+    // Only a halfword aligned destination, so two halfword pairs go out as words when that lines up too
+    if (IS_WORD_ALIGNED(out))
+    {
+        const uint32_t *in_words = (const uint32_t *)in;
+        uint32_t *out_words = (uint32_t *)out;
+
+        for (; samples >= 4; samples -= 4)
+        {
+            uint32_t word = *in_words++;
+
+            // Bytes 0 & 1 to the high byte of each halfword, sign flipped for both at once
+            *out_words++ = (((word << 8) & 0x0000FF00) | ((word << 16) & 0xFF000000)) ^ 0x80008000;
+            *out_words++ = (((word >> 8) & 0x0000FF00) | (word & 0xFF000000)) ^ 0x80008000;
+        }
+
+        in = (const uint8_t *)in_words;
+        out = (int16_t *)out_words;
+    }
+
+    pcm_u8_to_s16_scalar(in, out, samples);
+}
+
+// A store per sample whichever way, not worth any tricks
+void pcm_u8_to_s32(const void *source, void *destination, uint32_t samples)
+{
+    const uint8_t *in = source;
+    uint32_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        out[i] = (uint32_t)(in[i] ^ 0x80) << 24;
+    }
+}
+
+void pcm_s16_to_s32_scalar(const void *source, void *destination, uint32_t samples)
+{
+    const int16_t *in = source;
+    int32_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        out[i] = (int32_t)((uint32_t)(uint16_t)in[i] << 16);
+    }
+}
+
+void pcm_s16_to_s32(const void *source, void *destination, uint32_t samples)
+{
+    const int16_t *in = source;
+    uint32_t *out = destination;
+
+    if (samples > 0 && !IS_WORD_ALIGNED(in))
+    {
+        *out++ = (uint32_t)(uint16_t)*in++ << 16;
+        samples--;
+    }
+
+    const uint32_t *in_words = (const uint32_t *)in;
+
+    for (; samples >= 4; samples -= 4)
+    {
+        uint32_t first = *in_words++;
+        uint32_t second = *in_words++;
+
+        out[0] = first << 16;
+        out[1] = first & 0xFFFF0000;
+        out[2] = second << 16;
+        out[3] = second & 0xFFFF0000;
+        out += 4;
+    }
+
+    pcm_s16_to_s32_scalar(in_words, out, samples);
+}
+
+void pcm_s24_to_s32_scalar(const void *source, void *destination, uint32_t samples)
+{
+    const uint8_t *in = source;
+    int32_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++, in += 3)
+    {
+        out[i] = (int32_t)(((uint32_t)in[0] << 8) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 24));
+    }
+}
+
+void pcm_s24_to_s32(const void *source, void *destination, uint32_t samples)
+{
+    const uint8_t *in = source;
+    uint32_t *out = destination;
+
+    // Every sample moves the source 3 bytes, so at most 3 until it lines up
+    while (samples > 0 && !IS_WORD_ALIGNED(in))
+    {
+        *out++ = ((uint32_t)in[0] << 8) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 24);
+        in += 3;
+        samples--;
+    }
+
+    const uint32_t *in_words = (const uint32_t *)in;
+
+    // 4 samples are 3 words: 000 1|11 22|2 333
+    for (; samples >= 4; samples -= 4)
+    {
+        uint32_t first = in_words[0];
+        uint32_t second = in_words[1];
+        uint32_t third = in_words[2];
+
+        out[0] = first << 8;
+        out[1] = ((first >> 16) & 0x0000FF00) | (second << 16);
+        out[2] = ((second >> 8) & 0x00FFFF00) | (third << 24);
+        out[3] = third & 0xFFFFFF00;
+
+        in_words += 3;
+        out += 4;
+    }
+
+    pcm_s24_to_s32_scalar(in_words, out, samples);
+}
+
+void pcm_s32_to_s24_scalar(const void *source, void *destination, uint32_t samples)
+{
+    const int32_t *in = source;
+    uint8_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++, out += 3)
+    {
+        uint32_t sample = (uint32_t)in[i];
+
+        out[0] = (uint8_t)(sample >> 8);
+        out[1] = (uint8_t)(sample >> 16);
+        out[2] = (uint8_t)(sample >> 24);
+    }
+}
+
+void pcm_s32_to_s24(const void *source, void *destination, uint32_t samples)
+{
+    const uint32_t *in = source;
+    uint8_t *out = destination;
+
+    // Here it's the packed destination that has to line up
+    while (samples > 0 && !IS_WORD_ALIGNED(out))
+    {
+        pcm_s32_to_s24_scalar(in++, out, 1);
+        out += 3;
+        samples--;
+    }
+
+    uint32_t *out_words = (uint32_t *)out;
+
+    for (; samples >= 4; samples -= 4)
+    {
+        out_words[0] = (in[0] >> 8) | ((in[1] << 16) & 0xFF000000);
+        out_words[1] = (in[1] >> 16) | ((in[2] << 8) & 0xFFFF0000);
+        out_words[2] = (in[2] >> 24) | (in[3] & 0xFFFFFF00);
+
+        in += 4;
+        out_words += 3;
+    }
+
+    pcm_s32_to_s24_scalar(in, out_words, samples);
+}
+
+void pcm_s32_to_s16_dither_scalar(const void *source, void *destination, uint32_t samples)
+{
+    const int32_t *in = source;
+    int16_t *out = destination;
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        out[i] = dither_sample(in[i]);
+    }
+}
+
+void pcm_s32_to_s16_dither(const void *source, void *destination, uint32_t samples)
+{
+    const int32_t *in = source;
+    int16_t *out = destination;
+
+    if (samples > 0 && !IS_WORD_ALIGNED(out))
+    {
+        *out++ = dither_sample(*in++);
+        samples--;
+    }
+
+    uint32_t *out_words = (uint32_t *)out;
+
+    // The noise costs the same either way, the win is in half as many stores
+    for (; samples >= 2; samples -= 2)
+    {
+        uint16_t first = (uint16_t)dither_sample(in[0]);
+        uint16_t second = (uint16_t)dither_sample(in[1]);
+
+        *out_words++ = first | ((uint32_t)second << 16);
+        in += 2;
+    }
+
+    pcm_s32_to_s16_dither_scalar(in, out_words, samples);
+}
+
+void pcm_mono_to_stereo_s16_scalar(const void *source, void *destination, uint32_t frames)
+{
+    const int16_t *in = source;
+    int16_t *out = destination;
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        out[2 * i] = in[i];
+        out[2 * i + 1] = in[i];
+    }
+}
+
+void pcm_mono_to_stereo_s16(const void *source, void *destination, uint32_t frames)
+{
+    const int16_t *in = source;
+    uint32_t *out = destination; // A stereo frame is a word
+
+    if (frames > 0 && !IS_WORD_ALIGNED(in))
+    {
+        uint16_t sample = (uint16_t)*in++;
+
+        *out++ = sample | ((uint32_t)sample << 16);
+        frames--;
+    }
+
+    const uint32_t *in_words = (const uint32_t *)in;
+
+    for (; frames >= 2; frames -= 2)
+    {
+        uint32_t word = *in_words++;
+
+        out[0] = (word & 0x0000FFFF) | (word << 16);
+        out[1] = (word >> 16) | (word & 0xFFFF0000);
+        out += 2;
+    }
+
+    pcm_mono_to_stereo_s16_scalar(in_words, out, frames);
+}
+
+// Already a word per sample, nothing to gain from tricks
+void pcm_mono_to_stereo_s32(const void *source, void *destination, uint32_t frames)
+{
+    const int32_t *in = source;
+    int32_t *out = destination;
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        out[2 * i] = in[i];
+        out[2 * i + 1] = in[i];
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PCM_CONVERT_H
+#define PCM_CONVERT_H
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Sample format conversion, little endian interleaved integer PCM. Counts are in samples (frames x channels),
+ * except for the channel duplication which counts frames. Source & destination must not overlap.
+ *
+ * The plain functions are the ones to use: they move whole 32 bit words, a few samples per step.
+ * ESP32 faults on unaligned word access, so they go sample by sample until the source is aligned,
+ * destinations must be aligned to their sample size. The `_scalar` ones are the readable references
+ * the fast ones must match bit for bit.
+ */
+
+typedef void (*pcm_convert_func)(const void *source, void *destination, uint32_t samples);
+
+// Unsigned 8 bit to signed 16 bit
+void pcm_u8_to_s16(const void *source, void *destination, uint32_t samples);
+void pcm_u8_to_s16_scalar(const void *source, void *destination, uint32_t samples);
+
+// Unsigned 8 bit into the top of 32 bit
+void pcm_u8_to_s32(const void *source, void *destination, uint32_t samples);
+
+// 16 bit into the top of 32 bit
+void pcm_s16_to_s32(const void *source, void *destination, uint32_t samples);
+void pcm_s16_to_s32_scalar(const void *source, void *destination, uint32_t samples);
+
+// Packed 24 bit (3 bytes a sample) into the top of 32 bit
+void pcm_s24_to_s32(const void *source, void *destination, uint32_t samples);
+void pcm_s24_to_s32_scalar(const void *source, void *destination, uint32_t samples);
+
+// Top 24 bits of 32 bit, packed
+void pcm_s32_to_s24(const void *source, void *destination, uint32_t samples);
+void pcm_s32_to_s24_scalar(const void *source, void *destination, uint32_t samples);
+
+/**
+ * 32 bit to 16 bit with +-1 LSB triangular dither, so quiet passages turn into noise rather than distortion.
+ * The noise comes from a generator shared by both versions, `pcm_dither_seed` makes runs repeatable.
+ */
+void pcm_s32_to_s16_dither(const void *source, void *destination, uint32_t samples);
+void pcm_s32_to_s16_dither_scalar(const void *source, void *destination, uint32_t samples);
+
+void pcm_dither_seed(uint32_t seed);
+
+// Mono to stereo, every sample twice
+void pcm_mono_to_stereo_s16(const void *source, void *destination, uint32_t frames);
+void pcm_mono_to_stereo_s16_scalar(const void *source, void *destination, uint32_t frames);
+
+void pcm_mono_to_stereo_s32(const void *source, void *destination, uint32_t frames);
+
+#endif
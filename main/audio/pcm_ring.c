@@ -0,0 +1,91 @@
+#include "pcm_ring.h"
+
+esp_err_t pcm_ring_init(PCM_Ring *ring, uint8_t *storage, uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0 || ((uintptr_t)storage % PCM_RING_ALIGNMENT) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ring->data = storage;
+    ring->size = size;
+    ring->mask = size - 1;
+
+    pcm_ring_reset(ring, 0);
+
+    return ESP_OK;
+}
+
+void pcm_ring_reset(PCM_Ring *ring, uint32_t offset)
+{
+    atomic_store_explicit(&ring->head, offset & ring->mask, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, offset & ring->mask, memory_order_release);
+}
+
+uint32_t pcm_ring_acquire_write(PCM_Ring *ring, uint8_t **region)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // Acquire pairs with the reader's commit: it's done with the bytes before we overwrite them
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    uint32_t free = ring->size - (head - tail);
+    uint32_t offset = head & ring->mask;
+    uint32_t to_end = ring->size - offset;
+
+    *region = &ring->data[offset];
+
+    return free < to_end ? free : to_end;
+}
+
+void pcm_ring_commit_write(PCM_Ring *ring, uint32_t length)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // Release: the data is in memory before the reader can see the new head
+    atomic_store_explicit(&ring->head, head + length, memory_order_release);
+}
+
+uint32_t pcm_ring_acquire_read(PCM_Ring *ring, const uint8_t **region)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    uint32_t used = head - tail;
+    uint32_t offset = tail & ring->mask;
+    uint32_t to_end = ring->size - offset;
+
+    *region = &ring->data[offset];
+
+    return used < to_end ? used : to_end;
+}
+
+void pcm_ring_commit_read(PCM_Ring *ring, uint32_t length)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, tail + length, memory_order_release);
+}
+
+uint32_t pcm_ring_used(PCM_Ring *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+uint32_t pcm_ring_free(PCM_Ring *ring)
+{
+    return ring->size - pcm_ring_used(ring);
+}
+
+uint32_t pcm_ring_write_count(PCM_Ring *ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_relaxed);
+}
+
+uint32_t pcm_ring_read_count(PCM_Ring *ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
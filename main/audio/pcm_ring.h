@@ -0,0 +1,75 @@
+#ifndef PCM_RING_H
+#define PCM_RING_H
+
+#include <esp_err.h>
+#include <stdatomic.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Lock free ring of PCM bytes between exactly one writer & one reader, e.g. the card reader task & the output task.
+ * Neither side ever blocks or takes a lock: each owns one index & only reads the other's.
+ * Instead of copying, a side asks for the contiguous region it may use, fills or drains it in place
+ * (a multi-sector read from the card, a DMA out to I2S) & commits how much it used.
+ */
+
+// Storage alignment, one cache line. Also fine for DMA, which needs words
+#define PCM_RING_ALIGNMENT 32
+
+typedef struct
+{
+    uint8_t *data;
+    uint32_t size; // Power of two
+    uint32_t mask;
+
+    // Free running byte counts, wrap at 2^32. Each on its own cache line so the sides don't fight over one
+    _Alignas(PCM_RING_ALIGNMENT) atomic_uint head; // Written, owned by the writer
+    _Alignas(PCM_RING_ALIGNMENT) atomic_uint tail; // Read, owned by the reader
+} PCM_Ring;
+
+/**
+ * Set up a ring over `storage`, `size` must be a power of two & `storage` aligned to PCM_RING_ALIGNMENT.
+ */
+esp_err_t pcm_ring_init(PCM_Ring *ring, uint8_t *storage, uint32_t size);
+
+/**
+ * Empty the ring, the next write lands `offset` bytes into the storage. Lining the ring up with where
+ * the file's sectors start keeps every region the writer gets, even across the wrap, made of whole sectors.
+ * Only while neither side is using it.
+ */
+void pcm_ring_reset(PCM_Ring *ring, uint32_t offset);
+
+/**
+ * Writer: contiguous free region at the head, returns its length (0 when full).
+ */
+uint32_t pcm_ring_acquire_write(PCM_Ring *ring, uint8_t **region);
+
+/**
+ * Writer: publish `length` bytes of the acquired region to the reader.
+ */
+void pcm_ring_commit_write(PCM_Ring *ring, uint32_t length);
+
+/**
+ * Reader: contiguous filled region at the tail, returns its length (0 when empty).
+ */
+uint32_t pcm_ring_acquire_read(PCM_Ring *ring, const uint8_t **region);
+
+/**
+ * Reader: hand `length` bytes of the acquired region back to the writer.
+ */
+void pcm_ring_commit_read(PCM_Ring *ring, uint32_t length);
+
+// Bytes waiting to be read, a snapshot from either side
+uint32_t pcm_ring_used(PCM_Ring *ring);
+
+uint32_t pcm_ring_free(PCM_Ring *ring);
+
+/**
+ * Free running byte positions, wrapping at 2^32. Tell where in the stream a side is,
+ * e.g. to mark where one track ends & the next begins. Writer & reader respectively.
+ */
+uint32_t pcm_ring_write_count(PCM_Ring *ring);
+
+uint32_t pcm_ring_read_count(PCM_Ring *ring);
+
+#endif
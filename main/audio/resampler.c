@@ -0,0 +1,186 @@
+#include "resampler.h"
+
+#include <string.h>
+#include "esp_log.h"
+
+#include "resampler_tables.h"
+
+static const char *TAG = "RESAMPLER";
+
+esp_err_t resampler_init(Resampler *resampler, Resampler_Quality quality, uint32_t input_rate, uint32_t output_rate, uint32_t channels)
+{
+    if (channels == 0 || channels > RESAMPLER_MAX_CHANNELS || output_rate == 0 ||
+        input_rate == 0 || input_rate > output_rate * RESAMPLER_MAX_RATIO)
+    {
+        ESP_LOGE(TAG, "Can't go from %d Hz to %d Hz", (unsigned int)input_rate, (unsigned int)output_rate);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint32_t zero_crossings;
+
+    switch (quality)
+    {
+    case RESAMPLER_QUALITY_LOW:
+        resampler->table = resampler_low_table;
+        zero_crossings = RESAMPLER_LOW_ZERO_CROSSINGS;
+        break;
+    case RESAMPLER_QUALITY_MEDIUM:
+        resampler->table = resampler_medium_table;
+        zero_crossings = RESAMPLER_MEDIUM_ZERO_CROSSINGS;
+        break;
+    default:
+        resampler->table = resampler_high_table;
+        zero_crossings = RESAMPLER_HIGH_ZERO_CROSSINGS;
+        break;
+    }
+
+    resampler->channels = channels;
+    resampler->input_rate = input_rate;
+    resampler->output_rate = output_rate;
+    resampler->table_end = (zero_crossings * RESAMPLER_TABLE_OVERSAMPLE) << 16;
+
+    // Going down the prototype is stretched by output/input, both in time & the taps it covers
+    if (input_rate > output_rate)
+    {
+        resampler->scale = (uint32_t)(((uint64_t)RESAMPLER_TABLE_OVERSAMPLE << 16) * output_rate / input_rate);
+        resampler->gain = (int32_t)(((uint64_t)output_rate << 15) / input_rate);
+        resampler->reach = (zero_crossings * input_rate + output_rate - 1) / output_rate;
+    }
+    else
+    {
+        resampler->scale = RESAMPLER_TABLE_OVERSAMPLE << 16;
+        resampler->gain = 1 << 15;
+        resampler->reach = zero_crossings;
+    }
+
+    uint64_t step = ((uint64_t)input_rate << 32) / output_rate;
+
+    resampler->step = (uint32_t)(step >> 32);
+    resampler->step_fraction = (uint32_t)step;
+
+    // Silence before the first frame, so the first output sits on it with a full window
+    memset(resampler->buffer, 0, sizeof(resampler->buffer));
+    resampler->buffered = resampler->reach - 1;
+    resampler->base = resampler->reach - 1;
+    resampler->fraction = 0;
+
+    ESP_LOGI(TAG, "%d Hz -> %d Hz, %d taps", (unsigned int)input_rate, (unsigned int)output_rate, (unsigned int)(2 * resampler->reach));
+
+    return ESP_OK;
+}
+
+uint32_t resampler_acquire_input(Resampler *resampler, int32_t **input)
+{
+    // Drop what no output will need again, the left side of the next window is the oldest kept
+    uint32_t oldest = resampler->base - (resampler->reach - 1);
+
+    if (oldest > 0)
+    {
+        uint32_t kept = resampler->buffered - oldest;
+
+        memmove(resampler->buffer, &resampler->buffer[oldest * resampler->channels], kept * resampler->channels * sizeof(int32_t));
+        resampler->buffered = kept;
+        resampler->base -= oldest;
+    }
+
+    *input = &resampler->buffer[resampler->buffered * resampler->channels];
+
+    return RESAMPLER_BUFFER_FRAMES - resampler->buffered;
+}
+
+void resampler_commit_input(Resampler *resampler, uint32_t frames)
+{
+    resampler->buffered += frames;
+}
+
+// Filter value at a Q16 table position, between two table points
+static inline int32_t coefficient(const int32_t *table, uint32_t position)
+{
+    uint32_t index = position >> 16;
+    int32_t low = table[index];
+
+    return low + (int32_t)(((int64_t)(table[index + 1] - low) * (position & 0xFFFF)) >> 16);
+}
+
+static inline int32_t saturate(int64_t value)
+{
+    if (value > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+
+    if (value < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+
+    return (int32_t)value;
+}
+
+uint32_t resampler_read(Resampler *resampler, int32_t *output, uint32_t frames)
+{
+    const int32_t *table = resampler->table;
+    uint32_t channels = resampler->channels;
+    uint32_t produced = 0;
+
+    // The right side of the window has to be in
+    while (produced < frames && resampler->base + resampler->reach < resampler->buffered)
+    {
+        int64_t accumulators[RESAMPLER_MAX_CHANNELS] = {0};
+        uint32_t fraction16 = resampler->fraction >> 16;
+
+        // Left: frames at base, base - 1... at distance fraction, fraction + 1...
+        uint32_t position = (uint32_t)(((uint64_t)fraction16 * resampler->scale) >> 16);
+        const int32_t *frame = &resampler->buffer[resampler->base * channels];
+
+        for (; position < resampler->table_end; position += resampler->scale, frame -= channels)
+        {
+            int32_t c = coefficient(table, position);
+
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                accumulators[channel] += (int64_t)frame[channel] * c;
+            }
+        }
+
+        // Right: frames at base + 1... at distance 1 - fraction, 2 - fraction...
+        position = (uint32_t)(((uint64_t)(65536 - fraction16) * resampler->scale) >> 16);
+        frame = &resampler->buffer[(resampler->base + 1) * channels];
+
+        for (; position < resampler->table_end; position += resampler->scale, frame += channels)
+        {
+            int32_t c = coefficient(table, position);
+
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                accumulators[channel] += (int64_t)frame[channel] * c;
+            }
+        }
+
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            int64_t value = accumulators[channel] >> 28;
+
+            if (resampler->gain != 1 << 15)
+            {
+                value = (value * resampler->gain) >> 15;
+            }
+
+            *output++ = saturate(value);
+        }
+
+        produced++;
+
+        uint32_t fraction = resampler->fraction + resampler->step_fraction;
+
+        resampler->base += resampler->step + (fraction < resampler->fraction);
+        resampler->fraction = fraction;
+    }
+
+    return produced;
+}
+
+uint32_t resampler_latency(Resampler *resampler)
+{
+    return resampler->reach;
+}
@@ -0,0 +1,78 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Sample rate conversion of 32 bit PCM, any input rate to any output rate, so the I2S clock never changes between tracks.
+ * Every output sample is a windowed sinc over the input around it, the filter taken from a finely sampled
+ * prototype (tools/gen_resampler_tables.py) & linearly interpolated for the exact phase. When going down in rate
+ * the prototype is stretched, so the cutoff follows the output's Nyquist & nothing aliases.
+ * Positions are fixed point, coefficients Q28, accumulation 64 bit, no floating point per sample.
+ *
+ * Input goes straight into the resampler's own history buffer (acquire/commit), output is read out of it.
+ */
+
+typedef enum
+{
+    RESAMPLER_QUALITY_LOW = 0, // 8 taps up, ~10% passband lost
+    RESAMPLER_QUALITY_MEDIUM,  // 16 taps
+    RESAMPLER_QUALITY_HIGH,    // 32 taps, 48 kHz to 44.1 kHz: -0.6 dB at 19 kHz, -2.4 dB at 20 kHz
+} Resampler_Quality;
+
+#define RESAMPLER_MAX_CHANNELS 2
+
+// Input rates up to 4x the output, e.g. 176.4 kHz into the 44.1 kHz output. Taps grow with the ratio when going down
+#define RESAMPLER_MAX_RATIO 4
+
+// History kept in frames: the widest filter both sides plus room for new input
+#define RESAMPLER_BUFFER_FRAMES (2 * 16 * RESAMPLER_MAX_RATIO + 256)
+
+typedef struct
+{
+    uint32_t channels;
+    uint32_t input_rate;
+    uint32_t output_rate;
+
+    const int32_t *table;
+    uint32_t table_end; // Q16 table position where the filter is 0
+    uint32_t scale;     // Q16 table points per input sample, the prototype's stretch
+    int32_t gain;       // Q15 output gain making up for the stretch, 1 going up
+    uint32_t reach;     // Input frames taken on each side of an output
+
+    // Output position: frame `base` of the buffer plus `fraction` (Q32) towards the next one
+    uint32_t base;
+    uint32_t fraction;
+    uint32_t step;          // Whole input frames per output
+    uint32_t step_fraction; // & the Q32 rest
+
+    int32_t buffer[RESAMPLER_BUFFER_FRAMES * RESAMPLER_MAX_CHANNELS];
+    uint32_t buffered; // Frames in `buffer`
+} Resampler;
+
+/**
+ * Set up for a pair of rates. The history starts as silence, the first output lines up with the first input.
+ * ESP_ERR_NOT_SUPPORTED past RESAMPLER_MAX_RATIO or RESAMPLER_MAX_CHANNELS.
+ */
+esp_err_t resampler_init(Resampler *resampler, Resampler_Quality quality, uint32_t input_rate, uint32_t output_rate, uint32_t channels);
+
+/**
+ * Room for input frames at the end of the history, returns how many fit (contiguous).
+ */
+uint32_t resampler_acquire_input(Resampler *resampler, int32_t **input);
+
+void resampler_commit_input(Resampler *resampler, uint32_t frames);
+
+/**
+ * Produce up to `frames` output frames from what is buffered, returns how many.
+ */
+uint32_t resampler_read(Resampler *resampler, int32_t *output, uint32_t frames);
+
+/**
+ * Input frames still needed past the last one given for all of it to come out, e.g. appended as silence at the end.
+ */
+uint32_t resampler_latency(Resampler *resampler);
+
+#endif
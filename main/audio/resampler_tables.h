@@ -0,0 +1,475 @@
+// Generated by tools/gen_resampler_tables.py, don't edit
+#ifndef RESAMPLER_TABLES_H
+#define RESAMPLER_TABLES_H
+
+#include "stdint.h"
+
+#define RESAMPLER_TABLE_OVERSAMPLE 128
+
+// 4 zero crossings, cutoff 0.80, Kaiser beta 5.0. Q28
+#define RESAMPLER_LOW_ZERO_CROSSINGS 4
+static const int32_t resampler_low_table[514] = {
+    214748365, 214732737, 214685858, 214607741, 214498411, 214357899, 214186249, 213983511,
+    213749745, 213485023, 213189422, 212863032, 212505950, 212118282, 211700144, 211251662,
+    210772968, 210264206, 209725527, 209157091, 208559069, 207931637, 207274983, 206589301,
+    205874794, 205131676, 204360167, 203560493, 202732894, 201877612, 200994902, 200085022,
+    199148243, 198184839, 197195094, 196179298, 195137751, 194070758, 192978630, 191861688,
+    190720258, 189554672, 188365271, 187152400, 185916412, 184657665, 183376525, 182073360,
+    180748548, 179402470, 178035514, 176648073, 175240544, 173813330, 172366838, 170901482,
+    169417678, 167915848, 166396417, 164859814, 163306474, 161736834, 160151335, 158550420,
+    156934538, 155304140, 153659678, 152001610, 150330394, 148646492, 146950367, 145242484,
+    143523312, 141793319, 140052977, 138302757, 136543132, 134774579, 132997570, 131212583,
+    129420094, 127620580, 125814517, 124002383, 122184655, 120361808, 118534319, 116702664,
+    114867315, 113028748, 111187434, 109343843, 107498446, 105651710, 103804101, 101956083,
+    100108117, 98260662, 96414177, 94569115, 92725927, 90885062, 89046966, 87212081,
+    85380846, 83553697, 81731065, 79913378, 78101060, 76294531, 74494208, 72700500,
+    70913817, 69134559, 67363125, 65599907, 63845294, 62099668, 60363407, 58636883,
+    56920463, 55214510, 53519377, 51835417, 50162972, 48502382, 46853979, 45218089,
+    43595032, 41985123, 40388668, 38805969, 37237321, 35683011, 34143322, 32618527,
+    31108895, 29614687, 28136158, 26673554, 25227116, 23797077, 22383664, 20987095,
+    19607584, 18245334, 16900543, 15573402, 14264093, 12972793, 11699671, 10444886,
+    9208593, 7990939, 6792062, 5612095, 4451162, 3309380, 2186859, 1083700,
+    0, -1064154, -2108682, -3133511, -4138573, -5123812, -6089175, -7034617,
+    -7960102, -8865600, -9751087, -10616547, -11461971, -12287356, -13092709, -13878038,
+    -14643364, -15388710, -16114109, -16819597, -17505220, -18171029, -18817081, -19443438,
+    -20050172, -20637359, -21205079, -21753421, -22282478, -22792351, -23283145, -23754970,
+    -24207943, -24642186, -25057826, -25454996, -25833833, -26194481, -26537085, -26861801,
+    -27168783, -27458195, -27730203, -27984977, -28222693, -28443531, -28647674, -28835308,
+    -29006627, -29161824, -29301099, -29424655, -29532696, -29625432, -29703076, -29765842,
+    -29813950, -29847619, -29867075, -29872544, -29864254, -29842438, -29807328, -29759161,
+    -29698175, -29624609, -29538705, -29440706, -29330857, -29209403, -29076593, -28932675,
+    -28777899, -28612516, -28436778, -28250936, -28055243, -27849954, -27635322, -27411602,
+    -27179047, -26937913, -26688453, -26430922, -26165575, -25892664, -25612443, -25325165,
+    -25031082, -24730445, -24423504, -24110509, -23791709, -23467350, -23137679, -22802940,
+    -22463377, -22119231, -21770742, -21418149, -21061689, -20701597, -20338104, -19971443,
+    -19601842, -19229528, -18854724, -18477654, -18098536, -17717588, -17335026, -16951060,
+    -16565900, -16179753, -15792824, -15405313, -15017419, -14629336, -14241258, -13853374,
+    -13465870, -13078929, -12692731, -12307453, -11923269, -11540348, -11158858, -10778962,
+    -10400820, -10024589, -9650422, -9278470, -8908878, -8541789, -8177343, -7815675,
+    -7456917, -7101198, -6748643, -6399373, -6053506, -5711155, -5372433, -5037444,
+    -4706293, -4379079, -4055898, -3736843, -3422001, -3111459, -2805297, -2503594,
+    -2206424, -1913857, -1625962, -1342801, -1064434, -790920, -522310, -258654,
+    0, 253610, 502137, 745544, 983798, 1216869, 1444731, 1667360,
+    1884737, 2096844, 2303667, 2505196, 2701422, 2892341, 3077950, 3258251,
+    3433248, 3602946, 3767355, 3926487, 4080356, 4228980, 4372379, 4510574,
+    4643591, 4771457, 4894200, 5011853, 5124450, 5232027, 5334622, 5432275,
+    5525030, 5612929, 5696020, 5774351, 5847972, 5916934, 5981291, 6041097,
+    6096410, 6147287, 6193788, 6235974, 6273907, 6307651, 6337270, 6362831,
+    6384401, 6402048, 6415841, 6425850, 6432147, 6434802, 6433890, 6429483,
+    6421655, 6410481, 6396037, 6378397, 6357639, 6333839, 6307074, 6277421,
+    6244958, 6209763, 6171913, 6131487, 6088563, 6043218, 5995532, 5945582,
+    5893445, 5839200, 5782925, 5724695, 5664590, 5602684, 5539054, 5473776,
+    5406926, 5338578, 5268807, 5197686, 5125288, 5051687, 4976953, 4901159,
+    4824374, 4746669, 4668111, 4588769, 4508710, 4428001, 4346707, 4264892,
+    4182620, 4099953, 4016952, 3933679, 3850193, 3766552, 3682813, 3599033,
+    3515267, 3431568, 3347990, 3264583, 3181400, 3098488, 3015896, 2933672,
+    2851860, 2770505, 2689650, 2609338, 2529609, 2450503, 2372058, 2294312,
+    2217299, 2141054, 2065612, 1991003, 1917259, 1844409, 1772482, 1701505,
+    1631503, 1562501, 1494523, 1427590, 1361725, 1296945, 1233271, 1170720,
+    1109307, 1049048, 989957, 932047, 875328, 819813, 765510, 712427,
+    660573, 609953, 560573, 512436, 465546, 419905, 375515, 332375,
+    290485, 249844, 210449, 172297, 135383, 99702, 65250, 32018,
+    0, -30813, -60429, -88858, -116111, -142198, -167131, -190923,
+    -213586, -235134, -255580, -274940, -293228, -310461, -326653, -341822,
+    -355985, -369159, -381362, -392612, -402927, -412327, -420830, -428456,
+    -435225, -441156, -446270, -450587, -454127, -456911, -458961, -460296,
+    0, 0,
+};
+
+// 8 zero crossings, cutoff 0.90, Kaiser beta 7.0. Q28
+#define RESAMPLER_MEDIUM_ZERO_CROSSINGS 8
+static const int32_t resampler_medium_table[1026] = {
+    241591910, 241571518, 241510346, 241408414, 241265755, 241082415, 240858451, 240593935,
+    240288951, 239943596, 239557980, 239132225, 238666467, 238160854, 237615546, 237030717,
+    236406553, 235743250, 235041021, 234300087, 233520683, 232703056, 231847465, 230954181,
+    230023487, 229055675, 228051053, 227009937, 225932656, 224819548, 223670966, 222487269,
+    221268831, 220016034, 218729272, 217408948, 216055475, 214669278, 213250790, 211800454,
+    210318724, 208806059, 207262933, 205689825, 204087222, 202455624, 200795535, 199107470,
+    197391949, 195649503, 193880668, 192085989, 190266018, 188421314, 186552440, 184659970,
+    182744480, 180806556, 178846787, 176865768, 174864100, 172842390, 170801248, 168741290,
+    166663135, 164567409, 162454739, 160325757, 158181099, 156021403, 153847311, 151659468,
+    149458520, 147245118, 145019911, 142783554, 140536701, 138280007, 136014131, 133739730,
+    131457462, 129167987, 126871963, 124570048, 122262902, 119951182, 117635544, 115316645,
+    112995139, 110671679, 108346915, 106021497, 103696070, 101371280, 99047768, 96726171,
+    94407125, 92091261, 89779209, 87471590, 85169027, 82872134, 80581522, 78297798,
+    76021564, 73753416, 71493944, 69243734, 67003366, 64773413, 62554443, 60347016,
+    58151689, 55969007, 53799514, 51643741, 49502217, 47375460, 45263982, 43168287,
+    41088871, 39026223, 36980821, 34953138, 32943636, 30952769, 28980984, 27028717,
+    25096395, 23184437, 21293252, 19423240, 17574792, 15748287, 13944096, 12162582,
+    10404095, 8668976, 6957557, 5270159, 3607093, 1968658, 355145, -1233165,
+    -2796005, -4333114, -5844246, -7329163, -8787637, -10219454, -11624407, -13002302,
+    -14352955, -15676194, -16971856, -18239789, -19479854, -20691921, -21875870, -23031595,
+    -24158997, -25257990, -26328498, -27370457, -28383812, -29368520, -30324548, -31251872,
+    -32150482, -33020376, -33861562, -34674061, -35457901, -36213123, -36939777, -37637922,
+    -38307629, -38948977, -39562057, -40146968, -40703818, -41232727, -41733823, -42207242,
+    -42653132, -43071648, -43462955, -43827225, -44164642, -44475397, -44759687, -45017722,
+    -45249716, -45455894, -45636487, -45791736, -45921887, -46027196, -46107923, -46164339,
+    -46196721, -46205350, -46190517, -46152519, -46091658, -46008243, -45902590, -45775020,
+    -45625860, -45455441, -45264102, -45052186, -44820040, -44568018, -44296476, -44005777,
+    -43696288, -43368378, -43022422, -42658798, -42277888, -41880077, -41465754, -41035310,
+    -40589140, -40127639, -39651209, -39160250, -38655166, -38136364, -37604251, -37059235,
+    -36501728, -35932141, -35350888, -34758381, -34155034, -33541264, -32917484, -32284110,
+    -31641557, -30990239, -30330572, -29662969, -28987844, -28305608, -27616673, -26921449,
+    -26220344, -25513765, -24802117, -24085804, -23365226, -22640783, -21912872, -21181886,
+    -20448216, -19712252, -18974379, -18234979, -17494432, -16753113, -16011395, -15269647,
+    -14528233, -13787514, -13047848, -12309586, -11573077, -10838666, -10106692, -9377489,
+    -8651388, -7928714, -7209787, -6494923, -5784432, -5078617, -4377780, -3682214,
+    -2992207, -2308043, -1629998, -958345, -293349, 364730, 1015639, 1659129,
+    2294959, 2922892, 3542701, 4154161, 4757055, 5351173, 5936311, 6512271,
+    7078862, 7635898, 8183201, 8720600, 9247929, 9765029, 10271749, 10767942,
+    11253470, 11728200, 12192006, 12644770, 13086378, 13516725, 13935711, 14343243,
+    14739236, 15123608, 15496288, 15857208, 16206308, 16543534, 16868839, 17182181,
+    17483526, 17772844, 18050114, 18315320, 18568452, 18809505, 19038481, 19255390,
+    19460244, 19653064, 19833875, 20002709, 20159603, 20304598, 20437744, 20559094,
+    20668706, 20766645, 20852980, 20927786, 20991141, 21043132, 21083846, 21113378,
+    21131826, 21139294, 21135890, 21121726, 21096919, 21061588, 21015860, 20959862,
+    20893727, 20817593, 20731598, 20635888, 20530608, 20415911, 20291949, 20158880,
+    20016864, 19866064, 19706646, 19538778, 19362633, 19178383, 18986205, 18786277,
+    18578780, 18363897, 18141812, 17912712, 17676785, 17434220, 17185210, 16929947,
+    16668624, 16401438, 16128584, 15850259, 15566662, 15277992, 14984448, 14686229,
+    14383536, 14076571, 13765533, 13450624, 13132044, 12809995, 12484678, 12156292,
+    11825037, 11491114, 11154720, 10816054, 10475314, 10132696, 9788395, 9442605,
+    9095521, 8747334, 8398234, 8048411, 7698053, 7347345, 6996473, 6645619,
+    6294964, 5944687, 5594966, 5245974, 4897885, 4550869, 4205096, 3860731,
+    3517937, 3176877, 2837709, 2500589, 2165671, 1833105, 1503040, 1175622,
+    850992, 529291, 210655, -104782, -416889, -725538, -1030605, -1331968,
+    -1629509, -1923112, -2212666, -2498061, -2779192, -3055958, -3328258, -3595998,
+    -3859085, -4117431, -4370949, -4619558, -4863179, -5101737, -5335160, -5563379,
+    -5786329, -6003950, -6216182, -6422970, -6624265, -6820017, -7010181, -7194718,
+    -7373589, -7546759, -7714198, -7875878, -8031775, -8181866, -8326136, -8464568,
+    -8597152, -8723879, -8844745, -8959748, -9068888, -9172171, -9269604, -9361197,
+    -9446964, -9526920, -9601086, -9669484, -9732138, -9789076, -9840330, -9885931,
+    -9925916, -9960323, -9989194, -10012571, -10030502, -10043034, -10050219, -10052109,
+    -10048759, -10040228, -10026576, -10007863, -9984154, -9955515, -9922015, -9883721,
+    -9840707, -9793045, -9740811, -9684081, -9622933, -9557448, -9487707, -9413792,
+    -9335788, -9253780, -9167854, -9078100, -8984604, -8887459, -8786754, -8682581,
+    -8575034, -8464207, -8350193, -8233088, -8112987, -7989988, -7864186, -7735680,
+    -7604567, -7470946, -7334915, -7196572, -7056018, -6913349, -6768667, -6622069,
+    -6473656, -6323526, -6171778, -6018510, -5863822, -5707811, -5550575, -5392212,
+    -5232818, -5072491, -4911325, -4749417, -4586861, -4423751, -4260180, -4096241,
+    -3932026, -3767626, -3603130, -3438628, -3274207, -3109955, -2945958, -2782300,
+    -2619066, -2456339, -2294199, -2132726, -1972001, -1812100, -1653101, -1495077,
+    -1338103, -1182252, -1027593, -874197, -722131, -571462, -422256, -274574,
+    -128480, 15966, 158706, 299683, 438840, 576124, 711482, 844865,
+    976222, 1105507, 1232673, 1357678, 1480478, 1601033, 1719304, 1835254,
+    1948848, 2060051, 2168832, 2275159, 2379006, 2480343, 2579147, 2675393,
+    2769060, 2860128, 2948577, 3034391, 3117555, 3198055, 3275879, 3351017,
+    3423460, 3493200, 3560234, 3624555, 3686162, 3745054, 3801232, 3854698,
+    3905455, 3953508, 3998864, 4041531, 4081518, 4118836, 4153498, 4185515,
+    4214904, 4241680, 4265860, 4287464, 4306510, 4323020, 4337016, 4348521,
+    4357560, 4364158, 4368342, 4370139, 4369578, 4366688, 4361500, 4354045,
+    4344356, 4332466, 4318409, 4302220, 4283934, 4263588, 4241219, 4216865,
+    4190563, 4162354, 4132277, 4100372, 4066679, 4031241, 3994099, 3955295,
+    3914871, 3872871, 3829339, 3784317, 3737851, 3689983, 3640759, 3590224,
+    3538422, 3485399, 3431199, 3375869, 3319453, 3261997, 3203547, 3144147,
+    3083844, 3022683, 2960708, 2897966, 2834502, 2770359, 2705584, 2640220,
+    2574312, 2507903, 2441038, 2373760, 2306113, 2238138, 2169878, 2101376,
+    2032674, 1963811, 1894829, 1825769, 1756671, 1687572, 1618514, 1549533,
+    1480667, 1411955, 1343432, 1275134, 1207097, 1139356, 1071945, 1004898,
+    938246, 872024, 806262, 740990, 676240, 612041, 548422, 485409,
+    423032, 361317, 300288, 239972, 180393, 121574, 63539, 6308,
+    -50096, -105652, -160342, -214147, -267047, -319026, -370067, -420154,
+    -469273, -517408, -564546, -610675, -655782, -699857, -742888, -784867,
+    -825784, -865631, -904400, -942086, -978681, -1014182, -1048582, -1081879,
+    -1114069, -1145151, -1175121, -1203980, -1231727, -1258362, -1283887, -1308302,
+    -1331611, -1353816, -1374921, -1394929, -1413846, -1431677, -1448428, -1464105,
+    -1478716, -1492267, -1504768, -1516226, -1526650, -1536051, -1544438, -1551823,
+    -1558215, -1563626, -1568069, -1571554, -1574097, -1575708, -1576402, -1576192,
+    -1575093, -1573119, -1570284, -1566605, -1562096, -1556772, -1550651, -1543747,
+    -1536078, -1527660, -1518510, -1508645, -1498082, -1486838, -1474932, -1462380,
+    -1449201, -1435412, -1421032, -1406078, -1390569, -1374524, -1357960, -1340895,
+    -1323349, -1305339, -1286884, -1268003, -1248713, -1229034, -1208982, -1188578,
+    -1167838, -1146781, -1125425, -1103788, -1081887, -1059741, -1037367, -1014782,
+    -992004, -969049, -945936, -922680, -899299, -875808, -852224, -828564,
+    -804842, -781075, -757277, -733465, -709653, -685856, -662088, -638363,
+    -614696, -591099, -567588, -544173, -520869, -497688, -474643, -451744,
+    -429005, -406436, -384048, -361853, -339861, -318081, -296524, -275200,
+    -254117, -233285, -212712, -192407, -172377, -152630, -133174, -114016,
+    -95162, -76619, -58393, -40490, -22914, -5672, 11231, 27792,
+    44006, 59869, 75377, 90528, 105317, 119743, 133803, 147494,
+    160815, 173764, 186340, 198541, 210368, 221819, 232895, 243595,
+    253919, 263868, 273443, 282645, 291475, 299934, 308025, 315749,
+    323107, 330104, 336740, 343020, 348945, 354519, 359745, 364628,
+    369169, 373374, 377246, 380790, 384009, 386909, 389493, 391767,
+    393735, 395403, 396775, 397857, 398654, 399171, 399414, 399389,
+    399102, 398557, 397761, 396720, 395439, 393926, 392185, 390223,
+    388046, 385661, 383073, 380289, 377315, 374158, 370823, 367317,
+    363646, 359817, 355836, 351709, 347442, 343042, 338515, 333867,
+    329104, 324232, 319257, 314186, 309024, 303778, 298452, 293054,
+    287588, 282060, 276476, 270842, 265163, 259443, 253690, 247906,
+    242099, 236273, 230432, 224583, 218728, 212874, 207024, 201183,
+    195356, 189546, 183759, 177997, 172265, 166566, 160905, 155285,
+    149709, 144181, 138704, 133282, 127917, 122611, 117369, 112193,
+    107085, 102048, 97084, 92196, 87385, 82654, 78004, 73438,
+    68957, 64562, 60255, 56038, 51912, 47877, 43936, 40088,
+    36335, 32677, 29116, 25651, 22284, 19014, 15841, 12767,
+    9790, 6912, 4131, 1448, -1137, -3625, -6017, -8313,
+    -10512, -12617, -14628, -16545, -18370, -20103, -21745, -23298,
+    -24762, -26138, -27429, -28634, -29756, -30796, -31755, -32635,
+    -33436, -34162, -34812, -35390, -35895, -36331, -36699, -37001,
+    0, 0,
+};
+
+// 16 zero crossings, cutoff 0.95, Kaiser beta 9.0. Q28
+#define RESAMPLER_HIGH_ZERO_CROSSINGS 16
+static const int32_t resampler_high_table[2050] = {
+    255013683, 254990319, 254920235, 254803454, 254640015, 254429973, 254173398, 253870377,
+    253521010, 253125414, 252683721, 252196080, 251662653, 251083618, 250459170, 249789515,
+    249074879, 248315498, 247511628, 246663535, 245771503, 244835828, 243856822, 242834812,
+    241770136, 240663150, 239514220, 238323729, 237092071, 235819655, 234506903, 233154250,
+    231762142, 230331041, 228861420, 227353763, 225808569, 224226346, 222607615, 220952910,
+    219262773, 217537761, 215778438, 213985382, 212159179, 210300427, 208409732, 206487711,
+    204534991, 202552207, 200540004, 198499034, 196429959, 194333449, 192210182, 190060842,
+    187886124, 185686725, 183463353, 181216722, 178947550, 176656563, 174344493, 172012075,
+    169660051, 167289169, 164900178, 162493835, 160070898, 157632131, 155178299, 152710173,
+    150228524, 147734126, 145227757, 142710196, 140182222, 137644616, 135098162, 132543643,
+    129981841, 127413540, 124839524, 122260575, 119677476, 117091007, 114501947, 111911075,
+    109319165, 106726992, 104135325, 101544933, 98956581, 96371029, 93789036, 91211355,
+    88638734, 86071919, 83511650, 80958660, 78413680, 75877432, 73350636, 70834001,
+    68328234, 65834032, 63352087, 60883084, 58427699, 55986602, 53560453, 51149906,
+    48755606, 46378188, 44018281, 41676502, 39353462, 37049758, 34765983, 32502715,
+    30260525, 28039972, 25841608, 23665970, 21513586, 19384974, 17280641, 15201080,
+    13146776, 11118201, 9115815, 7140065, 5191390, 3270213, 1376946, -488011,
+    -2324271, -4131458, -5909211, -7657180, -9375029, -11062433, -12719083, -14344680,
+    -15938941, -17501594, -19032380, -20531056, -21997390, -23431163, -24832172, -26200225,
+    -27535144, -28836765, -30104938, -31339525, -32540403, -33707460, -34840601, -35939741,
+    -37004811, -38035754, -39032527, -39995099, -40923455, -41817590, -42677514, -43503249,
+    -44294832, -45052310, -45775746, -46465213, -47120799, -47742602, -48330735, -48885322,
+    -49406499, -49894415, -50349232, -50771120, -51160266, -51516864, -51841123, -52133261,
+    -52393509, -52622107, -52819307, -52985373, -53120577, -53225204, -53299547, -53343910,
+    -53358608, -53343964, -53300311, -53227992, -53127358, -52998770, -52842597, -52659217,
+    -52449016, -52212389, -51949737, -51661470, -51348006, -51009770, -50647193, -50260713,
+    -49850776, -49417834, -48962343, -48484767, -47985577, -47465245, -46924253, -46363085,
+    -45782231, -45182185, -44563445, -43926514, -43271899, -42600108, -41911655, -41207056,
+    -40486831, -39751500, -39001588, -38237621, -37460127, -36669635, -35866677, -35051784,
+    -34225489, -33388325, -32540828, -31683531, -30816969, -29941674, -29058182, -28167023,
+    -27268731, -26363835, -25452864, -24536346, -23614806, -22688768, -21758752, -20825278,
+    -19888859, -18950011, -18009241, -17067056, -16123959, -15180448, -14237018, -13294160,
+    -12352359, -11412098, -10473853, -9538095, -8605292, -7675904, -6750388, -5829193,
+    -4912765, -4001540, -3095952, -2196427, -1303382, -417232, 461618, 1332769,
+    2195829, 3050414, 3896145, 4732653, 5559576, 6376558, 7183253, 7979323,
+    8764435, 9538267, 10300505, 11050841, 11788979, 12514629, 13227510, 13927349,
+    14613884, 15286858, 15946027, 16591154, 17222009, 17838375, 18440041, 19026806,
+    19598478, 20154874, 20695821, 21221155, 21730720, 22224369, 22701967, 23163386,
+    23608507, 24037222, 24449430, 24845041, 25223972, 25586152, 25931518, 26260015,
+    26571598, 26866231, 27143887, 27404547, 27648202, 27874852, 28084505, 28277178,
+    28452896, 28611693, 28753613, 28878705, 28987030, 29078654, 29153654, 29212113,
+    29254123, 29279783, 29289201, 29282492, 29259777, 29221188, 29166860, 29096939,
+    29011576, 28910930, 28795165, 28664453, 28518974, 28358911, 28184457, 27995808,
+    27793169, 27576747, 27346758, 27103423, 26846968, 26577624, 26295627, 26001218,
+    25694644, 25376156, 25046009, 24704462, 24351780, 23988230, 23614084, 23229618,
+    22835110, 22430843, 22017102, 21594175, 21162355, 20721935, 20273211, 19816483,
+    19352052, 18880221, 18401295, 17915581, 17423386, 16925020, 16420795, 15911021,
+    15396012, 14876080, 14351539, 13822703, 13289887, 12753404, 12213569, 11670695,
+    11125097, 10577085, 10026973, 9475071, 8921689, 8367136, 7811718, 7255742,
+    6699511, 6143326, 5587489, 5032297, 4478045, 3925027, 3373533, 2823852,
+    2276267, 1731062, 1188514, 648901, 112494, -420438, -949629, -1474819,
+    -1995748, -2512163, -3023815, -3530457, -4031848, -4527752, -5017934, -5502168,
+    -5980230, -6451900, -6916966, -7375217, -7826450, -8270466, -8707070, -9136075,
+    -9557296, -9970555, -10375680, -10772503, -11160863, -11540603, -11911572, -12273625,
+    -12626623, -12970433, -13304926, -13629980, -13945479, -14251313, -14547377, -14833572,
+    -15109806, -15375992, -15632049, -15877901, -16113481, -16338724, -16553574, -16757980,
+    -16951896, -17135282, -17308106, -17470340, -17621962, -17762957, -17893313, -18013027,
+    -18122101, -18220541, -18308360, -18385578, -18452217, -18508308, -18553885, -18588990,
+    -18613668, -18627971, -18631955, -18625681, -18609218, -18582636, -18546013, -18499431,
+    -18442977, -18376742, -18300823, -18215321, -18120341, -18015993, -17902392, -17779657,
+    -17647910, -17507279, -17357894, -17199891, -17033408, -16858589, -16675578, -16484528,
+    -16285589, -16078920, -15864679, -15643030, -15414140, -15178175, -14935310, -14685717,
+    -14429574, -14167060, -13898358, -13623651, -13343126, -13056970, -12765375, -12468533,
+    -12166636, -11859881, -11548464, -11232584, -10912439, -10588230, -10260160, -9928430,
+    -9593243, -9254803, -8913315, -8568984, -8222015, -7872613, -7520983, -7167332,
+    -6811865, -6454786, -6096301, -5736614, -5375928, -5014448, -4652375, -4289910,
+    -3927255, -3564608, -3202169, -2840133, -2478698, -2118055, -1758399, -1399920,
+    -1042808, -687249, -333428, 18470, 368265, 715778, 1060833, 1403254,
+    1742870, 2079512, 2413014, 2743210, 3069941, 3393047, 3712374, 4027768,
+    4339080, 4646164, 4948877, 5247078, 5540631, 5829403, 6113264, 6392086,
+    6665747, 6934128, 7197112, 7454587, 7706445, 7952581, 8192892, 8427282,
+    8655658, 8877929, 9094009, 9303817, 9507273, 9704305, 9894841, 10078815,
+    10256164, 10426832, 10590762, 10747904, 10898213, 11041645, 11178163, 11307732,
+    11430321, 11545904, 11654459, 11755967, 11850414, 11937789, 12018086, 12091302,
+    12157438, 12216499, 12268494, 12313436, 12351342, 12382231, 12406128, 12423060,
+    12433059, 12436160, 12432400, 12421823, 12404474, 12380402, 12349659, 12312302,
+    12268388, 12217981, 12161145, 12097951, 12028468, 11952773, 11870943, 11783059,
+    11689204, 11589464, 11483929, 11372690, 11255842, 11133482, 11005708, 10872623,
+    10734330, 10590937, 10442550, 10289282, 10131245, 9968553, 9801322, 9629672,
+    9453723, 9273595, 9089412, 8901300, 8709384, 8513793, 8314655, 8112100,
+    7906259, 7697266, 7485253, 7270354, 7052705, 6832440, 6609698, 6384614,
+    6157326, 5927971, 5696689, 5463618, 5228896, 4992662, 4755055, 4516213,
+    4276276, 4035382, 3793668, 3551274, 3308336, 3064991, 2821376, 2577625,
+    2333876, 2090260, 1846913, 1603966, 1361551, 1119799, 878838, 638797,
+    399803, 161981, -74545, -309651, -543216, -775121, -1005248, -1233480,
+    -1459702, -1683801, -1905666, -2125188, -2342259, -2556775, -2768631, -2977726,
+    -3183961, -3387240, -3587466, -3784548, -3978395, -4168920, -4356035, -4539659,
+    -4719709, -4896109, -5068780, -5237651, -5402650, -5563708, -5720760, -5873742,
+    -6022594, -6167257, -6307677, -6443800, -6575577, -6702959, -6825903, -6944367,
+    -7058310, -7167697, -7272494, -7372670, -7468197, -7559048, -7645201, -7726637,
+    -7803336, -7875286, -7942473, -8004889, -8062528, -8115384, -8163457, -8206748,
+    -8245262, -8279005, -8307986, -8332217, -8351713, -8366491, -8376569, -8381971,
+    -8382719, -8378842, -8370369, -8357330, -8339760, -8317696, -8291176, -8260240,
+    -8224932, -8185296, -8141381, -8093235, -8040910, -7984460, -7923939, -7859405,
+    -7790918, -7718539, -7642329, -7562355, -7478683, -7391379, -7300515, -7206161,
+    -7108391, -7007277, -6902896, -6795325, -6684642, -6570926, -6454259, -6334723,
+    -6212399, -6087373, -5959730, -5829555, -5696936, -5561960, -5424716, -5285294,
+    -5143783, -5000274, -4854858, -4707627, -4558673, -4408089, -4255968, -4102403,
+    -3947488, -3791316, -3633981, -3475577, -3316199, -3155940, -2994894, -2833155,
+    -2670817, -2507973, -2344717, -2181140, -2017336, -1853397, -1689414, -1525478,
+    -1361680, -1198110, -1034857, -872009, -709655, -547881, -386773, -226416,
+    -66896, 91705, 249304, 405820, 561173, 715283, 868073, 1019466,
+    1169387, 1317760, 1464513, 1609575, 1752876, 1894345, 2033917, 2171525,
+    2307104, 2440592, 2571927, 2701049, 2827900, 2952423, 3074564, 3194269,
+    3311486, 3426165, 3538257, 3647718, 3754500, 3858563, 3959863, 4058362,
+    4154022, 4246807, 4336683, 4423617, 4507580, 4588542, 4666478, 4741361,
+    4813169, 4881881, 4947477, 5009940, 5069255, 5125407, 5178384, 5228177,
+    5274777, 5318177, 5358374, 5395364, 5429145, 5459720, 5487091, 5511261,
+    5532238, 5550028, 5564642, 5576090, 5584386, 5589544, 5591581, 5590515,
+    5586365, 5579152, 5568900, 5555631, 5539374, 5520154, 5498000, 5472943,
+    5445015, 5414249, 5380679, 5344341, 5305273, 5263512, 5219100, 5172076,
+    5122483, 5070364, 5015764, 4958729, 4899305, 4837540, 4773483, 4707183,
+    4638692, 4568061, 4495343, 4420590, 4343858, 4265200, 4184673, 4102333,
+    4018238, 3932444, 3845009, 3755994, 3665457, 3573458, 3480058, 3385316,
+    3289294, 3192054, 3093656, 2994164, 2893639, 2792144, 2689741, 2586493,
+    2482462, 2377711, 2272304, 2166303, 2059770, 1952768, 1845361, 1737609,
+    1629576, 1521322, 1412911, 1304402, 1195858, 1087338, 978903, 870614,
+    762528, 654706, 547205, 440083, 333398, 227206, 121564, 16526,
+    -87853, -191518, -294417, -396497, -497706, -597994, -697310, -795606,
+    -892833, -988944, -1083892, -1177631, -1270118, -1361309, -1451161, -1539633,
+    -1626683, -1712274, -1796366, -1878921, -1959905, -2039282, -2117017, -2193079,
+    -2267434, -2340054, -2410908, -2479969, -2547209, -2612603, -2676125, -2737754,
+    -2797465, -2855240, -2911057, -2964899, -3016747, -3066587, -3114403, -3160181,
+    -3203910, -3245578, -3285175, -3322693, -3358124, -3391462, -3422701, -3451839,
+    -3478873, -3503800, -3526622, -3547338, -3565952, -3582466, -3596885, -3609214,
+    -3619461, -3627633, -3633739, -3637789, -3639795, -3639769, -3637724, -3633674,
+    -3627636, -3619625, -3609658, -3597755, -3583935, -3568217, -3550624, -3531177,
+    -3509900, -3486816, -3461951, -3435330, -3406979, -3376926, -3345199, -3311826,
+    -3276838, -3240264, -3202136, -3162485, -3121344, -3078744, -3034721, -2989307,
+    -2942538, -2894449, -2845075, -2794453, -2742619, -2689611, -2635465, -2580220,
+    -2523915, -2466586, -2408275, -2349019, -2288858, -2227833, -2165982, -2103346,
+    -2039966, -1975882, -1911134, -1845763, -1779810, -1713317, -1646323, -1578869,
+    -1510997, -1442747, -1374160, -1305277, -1236139, -1166785, -1097256, -1027592,
+    -957833, -888019, -818190, -748383, -678640, -608997, -539494, -470168,
+    -401057, -332198, -263629, -195384, -127502, -60016, 7037, 73623,
+    139709, 205260, 270243, 334627, 398378, 461466, 523860, 585529,
+    646444, 706577, 765898, 824380, 881997, 938721, 994527, 1049391,
+    1103288, 1156194, 1208087, 1258944, 1308745, 1357469, 1405096, 1451606,
+    1496982, 1541207, 1584262, 1626133, 1666803, 1706260, 1744488, 1781475,
+    1817210, 1851680, 1884876, 1916788, 1947406, 1976723, 2004731, 2031425,
+    2056797, 2080844, 2103561, 2124945, 2144993, 2163704, 2181076, 2197109,
+    2211804, 2225162, 2237184, 2247874, 2257236, 2265272, 2271989, 2277392,
+    2281486, 2284281, 2285782, 2285998, 2284939, 2282614, 2279034, 2274209,
+    2268151, 2260873, 2252387, 2242707, 2231847, 2219821, 2206645, 2192335,
+    2176906, 2160375, 2142760, 2124078, 2104348, 2083588, 2061818, 2039056,
+    2015324, 1990641, 1965029, 1938508, 1911099, 1882826, 1853710, 1823774,
+    1793040, 1761532, 1729273, 1696286, 1662597, 1628228, 1593204, 1557550,
+    1521290, 1484449, 1447053, 1409127, 1370695, 1331783, 1292417, 1252621,
+    1212423, 1171847, 1130919, 1089665, 1048111, 1006281, 964202, 921900,
+    879399, 836725, 793905, 750962, 707922, 664810, 621650, 578469,
+    535289, 492136, 449034, 406006, 363077, 320269, 277606, 235111,
+    192807, 150717, 108861, 67263, 25943, -15076, -55775, -96132,
+    -136128, -175742, -214955, -253748, -292103, -330000, -367422, -404352,
+    -440771, -476665, -512015, -546808, -581026, -614655, -647681, -680090,
+    -711868, -743001, -773478, -803286, -832413, -860848, -888581, -915600,
+    -941897, -967462, -992286, -1016361, -1039679, -1062232, -1084015, -1105020,
+    -1125242, -1144675, -1163314, -1181156, -1198196, -1214430, -1229857, -1244473,
+    -1258276, -1271266, -1283440, -1294800, -1305343, -1315072, -1323987, -1332089,
+    -1339380, -1345862, -1351538, -1356411, -1360485, -1363764, -1366251, -1367953,
+    -1368874, -1369020, -1368397, -1367011, -1364870, -1361980, -1358349, -1353985,
+    -1348897, -1343093, -1336581, -1329373, -1321476, -1312901, -1303659, -1293760,
+    -1283215, -1272034, -1260231, -1247815, -1234800, -1221197, -1207019, -1192279,
+    -1176989, -1161163, -1144814, -1127955, -1110601, -1092765, -1074461, -1055703,
+    -1036506, -1016884, -996853, -976425, -955617, -934444, -912920, -891060,
+    -868881, -846396, -823621, -800572, -777264, -753712, -729932, -705939,
+    -681749, -657377, -632838, -608147, -583321, -558374, -533322, -508179,
+    -482961, -457683, -432359, -407005, -381635, -356264, -330905, -305575,
+    -280286, -255052, -229889, -204809, -179826, -154954, -130205, -105593,
+    -81131, -56832, -32707, -8769, 14969, 38496, 61800, 84870,
+    107695, 130263, 152565, 174589, 196325, 217764, 238895, 259709,
+    280198, 300351, 320161, 339619, 358717, 377447, 395802, 413774,
+    431356, 448542, 465326, 481700, 497660, 513199, 528313, 542997,
+    557245, 571054, 584419, 597337, 609804, 621817, 633373, 644469,
+    655104, 665274, 674979, 684216, 692985, 701284, 709114, 716473,
+    723361, 729780, 735729, 741208, 746220, 750765, 754844, 758461,
+    761615, 764311, 766550, 768335, 769670, 770557, 770999, 771002,
+    770568, 769702, 768407, 766690, 764554, 762004, 759046, 755685,
+    751926, 747776, 743240, 738325, 733035, 727379, 721363, 714992,
+    708275, 701218, 693828, 686113, 678080, 669736, 661090, 652148,
+    642919, 633411, 623632, 613589, 603291, 592747, 581964, 570952,
+    559718, 548271, 536619, 524772, 512737, 500524, 488142, 475598,
+    462902, 450062, 437087, 423986, 410768, 397441, 384015, 370497,
+    356896, 343221, 329481, 315684, 301839, 287954, 274037, 260097,
+    246142, 232181, 218221, 204270, 190337, 176430, 162555, 148722,
+    134936, 121207, 107542, 93947, 80430, 66997, 53657, 40416,
+    27280, 14256, 1351, -11429, -24078, -36590, -48959, -61179,
+    -73244, -85150, -96890, -108459, -119853, -131067, -142095, -152933,
+    -163577, -174022, -184264, -194300, -204125, -213737, -223130, -232303,
+    -241252, -249973, -258465, -266724, -274748, -282534, -290081, -297387,
+    -304449, -311266, -317836, -324158, -330230, -336053, -341624, -346944,
+    -352010, -356824, -361385, -365693, -369747, -373548, -377096, -380392,
+    -383437, -386230, -388774, -391068, -393115, -394916, -396471, -397783,
+    -398854, -399684, -400277, -400634, -400758, -400650, -400313, -399750,
+    -398964, -397956, -396731, -395290, -393638, -391776, -389710, -387441,
+    -384973, -382309, -379455, -376412, -373184, -369777, -366192, -362436,
+    -358510, -354420, -350169, -345762, -341203, -336497, -331646, -326657,
+    -321533, -316279, -310899, -305398, -299779, -294049, -288211, -282270,
+    -276230, -270097, -263874, -257566, -251179, -244716, -238182, -231582,
+    -224920, -218202, -211430, -204611, -197749, -190848, -183912, -176946,
+    -169955, -162943, -155915, -148874, -141824, -134771, -127719, -120671,
+    -113632, -106605, -99595, -92606, -85641, -78705, -71801, -64933,
+    -58105, -51320, -44582, -37894, -31260, -24682, -18165, -11712,
+    -5325, 993, 7238, 13407, 19498, 25508, 31435, 37275,
+    43026, 48687, 54253, 59725, 65098, 70371, 75542, 80609,
+    85571, 90425, 95170, 99804, 104326, 108735, 113028, 117206,
+    121266, 125207, 129030, 132732, 136312, 139772, 143108, 146322,
+    149412, 152378, 155220, 157937, 160529, 162997, 165340, 167559,
+    169653, 171622, 173467, 175189, 176787, 178263, 179616, 180848,
+    181959, 182949, 183821, 184574, 185210, 185729, 186133, 186423,
+    186600, 186666, 186620, 186466, 186205, 185837, 185364, 184788,
+    184111, 183334, 182459, 181487, 180421, 179262, 178012, 176672,
+    175245, 173733, 172138, 170461, 168705, 166872, 164963, 162981,
+    160929, 158807, 156618, 154365, 152050, 149674, 147240, 144751,
+    142207, 139613, 136969, 134278, 131542, 128764, 125946, 123090,
+    120197, 117272, 114315, 111328, 108315, 105277, 102216, 99135,
+    96035, 92920, 89790, 86648, 83496, 80337, 77171, 74002,
+    70831, 67661, 64492, 61327, 58168, 55017, 51876, 48746,
+    45629, 42527, 39442, 36375, 33328, 30302, 27300, 24322,
+    21371, 18447, 15553, 12688, 9856, 7057, 4292, 1563,
+    -1129, -3783, -6398, -8972, -11506, -13996, -16444, -18847,
+    -21205, -23518, -25783, -28001, -30170, -32291, -34362, -36383,
+    -38353, -40272, -42139, -43954, -45716, -47425, -49081, -50683,
+    -52231, -53726, -55166, -56552, -57883, -59160, -60382, -61549,
+    -62662, -63721, -64725, -65675, -66572, -67414, -68203, -68938,
+    -69621, -70251, -70828, -71354, -71828, -72252, -72624, -72947,
+    -73220, -73445, -73620, -73749, -73830, -73864, -73853, -73796,
+    -73695, -73550, -73363, -73133, -72861, -72549, -72198, -71807,
+    -71378, -70911, -70409, -69870, -69297, -68690, -68050, -67379,
+    -66676, -65943, -65180, -64390, -63572, -62728, -61858, -60964,
+    -60047, -59107, -58145, -57163, -56161, -55140, -54102, -53046,
+    -51975, -50889, -49789, -48676, -47551, -46415, -45269, -44113,
+    -42949, -41777, -40599, -39415, -38226, -37033, -35837, -34638,
+    -33438, -32238, -31037, -29838, -28640, -27444, -26252, -25064,
+    -23880, -22702, -21530, -20364, -19206, -18057, -16915, -15783,
+    -14661, -13550, -12449, -11361, -10284, -9220, -8169, -7132,
+    -6109, -5100, -4106, -3128, -2166, -1220, -290, 623,
+    1518, 2396, 3256, 4099, 4922, 5728, 6514, 7281,
+    8030, 8759, 9468, 10157, 10827, 11477, 12107, 12717,
+    13307, 13877, 14426, 14955, 15464, 15953, 16422, 16870,
+    17299, 17707, 18096, 18465, 18814, 19144, 19454, 19744,
+    20016, 20269, 20503, 20718, 20915, 21093, 21254, 21397,
+    21523, 21631, 21722, 21797, 21855, 21896, 21922, 21933,
+    21928, 21908, 21873, 21824, 21761, 21684, 21594, 21490,
+    21374, 21246, 21105, 20953, 20790, 20615, 20430, 20235,
+    20029, 19814, 19590, 19357, 19116, 18866, 18609, 18344,
+    18072, 17794, 17509, 17218, 16922, 16620, 16313, 16002,
+    15686, 15366, 15043, 14717, 14388, 14056, 13721, 13385,
+    13047, 12708, 12367, 12026, 11685, 11343, 11001, 10660,
+    10319, 9979, 9640, 9303, 8967, 8633, 8301, 7972,
+    7645, 7320, 6999, 6681, 6366, 6055, 5748, 5444,
+    5144, 4849, 4558, 4272, 3990, 3713, 3441, 3173,
+    2911, 2655, 2403, 2157, 1917, 1682, 1452, 1229,
+    1011, 799, 593, 392, 198, 10, -173, -349,
+    -519, -684, -842, -994, -1141, -1281, -1415, -1544,
+    -1666, -1783, -1894, -1999, -2099, -2192, -2281, -2363,
+    -2440, -2512, -2579, -2640, -2696, -2747, -2793, -2834,
+    0, 0,
+};
+
+#endif
@@ -0,0 +1,162 @@
+// audio_gain: ramps land on their targets without steps big enough to click, mute & balance reach zero,
+// unity leaves samples alone. Then cycles per sample (ns where there is no cycle counter), settled & ramping.
+//
+//   bench_audio_gain [million samples]
+
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "audio/audio_gain.h"
+
+#define SAMPLE_RATE 44100
+#define RAMP_FRAMES (SAMPLE_RATE * AUDIO_GAIN_RAMP_MS / 1000)
+#define TEST_FRAMES 1000
+#define BENCH_FRAMES 1024 // Per call, about an output buffer's worth
+#define LEVEL 16000
+
+static int16_t buffer[BENCH_FRAMES * 2];
+static int32_t buffer_s32[BENCH_FRAMES * 2];
+
+static void fill(int16_t value)
+{
+    for (uint32_t i = 0; i < TEST_FRAMES * 2; i++)
+    {
+        buffer[i] = value;
+    }
+}
+
+// Largest change from one frame to the next on a channel, starting from what came out before.
+// A constant level in makes any jump stand out
+static int32_t largest_step(uint32_t channel, int32_t before)
+{
+    int32_t largest = abs(buffer[channel] - before);
+
+    for (uint32_t i = 1; i < TEST_FRAMES; i++)
+    {
+        int32_t step = abs(buffer[2 * i + channel] - buffer[2 * (i - 1) + channel]);
+        largest = step > largest ? step : largest;
+    }
+
+    return largest;
+}
+
+static void test_ramps(void)
+{
+    Audio_Gain gain;
+
+    audio_gain_init(&gain);
+    audio_gain_configure(&gain, SAMPLE_RATE, 2);
+
+    fill(LEVEL);
+    audio_gain_apply_s16(&gain, buffer, TEST_FRAMES);
+    TEST_CHECK(audio_gain_is_unity(&gain));
+    TEST_CHECK_EQUAL(LEVEL, buffer[0]);
+    TEST_CHECK_EQUAL(LEVEL, buffer[TEST_FRAMES * 2 - 1]);
+
+    // Half volume is a quarter of the level, reached a ramp later in steps of about an equal share
+    audio_gain_set_volume(&gain, 50);
+    fill(LEVEL);
+    audio_gain_apply_s16(&gain, buffer, TEST_FRAMES);
+
+    int32_t expected = (LEVEL * (gain.target[0] >> 16)) >> 15;
+    int32_t share = (LEVEL - expected) / RAMP_FRAMES + 1;
+
+    TEST_CHECK_EQUAL(expected, buffer[2 * RAMP_FRAMES]);
+    TEST_CHECK_EQUAL(expected, buffer[TEST_FRAMES * 2 - 1]);
+    TEST_CHECK(largest_step(0, LEVEL) <= share);
+    TEST_CHECK(largest_step(1, LEVEL) <= share);
+
+    // Mute from there, then all the way back to full
+    audio_gain_set_mute(&gain, true);
+    fill(LEVEL);
+    audio_gain_apply_s16(&gain, buffer, TEST_FRAMES);
+    TEST_CHECK(audio_gain_is_silent(&gain));
+    TEST_CHECK_EQUAL(0, buffer[TEST_FRAMES * 2 - 1]);
+
+    audio_gain_set_mute(&gain, false);
+    audio_gain_set_volume(&gain, AUDIO_GAIN_MAX_VOLUME);
+    fill(LEVEL);
+    audio_gain_apply_s16(&gain, buffer, TEST_FRAMES);
+    TEST_CHECK(audio_gain_is_unity(&gain));
+    TEST_CHECK(largest_step(0, 0) <= LEVEL / RAMP_FRAMES + 1);
+
+    // Hard right: the left side fades to nothing, the right stays as it is
+    audio_gain_set_balance(&gain, AUDIO_GAIN_MAX_BALANCE);
+    int32_t samples[TEST_FRAMES * 2];
+
+    for (uint32_t i = 0; i < TEST_FRAMES * 2; i++)
+    {
+        samples[i] = INT32_MAX / 2;
+    }
+
+    audio_gain_apply_s32(&gain, samples, TEST_FRAMES);
+    TEST_CHECK_EQUAL(0, samples[TEST_FRAMES * 2 - 2]);
+    TEST_CHECK(samples[TEST_FRAMES * 2 - 1] >= INT32_MAX / 2 - 1);
+}
+
+// Cycles per sample over `million` million samples, a buffer at a time. Ramping flips the volume every call
+// with the ramp as long as the buffer, so every sample is on a ramp.
+static double bench(uint32_t channels, bool is_s32, bool is_ramping, uint32_t million)
+{
+    Audio_Gain gain;
+    uint32_t calls = million * 1000000 / (BENCH_FRAMES * channels);
+
+    audio_gain_init(&gain);
+    audio_gain_configure(&gain, is_ramping ? BENCH_FRAMES * 1000 / AUDIO_GAIN_RAMP_MS : SAMPLE_RATE, channels);
+    audio_gain_set_volume(&gain, 70);
+
+    // Settled before timing starts
+    audio_gain_apply_s16(&gain, buffer, BENCH_FRAMES);
+
+    uint64_t start = host_test_cycles();
+
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        if (is_ramping)
+        {
+            audio_gain_set_volume(&gain, (i & 1) ? 70 : 60);
+        }
+
+        if (is_s32)
+        {
+            audio_gain_apply_s32(&gain, buffer_s32, BENCH_FRAMES);
+        }
+        else
+        {
+            audio_gain_apply_s16(&gain, buffer, BENCH_FRAMES);
+        }
+    }
+
+    uint64_t elapsed = host_test_cycles() - start;
+
+    return calls == 0 ? 0 : (double)elapsed / ((double)calls * BENCH_FRAMES * channels);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t million = argc > 1 ? (uint32_t)atoi(argv[1]) : 64;
+
+    test_ramps();
+
+    for (uint32_t i = 0; i < BENCH_FRAMES * 2; i++)
+    {
+        buffer[i] = (int16_t)(i * 37);
+        buffer_s32[i] = (int32_t)(i * 37) << 16;
+    }
+
+    printf("%s per sample: settled, ramping\n", HOST_TEST_CYCLE_UNIT);
+
+    for (uint32_t is_s32 = 0; is_s32 < 2; is_s32++)
+    {
+        for (uint32_t channels = 1; channels <= 2; channels++)
+        {
+            double settled = bench(channels, is_s32, false, million);
+            double ramping = bench(channels, is_s32, true, million);
+
+            printf("  %s %s: %.2f, %.2f\n", is_s32 ? "s32" : "s16", channels == 2 ? "stereo" : "mono  ", settled,
+                   ramping);
+        }
+    }
+
+    return host_test_result();
+}
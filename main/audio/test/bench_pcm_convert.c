@@ -0,0 +1,197 @@
+// pcm_convert's fast kernels against their scalar references at every source & destination alignment the
+// kernels allow & every length up to a few words, then samples/s of each kernel, fast & scalar.
+//
+//   bench_pcm_convert [million samples]
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "audio/pcm_convert.h"
+
+#define MAX_LENGTH 40        // Samples (frames for mono to stereo), past a few rounds of every word loop
+#define GUARD_BYTES 16       // After the output, a kernel writing past its end shows up there
+#define BENCH_SAMPLES 4096   // Per call, about an output buffer's worth
+#define BUFFER_SIZE (BENCH_SAMPLES * 4 * 2 + 64)
+
+typedef struct
+{
+    const char *name;
+    pcm_convert_func fast;
+    pcm_convert_func scalar; // NULL when there is only the one version
+    uint32_t in_size;        // Bytes per sample (frame) in & out
+    uint32_t out_size;
+    uint32_t in_align;       // Alignment the kernel needs, in bytes
+    uint32_t out_align;
+    bool is_dithered;
+} Kernel;
+
+static const Kernel kernels[] = {
+    {"u8 to s16", pcm_u8_to_s16, pcm_u8_to_s16_scalar, 1, 2, 1, 2, false},
+    {"u8 to s32", pcm_u8_to_s32, NULL, 1, 4, 1, 4, false},
+    {"s16 to s32", pcm_s16_to_s32, pcm_s16_to_s32_scalar, 2, 4, 2, 4, false},
+    {"s24 to s32", pcm_s24_to_s32, pcm_s24_to_s32_scalar, 3, 4, 1, 4, false},
+    {"s32 to s24", pcm_s32_to_s24, pcm_s32_to_s24_scalar, 4, 3, 4, 1, false},
+    {"s32 to s16 dither", pcm_s32_to_s16_dither, pcm_s32_to_s16_dither_scalar, 4, 2, 4, 2, true},
+    {"mono to stereo s16", pcm_mono_to_stereo_s16, pcm_mono_to_stereo_s16_scalar, 2, 4, 2, 4, false},
+    {"mono to stereo s32", pcm_mono_to_stereo_s32, NULL, 4, 8, 4, 4, false},
+};
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+static void fill_random(uint8_t *data, uint32_t length, uint32_t seed)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+}
+
+static void run(const Kernel *kernel, pcm_convert_func func, const void *source, void *destination, uint32_t length)
+{
+    if (kernel->is_dithered)
+    {
+        pcm_dither_seed(12345);
+    }
+
+    func(source, destination, length);
+}
+
+// Offsets stay below a word, the kernels only care where they sit within one
+static uint32_t test_kernel(const Kernel *kernel, const uint8_t *source_base, uint8_t *fast_base, uint8_t *scalar_base)
+{
+    uint32_t mismatches = 0;
+
+    for (uint32_t in_offset = 0; in_offset < 4; in_offset += kernel->in_align)
+    {
+        for (uint32_t out_offset = 0; out_offset < 4; out_offset += kernel->out_align)
+        {
+            for (uint32_t length = 0; length <= MAX_LENGTH; length++)
+            {
+                uint32_t out_bytes = length * kernel->out_size + GUARD_BYTES;
+
+                memset(fast_base, 0xA5, out_offset + out_bytes);
+                memset(scalar_base, 0xA5, out_offset + out_bytes);
+
+                run(kernel, kernel->fast, &source_base[in_offset], &fast_base[out_offset], length);
+                run(kernel, kernel->scalar, &source_base[in_offset], &scalar_base[out_offset], length);
+
+                if (memcmp(fast_base, scalar_base, out_offset + out_bytes) != 0)
+                {
+                    fprintf(stderr, "%s: differs from the scalar version, source +%u, destination +%u, %u samples\n",
+                            kernel->name, (unsigned int)in_offset, (unsigned int)out_offset, (unsigned int)length);
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// A few known values, so fast & scalar can't agree on something wrong
+static void test_values(void)
+{
+    const uint8_t u8[] = {0x00, 0x80, 0xFF, 0x7F};
+    int16_t s16[4];
+
+    pcm_u8_to_s16_scalar(u8, s16, 4);
+    TEST_CHECK(s16[0] == -32768 && s16[1] == 0 && s16[2] == 0x7F00 && s16[3] == -256);
+
+    const uint8_t s24[] = {0x56, 0x34, 0x12, 0xFF, 0xFF, 0xFF};
+    int32_t s32[2];
+
+    pcm_s24_to_s32_scalar(s24, s32, 2);
+    TEST_CHECK(s32[0] == 0x12345600 && s32[1] == -256);
+
+    uint8_t packed[6];
+
+    pcm_s32_to_s24_scalar(s32, packed, 2);
+    TEST_CHECK(memcmp(packed, s24, sizeof(s24)) == 0);
+
+    const int16_t mono[] = {1, -2};
+    int16_t stereo[4];
+
+    pcm_mono_to_stereo_s16_scalar(mono, stereo, 2);
+    TEST_CHECK(stereo[0] == 1 && stereo[1] == 1 && stereo[2] == -2 && stereo[3] == -2);
+
+    // Dither is +-1 LSB at most, full scale doesn't overflow
+    const int32_t loud[] = {0x12340000, INT32_MAX, INT32_MIN, 0};
+    int16_t dithered[4];
+
+    for (int pass = 0; pass < 100; pass++)
+    {
+        pcm_s32_to_s16_dither_scalar(loud, dithered, 4);
+        TEST_CHECK(dithered[0] >= 0x1233 && dithered[0] <= 0x1235);
+        TEST_CHECK(dithered[1] >= 0x7FFE && dithered[2] <= -0x7FFF && dithered[3] >= -1 && dithered[3] <= 1);
+    }
+}
+
+// Million samples per second, a buffer's worth at a time
+static double bench(const Kernel *kernel, pcm_convert_func func, const uint8_t *source, uint8_t *destination,
+                    uint32_t million)
+{
+    uint32_t calls = million * 1000000 / BENCH_SAMPLES;
+    uint64_t start = host_test_now_ns();
+
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        func(source, destination, BENCH_SAMPLES);
+    }
+
+    uint64_t elapsed = host_test_now_ns() - start;
+
+    return elapsed == 0 ? 0 : (double)calls * BENCH_SAMPLES * 1e3 / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t million = argc > 1 ? (uint32_t)atoi(argv[1]) : 16;
+    uint8_t *source = aligned_alloc(32, BUFFER_SIZE);
+    uint8_t *fast = aligned_alloc(32, BUFFER_SIZE);
+    uint8_t *scalar = aligned_alloc(32, BUFFER_SIZE);
+
+    fill_random(source, BUFFER_SIZE, 1);
+
+    test_values();
+
+    for (uint32_t i = 0; i < KERNEL_COUNT; i++)
+    {
+        if (kernels[i].scalar != NULL)
+        {
+            TEST_CHECK_EQUAL(0, test_kernel(&kernels[i], source, fast, scalar));
+        }
+    }
+
+    uint32_t sink = 0;
+
+    printf("Million samples/s, %d a call:\n", BENCH_SAMPLES);
+
+    for (uint32_t i = 0; i < KERNEL_COUNT; i++)
+    {
+        const Kernel *kernel = &kernels[i];
+        double fast_rate = bench(kernel, kernel->fast, source, fast, million);
+        sink += fast[0];
+
+        if (kernel->scalar == NULL)
+        {
+            printf("  %-20s %8.0f\n", kernel->name, fast_rate);
+            continue;
+        }
+
+        double scalar_rate = bench(kernel, kernel->scalar, source, scalar, million);
+        sink += scalar[0];
+
+        printf("  %-20s %8.0f, scalar %8.0f (%.1fx)\n", kernel->name, fast_rate, scalar_rate,
+               scalar_rate > 0 ? fast_rate / scalar_rate : 0);
+    }
+
+    printf("[%02x]\n", (unsigned int)(sink & 0xFF));
+
+    free(source);
+    free(fast);
+    free(scalar);
+
+    return host_test_result();
+}
@@ -0,0 +1,238 @@
+// Resampler: SNR of a 1 kHz tone through every quality tier for the rates audio_output converts from,
+// the level of tones near the top of the passband, then cycles per output sample (ns without a cycle counter).
+//
+//   bench_resampler [output seconds]
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "audio/resampler.h"
+
+#define OUTPUT_RATE 44100
+#define TONE_HZ 1000.0
+#define AMPLITUDE (0.5 * INT32_MAX)
+#define SETTLE_FRAMES 1024   // Left out of the measurements, the window starts on silence
+#define MEASURE_FRAMES 16384
+#define BENCH_FRAMES 512     // Output frames per read, about a buffer's worth
+
+typedef struct
+{
+    uint32_t input_rate;
+    double min_snr[3]; // dB, low, medium & high
+} Rate_Case;
+
+// Measured about 60, 78-90 & 95-114 dB, the limits leave a few dB for other compilers & libm.
+// 176.4 kHz is exactly 4x, every output sits on an input frame & only the filter's stopband counts
+static const Rate_Case rate_cases[] = {
+    {48000, {56, 75, 92}},
+    {22050, {56, 75, 92}},
+    {32000, {56, 75, 92}},
+    {96000, {56, 75, 92}},
+    {176400, {56, 75, 92}},
+};
+
+// Feeds a sine at `frequency` into the resampler & collects `frames` output frames, the first channel
+static void run_tone(Resampler *resampler, uint32_t channels, double frequency, double *output, uint32_t frames)
+{
+    uint64_t input_frame = 0;
+    uint32_t produced = 0;
+    int32_t out[BENCH_FRAMES * RESAMPLER_MAX_CHANNELS];
+
+    while (produced < frames)
+    {
+        int32_t *input;
+        uint32_t room = resampler_acquire_input(resampler, &input);
+
+        for (uint32_t i = 0; i < room; i++, input_frame++)
+        {
+            double value = AMPLITUDE * sin(2 * M_PI * frequency * input_frame / resampler->input_rate);
+
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                input[i * channels + channel] = (int32_t)lrint(value);
+            }
+        }
+
+        resampler_commit_input(resampler, room);
+
+        uint32_t wanted = frames - produced < BENCH_FRAMES ? frames - produced : BENCH_FRAMES;
+        uint32_t count = resampler_read(resampler, out, wanted);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            output[produced + i] = out[i * channels];
+        }
+
+        produced += count;
+    }
+}
+
+// Least squares fit of a sine at `frequency` (amplitude & phase free), the rest is noise & distortion.
+// Returns the fitted amplitude, `snr` gets the ratio in dB
+static double fit_tone(const double *output, uint32_t frames, double frequency, double *snr)
+{
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        double s = sin(2 * M_PI * frequency * (SETTLE_FRAMES + i) / OUTPUT_RATE);
+        double c = cos(2 * M_PI * frequency * (SETTLE_FRAMES + i) / OUTPUT_RATE);
+
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += output[i] * s;
+        yc += output[i] * c;
+    }
+
+    double determinant = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / determinant;
+    double b = (yc * ss - ys * sc) / determinant;
+    double signal = 0, noise = 0;
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        double fit = a * sin(2 * M_PI * frequency * (SETTLE_FRAMES + i) / OUTPUT_RATE) +
+                     b * cos(2 * M_PI * frequency * (SETTLE_FRAMES + i) / OUTPUT_RATE);
+
+        signal += fit * fit;
+        noise += (output[i] - fit) * (output[i] - fit);
+    }
+
+    *snr = noise == 0 ? 200 : 10 * log10(signal / noise);
+
+    return sqrt(a * a + b * b);
+}
+
+static double measure(Resampler_Quality quality, uint32_t input_rate, double frequency, double *snr)
+{
+    static double output[SETTLE_FRAMES + MEASURE_FRAMES];
+    static Resampler resampler;
+
+    resampler_init(&resampler, quality, input_rate, OUTPUT_RATE, 2);
+    run_tone(&resampler, 2, frequency, output, SETTLE_FRAMES + MEASURE_FRAMES);
+
+    return fit_tone(&output[SETTLE_FRAMES], MEASURE_FRAMES, frequency, snr);
+}
+
+static void test_snr(void)
+{
+    printf("SNR of %.0f Hz, dB: low, medium, high\n", TONE_HZ);
+
+    for (size_t i = 0; i < sizeof(rate_cases) / sizeof(rate_cases[0]); i++)
+    {
+        double snr[3];
+
+        for (uint32_t quality = 0; quality < 3; quality++)
+        {
+            double level = measure(quality, rate_cases[i].input_rate, TONE_HZ, &snr[quality]);
+
+            TEST_CHECK(snr[quality] >= rate_cases[i].min_snr[quality]);
+            TEST_CHECK(fabs(20 * log10(level / AMPLITUDE)) < 0.1); // Flat there whatever the tier
+        }
+
+        printf("  %6u Hz: %5.1f, %5.1f, %5.1f\n", (unsigned int)rate_cases[i].input_rate, snr[0], snr[1], snr[2]);
+    }
+}
+
+// The high tier going down from 48 kHz: where the passband ends & that a tone past the output's Nyquist is gone
+static void test_response(void)
+{
+    const double frequencies[] = {10000, 15000, 19000, 20000, 21000};
+    const uint32_t count = sizeof(frequencies) / sizeof(frequencies[0]);
+    double levels[count];
+    double snr;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        levels[i] = 20 * log10(measure(RESAMPLER_QUALITY_HIGH, 48000, frequencies[i], &snr) / AMPLITUDE);
+    }
+
+    // Measured -0.0, -0.0, -0.6, -2.4 & -6.3 dB
+    TEST_CHECK(levels[0] > -0.1 && levels[1] > -0.1);
+    TEST_CHECK(levels[2] > -1.0);
+    TEST_CHECK(levels[3] > -3.0);
+
+    printf("High tier, 48 kHz in, dB:");
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        printf(" %.0f Hz %.1f%s", frequencies[i], levels[i], i + 1 < count ? "," : "\n");
+    }
+
+    // 30 kHz would fold back to 18.1 kHz, it must not come out at all
+    static double output[SETTLE_FRAMES + MEASURE_FRAMES];
+    static Resampler resampler;
+    double power = 0;
+
+    resampler_init(&resampler, RESAMPLER_QUALITY_HIGH, 96000, OUTPUT_RATE, 1);
+    run_tone(&resampler, 1, 30000, output, SETTLE_FRAMES + MEASURE_FRAMES);
+
+    for (uint32_t i = SETTLE_FRAMES; i < SETTLE_FRAMES + MEASURE_FRAMES; i++)
+    {
+        power += output[i] * output[i];
+    }
+
+    double level = 10 * log10(power / MEASURE_FRAMES / (AMPLITUDE * AMPLITUDE / 2) + 1e-30);
+
+    printf("High tier, 30 kHz at 96 kHz in: %.1f dB\n", level);
+    TEST_CHECK(level < -90); // Measured -96 dB
+}
+
+// Cycles per output sample of stereo noise, counting the few it takes to make the noise
+static double bench(Resampler_Quality quality, uint32_t input_rate, uint32_t seconds)
+{
+    static Resampler resampler;
+    int32_t out[BENCH_FRAMES * 2];
+    uint32_t frames = seconds * OUTPUT_RATE;
+    uint32_t produced = 0;
+    uint32_t state = 1;
+
+    resampler_init(&resampler, quality, input_rate, OUTPUT_RATE, 2);
+
+    uint64_t start = host_test_cycles();
+
+    while (produced < frames)
+    {
+        int32_t *input;
+        uint32_t room = resampler_acquire_input(&resampler, &input);
+
+        for (uint32_t i = 0; i < room * 2; i++)
+        {
+            state = state * 1103515245 + 12345;
+            input[i] = (int32_t)state >> 2;
+        }
+
+        resampler_commit_input(&resampler, room);
+        produced += resampler_read(&resampler, out, BENCH_FRAMES);
+    }
+
+    uint64_t elapsed = host_test_cycles() - start;
+
+    return (double)elapsed / ((double)produced * 2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = argc > 1 ? (uint32_t)atoi(argv[1]) : 10;
+
+    test_snr();
+    test_response();
+
+    printf("%s per output sample, stereo: low, medium, high\n", HOST_TEST_CYCLE_UNIT);
+
+    for (size_t i = 0; i < sizeof(rate_cases) / sizeof(rate_cases[0]); i++)
+    {
+        double cost[3];
+
+        for (uint32_t quality = 0; quality < 3; quality++)
+        {
+            cost[quality] = bench(quality, rate_cases[i].input_rate, seconds);
+        }
+
+        printf("  %6u Hz: %6.1f, %6.1f, %6.1f\n", (unsigned int)rate_cases[i].input_rate, cost[0], cost[1], cost[2]);
+    }
+
+    return host_test_result();
+}
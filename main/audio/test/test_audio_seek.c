@@ -0,0 +1,336 @@
+// audio_output_seek in the hour long track of the player image (make_player_image.py): half an hour ahead, back near
+// the start, to the last 300 ms, where the producer reads on into the next track, & from there back across that
+// boundary. After each seek the sink has to get the crossfade, the old position fading out under the new one, then
+// the file from data offset + frame x block align on, sample for sample. Reports how long the seek took to refill
+// the ring & start_latency_us, from the seek to its first sample at the sink.
+//
+//   test_audio_seek <player image>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "audio/wav.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_file.h"
+
+#define LONG_PATH "An hour long.wav"
+#define NEXT_PATH "ONE.WAV"
+
+#define CAPTURE_SIZE (4 * 1024 * 1024)
+#define CAPTURE_SAMPLES (CAPTURE_SIZE / sizeof(int16_t))
+
+// Compared after the crossfade, & the frames looked for to find where the new position starts
+#define COMPARED_FRAMES 2048
+#define LOCATE_FRAMES 16
+
+// After a seek returns, long enough for the crossfade & COMPARED_FRAMES to be written at the sink's pace
+#define SETTLE_MS 100
+
+// Where the old position was is looked for this far from where the last seek went
+#define OLD_SEARCH_FRAMES (5 * 44100)
+
+// Passes everything on to the image, counting reads of one sector
+typedef struct
+{
+    Block_Device image;
+    uint32_t watched_sector;
+    atomic_uint watched_reads;
+} Watching_Device;
+
+// Passes everything on to a null file sink, which keeps the time, & keeps a copy of what was written.
+// The track is 8 bit mono, so what's written is 16 bit mono
+typedef struct
+{
+    Audio_Sink_File file;
+    Audio_Sink file_sink;
+    int16_t *samples;
+    atomic_uint length; // In samples
+} Capture;
+
+static Watching_Device watching;
+static Capture capture;
+
+static FAT_File long_file;
+static WAV_Info long_info;
+static FAT_File next_file;
+static WAV_Info next_info;
+static atomic_uint opened = 0;
+
+static uint32_t last_frame = 0; // Where the last seek went, or 0 from the start
+
+static esp_err_t watching_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    if (sector <= watching.watched_sector && watching.watched_sector < sector + count)
+    {
+        atomic_fetch_add(&watching.watched_reads, 1);
+    }
+
+    return blockdev_read_many(&watching.image, sector, count, destination);
+}
+
+static esp_err_t watching_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return watching_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t watching_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t watching_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static uint32_t watching_sector_size(void *context)
+{
+    return blockdev_sector_size(&watching.image);
+}
+
+static uint32_t watching_sector_count(void *context)
+{
+    return blockdev_sector_count(&watching.image);
+}
+
+static const Block_Device_Ops watching_ops = {
+    .read = watching_read,
+    .read_many = watching_read_many,
+    .write = watching_write,
+    .write_many = watching_write_many,
+    .sector_size = watching_sector_size,
+    .sector_count = watching_sector_count,
+};
+
+static const Block_Device device = {.ops = &watching_ops, .context = &watching};
+
+static esp_err_t capture_open(void *context, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg)
+{
+    return audio_sink_open(&capture.file_sink, format, on_sent, arg);
+}
+
+static esp_err_t capture_write(void *context, const uint8_t *source, uint32_t size, uint32_t *written)
+{
+    esp_err_t err = audio_sink_write(&capture.file_sink, source, size, written);
+    uint32_t length = atomic_load(&capture.length);
+    uint32_t samples = *written / sizeof(int16_t);
+
+    if (err == ESP_OK && length + samples <= CAPTURE_SAMPLES)
+    {
+        memcpy(&capture.samples[length], source, samples * sizeof(int16_t));
+        atomic_store(&capture.length, length + samples);
+    }
+
+    return err;
+}
+
+static void capture_close(void *context)
+{
+    audio_sink_close(&capture.file_sink);
+}
+
+static uint32_t capture_buffer_size(void *context)
+{
+    return audio_sink_buffer_size(&capture.file_sink);
+}
+
+static const Audio_Sink_Ops capture_ops = {
+    .open = capture_open,
+    .write = capture_write,
+    .close = capture_close,
+    .buffer_size = capture_buffer_size,
+};
+
+// Audio output's next track function, the player image's first track once
+static bool open_next_track(FAT_File *file, WAV_Info *info)
+{
+    if (atomic_fetch_add(&opened, 1) > 0)
+    {
+        return false;
+    }
+
+    *file = next_file;
+    *info = next_info;
+
+    return true;
+}
+
+// `count` samples of the long track from `frame` on, read at data offset + frame x block align & widened to 16 bit
+// as the sink gets them
+static void read_samples(uint32_t frame, int16_t *samples, uint32_t count)
+{
+    static uint8_t bytes[OLD_SEARCH_FRAMES + LOCATE_FRAMES];
+    FAT_File file = long_file;
+    uint32_t bytes_read = 0;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_seek(&file, long_info.data_offset + frame * long_info.block_align));
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_read(&file, bytes, count, &bytes_read));
+    TEST_CHECK_EQUAL(count, bytes_read);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        samples[i] = (int16_t)((bytes[i] ^ 0x80) << 8);
+    }
+}
+
+// First index from `from` on where `count` samples of `haystack` are `needle`, or UINT32_MAX
+static uint32_t find_samples(const int16_t *haystack, uint32_t from, uint32_t length, const int16_t *needle, uint32_t count)
+{
+    for (uint32_t i = from; i + count <= length; i++)
+    {
+        if (memcmp(&haystack[i], needle, count * sizeof(int16_t)) == 0)
+        {
+            return i;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+// The crossfade's first `count` frames from `start` in the capture, the old position under the new one in Q15 as
+// audio output mixes them. The old one goes on from where the frames before it are in the file
+static bool is_crossfade(uint32_t start, const int16_t *new_samples, uint32_t count)
+{
+    static int16_t old_samples[OLD_SEARCH_FRAMES + LOCATE_FRAMES];
+
+    if (start < LOCATE_FRAMES)
+    {
+        return false;
+    }
+
+    uint32_t frames = long_info.data_size - last_frame < OLD_SEARCH_FRAMES ? long_info.data_size - last_frame : OLD_SEARCH_FRAMES;
+
+    read_samples(last_frame, old_samples, frames);
+
+    uint32_t old = find_samples(old_samples, 0, frames, &capture.samples[start - LOCATE_FRAMES], LOCATE_FRAMES);
+
+    if (old == UINT32_MAX || old + LOCATE_FRAMES + count > frames)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int64_t weight = ((int64_t)i << 15) / count;
+        int16_t mixed = (int16_t)((new_samples[i] * weight + old_samples[old + LOCATE_FRAMES + i] * (32768 - weight)) >> 15);
+
+        if (capture.samples[start + i] != mixed)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void test_seek(const char *name, uint32_t position_ms)
+{
+    static int16_t expected[AUDIO_OUTPUT_CROSSFADE_FRAMES + COMPARED_FRAMES];
+    uint32_t frame = (uint64_t)position_ms * long_info.sample_rate / 1000;
+    uint32_t from = atomic_load(&capture.length);
+    Audio_Output_Stats stats;
+
+    read_samples(frame, expected, AUDIO_OUTPUT_CROSSFADE_FRAMES + COMPARED_FRAMES);
+
+    int64_t start = esp_timer_get_time();
+
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_seek(position_ms));
+
+    uint32_t refill_us = (uint32_t)(esp_timer_get_time() - start);
+
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+
+    // Straight from the file once the crossfade is over, found after what was written before the seek
+    uint32_t length = atomic_load(&capture.length);
+    uint32_t after = find_samples(capture.samples, from, length, &expected[AUDIO_OUTPUT_CROSSFADE_FRAMES], LOCATE_FRAMES);
+
+    TEST_CHECK(after != UINT32_MAX);
+
+    if (after != UINT32_MAX)
+    {
+        uint32_t crossfade = after - AUDIO_OUTPUT_CROSSFADE_FRAMES;
+
+        TEST_CHECK(length - after >= COMPARED_FRAMES);
+        TEST_CHECK(crossfade >= from);
+        TEST_CHECK(memcmp(&capture.samples[after], &expected[AUDIO_OUTPUT_CROSSFADE_FRAMES], COMPARED_FRAMES * sizeof(int16_t)) == 0);
+        TEST_CHECK(is_crossfade(crossfade, expected, AUDIO_OUTPUT_CROSSFADE_FRAMES));
+    }
+
+    audio_output_get_stats(&stats);
+
+    printf("%s: to %u ms, frame %u, refilled in %u us, first sample at the sink after %u us\n", name, (unsigned int)position_ms,
+           (unsigned int)frame, (unsigned int)refill_us, (unsigned int)stats.start_latency_us);
+
+    last_frame = frame;
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File image;
+    static Audio_Sink sink = {.ops = &capture_ops, .context = &capture};
+
+    if (argc < 2 || blockdev_file_open(&image, argv[1], true, &watching.image) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <player image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, fat_open(&long_file, LONG_PATH));
+    TEST_CHECK_EQUAL(ESP_OK, wav_parse(&long_file, &long_info));
+    TEST_CHECK_EQUAL(ESP_OK, fat_open(&next_file, NEXT_PATH));
+    TEST_CHECK_EQUAL(ESP_OK, wav_parse(&next_file, &next_info));
+
+    TEST_CHECK_EQUAL(1, long_info.block_align);
+    TEST_CHECK_EQUAL(3600 * 1000, (uint64_t)long_info.data_size * 1000 / long_info.sample_rate);
+
+    // Past the next track's first sector, which the pre-open's header parse reads
+    uint32_t contiguous;
+    FAT_File next = next_file;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_map(&next, 2 * BLOCKDEV_SECTOR_SIZE, &watching.watched_sector, &contiguous));
+
+    capture.samples = malloc(CAPTURE_SIZE);
+    audio_sink_file_init(&capture.file, NULL, &capture.file_sink);
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_init(&sink));
+    audio_output_set_next_track(open_next_track);
+
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_start(&long_file, &long_info));
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+
+    test_seek("Half an hour ahead", 30 * 60 * 1000);
+    test_seek("Back near the start", 12345);
+
+    // 300 ms left, less than a ring: the producer reads it all & goes on into the next track
+    test_seek("Near the end", 3600 * 1000 - 300);
+
+    Audio_Output_Stats stats;
+
+    audio_output_get_stats(&stats);
+    TEST_CHECK_EQUAL(1, stats.tracks);
+    TEST_CHECK_EQUAL(1, atomic_load(&opened));
+    TEST_CHECK(atomic_load(&watching.watched_reads) > 0);
+
+    // Back to the long track's slot, the next one is kept waiting rather than opened again
+    test_seek("Back across the boundary", 1000);
+
+    audio_output_get_stats(&stats);
+    TEST_CHECK_EQUAL(1, stats.tracks);
+    TEST_CHECK_EQUAL(1, atomic_load(&opened));
+    TEST_CHECK_EQUAL(0, stats.underruns);
+
+    audio_output_stop();
+
+    free(capture.samples);
+    blockdev_file_close(&image);
+
+    return host_test_result();
+}
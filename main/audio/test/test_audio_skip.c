@@ -0,0 +1,327 @@
+// audio_output_skip from the first track of the test image, once while the second one waits opened in the other
+// slot & once with the producer already reading it past the boundary. Either way the sink has to go on with the
+// second track from its first frame, then the third, byte for byte. Which of the two it was shows in the reads of
+// a sector of the second track's data, only the producer reading on into it goes there. Reports the time from the
+// skip to its first sample at the sink.
+//
+//   test_audio_skip <test image>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "library/track_index.h"
+#include "audio/wav.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_file.h"
+
+#define OUTPUT_PATH "test_audio_skip.wav"
+#define WAV_HEADER_LENGTH 44
+#define TRACKS 3
+
+// Passes everything on to the image, counting reads of one sector
+typedef struct
+{
+    Block_Device image;
+    uint32_t watched_sector;
+    atomic_uint watched_reads;
+} Watching_Device;
+
+typedef struct
+{
+    FAT_File file; // At the start of the data
+    WAV_Info info;
+} Track;
+
+static Watching_Device watching;
+static Audio_Sink_File sink_file;
+static Track tracks[TRACKS];
+
+static uint32_t next_track = 0;
+static atomic_uint opened = 0;
+
+static esp_err_t watching_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    if (sector <= watching.watched_sector && watching.watched_sector < sector + count)
+    {
+        atomic_fetch_add(&watching.watched_reads, 1);
+    }
+
+    return blockdev_read_many(&watching.image, sector, count, destination);
+}
+
+static esp_err_t watching_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return watching_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t watching_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t watching_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static uint32_t watching_sector_size(void *context)
+{
+    return blockdev_sector_size(&watching.image);
+}
+
+static uint32_t watching_sector_count(void *context)
+{
+    return blockdev_sector_count(&watching.image);
+}
+
+static const Block_Device_Ops watching_ops = {
+    .read = watching_read,
+    .read_many = watching_read_many,
+    .write = watching_write,
+    .write_many = watching_write_many,
+    .sector_size = watching_sector_size,
+    .sector_count = watching_sector_count,
+};
+
+static const Block_Device device = {.ops = &watching_ops, .context = &watching};
+
+// Audio output's next track function, the tracks in index order from `next_track` on
+static bool open_next_track(FAT_File *file, WAV_Info *info)
+{
+    if (next_track >= TRACKS)
+    {
+        return false;
+    }
+
+    *file = tracks[next_track].file;
+    *info = tracks[next_track].info;
+    next_track++;
+    atomic_fetch_add(&opened, 1);
+
+    return true;
+}
+
+// The first TRACKS WAVs of the index, opened & parsed
+static void open_tracks(void)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < track_index_count() && count < TRACKS; i++)
+    {
+        const Track_Entry *track = track_index_get(i);
+
+        if (track->format != TRACK_FORMAT_WAV)
+        {
+            continue;
+        }
+
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_open_cluster(&tracks[count].file, track->first_cluster, track->size));
+        TEST_CHECK_EQUAL(ESP_OK, wav_parse(&tracks[count].file, &tracks[count].info));
+        count++;
+    }
+
+    TEST_CHECK_EQUAL(TRACKS, count);
+}
+
+// PCM of the tracks from `first` on, back to back
+static uint8_t *read_tracks(uint32_t first, uint32_t *length)
+{
+    uint8_t *pcm = NULL;
+
+    *length = 0;
+
+    for (uint32_t i = first; i < TRACKS; i++)
+    {
+        FAT_File file = tracks[i].file;
+        uint32_t bytes_read;
+
+        pcm = realloc(pcm, *length + tracks[i].info.data_size);
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_read(&file, &pcm[*length], tracks[i].info.data_size, &bytes_read));
+        TEST_CHECK_EQUAL(tracks[i].info.data_size, bytes_read);
+
+        *length += bytes_read;
+    }
+
+    return pcm;
+}
+
+static uint8_t *read_output(uint32_t *length)
+{
+    FILE *file = fopen(OUTPUT_PATH, "rb");
+
+    TEST_CHECK(file != NULL);
+
+    if (file == NULL)
+    {
+        *length = 0;
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file) - WAV_HEADER_LENGTH;
+    fseek(file, WAV_HEADER_LENGTH, SEEK_SET);
+
+    uint8_t *pcm = malloc(*length);
+    TEST_CHECK(fread(pcm, 1, *length, file) == *length);
+    fclose(file);
+
+    return pcm;
+}
+
+static bool is_silent(const uint8_t *pcm, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (pcm[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The sink's file is started over by the skip: silence until the ring is primed, then `expected` & silence again
+static void check_output(const uint8_t *expected, uint32_t expected_length)
+{
+    uint32_t played_length;
+    uint8_t *played = read_output(&played_length);
+    uint32_t start = 0;
+
+    // The test tracks never have a zero sample
+    while (start < played_length && played[start] == 0)
+    {
+        start++;
+    }
+
+    start -= start % 4;
+
+    TEST_CHECK(played_length - start >= expected_length);
+
+    if (played_length - start >= expected_length)
+    {
+        TEST_CHECK(memcmp(&played[start], expected, tracks[1].info.block_align) == 0);
+        TEST_CHECK(memcmp(&played[start], expected, expected_length) == 0);
+        TEST_CHECK(is_silent(&played[start + expected_length], played_length - start - expected_length));
+    }
+
+    free(played);
+}
+
+// Play the first track, skip once the sink played `skip_at` bytes of it. The second one has been opened by then,
+// its data read past the watched sector only when `is_past_boundary`
+static void test_skip(const char *name, uint32_t skip_at, bool is_past_boundary, const uint8_t *expected, uint32_t expected_length)
+{
+    Audio_Output_Stats stats;
+
+    // Nothing of the other tracks cached, the producer's reads go to the device
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+    next_track = 1;
+    atomic_store(&opened, 0);
+    atomic_store(&watching.watched_reads, 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_start(&tracks[0].file, &tracks[0].info));
+
+    while (audio_output_is_playing() && sink_file.data_bytes < skip_at)
+    {
+        vTaskDelay(1);
+    }
+
+    uint32_t played = sink_file.data_bytes;
+
+    // Still on the first track, the second one opened & read into or not
+    audio_output_get_stats(&stats);
+    TEST_CHECK_EQUAL(1, stats.tracks);
+    TEST_CHECK_EQUAL(1, atomic_load(&opened));
+    TEST_CHECK_EQUAL(is_past_boundary, atomic_load(&watching.watched_reads) > 0);
+
+    int64_t skipped_at = esp_timer_get_time();
+
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_skip());
+
+    uint32_t skip_us = (uint32_t)(esp_timer_get_time() - skipped_at);
+
+    while (audio_output_is_playing())
+    {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+
+    // The second track from its start, then the third. Nothing opened twice
+    audio_output_get_stats(&stats);
+    TEST_CHECK_EQUAL(2, stats.tracks);
+    TEST_CHECK_EQUAL(0, stats.underruns);
+    TEST_CHECK_EQUAL(2, atomic_load(&opened));
+
+    check_output(expected, expected_length);
+
+    printf("%s: skipped %u bytes into the first track, back in %u us, first sample of the next at the sink after %u us\n", name,
+           (unsigned int)played, (unsigned int)skip_us, (unsigned int)stats.start_latency_us);
+}
+
+// Skip on the last track, nothing to go on with
+static void test_skip_last(void)
+{
+    next_track = TRACKS;
+
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_start(&tracks[TRACKS - 1].file, &tracks[TRACKS - 1].info));
+    TEST_CHECK_EQUAL(ESP_ERR_NOT_FOUND, audio_output_skip());
+    TEST_CHECK(!audio_output_is_playing());
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File file;
+    static Audio_Sink sink;
+
+    if (argc < 2 || blockdev_file_open(&file, argv[1], true, &watching.image) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, track_index_init());
+    TEST_CHECK_EQUAL(ESP_OK, track_index_scan());
+
+    open_tracks();
+
+    uint32_t expected_length;
+    uint8_t *expected = read_tracks(1, &expected_length);
+
+    // Past the second track's first sector, which the pre-open's header parse reads
+    uint32_t contiguous;
+    FAT_File second = tracks[1].file;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_map(&second, 2 * BLOCKDEV_SECTOR_SIZE, &watching.watched_sector, &contiguous));
+
+    audio_sink_file_init(&sink_file, OUTPUT_PATH, &sink);
+    TEST_CHECK_EQUAL(ESP_OK, audio_output_init(&sink));
+    audio_output_set_next_track(open_next_track);
+
+    // The producer stays about a ring ahead of the sink & opens the next track AUDIO_OUTPUT_PREOPEN_SIZE before the end
+    uint32_t size = tracks[0].info.data_size;
+
+    TEST_CHECK(size > AUDIO_OUTPUT_PREOPEN_SIZE && size - AUDIO_OUTPUT_PREOPEN_SIZE < AUDIO_OUTPUT_RING_SIZE);
+
+    // Opened at the latest once the ring holds the rest of the track up to the last 32 KiB, not read yet
+    test_skip("Pre-opened", size - AUDIO_OUTPUT_PREOPEN_SIZE, false, expected, expected_length);
+
+    // Less than a ring of the first track left, the producer read all of it & went on, the sink hasn't got there
+    test_skip("Past the boundary", size - AUDIO_OUTPUT_RING_SIZE + 2 * AUDIO_OUTPUT_MIN_READ, true, expected, expected_length);
+
+    test_skip_last();
+
+    free(expected);
+    blockdev_file_close(&file);
+
+    return host_test_result();
+}
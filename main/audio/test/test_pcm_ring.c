@@ -0,0 +1,234 @@
+// pcm_ring between two threads: a writer & a reader with uneven region sizes push a byte pattern through,
+// every byte is checked on the way out. Then MB/s through the ring, the way audio_output uses it.
+//
+//   test_pcm_ring [MB]
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "audio/pcm_ring.h"
+
+#define RING_SIZE (16 * 1024)
+#define STRESS_BYTES (20 * 1000 * 1000)
+
+typedef struct
+{
+    PCM_Ring *ring;
+    uint32_t total;
+    uint32_t max_chunk; // Largest region used at once, 0 for whatever the ring offers
+    uint32_t seed;
+    uint32_t errors;
+    uint32_t full_or_empty; // Times the side found nothing to do
+} Side;
+
+static uint8_t pattern_byte(uint32_t position)
+{
+    return (position * 7 + (position >> 11)) & 0xFF;
+}
+
+static uint32_t next_random(uint32_t *state)
+{
+    *state = *state * 1103515245 + 12345;
+    return *state >> 8;
+}
+
+static uint32_t chunk_length(Side *side, uint32_t available, uint32_t remaining)
+{
+    uint32_t length = available < remaining ? available : remaining;
+
+    if (side->max_chunk != 0)
+    {
+        uint32_t limit = 1 + next_random(&side->seed) % side->max_chunk;
+        length = length < limit ? length : limit;
+    }
+
+    return length;
+}
+
+static void *writer(void *arg)
+{
+    Side *side = (Side *)arg;
+    uint32_t position = 0;
+
+    while (position < side->total)
+    {
+        uint8_t *region;
+        uint32_t available = pcm_ring_acquire_write(side->ring, &region);
+
+        if (available == 0)
+        {
+            side->full_or_empty++;
+            sched_yield();
+            continue;
+        }
+
+        uint32_t length = chunk_length(side, available, side->total - position);
+
+        for (uint32_t i = 0; i < length; i++)
+        {
+            region[i] = pattern_byte(position + i);
+        }
+
+        pcm_ring_commit_write(side->ring, length);
+        position += length;
+    }
+
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    Side *side = (Side *)arg;
+    uint32_t position = 0;
+
+    while (position < side->total)
+    {
+        const uint8_t *region;
+        uint32_t available = pcm_ring_acquire_read(side->ring, &region);
+
+        if (available == 0)
+        {
+            side->full_or_empty++;
+            sched_yield();
+            continue;
+        }
+
+        uint32_t length = chunk_length(side, available, side->total - position);
+
+        for (uint32_t i = 0; i < length; i++)
+        {
+            if (region[i] != pattern_byte(position + i))
+            {
+                side->errors++;
+            }
+        }
+
+        pcm_ring_commit_read(side->ring, length);
+        position += length;
+    }
+
+    return NULL;
+}
+
+static void run(Side *write_side, Side *read_side)
+{
+    pthread_t writer_thread;
+    pthread_t reader_thread;
+
+    pthread_create(&writer_thread, NULL, writer, write_side);
+    pthread_create(&reader_thread, NULL, reader, read_side);
+    pthread_join(writer_thread, NULL);
+    pthread_join(reader_thread, NULL);
+}
+
+static void test_init(uint8_t *storage)
+{
+    PCM_Ring ring;
+
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, pcm_ring_init(&ring, storage, 0));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, pcm_ring_init(&ring, storage, 3000));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, pcm_ring_init(&ring, storage + 4, RING_SIZE));
+    TEST_CHECK_EQUAL(ESP_OK, pcm_ring_init(&ring, storage, RING_SIZE));
+    TEST_CHECK_EQUAL(0, pcm_ring_used(&ring));
+    TEST_CHECK_EQUAL(RING_SIZE, pcm_ring_free(&ring));
+}
+
+// Regions stop at the end of the storage, a reset offset lines them up with sectors, the counts wrap at 2^32
+static void test_regions(uint8_t *storage)
+{
+    PCM_Ring ring;
+    uint8_t *write_region;
+    const uint8_t *read_region;
+
+    pcm_ring_init(&ring, storage, RING_SIZE);
+    pcm_ring_reset(&ring, 100);
+
+    TEST_CHECK_EQUAL(RING_SIZE - 100, pcm_ring_acquire_write(&ring, &write_region));
+    TEST_CHECK(write_region == storage + 100);
+    pcm_ring_commit_write(&ring, RING_SIZE - 100);
+
+    TEST_CHECK_EQUAL(100, pcm_ring_acquire_write(&ring, &write_region));
+    TEST_CHECK(write_region == storage);
+    pcm_ring_commit_write(&ring, 100);
+
+    TEST_CHECK_EQUAL(0, pcm_ring_acquire_write(&ring, &write_region));
+    TEST_CHECK_EQUAL(RING_SIZE, pcm_ring_used(&ring));
+
+    TEST_CHECK_EQUAL(RING_SIZE - 100, pcm_ring_acquire_read(&ring, &read_region));
+    pcm_ring_commit_read(&ring, RING_SIZE - 100);
+    TEST_CHECK_EQUAL(100, pcm_ring_acquire_read(&ring, &read_region));
+    TEST_CHECK(read_region == storage);
+    pcm_ring_commit_read(&ring, 100);
+    TEST_CHECK_EQUAL(0, pcm_ring_acquire_read(&ring, &read_region));
+
+    // Counts about to wrap, as after 4 GB of playback
+    atomic_store(&ring.head, UINT32_MAX - 999);
+    atomic_store(&ring.tail, UINT32_MAX - 999);
+
+    pcm_ring_acquire_write(&ring, &write_region);
+    pcm_ring_commit_write(&ring, 3000);
+    TEST_CHECK_EQUAL(3000, pcm_ring_used(&ring));
+    TEST_CHECK_EQUAL(RING_SIZE - 3000, pcm_ring_free(&ring));
+    TEST_CHECK_EQUAL(2000, pcm_ring_write_count(&ring));
+
+    pcm_ring_acquire_read(&ring, &read_region);
+    pcm_ring_commit_read(&ring, 3000);
+    TEST_CHECK_EQUAL(0, pcm_ring_used(&ring));
+}
+
+// Uneven sizes on both sides so regions end everywhere, including a byte short of the wrap
+static void test_stress(uint8_t *storage)
+{
+    PCM_Ring ring;
+
+    pcm_ring_init(&ring, storage, RING_SIZE);
+    pcm_ring_reset(&ring, 123);
+
+    Side write_side = {.ring = &ring, .total = STRESS_BYTES, .max_chunk = 3001, .seed = 1};
+    Side read_side = {.ring = &ring, .total = STRESS_BYTES, .max_chunk = 1999, .seed = 2};
+
+    run(&write_side, &read_side);
+
+    printf("Stress: %u bytes, writer full %u times, reader empty %u times\n", (unsigned int)STRESS_BYTES,
+           (unsigned int)write_side.full_or_empty, (unsigned int)read_side.full_or_empty);
+
+    TEST_CHECK_EQUAL(0, read_side.errors);
+    TEST_CHECK_EQUAL(STRESS_BYTES, pcm_ring_read_count(&ring) - 123);
+    TEST_CHECK_EQUAL(0, pcm_ring_used(&ring));
+}
+
+// MB/s with each side taking whole regions, as large as the ring offers, pattern checked on the way
+static void bench(uint8_t *storage, uint32_t mb)
+{
+    PCM_Ring ring;
+
+    pcm_ring_init(&ring, storage, RING_SIZE);
+
+    Side write_side = {.ring = &ring, .total = mb * 1024 * 1024, .max_chunk = 0};
+    Side read_side = {.ring = &ring, .total = mb * 1024 * 1024, .max_chunk = 0};
+
+    uint64_t start = host_test_now_ns();
+    run(&write_side, &read_side);
+    uint64_t elapsed = host_test_now_ns() - start;
+
+    printf("Throughput: %.0f MB/s over %u MB\n", elapsed == 0 ? 0 : (double)mb * 1e9 / elapsed, (unsigned int)mb);
+
+    TEST_CHECK_EQUAL(0, read_side.errors);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t mb = argc > 1 ? (uint32_t)atoi(argv[1]) : 256;
+    uint8_t *storage = aligned_alloc(PCM_RING_ALIGNMENT, RING_SIZE);
+
+    test_init(storage);
+    test_regions(storage);
+    test_stress(storage);
+    bench(storage, mb);
+
+    free(storage);
+
+    return host_test_result();
+}
@@ -0,0 +1,204 @@
+#include "wav.h"
+
+#include "esp_log.h"
+#include "utils.h"
+
+// Sub format GUID of an extensible file starts with the format tag, the rest is fixed
+#define WAV_SUBFORMAT_OFFSET 24
+
+static const char *TAG = "WAV";
+
+// Read exactly `length` bytes, a short read means the file is cut off
+static esp_err_t read_exact(FAT_File *file, uint8_t *destination, uint32_t length)
+{
+    uint32_t bytes_read;
+    esp_err_t err = fat_file_read(file, destination, length, &bytes_read);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    return bytes_read == length ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+static esp_err_t parse_fmt(FAT_File *file, uint32_t chunk_size, WAV_Info *info)
+{
+    if (chunk_size < WAV_FMT_MIN_LENGTH)
+    {
+        ESP_LOGE(TAG, "fmt chunk too short: %d", (unsigned int)chunk_size);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    uint8_t fmt[WAV_FMT_EXTENSIBLE_LENGTH];
+    uint32_t length = chunk_size < sizeof(fmt) ? chunk_size : sizeof(fmt);
+
+    esp_err_t err = read_exact(file, fmt, length);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    info->format = extract_uint16_le(fmt, 0);
+    info->channels = extract_uint16_le(fmt, 2);
+    info->sample_rate = extract_uint32_le(fmt, 4);
+    info->block_align = extract_uint16_le(fmt, 12);
+    info->bits_per_sample = extract_uint16_le(fmt, 14);
+    info->valid_bits = info->bits_per_sample;
+    info->channel_mask = 0;
+
+    if (info->format == WAV_FORMAT_EXTENSIBLE)
+    {
+        if (length < WAV_FMT_EXTENSIBLE_LENGTH)
+        {
+            ESP_LOGE(TAG, "Extensible fmt chunk too short: %d", (unsigned int)chunk_size);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        info->valid_bits = extract_uint16_le(fmt, 18);
+        info->channel_mask = extract_uint32_le(fmt, 20);
+        info->format = extract_uint16_le(fmt, WAV_SUBFORMAT_OFFSET);
+
+        if (info->valid_bits == 0)
+        {
+            info->valid_bits = info->bits_per_sample;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t check_supported(const WAV_Info *info)
+{
+    if (info->format != WAV_FORMAT_PCM)
+    {
+        ESP_LOGW(TAG, "Format 0x%04X not supported", (unsigned int)info->format);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (info->bits_per_sample != 8 && info->bits_per_sample != 16 && info->bits_per_sample != 24 && info->bits_per_sample != 32)
+    {
+        ESP_LOGW(TAG, "%d bit samples not supported", (unsigned int)info->bits_per_sample);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (info->channels == 0 || info->sample_rate == 0 ||
+        info->block_align != info->channels * (info->bits_per_sample / 8) || info->valid_bits > info->bits_per_sample)
+    {
+        ESP_LOGE(TAG, "Inconsistent fmt chunk");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t wav_parse(FAT_File *file, WAV_Info *info)
+{
+    memset(info, 0, sizeof(WAV_Info));
+
+    esp_err_t err = fat_file_seek(file, 0);
+
+    uint8_t header[WAV_RIFF_HEADER_LENGTH];
+
+    if (err == ESP_OK)
+    {
+        err = read_exact(file, header, sizeof(header));
+    }
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (extract_uint32_le(header, 0) != WAV_RIFF_ID || extract_uint32_le(header, 8) != WAV_WAVE_ID)
+    {
+        ESP_LOGE(TAG, "Not a RIFF/WAVE file");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    bool has_fmt = false;
+    bool has_data = false;
+
+    for (uint32_t chunk = 0; chunk < WAV_MAX_CHUNKS && !(has_fmt && has_data); chunk++)
+    {
+        err = read_exact(file, header, WAV_CHUNK_HEADER_LENGTH);
+
+        if (err != ESP_OK)
+        {
+            break;
+        }
+
+        uint32_t id = extract_uint32_le(header, 0);
+        uint32_t size = extract_uint32_le(header, 4);
+        uint32_t start = file->position;
+
+        // Whatever is left of the file, streaming writers leave the size at 0 or 0xFFFFFFFF
+        uint32_t available = file->size - start;
+
+        if (id == WAV_DATA_ID)
+        {
+            info->data_offset = start;
+            info->data_size = (size == 0 || size > available) ? available : size;
+            has_data = true;
+        }
+        else if (id == WAV_FMT_ID)
+        {
+            err = parse_fmt(file, size, info);
+
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+
+            has_fmt = true;
+        }
+
+        if (has_fmt && has_data)
+        {
+            break;
+        }
+
+        // Chunks are padded to an even size
+        uint64_t next = (uint64_t)start + size + (size & 1);
+
+        if (next > file->size)
+        {
+            break;
+        }
+
+        err = fat_file_seek(file, next);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    if (!has_fmt || !has_data)
+    {
+        ESP_LOGE(TAG, "No %s chunk", has_fmt ? "data" : "fmt");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    err = check_supported(info);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // A trailing partial frame can't be played
+    info->data_size -= info->data_size % info->block_align;
+
+    ESP_LOGI(TAG, "%d Hz, %d ch, %d bit (%d valid), data at %d, %d bytes",
+             (unsigned int)info->sample_rate, (unsigned int)info->channels, (unsigned int)info->bits_per_sample,
+             (unsigned int)info->valid_bits, (unsigned int)info->data_offset, (unsigned int)info->data_size);
+
+    return fat_file_seek(file, info->data_offset);
+}
+
+uint32_t wav_frame_count(const WAV_Info *info)
+{
+    return info->block_align == 0 ? 0 : info->data_size / info->block_align;
+}
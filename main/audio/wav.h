@@ -0,0 +1,57 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "fat/fat_file.h"
+
+/**
+ * RIFF/WAVE parsing straight off an open file. Chunk headers are read one by one,
+ * chunks other than `fmt ` & `data` (LIST, id3, fact...) are seeked over without reading them.
+ * On a freshly written file the header & the start of the data share the first sector or two.
+ */
+
+#define WAV_RIFF_ID 0x46464952 // "RIFF"
+#define WAV_WAVE_ID 0x45564157 // "WAVE"
+#define WAV_FMT_ID 0x20746D66  // "fmt "
+#define WAV_DATA_ID 0x61746164 // "data"
+
+#define WAV_RIFF_HEADER_LENGTH 12 // "RIFF", size, "WAVE"
+#define WAV_CHUNK_HEADER_LENGTH 8 // Id & size
+
+// `fmt ` is 16 bytes for plain PCM, 18 with cbSize & 40 when extensible
+#define WAV_FMT_MIN_LENGTH 16
+#define WAV_FMT_EXTENSIBLE_LENGTH 40
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Chunks looked at before giving up on finding `data`
+#define WAV_MAX_CHUNKS 32
+
+typedef struct
+{
+    uint16_t format;          // WAV_FORMAT_PCM, extensible files report their sub format
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t block_align;     // Bytes per frame, all channels
+    uint16_t bits_per_sample; // Container size of a sample
+    uint16_t valid_bits;      // Bits actually used, only differs for extensible files
+    uint32_t channel_mask;    // Speaker positions, 0 when not extensible
+    uint32_t data_offset;     // PCM payload starts here in the file
+    uint32_t data_size;       // In bytes, whole frames only
+} WAV_Info;
+
+/**
+ * Parse the headers of a WAV file from its start. On success the file is left at `data_offset`, ready to stream.
+ * ESP_ERR_INVALID_RESPONSE for anything that is not RIFF/WAVE or lacks `fmt `/`data`,
+ * ESP_ERR_NOT_SUPPORTED for valid files in a format other than 8/16/24/32 bit integer PCM.
+ */
+esp_err_t wav_parse(FAT_File *file, WAV_Info *info);
+
+// Frames in the payload
+uint32_t wav_frame_count(const WAV_Info *info);
+
+#endif
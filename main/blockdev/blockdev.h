@@ -0,0 +1,73 @@
+#ifndef BLOCKDEV_H
+#define BLOCKDEV_H
+
+#include "stdbool.h"
+#include "stdint.h"
+#include <esp_err.h>
+
+/**
+ * A block device is anything that can hand out fixed size sectors: the SD card, a disk image on a host...
+ * The FAT layer only talks to this, so it does not care where sectors come from.
+ */
+
+// Sector size the FAT layer works with
+#define BLOCKDEV_SECTOR_SIZE 512
+
+typedef struct
+{
+    // Read one sector
+    esp_err_t (*read)(void *context, uint32_t sector, uint8_t *destination);
+
+    // Read `count` contiguous sectors, destination must fit them all
+    esp_err_t (*read_many)(void *context, uint32_t sector, uint32_t count, uint8_t *destination);
+
+    // Write one sector, ESP_ERR_NOT_SUPPORTED if the device is read only
+    esp_err_t (*write)(void *context, uint32_t sector, const uint8_t *source);
+
+    // Write `count` contiguous sectors
+    esp_err_t (*write_many)(void *context, uint32_t sector, uint32_t count, const uint8_t *source);
+
+    // Bytes per sector
+    uint32_t (*sector_size)(void *context);
+
+    // Amount of sectors on the device, 0 when unknown
+    uint32_t (*sector_count)(void *context);
+} Block_Device_Ops;
+
+typedef struct
+{
+    const Block_Device_Ops *ops;
+    void *context; // Handed to every op, backend specific
+} Block_Device;
+
+static inline esp_err_t blockdev_read(const Block_Device *device, uint32_t sector, uint8_t *destination)
+{
+    return device->ops->read(device->context, sector, destination);
+}
+
+static inline esp_err_t blockdev_read_many(const Block_Device *device, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    return device->ops->read_many(device->context, sector, count, destination);
+}
+
+static inline esp_err_t blockdev_write(const Block_Device *device, uint32_t sector, const uint8_t *source)
+{
+    return device->ops->write(device->context, sector, source);
+}
+
+static inline esp_err_t blockdev_write_many(const Block_Device *device, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return device->ops->write_many(device->context, sector, count, source);
+}
+
+static inline uint32_t blockdev_sector_size(const Block_Device *device)
+{
+    return device->ops->sector_size(device->context);
+}
+
+static inline uint32_t blockdev_sector_count(const Block_Device *device)
+{
+    return device->ops->sector_count(device->context);
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include "blockdev_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+// Only the host has mmap
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/mman.h>
+#define BLOCKDEV_FILE_HAS_MMAP 1
+#else
+#define BLOCKDEV_FILE_HAS_MMAP 0
+#endif
+
+static const char *TAG = "BLOCKDEV_FILE";
+
+static esp_err_t file_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    Block_Device_File *file = (Block_Device_File *)context;
+
+    if (sector + count > file->sector_count)
+    {
+        ESP_LOGE(TAG, "Read past the end of the image: %d", (unsigned int)(sector + count));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t length = (size_t)count * BLOCKDEV_SECTOR_SIZE;
+    off_t offset = (off_t)sector * BLOCKDEV_SECTOR_SIZE;
+
+    if (file->map != NULL)
+    {
+        memcpy(destination, &file->map[offset], length);
+        return ESP_OK;
+    }
+
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t got = pread(file->fd, &destination[done], length - done, offset + done);
+
+        if (got <= 0)
+        {
+            ESP_LOGE(TAG, "Failed to read sector %d", (unsigned int)sector);
+            return ESP_FAIL;
+        }
+
+        done += got;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t file_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return file_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t file_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    Block_Device_File *file = (Block_Device_File *)context;
+
+    if (sector + count > file->sector_count)
+    {
+        ESP_LOGE(TAG, "Write past the end of the image: %d", (unsigned int)(sector + count));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t length = (size_t)count * BLOCKDEV_SECTOR_SIZE;
+    off_t offset = (off_t)sector * BLOCKDEV_SECTOR_SIZE;
+
+    if (file->map != NULL)
+    {
+        memcpy(&file->map[offset], source, length);
+        return ESP_OK;
+    }
+
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t put = pwrite(file->fd, &source[done], length - done, offset + done);
+
+        if (put <= 0)
+        {
+            ESP_LOGE(TAG, "Failed to write sector %d", (unsigned int)sector);
+            return ESP_FAIL;
+        }
+
+        done += put;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t file_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return file_write_many(context, sector, 1, source);
+}
+
+static uint32_t file_sector_size(void *context)
+{
+    return BLOCKDEV_SECTOR_SIZE;
+}
+
+static uint32_t file_sector_count(void *context)
+{
+    return ((Block_Device_File *)context)->sector_count;
+}
+
+static const Block_Device_Ops file_ops = {
+    .read = file_read,
+    .read_many = file_read_many,
+    .write = file_write,
+    .write_many = file_write_many,
+    .sector_size = file_sector_size,
+    .sector_count = file_sector_count,
+};
+
+esp_err_t blockdev_file_open(Block_Device_File *file, const char *path, bool use_mmap, Block_Device *device)
+{
+    file->fd = open(path, O_RDWR);
+    file->map = NULL;
+
+    if (file->fd < 0)
+    {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct stat info;
+
+    if (fstat(file->fd, &info) != 0)
+    {
+        close(file->fd);
+        return ESP_FAIL;
+    }
+
+    file->sector_count = info.st_size / BLOCKDEV_SECTOR_SIZE;
+
+#if BLOCKDEV_FILE_HAS_MMAP
+    if (use_mmap)
+    {
+        void *map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+
+        if (map == MAP_FAILED)
+        {
+            ESP_LOGW(TAG, "mmap failed, falling back to reads");
+        }
+        else
+        {
+            file->map = (uint8_t *)map;
+        }
+    }
+#endif
+
+    device->ops = &file_ops;
+    device->context = file;
+
+    ESP_LOGI(TAG, "Opened %s, %d sectors", path, (unsigned int)file->sector_count);
+
+    return ESP_OK;
+}
+
+void blockdev_file_close(Block_Device_File *file)
+{
+#if BLOCKDEV_FILE_HAS_MMAP
+    if (file->map != NULL)
+    {
+        munmap(file->map, (size_t)file->sector_count * BLOCKDEV_SECTOR_SIZE);
+    }
+#endif
+
+    file->map = NULL;
+
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
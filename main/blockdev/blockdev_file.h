@@ -0,0 +1,27 @@
+#ifndef BLOCKDEV_FILE_H
+#define BLOCKDEV_FILE_H
+
+#include "blockdev.h"
+
+/**
+ * Block device backed by a disk image file, e.g. a `dd` of a real card.
+ * Lets the FAT & audio code run against real FAT32 images on a Linux host.
+ */
+
+typedef struct
+{
+    int fd;
+    uint8_t *map; // Whole image when mmap'd, NULL otherwise
+    uint32_t sector_count;
+} Block_Device_File;
+
+/**
+ * Open the image at `path` & fill in `device` to read it through `file`.
+ * With `use_mmap` the whole image is mapped & sectors are copied out of memory,
+ * only available on host builds, ignored elsewhere.
+ */
+esp_err_t blockdev_file_open(Block_Device_File *file, const char *path, bool use_mmap, Block_Device *device);
+
+void blockdev_file_close(Block_Device_File *file);
+
+#endif
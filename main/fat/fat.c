@@ -1,15 +1,47 @@
 #include "fat.h"
+#include "fat_cache.h"
+#include "fat_prefetch.h"
+#include "fat_dir.h"
+#include "fat_lookup.h"
 
-#include <wchar.h>
-#include <locale.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 static const char *TAG = "FAT";
-static uint8_t working_block[SDHC_SDXC_BLOCK_SIZE] = {0};
+static const Block_Device *device;
+static uint8_t working_block[BLOCKDEV_SECTOR_SIZE] = {0};
 
 static uint32_t fat_begin_lba;
 static uint32_t cluster_begin_lba;
 static uint32_t sectors_per_cluster;
 static uint32_t root_cluster; // Clusters start with 2, there is no 0 or 1 cluster
+static uint32_t sectors_per_fat;
+static uint32_t num_fats;
+static uint32_t cluster_count; // Data clusters, numbered from 2 up to cluster_count + 1
+
+static uint32_t volume_serial;
+static uint32_t fsinfo_sector = 0; // 0 when the volume has no valid FSInfo
+static uint32_t free_count = FAT_FSINFO_UNKNOWN;
+static uint32_t next_free = FAT_FSINFO_UNKNOWN;
+
+// A few FAT sectors in a row, so walking a chain doesn't hit the device for every cluster
+static uint8_t fat_window[FAT_WINDOW_SECTORS * BLOCKDEV_SECTOR_SIZE];
+static uint32_t fat_window_sector = 0;
+static uint32_t fat_window_length = 0; // In sectors, 0 when nothing is loaded
+static bool fat_window_dirty = false;  // Entries were changed, the window must be written back before it moves
+
+// The window, sector cache, read-ahead & lookup tables are shared by every task that reads files, see fat_lock
+static SemaphoreHandle_t fat_mutex = NULL;
+
+void fat_lock(void)
+{
+    xSemaphoreTakeRecursive(fat_mutex, portMAX_DELAY);
+}
+
+void fat_unlock(void)
+{
+    xSemaphoreGiveRecursive(fat_mutex);
+}
 
 void get_partition_data(uint8_t *source, uint8_t *destination, uint8_t partition)
 {
@@ -43,58 +75,63 @@ uint32_t get_partition_sector_count(uint8_t *partition_data)
     return extract_uint32_le(partition_data, FAT_PARTITION_TYPE_INDEX);
 }
 
-esp_err_t fat_read_bytes(uint8_t *destination, uint32_t size, uint32_t address)
+esp_err_t fat_read_bytes(uint8_t *destination, uint32_t size, uint64_t address)
 {
-    // Calc start block
-    uint32_t start_block = address / SDHC_SDXC_BLOCK_SIZE;
-
-    // Calc how many blocks the data spans
-    uint32_t block_count = (size + SDHC_SDXC_BLOCK_SIZE - 1) / SDHC_SDXC_BLOCK_SIZE;
-
-    // If start data is not aligned
-    uint32_t offset = address % SDHC_SDXC_BLOCK_SIZE;
-
-    uint32_t block_index = start_block;
-    bool is_first = true;
-    uint32_t bytes_left = size;
+    uint32_t sector = address / BLOCKDEV_SECTOR_SIZE;
+    uint32_t offset = address % BLOCKDEV_SECTOR_SIZE;
     uint32_t index = 0;
 
-    while (block_count != 0)
+    // Unaligned head, bounced through the cache
+    if (offset != 0 && size > 0)
     {
-
-        esp_err_t op_status = sd_read_block(block_index, working_block);
+        uint8_t *block;
+        esp_err_t op_status = fat_cache_read(sector, &block);
 
         if (op_status != ESP_OK)
         {
             return op_status;
         }
 
-        block_index++;
+        uint32_t length = BLOCKDEV_SECTOR_SIZE - offset;
 
-        // Handle possible offset of the first block
-        if (is_first)
+        if (length > size)
         {
-            memcpy(destination, &working_block[offset], sizeof(uint8_t) * (SDHC_SDXC_BLOCK_SIZE - offset));
-            index += SDHC_SDXC_BLOCK_SIZE - offset;
-            bytes_left -= SDHC_SDXC_BLOCK_SIZE - offset;
-            is_first = false;
+            length = size;
         }
-        else if (block_count == 1)
+
+        memcpy(destination, &block[offset], sizeof(uint8_t) * length);
+        index += length;
+        sector++;
+    }
+
+    // Whole sectors in the middle go straight into the destination with one multi-sector read
+    uint32_t full_sectors = (size - index) / BLOCKDEV_SECTOR_SIZE;
+
+    if (full_sectors > 0)
+    {
+        esp_err_t op_status = blockdev_read_many(device, sector, full_sectors, &destination[index]);
+
+        if (op_status != ESP_OK)
         {
-            // Handle the last block that might be smaller
-            memcpy(destination, &working_block[index], sizeof(uint8_t) * (bytes_left));
-            index += bytes_left;
-            bytes_left -= bytes_left;
+            return op_status;
         }
-        else
+
+        index += full_sectors * BLOCKDEV_SECTOR_SIZE;
+        sector += full_sectors;
+    }
+
+    // Partial tail, bounced through the cache
+    if (index < size)
+    {
+        uint8_t *block;
+        esp_err_t op_status = fat_cache_read(sector, &block);
+
+        if (op_status != ESP_OK)
         {
-            // Handle the full blocks
-            memcpy(destination, &working_block[index], sizeof(uint8_t) * (SDHC_SDXC_BLOCK_SIZE));
-            index += SDHC_SDXC_BLOCK_SIZE;
-            bytes_left -= SDHC_SDXC_BLOCK_SIZE;
+            return op_status;
         }
 
-        block_count--;
+        memcpy(&destination[index], block, sizeof(uint8_t) * (size - index));
     }
 
     return ESP_OK;
@@ -106,43 +143,383 @@ static uint32_t get_cluster_lba(uint32_t cluster_num)
     return cluster_begin_lba + (cluster_num - 2) * sectors_per_cluster;
 }
 
-void utf16_to_utf8(uint8_t *utf16_array, size_t utf16_len, uint8_t *utf8_array)
+uint32_t fat_cluster_to_sector(uint32_t cluster)
+{
+    return get_cluster_lba(cluster);
+}
+
+uint32_t fat_get_sectors_per_cluster(void)
 {
-    size_t idx = 0;
+    return sectors_per_cluster;
+}
 
-    for (size_t i = 0; i < utf16_len; i += 2)
+uint32_t fat_get_root_cluster(void)
+{
+    return root_cluster;
+}
+
+const Block_Device *fat_get_block_device(void)
+{
+    return device;
+}
+
+uint32_t fat_get_volume_serial(void)
+{
+    return volume_serial;
+}
+
+uint32_t fat_get_free_count(void)
+{
+    return free_count;
+}
+
+esp_err_t fat_write_sector(uint32_t sector, const uint8_t *source)
+{
+    esp_err_t err = blockdev_write(device, sector, source);
+
+    if (err != ESP_OK)
     {
-        // 0xffff is padding
-        if ((utf16_array[i] == 0xff && utf16_array[i + 1] == 0xff) || (utf16_array[i] == 0 && utf16_array[i + 1] == 0))
+        return err;
+    }
+
+    fat_cache_update(sector, source);
+
+    return ESP_OK;
+}
+
+// Write changed entries back, into every copy of the FAT
+static esp_err_t fat_window_flush(void)
+{
+    if (!fat_window_dirty)
+    {
+        return ESP_OK;
+    }
+
+    for (uint32_t i = 0; i < num_fats; i++)
+    {
+        esp_err_t err = blockdev_write_many(device, fat_window_sector + i * sectors_per_fat, fat_window_length, fat_window);
+
+        if (err != ESP_OK)
         {
-            break;
+            return err;
+        }
+    }
+
+    fat_window_dirty = false;
+
+    return ESP_OK;
+}
+
+// Slide the window over the FAT entry of a cluster, hands back where the entry is within the window
+static esp_err_t fat_window_entry(uint32_t cluster, uint32_t *window_offset)
+{
+    // FAT32 entries are 4 bytes
+    uint32_t entry_offset = cluster * 4;
+    uint32_t relative_sector = entry_offset / BLOCKDEV_SECTOR_SIZE;
+
+    if (relative_sector >= sectors_per_fat)
+    {
+        ESP_LOGE(TAG, "Cluster %d is past the end of the FAT", (unsigned int)cluster);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t sector = fat_begin_lba + relative_sector;
+
+    // Slide the window so it starts at the wanted sector
+    if (fat_window_length == 0 || sector < fat_window_sector || sector >= fat_window_sector + fat_window_length)
+    {
+        esp_err_t err = fat_window_flush();
+
+        if (err != ESP_OK)
+        {
+            return err;
         }
 
-        // Combine two uint8s into a single uint16 character
-        uint16_t utf16_char = (utf16_array[i + 1] << 8) | utf16_array[i];
+        uint32_t length = FAT_WINDOW_SECTORS;
 
-        // Convert the uint16 character to UTF-8
-        if (utf16_char <= 0x7F)
+        if (relative_sector + length > sectors_per_fat)
         {
-            // 1-byte UTF-8
-            utf8_array[idx++] = (uint8_t)utf16_char;
+            length = sectors_per_fat - relative_sector;
         }
-        else if (utf16_char <= 0x7FF)
+
+        fat_window_length = 0;
+
+        err = blockdev_read_many(device, sector, length, fat_window);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        fat_window_sector = sector;
+        fat_window_length = length;
+    }
+
+    *window_offset = (sector - fat_window_sector) * BLOCKDEV_SECTOR_SIZE + entry_offset % BLOCKDEV_SECTOR_SIZE;
+
+    return ESP_OK;
+}
+
+// Look up the FAT entry of a cluster, tells which cluster comes next in the chain
+static esp_err_t fat_next_cluster(uint32_t cluster, uint32_t *next)
+{
+    uint32_t window_offset;
+    esp_err_t err = fat_window_entry(cluster, &window_offset);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    *next = extract_uint32_le(fat_window, window_offset) & FAT_EntryMask;
+
+    return ESP_OK;
+}
+
+// Change the FAT entry of a cluster, only in the window until it is flushed
+static esp_err_t fat_set_cluster(uint32_t cluster, uint32_t value)
+{
+    uint32_t window_offset;
+    esp_err_t err = fat_window_entry(cluster, &window_offset);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // Reserved bits have to be kept as they were
+    uint32_t reserved = extract_uint32_le(fat_window, window_offset) & ~FAT_EntryMask;
+
+    insert_uint32_le(fat_window, window_offset, reserved | (value & FAT_EntryMask));
+    fat_window_dirty = true;
+
+    return ESP_OK;
+}
+
+static esp_err_t fat_write_fsinfo(void)
+{
+    if (fsinfo_sector == 0)
+    {
+        return ESP_OK;
+    }
+
+    uint8_t *block;
+    esp_err_t err = fat_cache_read(fsinfo_sector, &block);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    memcpy(working_block, block, BLOCKDEV_SECTOR_SIZE);
+    insert_uint32_le(working_block, FAT_FSINFO_FREE_COUNT, free_count);
+    insert_uint32_le(working_block, FAT_FSINFO_NEXT_FREE, next_free);
+
+    return fat_write_sector(fsinfo_sector, working_block);
+}
+
+// Mark every cluster of a chain free, only in the window. Returns how many were
+static uint32_t fat_clear_chain(uint32_t first_cluster)
+{
+    uint32_t cluster = first_cluster;
+    uint32_t cleared = 0;
+
+    while (cluster >= 2 && cluster < FAT_EndOfClusterMin)
+    {
+        uint32_t next;
+
+        if (fat_next_cluster(cluster, &next) != ESP_OK || fat_set_cluster(cluster, FAT_FreeCluster) != ESP_OK)
+        {
+            break;
+        }
+
+        cluster = next;
+        cleared++;
+    }
+
+    return cleared;
+}
+
+// Hand a half allocated chain back, `previous_cluster` ends the chain again
+static void fat_release_chain(uint32_t previous_cluster, uint32_t first_cluster)
+{
+    fat_clear_chain(first_cluster);
+
+    if (previous_cluster != 0)
+    {
+        fat_set_cluster(previous_cluster, FAT_EndOfCluster);
+    }
+
+    fat_window_flush();
+}
+
+esp_err_t fat_allocate_chain(uint32_t previous_cluster, uint32_t count, uint32_t *first_cluster)
+{
+    *first_cluster = 0;
+
+    if (count == 0)
+    {
+        return ESP_OK;
+    }
+
+    if (free_count != FAT_FSINFO_UNKNOWN && free_count < count)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t cluster = (next_free >= 2 && next_free < cluster_count + 2) ? next_free : 2;
+    uint32_t previous = previous_cluster;
+    uint32_t allocated = 0;
+
+    for (uint32_t scanned = 0; scanned < cluster_count && allocated < count; scanned++)
+    {
+        uint32_t value;
+        esp_err_t err = fat_next_cluster(cluster, &value);
+
+        if (err == ESP_OK && value == FAT_FreeCluster)
         {
-            // 2-byte UTF-8
-            utf8_array[idx++] = 0xC0 | (utf16_char >> 6);
-            utf8_array[idx++] = 0x80 | (utf16_char & 0x3F);
+            err = fat_set_cluster(cluster, FAT_EndOfCluster);
+
+            if (err == ESP_OK && previous != 0)
+            {
+                err = fat_set_cluster(previous, cluster);
+            }
+
+            if (*first_cluster == 0)
+            {
+                *first_cluster = cluster;
+            }
+
+            previous = cluster;
+            allocated++;
         }
-        else
+
+        if (err != ESP_OK)
         {
-            // 3-byte UTF-8
-            utf8_array[idx++] = 0xE0 | (utf16_char >> 12);
-            utf8_array[idx++] = 0x80 | ((utf16_char >> 6) & 0x3F);
-            utf8_array[idx++] = 0x80 | (utf16_char & 0x3F);
+            fat_release_chain(previous_cluster, *first_cluster);
+            return err;
         }
+
+        // Wrap around to the start of the data area
+        cluster = cluster + 1 < cluster_count + 2 ? cluster + 1 : 2;
+    }
+
+    if (allocated < count)
+    {
+        ESP_LOGE(TAG, "Volume full, wanted %d clusters", (unsigned int)count);
+        fat_release_chain(previous_cluster, *first_cluster);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = fat_window_flush();
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (free_count != FAT_FSINFO_UNKNOWN)
+    {
+        free_count -= count;
+    }
+
+    next_free = cluster;
+
+    return fat_write_fsinfo();
+}
+
+esp_err_t fat_free_chain(uint32_t first_cluster)
+{
+    uint32_t freed = fat_clear_chain(first_cluster);
+    esp_err_t err = fat_window_flush();
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (free_count != FAT_FSINFO_UNKNOWN)
+    {
+        free_count += freed;
+    }
+
+    return fat_write_fsinfo();
+}
+
+void fat_chain_begin(FAT_Chain_Iterator *iterator, uint32_t first_cluster)
+{
+    iterator->cluster = first_cluster;
+    iterator->index = 0;
+    iterator->is_end = first_cluster < 2 || first_cluster >= FAT_EndOfClusterMin;
+}
+
+esp_err_t fat_chain_next(FAT_Chain_Iterator *iterator)
+{
+    if (iterator->is_end)
+    {
+        return ESP_OK;
+    }
+
+    uint32_t next;
+    esp_err_t err = fat_next_cluster(iterator->cluster, &next);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (next >= FAT_EndOfClusterMin)
+    {
+        iterator->is_end = true;
+        return ESP_OK;
+    }
+
+    // A chain must never point at a free or bad cluster, the FAT is broken if it does
+    if (next < 2 || next == FAT_BadCluster)
+    {
+        ESP_LOGE(TAG, "Chain broken at cluster %d: %d", (unsigned int)iterator->cluster, (unsigned int)next);
+        iterator->is_end = true;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    iterator->cluster = next;
+    iterator->index++;
+
+    return ESP_OK;
+}
+
+bool fat_next_file_sector(uint32_t sector, uint32_t *next)
+{
+    if (sector < cluster_begin_lba)
+    {
+        *next = sector + 1;
+        return true;
+    }
+
+    uint32_t relative = sector - cluster_begin_lba;
+
+    if ((relative + 1) % sectors_per_cluster != 0)
+    {
+        *next = sector + 1;
+        return true;
+    }
+
+    uint32_t next_cluster;
+
+    if (fat_next_cluster(relative / sectors_per_cluster + 2, &next_cluster) != ESP_OK)
+    {
+        return false;
     }
 
-    utf8_array[idx] = '\0';
+    // End of chain, bad or free cluster, nothing to follow
+    if (next_cluster < 2 || next_cluster >= FAT_BadCluster)
+    {
+        return false;
+    }
+
+    *next = get_cluster_lba(next_cluster);
+
+    return true;
 }
 
 void log_attributes(FAT_Directory_Entry *entry)
@@ -184,10 +561,31 @@ void log_attributes(FAT_Directory_Entry *entry)
     }
 }
 
-esp_err_t fat_init()
+static bool log_root_entry(const FAT_Dir_Item *item, void *arg)
 {
+    ESP_LOGI(TAG, "Filename: %s", item->long_name != NULL ? item->long_name : item->name);
+    ESP_LOGI(TAG, "Filesize: %u bytes", (unsigned int)item->entry->DIR_FileSize);
+
+    log_attributes((FAT_Directory_Entry *)item->entry);
+
+    return true;
+}
+
+esp_err_t fat_init(const Block_Device *block_device)
+{
+    if (fat_mutex == NULL)
+    {
+        fat_mutex = xSemaphoreCreateRecursiveMutex();
+    }
+
+    device = block_device;
+    fat_cache_init(device);
+    fat_window_length = 0;
+    fat_window_dirty = false;
+    fat_lookup_reset();
+
     // Read the MBR
-    esp_err_t err = fat_read_bytes(working_block, SDHC_SDXC_BLOCK_SIZE, 0);
+    esp_err_t err = fat_read_bytes(working_block, BLOCKDEV_SECTOR_SIZE, 0);
 
     // ESP_LOGI(TAG, "MBR, Sector 0:");
     // debug_512_block(working_block);
@@ -207,7 +605,13 @@ esp_err_t fat_init()
     ESP_LOGI(TAG, "Partition 1 Boot Sector LBA Begin: %" PRIu32 "", p1_lba);
 
     // Read the partitions boot sector/volume id
-    fat_read_bytes(working_block, SDHC_SDXC_BLOCK_SIZE, p1_lba);
+    err = fat_read_bytes(working_block, BLOCKDEV_SECTOR_SIZE, (uint64_t)p1_lba * BLOCKDEV_SECTOR_SIZE);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to read the boot sector at %" PRIu32 "", p1_lba);
+        return err;
+    }
 
     // ESP_LOGI(TAG, "Boot Sector");
     // debug_512_block(working_block);
@@ -216,9 +620,12 @@ esp_err_t fat_init()
     uint16_t byter_per_sector = extract_uint16_le(working_block, FAT_BOOT_SECTOR_BYTES_PER_SECTOR);
     sectors_per_cluster = extract_uint8_le(working_block, FAT_BOOT_SECTORS_PER_CLUSTER);
     uint16_t reserved_sectors = extract_uint16_le(working_block, FAT_BOOT_RESERVED_SECTORS);
-    uint16_t num_fats = extract_uint8_le(working_block, FAT_BOOT_NUM_FATS);
-    uint16_t sectors_per_fat = extract_uint32_le(working_block, FAT_BOOT_SECTORS_PER_FAT);
+    num_fats = extract_uint8_le(working_block, FAT_BOOT_NUM_FATS);
+    uint32_t total_sectors = extract_uint32_le(working_block, FAT_BOOT_TOTAL_SECTORS);
+    sectors_per_fat = extract_uint32_le(working_block, FAT_BOOT_SECTORS_PER_FAT);
     root_cluster = extract_uint32_le(working_block, FAT_BOOT_ROOT_CLUSTER);
+    uint16_t fsinfo_relative = extract_uint16_le(working_block, FAT_BOOT_FSINFO_SECTOR);
+    volume_serial = extract_uint32_le(working_block, FAT_BOOT_VOLUME_ID);
     uint16_t signature = extract_uint16_le(working_block, FAT_BOOT_SIGNATURE);
 
     ESP_LOGI(TAG, "byter_per_sector: %d", (unsigned int)byter_per_sector);
@@ -227,6 +634,7 @@ esp_err_t fat_init()
     ESP_LOGI(TAG, "num_fats: %d", (unsigned int)num_fats);
     ESP_LOGI(TAG, "sectors_per_fat: %d", (unsigned int)sectors_per_fat);
     ESP_LOGI(TAG, "root_cluster: %d", (unsigned int)root_cluster);
+    ESP_LOGI(TAG, "volume_serial: %08X", (unsigned int)volume_serial);
 
     // Sanity check, must always match
     if (signature != FAT_BOOT_SIGNATURE_VALUE)
@@ -234,6 +642,14 @@ esp_err_t fat_init()
         return ESP_FAIL;
     }
 
+    // Everything below takes sectors to be the device's & divides by the cluster size
+    if (byter_per_sector != BLOCKDEV_SECTOR_SIZE || sectors_per_cluster == 0)
+    {
+        ESP_LOGE(TAG, "Unsupported BPB: %d bytes per sector, %d sectors per cluster", (unsigned int)byter_per_sector,
+                 (unsigned int)sectors_per_cluster);
+        return ESP_ERR_INVALID_STATE;
+    }
+
     // Calculate a few necessities
     fat_begin_lba = p1_lba + reserved_sectors;                                    // Where the first FAT is
     cluster_begin_lba = p1_lba + reserved_sectors + (num_fats * sectors_per_fat); // Where the first cluster is
@@ -241,122 +657,50 @@ esp_err_t fat_init()
     ESP_LOGI(TAG, "fat_begin_lba: %d", (unsigned int)fat_begin_lba);
     ESP_LOGI(TAG, "cluster_begin_lba: %d", (unsigned int)cluster_begin_lba);
 
-    // TODO use this to read the whole cluster?
-    // uint32_t cluster_size_bytes = sectors_per_cluster * byter_per_sector;
-
-    uint32_t offset = 0;
+    // Clusters the data area holds, but never more than the FAT has entries for
+    cluster_count = (total_sectors - (cluster_begin_lba - p1_lba)) / sectors_per_cluster;
 
-    // XXX Clusters hold data or directory entries! We must parse directory entries first
-
-    // A file has a short & n long directory entries
-    // A directory is a file
-    uint32_t cluster_sector = get_cluster_lba(root_cluster) + offset;
-
-    fat_read_bytes(working_block, SDHC_SDXC_BLOCK_SIZE, cluster_sector);
+    if (cluster_count > sectors_per_fat * (BLOCKDEV_SECTOR_SIZE / 4) - 2)
+    {
+        cluster_count = sectors_per_fat * (BLOCKDEV_SECTOR_SIZE / 4) - 2;
+    }
 
-    // ESP_LOGI(TAG, "cluster_sector: %d", (unsigned int)cluster_sector);
-    // debug_512_block(working_block);
+    // FSInfo is only a hint, the volume works without it
+    fsinfo_sector = 0;
+    free_count = FAT_FSINFO_UNKNOWN;
+    next_free = FAT_FSINFO_UNKNOWN;
 
-    bool is_loop = true;
-    while (is_loop)
+    if (fsinfo_relative != 0 && fsinfo_relative != 0xFFFF)
     {
-        // Read a sector
-        uint32_t cluster_sector = get_cluster_lba(root_cluster) + offset;
+        err = fat_read_bytes(working_block, BLOCKDEV_SECTOR_SIZE, (uint64_t)(p1_lba + fsinfo_relative) * BLOCKDEV_SECTOR_SIZE);
 
-        err = fat_read_bytes(working_block, SDHC_SDXC_BLOCK_SIZE, cluster_sector);
-
-        for (uint8_t i = 0; i < SDHC_SDXC_BLOCK_SIZE / FAT_CLUSTER_ENTRY_LENGTH; i++)
+        if (err == ESP_OK && extract_uint32_le(working_block, FAT_FSINFO_LEAD_SIGNATURE) == FAT_FSINFO_LEAD_SIGNATURE_VALUE)
         {
-            uint8_t dir[FAT_CLUSTER_ENTRY_LENGTH];
-            memcpy(dir, &working_block[i * FAT_CLUSTER_ENTRY_LENGTH], sizeof(uint8_t) * FAT_CLUSTER_ENTRY_LENGTH);
-
-            FAT_Directory_Entry *entry = (FAT_Directory_Entry *)&dir;
-
-            if (entry->DIR_Name[0] == FAT_DIRECTORY_ALL_FREE)
-            {
-                is_loop = false;
-                break;
-            }
-
-            // XXX ONLY FOR A DIRECTORY
-            // Not a valid file
-            // if (entry->DIR_Name[0] == FAT_DIRECTORY_EMPTY)
-            // {
-            //     break;
-            // }
-
-            ESP_LOGI(TAG, "\n\nEntry Index: %d", (unsigned int)i);
+            fsinfo_sector = p1_lba + fsinfo_relative;
+            free_count = extract_uint32_le(working_block, FAT_FSINFO_FREE_COUNT);
+            next_free = extract_uint32_le(working_block, FAT_FSINFO_NEXT_FREE);
+        }
+    }
 
-            log_attributes(entry);
+    ESP_LOGI(TAG, "clusters: %d, free: %d", (unsigned int)cluster_count, (unsigned int)free_count);
 
-            // Take 4 LSB's and check they all are set
-            if ((entry->DIR_Attr & LONG_NAME) == LONG_NAME)
-            {
-                FAT_Directory_Long_Entry *long_entry = (FAT_Directory_Long_Entry *)&dir;
-
-                uint8_t name1_utf8[16];
-                uint8_t name2_utf8[19];
-                uint8_t name3_utf8[7];
-
-                utf16_to_utf8(long_entry->LDIR_Name1, 10, name1_utf8);
-                utf16_to_utf8(long_entry->LDIR_Name2, 12, name2_utf8);
-                utf16_to_utf8(long_entry->LDIR_Name3, 4, name3_utf8);
-
-                name1_utf8[15] = '\0';
-                name2_utf8[18] = '\0';
-                name3_utf8[6] = '\0';
-
-                uint8_t index = 0;
-                uint8_t full_name[52];
-
-                for (size_t i = 0; i < 16 && name1_utf8[i] != '\0'; i++)
-                {
-                    full_name[index++] = name1_utf8[i];
-                }
-                for (size_t i = 0; i < 19 && name2_utf8[i] != '\0'; i++)
-                {
-                    full_name[index++] = name2_utf8[i];
-                }
-                for (size_t i = 0; i < 7 && name3_utf8[i] != '\0'; i++)
-                {
-                    full_name[index++] = name3_utf8[i];
-                }
-
-                full_name[index] = '\0';
-
-                ESP_LOGI(TAG, "%s", (char *)full_name);
-            }
-            else
-            {
-                char short_name[12];
-                memcpy(short_name, entry->DIR_Name, 11);
-
-                uint8_t idx = 0;
-                for (size_t i = 0; i < 11; i++)
-                {
-                    if (entry->DIR_Name[i] != 0x20)
-                    {
-                        short_name[idx++] = entry->DIR_Name[i];
-                    }
-                }
-
-                short_name[idx] = '\0';
-
-                ESP_LOGI(TAG, "Filename: %s", short_name);
-                ESP_LOGI(TAG, "Filesize: %u bytes", (unsigned int)entry->DIR_FileSize);
-            }
-        }
+    // File data is streamed past the cache, read-ahead follows cluster chains
+    err = fat_prefetch_init(device, fat_next_file_sector);
 
-        break;
+    if (err != ESP_OK)
+    {
+        return err;
+    }
 
-        // offset += SDHC_SDXC_BLOCK_SIZE;
+    // A file has a short & n long directory entries
+    err = fat_dir_iterate(root_cluster, log_root_entry, NULL);
 
-        // // Debugging purposes
-        // if (offset == SDHC_SDXC_BLOCK_SIZE * sectors_per_cluster)
-        // {
-        //     break;
-        // }
+    if (err != ESP_OK)
+    {
+        return err;
     }
 
+    fat_cache_log_stats();
+
     return ESP_OK;
 }
\ No newline at end of file
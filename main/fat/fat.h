@@ -8,7 +8,7 @@
 #include <stdbool.h>
 
 #include "utils.h"
-#include "sd/sd.h"
+#include "blockdev/blockdev.h"
 
 // FAT12/16/32 is determined by sector count only
 
@@ -20,6 +20,12 @@
 
 #define FAT_EndOfCluster 0x0FFFFFFF
 #define FAT_BadCluster 0x0FFFFFF7
+#define FAT_EndOfClusterMin 0x0FFFFFF8 // Anything from here up marks the end of a chain
+#define FAT_EntryMask 0x0FFFFFFF       // Top 4 bits of a FAT32 entry are reserved
+#define FAT_FreeCluster 0x00000000
+
+// FAT sectors kept in RAM while following chains, each sector covers 128 clusters
+#define FAT_WINDOW_SECTORS 4
 
 // DIR_Name[0] special case when all dirs after this one are free
 #define FAT_DIRECTORY_ALL_FREE 0x00
@@ -40,8 +46,11 @@
 #define FAT_BOOT_SECTORS_PER_CLUSTER 0x0D     // 1 byte
 #define FAT_BOOT_RESERVED_SECTORS 0x0E        // 2 bytes
 #define FAT_BOOT_NUM_FATS 0x10                // 1 bytes
+#define FAT_BOOT_TOTAL_SECTORS 0x20           // 4 bytes
 #define FAT_BOOT_SECTORS_PER_FAT 0x24         // 4 bytes
 #define FAT_BOOT_ROOT_CLUSTER 0x2C            // 4 bytes
+#define FAT_BOOT_FSINFO_SECTOR 0x30           // 2 bytes, relative to the boot sector
+#define FAT_BOOT_VOLUME_ID 0x43               // 4 bytes, serial number set when formatting
 #define FAT_BOOT_SIGNATURE 0x1FE              // 2 bytes
 
 // Short name dir entry/long file name entry for high capacity cards
@@ -49,6 +58,13 @@
 
 #define FAT_BOOT_SIGNATURE_VALUE 0xAA55
 
+// FSInfo sector, free space hints kept up to date by whoever writes the volume
+#define FAT_FSINFO_LEAD_SIGNATURE 0x000 // 4 bytes
+#define FAT_FSINFO_FREE_COUNT 0x1E8     // 4 bytes
+#define FAT_FSINFO_NEXT_FREE 0x1EC      // 4 bytes
+#define FAT_FSINFO_LEAD_SIGNATURE_VALUE 0x41615252
+#define FAT_FSINFO_UNKNOWN 0xFFFFFFFF
+
 /**
  * FAT is little endian - LSB is stored first.
  * LBA - Logical Block Addressing.
@@ -56,9 +72,88 @@
  */
 
 /**
- * Initialize the FAT for reading files
+ * Initialize the FAT for reading files from the supplied block device.
+ * Must be done before any other task uses the FAT layer.
+ */
+esp_err_t fat_init(const Block_Device *block_device);
+
+/**
+ * The FAT window, sector cache, read-ahead ring & lookup tables are globals. The player task opens & parses
+ * files while audio_output's producer reads them & opens the next track for gapless playback.
+ * fat_file_open_cluster/read/write/create, fat_dir_iterate & fat_lookup hold this lock while they run,
+ * so calls from different tasks take turns. It is recursive, a directory callback may call back into the FAT.
+ * A FAT_File itself is not guarded, only one task may use a given file at a time.
+ */
+void fat_lock(void);
+void fat_unlock(void);
+
+/**
+ * Read `size` bytes starting at byte `address` of the device.
+ * Whole sectors are read straight into the destination, only an unaligned head & tail go through the sector cache.
+ */
+esp_err_t fat_read_bytes(uint8_t *destination, uint32_t size, uint64_t address);
+
+/**
+ * Walks a cluster chain through the FAT.
+ * FAT sectors are read a window at a time, so a chain costs one read per FAT_WINDOW_SECTORS * 128 clusters.
+ */
+typedef struct
+{
+    uint32_t cluster; // Current cluster
+    uint32_t index;   // How many clusters into the chain we are
+    bool is_end;      // Walked past the last cluster
+} FAT_Chain_Iterator;
+
+void fat_chain_begin(FAT_Chain_Iterator *iterator, uint32_t first_cluster);
+
+/**
+ * Move to the next cluster of the chain, sets `is_end` once the chain is over.
+ * Returns ESP_ERR_INVALID_STATE when the chain runs into a bad or free cluster.
+ */
+esp_err_t fat_chain_next(FAT_Chain_Iterator *iterator);
+
+/**
+ * First sector of a cluster.
  */
-esp_err_t fat_init();
+uint32_t fat_cluster_to_sector(uint32_t cluster);
+
+/**
+ * Sector following the supplied one in the same file or directory, jumps to the next cluster at the end of one.
+ * False at the end of the chain.
+ */
+bool fat_next_file_sector(uint32_t sector, uint32_t *next);
+
+uint32_t fat_get_sectors_per_cluster(void);
+
+// First cluster of the root directory
+uint32_t fat_get_root_cluster(void);
+
+// Device the FAT was initialized with
+const Block_Device *fat_get_block_device(void);
+
+// Serial number the volume got when it was formatted
+uint32_t fat_get_volume_serial(void);
+
+// Free cluster count kept in FSInfo, FAT_FSINFO_UNKNOWN if the volume never counted them
+uint32_t fat_get_free_count(void);
+
+/**
+ * Write a sector to the device & refresh its cached copy, if any.
+ */
+esp_err_t fat_write_sector(uint32_t sector, const uint8_t *source);
+
+/**
+ * Take `count` free clusters & link them into a chain, hung off `previous_cluster` unless that is 0.
+ * Free clusters are taken in order from the FSInfo hint on, so with unfragmented free space the chain is contiguous.
+ * Every FAT copy & FSInfo are written before returning. ESP_ERR_NO_MEM when the volume is full.
+ */
+esp_err_t fat_allocate_chain(uint32_t previous_cluster, uint32_t count, uint32_t *first_cluster);
+
+/**
+ * Free every cluster of the chain starting at `first_cluster`, for a file that never made it into a directory.
+ * FAT copies & FSInfo are written before returning.
+ */
+esp_err_t fat_free_chain(uint32_t first_cluster);
 
 /**
  * Copies partition data into the destination from the source
@@ -97,6 +192,9 @@ typedef struct
     uint32_t DIR_FileSize;
 } FAT_Directory_Entry;
 
+// DIR_Name[0] of 0x05 stands for an actual 0xE5, which would otherwise mean a free entry
+#define FAT_DIRECTORY_KANJI 0x05
+
 typedef struct
 {
     uint8_t LDIR_Ord;
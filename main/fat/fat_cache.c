@@ -0,0 +1,155 @@
+#include "fat_cache.h"
+
+#include <string.h>
+#include "esp_log.h"
+
+#define FAT_CACHE_NO_SECTOR 0xFFFFFFFF
+
+typedef struct
+{
+    uint32_t sector;
+    uint32_t last_used; // Use stamp, lowest is the least recently used
+} FAT_Cache_Slot;
+
+static const char *TAG = "FAT_CACHE";
+static const Block_Device *device;
+
+static uint8_t blocks[FAT_CACHE_SLOTS][BLOCKDEV_SECTOR_SIZE];
+static FAT_Cache_Slot slots[FAT_CACHE_SLOTS];
+
+static uint32_t use_counter = 0;
+static FAT_Cache_Stats stats;
+
+void fat_cache_init(const Block_Device *block_device)
+{
+    device = block_device;
+
+    for (uint32_t i = 0; i < FAT_CACHE_SLOTS; i++)
+    {
+        slots[i].sector = FAT_CACHE_NO_SECTOR;
+        slots[i].last_used = 0;
+    }
+
+    use_counter = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+static int32_t find_slot(uint32_t sector)
+{
+    for (uint32_t i = 0; i < FAT_CACHE_SLOTS; i++)
+    {
+        if (slots[i].sector == sector)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Empty slot if there is one, otherwise the least recently used one
+static int32_t find_victim(void)
+{
+    int32_t victim = -1;
+
+    for (uint32_t i = 0; i < FAT_CACHE_SLOTS; i++)
+    {
+        if (slots[i].sector == FAT_CACHE_NO_SECTOR)
+        {
+            return i;
+        }
+
+        if (victim < 0 || slots[i].last_used < slots[victim].last_used)
+        {
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+static esp_err_t load_slot(uint32_t sector, int32_t *slot)
+{
+    int32_t index = find_slot(sector);
+
+    if (index >= 0)
+    {
+        stats.hits++;
+    }
+    else
+    {
+        stats.misses++;
+
+        index = find_victim();
+
+        if (slots[index].sector != FAT_CACHE_NO_SECTOR)
+        {
+            stats.evictions++;
+        }
+
+        // Mark empty first, a failed read must not leave stale data behind a valid sector number
+        slots[index].sector = FAT_CACHE_NO_SECTOR;
+
+        esp_err_t err = blockdev_read(device, sector, blocks[index]);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        slots[index].sector = sector;
+    }
+
+    slots[index].last_used = ++use_counter;
+    *slot = index;
+
+    return ESP_OK;
+}
+
+esp_err_t fat_cache_read(uint32_t sector, uint8_t **block)
+{
+    int32_t index;
+    esp_err_t err = load_slot(sector, &index);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    *block = blocks[index];
+
+    return ESP_OK;
+}
+
+void fat_cache_invalidate(uint32_t sector)
+{
+    int32_t index = find_slot(sector);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    slots[index].sector = FAT_CACHE_NO_SECTOR;
+}
+
+void fat_cache_update(uint32_t sector, const uint8_t *block)
+{
+    int32_t index = find_slot(sector);
+
+    if (index >= 0)
+    {
+        memcpy(blocks[index], block, BLOCKDEV_SECTOR_SIZE);
+    }
+}
+
+void fat_cache_get_stats(FAT_Cache_Stats *out)
+{
+    *out = stats;
+}
+
+void fat_cache_log_stats(void)
+{
+    ESP_LOGI(TAG, "hits: %d, misses: %d, evictions: %d",
+             (unsigned int)stats.hits, (unsigned int)stats.misses, (unsigned int)stats.evictions);
+}
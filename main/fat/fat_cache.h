@@ -0,0 +1,51 @@
+#ifndef FAT_CACHE_H
+#define FAT_CACHE_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "blockdev/blockdev.h"
+
+/**
+ * Sector cache sitting between the FAT layer & the block device.
+ * Fully associative, least recently used sector is evicted first.
+ * Holds directory sectors & unaligned reads, FAT entries go through the FAT window in fat.c instead.
+ */
+
+// How many sectors are kept in RAM, each costs a sector worth of memory
+#define FAT_CACHE_SLOTS 8
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} FAT_Cache_Stats;
+
+/**
+ * Drop everything & start caching sectors of the supplied device.
+ */
+void fat_cache_init(const Block_Device *block_device);
+
+/**
+ * Get a sector, from RAM if it is cached, from the device otherwise.
+ * `block` points into the cache & stays valid until the next cache call.
+ */
+esp_err_t fat_cache_read(uint32_t sector, uint8_t **block);
+
+/**
+ * Forget a sector, e.g. after it has been written behind the cache's back.
+ */
+void fat_cache_invalidate(uint32_t sector);
+
+/**
+ * A sector was written to the device, refresh the cached copy if there is one.
+ */
+void fat_cache_update(uint32_t sector, const uint8_t *block);
+
+void fat_cache_get_stats(FAT_Cache_Stats *stats);
+
+void fat_cache_log_stats(void);
+
+#endif
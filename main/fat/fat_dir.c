@@ -0,0 +1,351 @@
+#include "fat_dir.h"
+
+#include "fat_cache.h"
+#include "fat_lfn.h"
+#include "fat_lookup.h"
+
+#include <ctype.h>
+
+// Sector being modified when adding an entry, the cached one can't be written to
+static uint8_t dir_block[BLOCKDEV_SECTOR_SIZE];
+
+// One is enough even when recursing, a name is complete before its callback runs
+static FAT_LFN_Assembler lfn;
+
+// Separate one for reading a single name again, that may happen while a directory is being iterated
+static FAT_LFN_Assembler reread_lfn;
+
+void fat_dir_short_name(const FAT_Directory_Entry *entry, char *name)
+{
+    uint8_t index = 0;
+
+    for (uint8_t i = 0; i < 8 && entry->DIR_Name[i] != ' '; i++)
+    {
+        name[index++] = entry->DIR_Name[i];
+    }
+
+    if (entry->DIR_Name[0] == FAT_DIRECTORY_KANJI)
+    {
+        name[0] = (char)FAT_DIRECTORY_EMPTY;
+    }
+
+    // Extension is optional, no dot without one
+    if (entry->DIR_Name[8] != ' ')
+    {
+        name[index++] = '.';
+
+        for (uint8_t i = 8; i < 11 && entry->DIR_Name[i] != ' '; i++)
+        {
+            name[index++] = entry->DIR_Name[i];
+        }
+    }
+
+    name[index] = '\0';
+}
+
+uint32_t fat_dir_entry_cluster(const FAT_Directory_Entry *entry)
+{
+    return ((uint32_t)entry->DIR_FstClusHI << 16) | entry->DIR_FstClusLO;
+}
+
+bool fat_dir_is_dot_entry(const FAT_Directory_Entry *entry)
+{
+    return entry->DIR_Name[0] == '.';
+}
+
+static esp_err_t dir_iterate(uint32_t cluster, fat_dir_callback callback, void *arg)
+{
+    uint32_t sectors_per_cluster = fat_get_sectors_per_cluster();
+    uint32_t entries_per_sector = BLOCKDEV_SECTOR_SIZE / FAT_CLUSTER_ENTRY_LENGTH;
+
+    FAT_Chain_Iterator chain;
+    fat_chain_begin(&chain, cluster);
+
+    fat_lfn_reset(&lfn);
+
+    // Where the long name in progress started
+    uint32_t long_name_sector = 0;
+    uint16_t long_name_index = 0;
+
+    while (!chain.is_end)
+    {
+        uint32_t first_sector = fat_cluster_to_sector(chain.cluster);
+
+        for (uint32_t s = 0; s < sectors_per_cluster; s++)
+        {
+            for (uint32_t i = 0; i < entries_per_sector; i++)
+            {
+                // Fetched for every entry, the callback may have pushed this sector out of the cache
+                uint8_t *block;
+                esp_err_t err = fat_cache_read(first_sector + s, &block);
+
+                if (err != ESP_OK)
+                {
+                    return err;
+                }
+
+                FAT_Directory_Entry *entry = (FAT_Directory_Entry *)&block[i * FAT_CLUSTER_ENTRY_LENGTH];
+
+                if (entry->DIR_Name[0] == FAT_DIRECTORY_ALL_FREE)
+                {
+                    return ESP_OK;
+                }
+
+                // A deleted entry breaks up any long name in progress
+                if (entry->DIR_Name[0] == FAT_DIRECTORY_EMPTY)
+                {
+                    fat_lfn_reset(&lfn);
+                    continue;
+                }
+
+                if ((entry->DIR_Attr & LONG_NAME) == LONG_NAME)
+                {
+                    if (((const FAT_Directory_Long_Entry *)entry)->LDIR_Ord & FAT_LFN_LAST_ENTRY)
+                    {
+                        long_name_sector = first_sector + s;
+                        long_name_index = i;
+                    }
+
+                    fat_lfn_push(&lfn, (const FAT_Directory_Long_Entry *)entry);
+                    continue;
+                }
+
+                // The volume label is not a file
+                if (entry->DIR_Attr & VOLUME_ID)
+                {
+                    fat_lfn_reset(&lfn);
+                    continue;
+                }
+
+                // Copy out, the cached sector can go away during the callback
+                FAT_Directory_Entry copy = *entry;
+                FAT_Dir_Item item = {
+                    .entry = &copy,
+                    .long_name = fat_lfn_finish(&lfn, entry),
+                    .sector = first_sector + s,
+                    .index = i,
+                    .long_name_sector = long_name_sector,
+                    .long_name_index = long_name_index,
+                };
+
+                fat_dir_short_name(&copy, item.name);
+
+                if (!callback(&item, arg))
+                {
+                    return ESP_OK;
+                }
+
+                // The callback may have iterated another directory with the assembler
+                fat_lfn_reset(&lfn);
+            }
+        }
+
+        esp_err_t err = fat_chain_next(&chain);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fat_dir_iterate(uint32_t cluster, fat_dir_callback callback, void *arg)
+{
+    fat_lock();
+    esp_err_t err = dir_iterate(cluster, callback, arg);
+    fat_unlock();
+
+    return err;
+}
+
+esp_err_t fat_dir_read_long_name(uint32_t long_name_sector, uint16_t long_name_index, uint32_t sector, uint16_t index,
+                                 const char **long_name)
+{
+    uint32_t entries_per_sector = BLOCKDEV_SECTOR_SIZE / FAT_CLUSTER_ENTRY_LENGTH;
+    uint32_t current_sector = long_name_sector;
+    uint32_t current_index = long_name_index;
+
+    *long_name = NULL;
+    fat_lfn_reset(&reread_lfn);
+
+    // A name takes at most 20 LFN entries, more than that & it's not the name it was
+    for (uint32_t count = 0; count <= FAT_LFN_MAX_ENTRIES; count++)
+    {
+        uint8_t *block;
+        esp_err_t err = fat_cache_read(current_sector, &block);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        const FAT_Directory_Entry *entry = (const FAT_Directory_Entry *)&block[current_index * FAT_CLUSTER_ENTRY_LENGTH];
+
+        if (current_sector == sector && current_index == index)
+        {
+            *long_name = fat_lfn_finish(&reread_lfn, entry);
+            return ESP_OK;
+        }
+
+        if ((entry->DIR_Attr & LONG_NAME) != LONG_NAME)
+        {
+            return ESP_OK;
+        }
+
+        fat_lfn_push(&reread_lfn, (const FAT_Directory_Long_Entry *)entry);
+
+        // The entries may run on into the next sector or the directory's next cluster
+        if (++current_index == entries_per_sector)
+        {
+            current_index = 0;
+
+            if (!fat_next_file_sector(current_sector, &current_sector))
+            {
+                return ESP_OK;
+            }
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fat_dir_make_short_name(const char *name, uint8_t *short_name)
+{
+    memset(short_name, ' ', 11);
+
+    uint32_t index = 0;
+    uint32_t limit = 8;
+
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        if (*c == '.' && index <= 8)
+        {
+            // Only a single dot, right after the base name
+            if (limit == 11)
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+
+            index = 8;
+            limit = 11;
+            continue;
+        }
+
+        if (index >= limit || *c == ' ' || *c == '.')
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        short_name[index++] = toupper((unsigned char)*c);
+    }
+
+    if (short_name[0] == ' ')
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A leading 0xE5 would read as a deleted entry
+    if (short_name[0] == FAT_DIRECTORY_EMPTY)
+    {
+        short_name[0] = FAT_DIRECTORY_KANJI;
+    }
+
+    return ESP_OK;
+}
+
+// Write the entry into a slot of a sector
+static esp_err_t fat_dir_write_entry(uint32_t sector, uint32_t index, const FAT_Directory_Entry *entry)
+{
+    uint8_t *block;
+    esp_err_t err = fat_cache_read(sector, &block);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    memcpy(dir_block, block, BLOCKDEV_SECTOR_SIZE);
+    memcpy(&dir_block[index * FAT_CLUSTER_ENTRY_LENGTH], entry, FAT_CLUSTER_ENTRY_LENGTH);
+
+    return fat_write_sector(sector, dir_block);
+}
+
+esp_err_t fat_dir_add_entry(uint32_t cluster, const FAT_Directory_Entry *entry)
+{
+    // Whatever happens below, the directory is not what its lookup table says anymore
+    fat_lookup_invalidate(cluster);
+
+    uint32_t sectors_per_cluster = fat_get_sectors_per_cluster();
+    uint32_t entries_per_sector = BLOCKDEV_SECTOR_SIZE / FAT_CLUSTER_ENTRY_LENGTH;
+
+    FAT_Chain_Iterator chain;
+    fat_chain_begin(&chain, cluster);
+
+    uint32_t last_cluster = cluster;
+
+    while (!chain.is_end)
+    {
+        uint32_t first_sector = fat_cluster_to_sector(chain.cluster);
+
+        for (uint32_t s = 0; s < sectors_per_cluster; s++)
+        {
+            uint8_t *block;
+            esp_err_t err = fat_cache_read(first_sector + s, &block);
+
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+
+            for (uint32_t i = 0; i < entries_per_sector; i++)
+            {
+                uint8_t first = block[i * FAT_CLUSTER_ENTRY_LENGTH];
+
+                if (first == FAT_DIRECTORY_ALL_FREE || first == FAT_DIRECTORY_EMPTY)
+                {
+                    return fat_dir_write_entry(first_sector + s, i, entry);
+                }
+            }
+        }
+
+        last_cluster = chain.cluster;
+
+        esp_err_t err = fat_chain_next(&chain);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    // Every slot taken, grow the directory. The new cluster must read as all free
+    uint32_t new_cluster;
+    esp_err_t err = fat_allocate_chain(last_cluster, 1, &new_cluster);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint32_t first_sector = fat_cluster_to_sector(new_cluster);
+
+    memset(dir_block, 0, BLOCKDEV_SECTOR_SIZE);
+    memcpy(dir_block, entry, FAT_CLUSTER_ENTRY_LENGTH);
+
+    for (uint32_t s = 0; s < sectors_per_cluster; s++)
+    {
+        err = fat_write_sector(first_sector + s, dir_block);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        // Only the first sector holds the entry
+        memset(dir_block, 0, FAT_CLUSTER_ENTRY_LENGTH);
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,73 @@
+#ifndef FAT_DIR_H
+#define FAT_DIR_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "fat.h"
+
+// "NAME.EXT" & a terminator
+#define FAT_SHORT_NAME_LENGTH 13
+
+/**
+ * A live directory entry handed out while iterating a directory.
+ * Deleted entries, volume labels & long name fragments are never handed out.
+ */
+typedef struct
+{
+    const FAT_Directory_Entry *entry;
+    char name[FAT_SHORT_NAME_LENGTH];
+    const char *long_name; // UTF-8, NULL when the entry has no (valid) long name. Gone once another directory is iterated
+    uint32_t sector; // Where the entry lives, for finding it again
+    uint16_t index;  // Entry index within that sector
+    uint32_t long_name_sector; // Where the long name's first LFN entry lives, when there is a long name
+    uint16_t long_name_index;
+} FAT_Dir_Item;
+
+/**
+ * Called for every entry of a directory, return false to stop iterating.
+ * The entry is only valid during the call.
+ */
+typedef bool (*fat_dir_callback)(const FAT_Dir_Item *item, void *arg);
+
+/**
+ * Go over every entry of the directory starting at `cluster`, following its cluster chain.
+ * Long names are assembled on the way, without allocating.
+ * Callbacks are free to iterate other directories, e.g. to recurse - after they are done with `long_name`.
+ */
+esp_err_t fat_dir_iterate(uint32_t cluster, fat_dir_callback callback, void *arg);
+
+/**
+ * Put a long name together again from its LFN entries on disk, as located by an item: from the first LFN entry
+ * at `long_name_sector`/`long_name_index` up to the short entry at `sector`/`index`.
+ * `long_name` is NULL when the entries there don't make up a long name of that entry (anymore).
+ * The name is good until the next call.
+ */
+esp_err_t fat_dir_read_long_name(uint32_t long_name_sector, uint16_t long_name_index, uint32_t sector, uint16_t index,
+                                 const char **long_name);
+
+/**
+ * "NAME.EXT" from the padded 8.3 name of an entry.
+ */
+void fat_dir_short_name(const FAT_Directory_Entry *entry, char *name);
+
+// First cluster of the entry, split over two fields
+uint32_t fat_dir_entry_cluster(const FAT_Directory_Entry *entry);
+
+// "." & ".." entries of a subdirectory
+bool fat_dir_is_dot_entry(const FAT_Directory_Entry *entry);
+
+/**
+ * Padded & upper cased 8.3 name from "NAME.EXT", for a new entry.
+ * ESP_ERR_INVALID_ARG if the name does not fit 8.3, there is no long name support for writing.
+ */
+esp_err_t fat_dir_make_short_name(const char *name, uint8_t *short_name);
+
+/**
+ * Put an entry into the first free slot of the directory, deleted or never used.
+ * A full directory grows by a cluster.
+ */
+esp_err_t fat_dir_add_entry(uint32_t cluster, const FAT_Directory_Entry *entry);
+
+#endif
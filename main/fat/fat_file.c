@@ -0,0 +1,479 @@
+#include "fat_file.h"
+
+#include "esp_timer.h"
+#include "fat_prefetch.h"
+#include "fat_cache.h"
+#include "fat_dir.h"
+#include "fat_lookup.h"
+
+static const char *TAG = "FAT_FILE";
+
+static esp_err_t file_open_cluster(FAT_File *file, uint32_t first_cluster, uint32_t size)
+{
+    int64_t start = esp_timer_get_time();
+
+    file->first_cluster = first_cluster;
+    file->size = size;
+    file->position = 0;
+    file->extent_count = 0;
+    file->is_fragmented_past_extents = false;
+    file->walked_file_cluster = 0;
+    file->walked_cluster = 0;
+    file->is_sector_buffered = false;
+
+    // Empty files have no clusters at all
+    if (size == 0 || first_cluster < 2)
+    {
+        return ESP_OK;
+    }
+
+    FAT_Chain_Iterator chain;
+    fat_chain_begin(&chain, first_cluster);
+
+    FAT_Extent *extent = &file->extents[0];
+    extent->start_cluster = first_cluster;
+    extent->length = 1;
+    extent->file_cluster = 0;
+    file->extent_count = 1;
+
+    while (1)
+    {
+        uint32_t previous = chain.cluster;
+        esp_err_t err = fat_chain_next(&chain);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        if (chain.is_end)
+        {
+            break;
+        }
+
+        if (chain.cluster == previous + 1)
+        {
+            extent->length++;
+            continue;
+        }
+
+        // Out of room, the rest gets walked when it is needed
+        if (file->extent_count == FAT_FILE_MAX_EXTENTS)
+        {
+            file->is_fragmented_past_extents = true;
+            break;
+        }
+
+        extent = &file->extents[file->extent_count++];
+        extent->start_cluster = chain.cluster;
+        extent->length = 1;
+        extent->file_cluster = chain.index;
+    }
+
+    ESP_LOGI(TAG, "Cluster %d: %d extents%s, built in %d us",
+             (unsigned int)first_cluster, (unsigned int)file->extent_count,
+             file->is_fragmented_past_extents ? " (more not mapped)" : "",
+             (unsigned int)(esp_timer_get_time() - start));
+
+    return ESP_OK;
+}
+
+esp_err_t fat_file_open_cluster(FAT_File *file, uint32_t first_cluster, uint32_t size)
+{
+    fat_lock();
+    esp_err_t err = file_open_cluster(file, first_cluster, size);
+    fat_unlock();
+
+    return err;
+}
+
+esp_err_t fat_open(FAT_File *file, const char *path)
+{
+    uint32_t cluster = fat_get_root_cluster();
+    bool is_directory = true;
+    FAT_Lookup_Entry entry = {0};
+
+    const char *component = path;
+
+    while (*component != '\0')
+    {
+        const char *end = strchr(component, '/');
+        uint32_t length = end != NULL ? end - component : strlen(component);
+
+        // Leading, doubled & trailing slashes, "."
+        if (length == 0 || (length == 1 && component[0] == '.'))
+        {
+            component += length + (end != NULL ? 1 : 0);
+            continue;
+        }
+
+        if (!is_directory)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        esp_err_t err = fat_lookup(cluster, component, length, &entry);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        is_directory = (entry.attributes & DIRECTORY) != 0;
+
+        // ".." back to the root points at cluster 0
+        cluster = entry.first_cluster != 0 ? entry.first_cluster : fat_get_root_cluster();
+
+        component += length + (end != NULL ? 1 : 0);
+    }
+
+    if (is_directory)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return fat_file_open_cluster(file, entry.first_cluster, entry.size);
+}
+
+esp_err_t fat_file_seek(FAT_File *file, uint32_t position)
+{
+    if (position > file->size)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    file->position = position;
+
+    return ESP_OK;
+}
+
+esp_err_t fat_file_map(FAT_File *file, uint32_t position, uint32_t *sector, uint32_t *contiguous_bytes)
+{
+    if (file->extent_count == 0 || position >= file->size)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t cluster_bytes = fat_get_sectors_per_cluster() * BLOCKDEV_SECTOR_SIZE;
+    uint32_t file_cluster = position / cluster_bytes;
+    uint32_t cluster_offset = position % cluster_bytes;
+
+    // Binary search for the last extent starting at or before the cluster
+    uint32_t low = 0;
+    uint32_t high = file->extent_count - 1;
+
+    while (low < high)
+    {
+        uint32_t middle = (low + high + 1) / 2;
+
+        if (file->extents[middle].file_cluster <= file_cluster)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    FAT_Extent *extent = &file->extents[low];
+    uint32_t extent_end = extent->file_cluster + extent->length;
+
+    if (file_cluster < extent_end)
+    {
+        uint32_t cluster = extent->start_cluster + (file_cluster - extent->file_cluster);
+
+        *sector = fat_cluster_to_sector(cluster) + cluster_offset / BLOCKDEV_SECTOR_SIZE;
+        *contiguous_bytes = (extent_end - file_cluster) * cluster_bytes - cluster_offset;
+
+        return ESP_OK;
+    }
+
+    if (!file->is_fragmented_past_extents)
+    {
+        ESP_LOGE(TAG, "Position %d is past the cluster chain", (unsigned int)position);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Past the mapped extents, walk on from the last mapped cluster or from where the last walk ended,
+    // so reading on sequentially costs a step per cluster rather than a walk from the extents every time
+    uint32_t index = extent_end - 1;
+    uint32_t from = extent->start_cluster + extent->length - 1;
+
+    if (file->walked_cluster != 0 && file->walked_file_cluster > index && file->walked_file_cluster <= file_cluster)
+    {
+        index = file->walked_file_cluster;
+        from = file->walked_cluster;
+    }
+
+    FAT_Chain_Iterator chain;
+    fat_chain_begin(&chain, from);
+
+    for (; index < file_cluster; index++)
+    {
+        esp_err_t err = fat_chain_next(&chain);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        if (chain.is_end)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    file->walked_file_cluster = file_cluster;
+    file->walked_cluster = chain.cluster;
+
+    *sector = fat_cluster_to_sector(chain.cluster) + cluster_offset / BLOCKDEV_SECTOR_SIZE;
+    *contiguous_bytes = cluster_bytes - cluster_offset;
+
+    return ESP_OK;
+}
+
+// Copy a piece of a single sector, through the read-ahead so small sequential reads stay cheap
+static esp_err_t read_partial_sector(FAT_File *file, uint32_t sector, uint32_t offset, uint8_t *destination, uint32_t length)
+{
+    if (!file->is_sector_buffered || file->buffered_sector != sector)
+    {
+        file->is_sector_buffered = false;
+
+        esp_err_t err = fat_prefetch_read(sector, file->sector_buffer);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        file->buffered_sector = sector;
+        file->is_sector_buffered = true;
+    }
+
+    memcpy(destination, &file->sector_buffer[offset], sizeof(uint8_t) * length);
+
+    return ESP_OK;
+}
+
+static esp_err_t file_read(FAT_File *file, uint8_t *destination, uint32_t size, uint32_t *bytes_read)
+{
+    *bytes_read = 0;
+
+    // Compared this way round, position + size could wrap for a huge size
+    if (size > file->size - file->position)
+    {
+        size = file->size - file->position;
+    }
+
+    while (*bytes_read < size)
+    {
+        uint32_t sector;
+        uint32_t contiguous;
+        esp_err_t err = fat_file_map(file, file->position, &sector, &contiguous);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        uint32_t wanted = size - *bytes_read;
+        uint32_t offset = file->position % BLOCKDEV_SECTOR_SIZE;
+        uint32_t length;
+
+        if (offset != 0 || wanted < BLOCKDEV_SECTOR_SIZE)
+        {
+            // Piece of a sector
+            length = BLOCKDEV_SECTOR_SIZE - offset;
+
+            if (length > wanted)
+            {
+                length = wanted;
+            }
+
+            err = read_partial_sector(file, sector, offset, &destination[*bytes_read], length);
+        }
+        else
+        {
+            // As many whole sectors as the extent & the request allow, from the read-ahead or one multi-block read
+            length = (wanted < contiguous ? wanted : contiguous) / BLOCKDEV_SECTOR_SIZE * BLOCKDEV_SECTOR_SIZE;
+
+            err = fat_prefetch_read_many(sector, length / BLOCKDEV_SECTOR_SIZE, &destination[*bytes_read]);
+        }
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        file->position += length;
+        *bytes_read += length;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fat_file_read(FAT_File *file, uint8_t *destination, uint32_t size, uint32_t *bytes_read)
+{
+    fat_lock();
+    esp_err_t err = file_read(file, destination, size, bytes_read);
+    fat_unlock();
+
+    return err;
+}
+
+static esp_err_t file_create(FAT_File *file, uint32_t dir_cluster, const char *name, uint32_t size)
+{
+    FAT_Directory_Entry entry = {0};
+
+    esp_err_t err = fat_dir_make_short_name(name, entry.DIR_Name);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Not an 8.3 name: %s", name);
+        return err;
+    }
+
+    uint32_t cluster_bytes = fat_get_sectors_per_cluster() * BLOCKDEV_SECTOR_SIZE;
+    uint32_t first_cluster = 0;
+
+    // XXX no clock, timestamps stay 0
+    err = fat_allocate_chain(0, (size + cluster_bytes - 1) / cluster_bytes, &first_cluster);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    entry.DIR_Attr = ARCHIVE;
+    entry.DIR_FstClusHI = first_cluster >> 16;
+    entry.DIR_FstClusLO = first_cluster & 0xFFFF;
+    entry.DIR_FileSize = size;
+
+    err = fat_dir_add_entry(dir_cluster, &entry);
+
+    if (err != ESP_OK)
+    {
+        // Nothing points at the chain, it would be lost for good
+        fat_free_chain(first_cluster);
+        return err;
+    }
+
+    return file_open_cluster(file, first_cluster, size);
+}
+
+esp_err_t fat_file_create(FAT_File *file, uint32_t dir_cluster, const char *name, uint32_t size)
+{
+    fat_lock();
+    esp_err_t err = file_create(file, dir_cluster, name, size);
+    fat_unlock();
+
+    return err;
+}
+
+// Patch a piece of a single sector
+static esp_err_t write_partial_sector(FAT_File *file, uint32_t sector, uint32_t offset, const uint8_t *source, uint32_t length)
+{
+    // The file's own buffer doubles as the scratch space
+    file->is_sector_buffered = false;
+
+    esp_err_t err = blockdev_read(fat_get_block_device(), sector, file->sector_buffer);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    memcpy(&file->sector_buffer[offset], source, sizeof(uint8_t) * length);
+
+    err = fat_write_sector(sector, file->sector_buffer);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    file->buffered_sector = sector;
+    file->is_sector_buffered = true;
+
+    return ESP_OK;
+}
+
+static esp_err_t file_write(FAT_File *file, const uint8_t *source, uint32_t size, uint32_t *bytes_written)
+{
+    *bytes_written = 0;
+
+    if (size > file->size - file->position)
+    {
+        size = file->size - file->position;
+    }
+
+    // Whatever was read ahead may be stale now
+    fat_prefetch_reset();
+
+    while (*bytes_written < size)
+    {
+        uint32_t sector;
+        uint32_t contiguous;
+        esp_err_t err = fat_file_map(file, file->position, &sector, &contiguous);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        uint32_t wanted = size - *bytes_written;
+        uint32_t offset = file->position % BLOCKDEV_SECTOR_SIZE;
+        uint32_t length;
+
+        if (offset != 0 || wanted < BLOCKDEV_SECTOR_SIZE)
+        {
+            length = BLOCKDEV_SECTOR_SIZE - offset;
+
+            if (length > wanted)
+            {
+                length = wanted;
+            }
+
+            err = write_partial_sector(file, sector, offset, &source[*bytes_written], length);
+        }
+        else
+        {
+            length = (wanted < contiguous ? wanted : contiguous) / BLOCKDEV_SECTOR_SIZE * BLOCKDEV_SECTOR_SIZE;
+
+            uint32_t count = length / BLOCKDEV_SECTOR_SIZE;
+
+            err = blockdev_write_many(fat_get_block_device(), sector, count, &source[*bytes_written]);
+
+            // Data sectors only end up cached when read unaligned, drop any that were
+            for (uint32_t i = 0; i < count; i++)
+            {
+                fat_cache_invalidate(sector + i);
+            }
+
+            if (file->is_sector_buffered && file->buffered_sector >= sector && file->buffered_sector < sector + count)
+            {
+                file->is_sector_buffered = false;
+            }
+        }
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        file->position += length;
+        *bytes_written += length;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fat_file_write(FAT_File *file, const uint8_t *source, uint32_t size, uint32_t *bytes_written)
+{
+    fat_lock();
+    esp_err_t err = file_write(file, source, size, bytes_written);
+    fat_unlock();
+
+    return err;
+}
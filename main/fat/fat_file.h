@@ -0,0 +1,89 @@
+#ifndef FAT_FILE_H
+#define FAT_FILE_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "fat.h"
+
+/**
+ * Open files. On open the cluster chain is squashed into extents - runs of consecutive clusters.
+ * Freshly written cards store files in one piece, so it's usually a single extent.
+ * Seeking is a binary search over the extents & every extent can be read with a single multi-block read.
+ */
+
+// Extents kept per file, past this the rest of the chain is walked on demand
+#define FAT_FILE_MAX_EXTENTS 32
+
+typedef struct
+{
+    uint32_t start_cluster;
+    uint32_t length;       // In clusters
+    uint32_t file_cluster; // Index of the first cluster within the file
+} FAT_Extent;
+
+typedef struct
+{
+    uint32_t first_cluster;
+    uint32_t size;
+    uint32_t position;
+
+    FAT_Extent extents[FAT_FILE_MAX_EXTENTS];
+    uint32_t extent_count;
+    bool is_fragmented_past_extents; // Chain goes on past the last extent
+
+    // Where the last walk past the extents got to, the next one goes on from there instead of the last extent
+    uint32_t walked_file_cluster;
+    uint32_t walked_cluster;
+
+    // Last partially read sector, repeated small reads don't go back to the device
+    uint8_t sector_buffer[BLOCKDEV_SECTOR_SIZE];
+    uint32_t buffered_sector;
+    bool is_sector_buffered;
+} FAT_File;
+
+/**
+ * Open a file by its first cluster & size, as found in its directory entry.
+ */
+esp_err_t fat_file_open_cluster(FAT_File *file, uint32_t first_cluster, uint32_t size);
+
+/**
+ * Open a file by its path from the root, e.g. "Music/Artist/Album/track07.wav".
+ * Components are matched against long & short names, ignoring ASCII case.
+ * Each directory on the way is looked up through its hash table, so repeated opens don't rescan directories.
+ * ESP_ERR_NOT_FOUND if a component does not exist, ESP_ERR_INVALID_ARG if the path leads to a directory.
+ */
+esp_err_t fat_open(FAT_File *file, const char *path);
+
+/**
+ * Move to a byte position, can't go past the end of the file.
+ */
+esp_err_t fat_file_seek(FAT_File *file, uint32_t position);
+
+/**
+ * Read up to `size` bytes from the current position, `bytes_read` tells how many made it (less at the end of the file).
+ * Whole sectors come from the read-ahead ring while reading sequentially, otherwise straight into the destination
+ * with a multi-block read per extent.
+ */
+esp_err_t fat_file_read(FAT_File *file, uint8_t *destination, uint32_t size, uint32_t *bytes_read);
+
+/**
+ * Create a file of `size` bytes in a directory & open it. All its clusters are allocated up front,
+ * writes can't grow the file past that. The contents start out as whatever the clusters held.
+ * `name` must be a plain 8.3 name, e.g. "TRACKS.IDX".
+ */
+esp_err_t fat_file_create(FAT_File *file, uint32_t dir_cluster, const char *name, uint32_t size);
+
+/**
+ * Write up to `size` bytes at the current position, `bytes_written` stops short at the end of the file.
+ * Whole sectors go to the device with a single multi-block write per extent, partial ones are read, patched & written back.
+ */
+esp_err_t fat_file_write(FAT_File *file, const uint8_t *source, uint32_t size, uint32_t *bytes_written);
+
+/**
+ * Device sector holding a byte position of the file & how many bytes from there on are contiguous on the device.
+ */
+esp_err_t fat_file_map(FAT_File *file, uint32_t position, uint32_t *sector, uint32_t *contiguous_bytes);
+
+#endif
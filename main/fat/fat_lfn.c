@@ -0,0 +1,188 @@
+#include "fat_lfn.h"
+
+#define UTF16_HIGH_SURROGATE_MIN 0xD800
+#define UTF16_LOW_SURROGATE_MIN 0xDC00
+#define UTF16_LOW_SURROGATE_MAX 0xDFFF
+#define UTF8_REPLACEMENT 0xFFFD
+
+// Where the 13 units sit within an entry, as byte offsets
+static const uint8_t unit_offsets[FAT_LFN_CHARS_PER_ENTRY] = {
+    1, 3, 5, 7, 9,            // LDIR_Name1
+    14, 16, 18, 20, 22, 24,   // LDIR_Name2
+    28, 30,                   // LDIR_Name3
+};
+
+void fat_lfn_reset(FAT_LFN_Assembler *lfn)
+{
+    lfn->start = FAT_LFN_BUFFER_SIZE - 1;
+    lfn->buffer[lfn->start] = '\0';
+    lfn->units = 0;
+    lfn->pending_low = 0;
+    lfn->next_ord = 0;
+    lfn->checksum = 0;
+}
+
+uint8_t fat_lfn_checksum(const uint8_t *short_name)
+{
+    uint8_t sum = 0;
+
+    for (uint8_t i = 0; i < 11; i++)
+    {
+        // Rotate right by one, then add
+        sum = ((sum & 1) ? 0x80 : 0) + (sum >> 1) + short_name[i];
+    }
+
+    return sum;
+}
+
+// Put a code point in front of what is already there
+static void prepend_code_point(FAT_LFN_Assembler *lfn, uint32_t code_point)
+{
+    uint8_t bytes[4];
+    uint8_t length;
+
+    if (code_point <= 0x7F)
+    {
+        bytes[0] = code_point;
+        length = 1;
+    }
+    else if (code_point <= 0x7FF)
+    {
+        bytes[0] = 0xC0 | (code_point >> 6);
+        bytes[1] = 0x80 | (code_point & 0x3F);
+        length = 2;
+    }
+    else if (code_point <= 0xFFFF)
+    {
+        bytes[0] = 0xE0 | (code_point >> 12);
+        bytes[1] = 0x80 | ((code_point >> 6) & 0x3F);
+        bytes[2] = 0x80 | (code_point & 0x3F);
+        length = 3;
+    }
+    else
+    {
+        bytes[0] = 0xF0 | (code_point >> 18);
+        bytes[1] = 0x80 | ((code_point >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((code_point >> 6) & 0x3F);
+        bytes[3] = 0x80 | (code_point & 0x3F);
+        length = 4;
+    }
+
+    lfn->start -= length;
+    memcpy(&lfn->buffer[lfn->start], bytes, length);
+}
+
+// Units arrive back to front, so a low surrogate shows up before its high half
+static void prepend_unit(FAT_LFN_Assembler *lfn, uint16_t unit)
+{
+    bool is_low = unit >= UTF16_LOW_SURROGATE_MIN && unit <= UTF16_LOW_SURROGATE_MAX;
+    bool is_high = unit >= UTF16_HIGH_SURROGATE_MIN && unit < UTF16_LOW_SURROGATE_MIN;
+
+    if (is_high && lfn->pending_low != 0)
+    {
+        uint32_t code_point = 0x10000 + (((uint32_t)unit - UTF16_HIGH_SURROGATE_MIN) << 10) + (lfn->pending_low - UTF16_LOW_SURROGATE_MIN);
+
+        lfn->pending_low = 0;
+        prepend_code_point(lfn, code_point);
+        return;
+    }
+
+    // An unpaired low surrogate left behind
+    if (lfn->pending_low != 0)
+    {
+        lfn->pending_low = 0;
+        prepend_code_point(lfn, UTF8_REPLACEMENT);
+    }
+
+    if (is_low)
+    {
+        lfn->pending_low = unit;
+        return;
+    }
+
+    prepend_code_point(lfn, is_high ? UTF8_REPLACEMENT : unit);
+}
+
+void fat_lfn_push(FAT_LFN_Assembler *lfn, const FAT_Directory_Long_Entry *entry)
+{
+    const uint8_t *raw = (const uint8_t *)entry;
+    uint8_t ord = entry->LDIR_Ord & FAT_LFN_ORD_MASK;
+    bool is_last = (entry->LDIR_Ord & FAT_LFN_LAST_ENTRY) != 0;
+
+    // The last piece starts a new sequence, whatever came before it was an orphan
+    if (is_last)
+    {
+        fat_lfn_reset(lfn);
+
+        if (ord == 0 || ord > FAT_LFN_MAX_ENTRIES)
+        {
+            return;
+        }
+
+        lfn->checksum = entry->LDIR_Chksum;
+    }
+    else if (ord == 0 || ord != lfn->next_ord || entry->LDIR_Chksum != lfn->checksum)
+    {
+        fat_lfn_reset(lfn);
+        return;
+    }
+
+    if (entry->LDIR_Type != 0 || entry->LDIR_FstClusLO != 0)
+    {
+        fat_lfn_reset(lfn);
+        return;
+    }
+
+    // Only the last piece may end early, with a 0x0000 terminator & 0xFFFF padding after it
+    uint8_t length = FAT_LFN_CHARS_PER_ENTRY;
+
+    for (uint8_t i = 0; i < FAT_LFN_CHARS_PER_ENTRY; i++)
+    {
+        uint16_t unit = raw[unit_offsets[i]] | (raw[unit_offsets[i] + 1] << 8);
+
+        if (unit == 0x0000 || unit == 0xFFFF)
+        {
+            length = i;
+            break;
+        }
+    }
+
+    if ((length < FAT_LFN_CHARS_PER_ENTRY && !is_last) || lfn->units + length > FAT_LFN_MAX_CHARS)
+    {
+        fat_lfn_reset(lfn);
+        return;
+    }
+
+    for (int8_t i = length - 1; i >= 0; i--)
+    {
+        prepend_unit(lfn, raw[unit_offsets[i]] | (raw[unit_offsets[i] + 1] << 8));
+    }
+
+    lfn->units += length;
+    lfn->next_ord = ord - 1;
+}
+
+const char *fat_lfn_finish(FAT_LFN_Assembler *lfn, const FAT_Directory_Entry *entry)
+{
+    // Ordinal 1 must have been the last one in, no more, no less
+    bool is_complete = lfn->units > 0 && lfn->next_ord == 0 && lfn->start < FAT_LFN_BUFFER_SIZE - 1;
+    bool is_match = is_complete && fat_lfn_checksum(entry->DIR_Name) == lfn->checksum;
+
+    if (is_match && lfn->pending_low != 0)
+    {
+        prepend_code_point(lfn, UTF8_REPLACEMENT);
+    }
+
+    // Keep the name, only forget the sequence
+    uint32_t start = lfn->start;
+    fat_lfn_reset(lfn);
+
+    if (!is_match)
+    {
+        return NULL;
+    }
+
+    lfn->start = start;
+
+    return &lfn->buffer[start];
+}
@@ -0,0 +1,53 @@
+#ifndef FAT_LFN_H
+#define FAT_LFN_H
+
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "fat.h"
+
+/**
+ * Long file names, put back together from the LFN entries in front of a short entry.
+ * Entries come last piece first (LDIR_Ord N | 0x40, N-1, ... 1), every one holds 13 UTF-16 units.
+ * The name is converted to UTF-8 as the entries arrive, written from the back of a single fixed buffer towards the front.
+ * A sequence with a gap in the ordinals, a bad checksum or no short entry right after it is dropped,
+ * the short name is all there is then.
+ */
+
+#define FAT_LFN_MAX_CHARS 255 // In UTF-16 units
+#define FAT_LFN_CHARS_PER_ENTRY 13
+#define FAT_LFN_MAX_ENTRIES 20
+#define FAT_LFN_LAST_ENTRY 0x40 // LDIR_Ord flag of the first entry on disk, the last piece of the name
+#define FAT_LFN_ORD_MASK 0x3F
+
+// Worst case UTF-8: 3 bytes per unit, a surrogate pair takes 4 for 2 units. And a terminator
+#define FAT_LFN_BUFFER_SIZE (FAT_LFN_MAX_CHARS * 3 + 1)
+
+typedef struct
+{
+    char buffer[FAT_LFN_BUFFER_SIZE];
+    uint32_t start; // The name begins here & runs to the end of the buffer
+    uint16_t units; // UTF-16 units taken so far
+    uint16_t pending_low; // Low surrogate still waiting for its high half, 0 if none
+    uint8_t next_ord; // Ordinal the next entry must have, 0 outside of a sequence
+    uint8_t checksum;
+} FAT_LFN_Assembler;
+
+void fat_lfn_reset(FAT_LFN_Assembler *lfn);
+
+/**
+ * Feed an LFN entry, in the order they are on disk.
+ */
+void fat_lfn_push(FAT_LFN_Assembler *lfn, const FAT_Directory_Long_Entry *entry);
+
+/**
+ * Hand over the short entry following the LFN entries.
+ * Returns the UTF-8 long name if a complete sequence belongs to it, NULL otherwise.
+ * The name lives in the assembler & is good until it is fed again. Resets the assembler either way.
+ */
+const char *fat_lfn_finish(FAT_LFN_Assembler *lfn, const FAT_Directory_Entry *entry);
+
+// Checksum of an 11 byte padded short name, every LFN entry of the file carries it
+uint8_t fat_lfn_checksum(const uint8_t *short_name);
+
+#endif
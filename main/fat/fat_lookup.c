@@ -0,0 +1,336 @@
+#include "fat_lookup.h"
+
+#include "fat_cache.h"
+#include "fat_dir.h"
+
+// long_name_index of a short name's slot, that name is read back from the entry itself
+#define SLOT_SHORT_NAME 0xFF
+
+typedef struct
+{
+    uint32_t hash;
+    uint16_t length; // Of the name, a cheap second check next to the hash
+    bool is_used;
+    uint8_t long_name_index; // Where the long name starts, SLOT_SHORT_NAME for the short name
+    uint32_t long_name_sector;
+    FAT_Lookup_Entry entry;
+} FAT_Lookup_Slot;
+
+typedef struct
+{
+    uint32_t cluster; // Directory the table is for, 0 when the table is free
+    uint32_t last_used;
+    uint32_t count;
+    bool is_complete; // Every name made it in, so a miss is final
+    FAT_Lookup_Slot slots[FAT_LOOKUP_SLOTS];
+} FAT_Lookup_Table;
+
+// Name being looked for during a fallback scan
+typedef struct
+{
+    const char *name;
+    uint32_t length;
+    FAT_Lookup_Entry *result;
+    bool is_found;
+} Scan_Context;
+
+static const char *TAG = "FAT_LOOKUP";
+
+static FAT_Lookup_Table tables[FAT_LOOKUP_TABLES];
+static uint32_t use_counter = 0;
+static FAT_Lookup_Stats stats;
+
+static char fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// FNV-1a over the case folded name
+static uint32_t hash_name(const char *name, uint32_t length)
+{
+    uint32_t hash = UTILS_FNV1A_INIT;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint8_t c = fold(name[i]);
+        hash = utils_hash_fnv1a(hash, &c, 1);
+    }
+
+    return hash;
+}
+
+static bool names_match(const char *a, uint32_t a_length, const char *b, uint32_t b_length)
+{
+    if (a_length != b_length)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < a_length; i++)
+    {
+        if (fold(a[i]) != fold(b[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void entry_from_item(const FAT_Dir_Item *item, FAT_Lookup_Entry *entry)
+{
+    entry->first_cluster = fat_dir_entry_cluster(item->entry);
+    entry->size = item->entry->DIR_FileSize;
+    entry->sector = item->sector;
+    entry->index = item->index;
+    entry->attributes = item->entry->DIR_Attr;
+}
+
+static void insert_name(FAT_Lookup_Table *table, const char *name, const FAT_Dir_Item *item, bool is_long_name,
+                        const FAT_Lookup_Entry *entry)
+{
+    if (table->count >= FAT_LOOKUP_MAX_NAMES)
+    {
+        table->is_complete = false;
+        return;
+    }
+
+    uint32_t length = strlen(name);
+    uint32_t hash = hash_name(name, length);
+    uint32_t slot = hash & (FAT_LOOKUP_SLOTS - 1);
+
+    // Linear probing, the table is never full so there always is a free slot
+    while (table->slots[slot].is_used)
+    {
+        slot = (slot + 1) & (FAT_LOOKUP_SLOTS - 1);
+    }
+
+    table->slots[slot].hash = hash;
+    table->slots[slot].length = length;
+    table->slots[slot].long_name_index = is_long_name ? item->long_name_index : SLOT_SHORT_NAME;
+    table->slots[slot].long_name_sector = item->long_name_sector;
+    table->slots[slot].entry = *entry;
+    table->slots[slot].is_used = true;
+    table->count++;
+}
+
+static bool build_entry(const FAT_Dir_Item *item, void *arg)
+{
+    FAT_Lookup_Table *table = (FAT_Lookup_Table *)arg;
+    FAT_Lookup_Entry entry;
+
+    entry_from_item(item, &entry);
+
+    if (item->long_name != NULL)
+    {
+        insert_name(table, item->long_name, item, true, &entry);
+    }
+
+    insert_name(table, item->name, item, false, &entry);
+
+    return true;
+}
+
+static bool scan_entry(const FAT_Dir_Item *item, void *arg)
+{
+    Scan_Context *context = (Scan_Context *)arg;
+
+    bool is_match = names_match(item->name, strlen(item->name), context->name, context->length) ||
+                    (item->long_name != NULL && names_match(item->long_name, strlen(item->long_name), context->name, context->length));
+
+    if (is_match)
+    {
+        entry_from_item(item, context->result);
+        context->is_found = true;
+    }
+
+    return !is_match;
+}
+
+// Hash & length say little about the name itself, read it back from the directory & compare for real
+static esp_err_t confirm_name(const FAT_Lookup_Slot *slot, const char *name, uint32_t length, bool *is_match)
+{
+    *is_match = false;
+
+    if (slot->long_name_index == SLOT_SHORT_NAME)
+    {
+        uint8_t *block;
+        esp_err_t err = fat_cache_read(slot->entry.sector, &block);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        char short_name[FAT_SHORT_NAME_LENGTH];
+        fat_dir_short_name((const FAT_Directory_Entry *)&block[slot->entry.index * FAT_CLUSTER_ENTRY_LENGTH], short_name);
+
+        *is_match = names_match(short_name, strlen(short_name), name, length);
+
+        return ESP_OK;
+    }
+
+    const char *long_name;
+    esp_err_t err = fat_dir_read_long_name(slot->long_name_sector, slot->long_name_index, slot->entry.sector,
+                                           slot->entry.index, &long_name);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    *is_match = long_name != NULL && names_match(long_name, strlen(long_name), name, length);
+
+    return ESP_OK;
+}
+
+// Table of the directory, built when there is none yet
+static esp_err_t get_table(uint32_t dir_cluster, FAT_Lookup_Table **table)
+{
+    FAT_Lookup_Table *victim = &tables[0];
+
+    for (uint32_t i = 0; i < FAT_LOOKUP_TABLES; i++)
+    {
+        if (tables[i].cluster == dir_cluster)
+        {
+            tables[i].last_used = ++use_counter;
+            *table = &tables[i];
+            return ESP_OK;
+        }
+
+        if (tables[i].cluster == 0 || (victim->cluster != 0 && tables[i].last_used < victim->last_used))
+        {
+            victim = &tables[i];
+        }
+    }
+
+    memset(victim->slots, 0, sizeof(victim->slots));
+    victim->cluster = 0;
+    victim->count = 0;
+    victim->is_complete = true;
+
+    esp_err_t err = fat_dir_iterate(dir_cluster, build_entry, victim);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    victim->cluster = dir_cluster;
+    victim->last_used = ++use_counter;
+    stats.builds++;
+
+    ESP_LOGD(TAG, "Cluster %d: %d names%s", (unsigned int)dir_cluster, (unsigned int)victim->count,
+             victim->is_complete ? "" : " (table full)");
+
+    *table = victim;
+
+    return ESP_OK;
+}
+
+static esp_err_t lookup(uint32_t dir_cluster, const char *name, uint32_t length, FAT_Lookup_Entry *result)
+{
+    FAT_Lookup_Table *table;
+    esp_err_t err = get_table(dir_cluster, &table);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint32_t hash = hash_name(name, length);
+    uint32_t slot = hash & (FAT_LOOKUP_SLOTS - 1);
+
+    while (table->slots[slot].is_used)
+    {
+        if (table->slots[slot].hash == hash && table->slots[slot].length == length)
+        {
+            bool is_match;
+            err = confirm_name(&table->slots[slot], name, length, &is_match);
+
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+
+            if (is_match)
+            {
+                *result = table->slots[slot].entry;
+                stats.hits++;
+                return ESP_OK;
+            }
+
+            // Another name with the same hash, keep probing
+            stats.collisions++;
+        }
+
+        slot = (slot + 1) & (FAT_LOOKUP_SLOTS - 1);
+    }
+
+    if (table->is_complete)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Some names did not fit, only a scan can tell
+    stats.fallbacks++;
+
+    Scan_Context context = {
+        .name = name,
+        .length = length,
+        .result = result,
+        .is_found = false,
+    };
+
+    err = fat_dir_iterate(dir_cluster, scan_entry, &context);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    return context.is_found ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t fat_lookup(uint32_t dir_cluster, const char *name, uint32_t length, FAT_Lookup_Entry *result)
+{
+    fat_lock();
+    esp_err_t err = lookup(dir_cluster, name, length, result);
+    fat_unlock();
+
+    return err;
+}
+
+void fat_lookup_invalidate(uint32_t dir_cluster)
+{
+    for (uint32_t i = 0; i < FAT_LOOKUP_TABLES; i++)
+    {
+        if (tables[i].cluster == dir_cluster)
+        {
+            tables[i].cluster = 0;
+        }
+    }
+}
+
+void fat_lookup_reset(void)
+{
+    for (uint32_t i = 0; i < FAT_LOOKUP_TABLES; i++)
+    {
+        tables[i].cluster = 0;
+        tables[i].last_used = 0;
+    }
+
+    use_counter = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void fat_lookup_get_stats(FAT_Lookup_Stats *out)
+{
+    *out = stats;
+}
+
+void fat_lookup_log_stats(void)
+{
+    ESP_LOGI(TAG, "builds: %d, hits: %d, collisions: %d, fallbacks: %d", (unsigned int)stats.builds,
+             (unsigned int)stats.hits, (unsigned int)stats.collisions, (unsigned int)stats.fallbacks);
+}
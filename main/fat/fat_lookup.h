@@ -0,0 +1,60 @@
+#ifndef FAT_LOOKUP_H
+#define FAT_LOOKUP_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "fat.h"
+
+/**
+ * Name lookups within a directory. The first lookup in a directory reads it once & builds a hash table
+ * of its names (long & short, case folded), after that finding a name is a single probe.
+ * A probe that matches hash & length reads the name back from the directory (usually a cached sector) to be sure.
+ * Only a few directories keep a table, the least recently used one is dropped for a new one.
+ * A directory with more names than fit is still looked up, a miss in it falls back to a linear scan.
+ */
+
+// Directories that keep a table at the same time
+#define FAT_LOOKUP_TABLES 4
+
+// Slots per table, a power of two. Filled up to 3/4 at most, a file takes two when it has a long name
+#define FAT_LOOKUP_SLOTS 256
+#define FAT_LOOKUP_MAX_NAMES (FAT_LOOKUP_SLOTS * 3 / 4)
+
+typedef struct
+{
+    uint32_t first_cluster;
+    uint32_t size;
+    uint32_t sector; // Where the entry lives
+    uint16_t index;  // Entry index within that sector
+    uint8_t attributes;
+} FAT_Lookup_Entry;
+
+typedef struct
+{
+    uint32_t builds;     // Tables built, a directory read in full
+    uint32_t hits;       // Names found with a probe
+    uint32_t collisions; // Other names with the same hash & length, told apart by reading them back
+    uint32_t fallbacks;  // Misses in an incomplete table that needed a scan
+} FAT_Lookup_Stats;
+
+/**
+ * Find `name` (UTF-8, `length` bytes, no terminator needed) in the directory starting at `dir_cluster`.
+ * Case is ignored for ASCII letters. ESP_ERR_NOT_FOUND when there is no such name.
+ */
+esp_err_t fat_lookup(uint32_t dir_cluster, const char *name, uint32_t length, FAT_Lookup_Entry *result);
+
+/**
+ * The directory's contents changed, drop its table.
+ */
+void fat_lookup_invalidate(uint32_t dir_cluster);
+
+// Drop every table, e.g. when another volume is mounted
+void fat_lookup_reset(void);
+
+void fat_lookup_get_stats(FAT_Lookup_Stats *stats);
+
+void fat_lookup_log_stats(void);
+
+#endif
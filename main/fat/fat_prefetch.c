@@ -0,0 +1,357 @@
+#include "fat_prefetch.h"
+
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+typedef enum
+{
+    SLOT_EMPTY,
+    SLOT_PENDING, // Queued for the background reader
+    SLOT_READY,
+} Prefetch_Slot_State;
+
+// A contiguous stretch of sectors landing in contiguous slots
+typedef struct
+{
+    uint32_t sector;
+    uint32_t count;
+    uint32_t slot;
+} Prefetch_Run;
+
+static const char *TAG = "FAT_PREFETCH";
+static const Block_Device *device;
+static fat_prefetch_next_sector_func next_sector_func;
+
+static uint8_t ring[FAT_PREFETCH_RING_SECTORS][BLOCKDEV_SECTOR_SIZE];
+static uint32_t ring_sectors[FAT_PREFETCH_RING_SECTORS];
+static volatile Prefetch_Slot_State ring_states[FAT_PREFETCH_RING_SECTORS];
+
+// Slots in use go from head (oldest) to head + used, wrapping around
+static uint32_t ring_head = 0;
+static uint32_t ring_used = 0;
+
+static QueueHandle_t run_queue = NULL;
+static SemaphoreHandle_t run_done = NULL;
+static atomic_uint runs_in_flight = 0;
+
+static bool has_last_sector = false;
+static uint32_t last_sector = 0;
+static uint32_t sequential_streak = 0;
+
+static FAT_Prefetch_Stats stats;
+
+static void prefetch_task(void *arg)
+{
+    Prefetch_Run run;
+
+    while (1)
+    {
+        xQueueReceive(run_queue, &run, portMAX_DELAY);
+
+        esp_err_t err = blockdev_read_many(device, run.sector, run.count, ring[run.slot]);
+
+        // A failed run just looks like it was never prefetched, the reader falls back to the device
+        Prefetch_Slot_State state = err == ESP_OK ? SLOT_READY : SLOT_EMPTY;
+
+        for (uint32_t i = 0; i < run.count; i++)
+        {
+            ring_states[run.slot + i] = state;
+        }
+
+        atomic_fetch_sub(&runs_in_flight, 1);
+        xSemaphoreGive(run_done);
+    }
+}
+
+static bool follow_sector(uint32_t sector, uint32_t *next)
+{
+    if (next_sector_func == NULL)
+    {
+        *next = sector + 1;
+        return true;
+    }
+
+    return next_sector_func(sector, next);
+}
+
+esp_err_t fat_prefetch_init(const Block_Device *block_device, fat_prefetch_next_sector_func next_sector)
+{
+    device = block_device;
+    next_sector_func = next_sector;
+
+    if (run_queue == NULL)
+    {
+        run_queue = xQueueCreate(FAT_PREFETCH_RING_SECTORS, sizeof(Prefetch_Run));
+        run_done = xSemaphoreCreateBinary();
+
+        if (run_queue == NULL || run_done == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+
+        if (xTaskCreatePinnedToCore(prefetch_task, "fat_prefetch", FAT_PREFETCH_TASK_STACK, NULL, FAT_PREFETCH_TASK_PRIORITY, NULL,
+                                    FAT_PREFETCH_TASK_CORE) != pdPASS)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    fat_prefetch_reset();
+
+    memset(&stats, 0, sizeof(stats));
+    stats.window = FAT_PREFETCH_MIN_WINDOW * 2;
+
+    return ESP_OK;
+}
+
+// Slots can only be reused once the background reader is done with them
+static void wait_for_runs(void)
+{
+    while (atomic_load(&runs_in_flight) > 0)
+    {
+        xSemaphoreTake(run_done, portMAX_DELAY);
+    }
+}
+
+static void shrink_window(void)
+{
+    stats.window /= 2;
+
+    if (stats.window < FAT_PREFETCH_MIN_WINDOW)
+    {
+        stats.window = FAT_PREFETCH_MIN_WINDOW;
+    }
+}
+
+static void grow_window(void)
+{
+    stats.window *= 2;
+
+    if (stats.window > FAT_PREFETCH_MAX_WINDOW)
+    {
+        stats.window = FAT_PREFETCH_MAX_WINDOW;
+    }
+}
+
+void fat_prefetch_reset(void)
+{
+    wait_for_runs();
+
+    for (uint32_t i = 0; i < FAT_PREFETCH_RING_SECTORS; i++)
+    {
+        ring_states[i] = SLOT_EMPTY;
+    }
+
+    ring_head = 0;
+    ring_used = 0;
+    has_last_sector = false;
+    sequential_streak = 0;
+}
+
+// Throw away everything read ahead, counts as waste
+static void drop_ring(void)
+{
+    wait_for_runs();
+
+    for (uint32_t i = 0; i < ring_used; i++)
+    {
+        uint32_t slot = (ring_head + i) % FAT_PREFETCH_RING_SECTORS;
+
+        if (ring_states[slot] == SLOT_READY)
+        {
+            stats.wasted++;
+        }
+
+        ring_states[slot] = SLOT_EMPTY;
+    }
+
+    if (ring_used > 0)
+    {
+        shrink_window();
+    }
+
+    ring_head = 0;
+    ring_used = 0;
+}
+
+static void queue_run(Prefetch_Run *run)
+{
+    if (run->count == 0)
+    {
+        return;
+    }
+
+    atomic_fetch_add(&runs_in_flight, 1);
+    xQueueSend(run_queue, run, portMAX_DELAY);
+}
+
+// Fill the ring up to the window ahead of the last read sector
+static void top_up(void)
+{
+    // Where the next prefetched sector comes from: after the newest slot, or after what was just read
+    uint32_t from = ring_used > 0 ? ring_sectors[(ring_head + ring_used - 1) % FAT_PREFETCH_RING_SECTORS] : last_sector;
+
+    Prefetch_Run run = {.count = 0};
+
+    while (ring_used < stats.window)
+    {
+        uint32_t next;
+
+        if (!follow_sector(from, &next))
+        {
+            break;
+        }
+
+        uint32_t slot = (ring_head + ring_used) % FAT_PREFETCH_RING_SECTORS;
+
+        // A run has to be contiguous both on the device & in the ring
+        if (run.count > 0 && (next != run.sector + run.count || slot != run.slot + run.count))
+        {
+            queue_run(&run);
+            run.count = 0;
+        }
+
+        if (run.count == 0)
+        {
+            run.sector = next;
+            run.slot = slot;
+        }
+
+        ring_sectors[slot] = next;
+        ring_states[slot] = SLOT_PENDING;
+        ring_used++;
+        run.count++;
+        from = next;
+    }
+
+    queue_run(&run);
+}
+
+// Serve a sector from what was read ahead & top the ring up behind it, false if it isn't there
+static bool read_from_ring(uint32_t sector, uint8_t *destination)
+{
+    // Look for it among what was read ahead, anything before it was skipped over
+    for (uint32_t i = 0; i < ring_used; i++)
+    {
+        uint32_t slot = (ring_head + i) % FAT_PREFETCH_RING_SECTORS;
+
+        if (ring_sectors[slot] != sector)
+        {
+            continue;
+        }
+
+        if (ring_states[slot] == SLOT_PENDING)
+        {
+            // Reader is as fast as the background, give it more room
+            stats.stalls++;
+            grow_window();
+
+            while (ring_states[slot] == SLOT_PENDING)
+            {
+                xSemaphoreTake(run_done, portMAX_DELAY);
+            }
+        }
+
+        if (ring_states[slot] != SLOT_READY)
+        {
+            // Background read failed
+            return false;
+        }
+
+        memcpy(destination, ring[slot], BLOCKDEV_SECTOR_SIZE);
+        stats.hits++;
+
+        if (i > 0)
+        {
+            stats.wasted += i;
+            shrink_window();
+        }
+
+        // Free the slot & everything skipped before it
+        for (uint32_t j = 0; j <= i; j++)
+        {
+            ring_states[(ring_head + j) % FAT_PREFETCH_RING_SECTORS] = SLOT_EMPTY;
+        }
+
+        ring_head = (ring_head + i + 1) % FAT_PREFETCH_RING_SECTORS;
+        ring_used -= i + 1;
+
+        last_sector = sector;
+        top_up();
+
+        return true;
+    }
+
+    return false;
+}
+
+esp_err_t fat_prefetch_read(uint32_t sector, uint8_t *destination)
+{
+    return fat_prefetch_read_many(sector, 1, destination);
+}
+
+esp_err_t fat_prefetch_read_many(uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    uint32_t done = 0;
+
+    while (done < count && read_from_ring(sector + done, &destination[done * BLOCKDEV_SECTOR_SIZE]))
+    {
+        done++;
+    }
+
+    if (done == count)
+    {
+        return ESP_OK;
+    }
+
+    // Not read ahead, the pattern broke or has not started yet. The rest goes in one read straight from the device
+    uint32_t first = sector + done;
+
+    stats.misses += count - done;
+    drop_ring();
+
+    uint32_t expected;
+
+    if (has_last_sector && follow_sector(last_sector, &expected) && expected == first)
+    {
+        sequential_streak++;
+    }
+    else
+    {
+        sequential_streak = 0;
+    }
+
+    esp_err_t err = blockdev_read_many(device, first, count - done, &destination[done * BLOCKDEV_SECTOR_SIZE]);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    has_last_sector = true;
+    last_sector = sector + count - 1;
+
+    if (sequential_streak + 1 >= FAT_PREFETCH_TRIGGER)
+    {
+        top_up();
+    }
+
+    return ESP_OK;
+}
+
+void fat_prefetch_get_stats(FAT_Prefetch_Stats *out)
+{
+    *out = stats;
+}
+
+void fat_prefetch_log_stats(void)
+{
+    ESP_LOGI(TAG, "hits: %d, misses: %d, wasted: %d, stalls: %d, window: %d",
+             (unsigned int)stats.hits, (unsigned int)stats.misses, (unsigned int)stats.wasted,
+             (unsigned int)stats.stalls, (unsigned int)stats.window);
+}
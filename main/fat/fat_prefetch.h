@@ -0,0 +1,76 @@
+#ifndef FAT_PREFETCH_H
+#define FAT_PREFETCH_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "blockdev/blockdev.h"
+#include "task_layout.h"
+
+/**
+ * Sequential read-ahead for streaming file data.
+ * Once a run of sequential sector reads is seen, the next sectors are fetched in the background
+ * into a ring of sector buffers with multi-sector reads, so the reader finds them already in RAM.
+ *
+ * The read-ahead window adapts: it grows when the reader catches up with the background reads
+ * & shrinks when prefetched sectors end up unused.
+ */
+
+// Sectors held by the ring, also the largest possible window
+#define FAT_PREFETCH_RING_SECTORS 32
+
+#define FAT_PREFETCH_MIN_WINDOW 4
+#define FAT_PREFETCH_MAX_WINDOW FAT_PREFETCH_RING_SECTORS
+
+// Sequential reads in a row before read-ahead kicks in, a multi-sector read counts once
+#define FAT_PREFETCH_TRIGGER 2
+
+#define FAT_PREFETCH_TASK_STACK 3072
+#define FAT_PREFETCH_TASK_PRIORITY 5
+#define FAT_PREFETCH_TASK_CORE TASK_CORE_IO
+
+/**
+ * Maps a sector to the one that follows it in the same file, e.g. across a cluster boundary.
+ * Returns false when there is no next sector (end of chain).
+ */
+typedef bool (*fat_prefetch_next_sector_func)(uint32_t sector, uint32_t *next);
+
+typedef struct
+{
+    uint32_t hits;    // Sectors served from the ring
+    uint32_t misses;  // Sectors that had to go to the device
+    uint32_t wasted;  // Prefetched sectors thrown away unread
+    uint32_t stalls;  // Hits that still had to wait for the background read
+    uint32_t window;  // Current read-ahead window in sectors
+} FAT_Prefetch_Stats;
+
+/**
+ * Start the background reader for the device. `next_sector` follows files across clusters,
+ * NULL means sectors simply follow each other.
+ */
+esp_err_t fat_prefetch_init(const Block_Device *block_device, fat_prefetch_next_sector_func next_sector);
+
+/**
+ * Read a sector, from the read-ahead ring when it is there.
+ * Meant for a single sequential reader, e.g. the file being played.
+ */
+esp_err_t fat_prefetch_read(uint32_t sector, uint8_t *destination);
+
+/**
+ * Read `count` sectors that follow each other on the device, e.g. a stretch of a file's extent.
+ * Sectors read ahead are copied from the ring, from the first one that isn't on the rest is a single multi-sector read.
+ * Reading on where the last read left off keeps the ring filled in the background.
+ */
+esp_err_t fat_prefetch_read_many(uint32_t sector, uint32_t count, uint8_t *destination);
+
+/**
+ * Drop everything read ahead, e.g. on seek or when another file is opened.
+ */
+void fat_prefetch_reset(void);
+
+void fat_prefetch_get_stats(FAT_Prefetch_Stats *stats);
+
+void fat_prefetch_log_stats(void);
+
+#endif
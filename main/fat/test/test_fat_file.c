@@ -0,0 +1,185 @@
+// fat_file reads of a file fragmented far past FAT_FILE_MAX_EXTENTS, on the test image.
+// Every step along the cluster chain is counted by wrapping fat_chain_next (-Wl,--wrap=fat_chain_next),
+// reading on sequentially must cost a step per cluster, not a walk from the last extent every time.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+
+#define FRAGMENTED_PATH "FRAGMENT.BIN"
+#define FRAGMENTED_CLUSTERS 800 // One sector per cluster on the test image, each in a piece of its own
+#define READER_PASSES 20
+
+static uint32_t chain_steps = 0;
+
+esp_err_t __real_fat_chain_next(FAT_Chain_Iterator *iterator);
+
+esp_err_t __wrap_fat_chain_next(FAT_Chain_Iterator *iterator)
+{
+    chain_steps++;
+
+    return __real_fat_chain_next(iterator);
+}
+
+static uint8_t pattern_byte(uint32_t position)
+{
+    return (position ^ (position >> 9)) & 0xFF;
+}
+
+static bool matches_pattern(const uint8_t *data, uint32_t position, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (data[i] != pattern_byte(position + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void test_sequential(FAT_File *file)
+{
+    uint8_t *data = malloc(file->size);
+    uint32_t bytes_read = 0;
+    uint32_t steps = chain_steps;
+    uint64_t start = host_test_now_ns();
+
+    // A sector at a time, like the player reads on
+    for (uint32_t position = 0; position < file->size; position += BLOCKDEV_SECTOR_SIZE)
+    {
+        uint32_t length;
+
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_read(file, &data[position], BLOCKDEV_SECTOR_SIZE, &length));
+        bytes_read += length;
+    }
+
+    uint64_t elapsed = host_test_now_ns() - start;
+    steps = chain_steps - steps;
+
+    printf("Sequential read of %u clusters: %u chain steps, %llu us\n", (unsigned int)FRAGMENTED_CLUSTERS,
+           (unsigned int)steps, (unsigned long long)(elapsed / 1000));
+
+    TEST_CHECK_EQUAL(file->size, bytes_read);
+    TEST_CHECK(matches_pattern(data, 0, file->size));
+
+    // One step per cluster past the extents
+    TEST_CHECK(steps <= FRAGMENTED_CLUSTERS);
+
+    free(data);
+}
+
+// Seeks back & forth past the extents still land on the right bytes
+static void test_seeks(FAT_File *file)
+{
+    const uint32_t positions[] = {file->size - 1, 100, 600 * BLOCKDEV_SECTOR_SIZE + 7, 40 * BLOCKDEV_SECTOR_SIZE,
+                                  700 * BLOCKDEV_SECTOR_SIZE - 3, 33 * BLOCKDEV_SECTOR_SIZE, 0};
+
+    for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+    {
+        uint8_t data[3 * BLOCKDEV_SECTOR_SIZE];
+        uint32_t length;
+        uint32_t expected = file->size - positions[i] < sizeof(data) ? file->size - positions[i] : sizeof(data);
+
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_seek(file, positions[i]));
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_read(file, data, sizeof(data), &length));
+        TEST_CHECK_EQUAL(expected, length);
+        TEST_CHECK(matches_pattern(data, positions[i], length));
+    }
+}
+
+// A size that wraps position + size still gets clamped to what is left
+static void test_huge_size(FAT_File *file)
+{
+    uint8_t data[2 * BLOCKDEV_SECTOR_SIZE];
+    uint32_t length;
+    uint32_t position = file->size - sizeof(data) + 10;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_seek(file, position));
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_read(file, data, UINT32_MAX - 100, &length));
+    TEST_CHECK_EQUAL(sizeof(data) - 10, length);
+    TEST_CHECK(matches_pattern(data, position, length));
+}
+
+// Reads the whole file in chunks that don't line up with sectors, counts those that came out wrong
+static void *read_passes(void *arg)
+{
+    uint32_t *mismatches = (uint32_t *)arg;
+    uint8_t data[700];
+    FAT_File file;
+
+    for (uint32_t pass = 0; pass < READER_PASSES; pass++)
+    {
+        uint32_t length = 0;
+
+        if (fat_open(&file, FRAGMENTED_PATH) != ESP_OK)
+        {
+            (*mismatches)++;
+            continue;
+        }
+
+        for (uint32_t position = 0; position < file.size; position += length)
+        {
+            if (fat_file_read(&file, data, sizeof(data), &length) != ESP_OK || length == 0 ||
+                !matches_pattern(data, position, length))
+            {
+                (*mismatches)++;
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Two tasks reading their own files at once, as the player & producer may, share the FAT window & caches
+static void test_two_tasks(void)
+{
+    pthread_t threads[2];
+    uint32_t mismatches[2] = {0};
+
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_create(&threads[i], NULL, read_passes, &mismatches[i]);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], NULL);
+        TEST_CHECK_EQUAL(0, mismatches[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File image;
+    static Block_Device device;
+
+    if (argc < 2 || blockdev_file_open(&image, argv[1], true, &device) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(1, fat_get_sectors_per_cluster());
+
+    FAT_File file;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_open(&file, FRAGMENTED_PATH));
+    TEST_CHECK_EQUAL(FAT_FILE_MAX_EXTENTS, file.extent_count);
+    TEST_CHECK(file.is_fragmented_past_extents);
+
+    test_sequential(&file);
+    test_seeks(&file);
+    test_huge_size(&file);
+    test_two_tasks();
+
+    return host_test_result();
+}
@@ -0,0 +1,216 @@
+// fat_lfn fed crafted long name entries, the way they sit on disk: longest names, non-ASCII & surrogate pairs,
+// plus sequences that must be dropped (checksum mismatch, gaps, too long).
+
+#include <string.h>
+
+#include "host_test.h"
+#include "fat/fat_lfn.h"
+
+#define MAX_UNITS 300
+
+static const uint8_t short_name[11] = {'L', 'O', 'N', 'G', 'N', 'A', '~', '1', 'W', 'A', 'V'};
+
+// Where the 13 units of an entry sit, as byte offsets
+static const uint8_t unit_offsets[FAT_LFN_CHARS_PER_ENTRY] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+
+typedef struct
+{
+    FAT_Directory_Long_Entry entries[FAT_LFN_MAX_ENTRIES + 2];
+    uint32_t count;
+} Long_Name;
+
+// Entries for a name in UTF-16 units, last piece first, as a formatter writes them
+static void make_long_name(Long_Name *name, const uint16_t *units, uint32_t length, uint8_t checksum)
+{
+    name->count = (length + FAT_LFN_CHARS_PER_ENTRY - 1) / FAT_LFN_CHARS_PER_ENTRY;
+
+    for (uint32_t i = 0; i < name->count; i++)
+    {
+        uint32_t ord = name->count - i;
+        FAT_Directory_Long_Entry *entry = &name->entries[i];
+        uint8_t *raw = (uint8_t *)entry;
+
+        memset(entry, 0, sizeof(*entry));
+        entry->LDIR_Ord = ord | (i == 0 ? FAT_LFN_LAST_ENTRY : 0);
+        entry->LDIR_Attr = LONG_NAME;
+        entry->LDIR_Chksum = checksum;
+
+        for (uint32_t j = 0; j < FAT_LFN_CHARS_PER_ENTRY; j++)
+        {
+            uint32_t index = (ord - 1) * FAT_LFN_CHARS_PER_ENTRY + j;
+
+            // A name that ends early is terminated, then padded
+            uint16_t unit = index < length ? units[index] : index == length ? 0x0000 : 0xFFFF;
+
+            raw[unit_offsets[j]] = unit & 0xFF;
+            raw[unit_offsets[j] + 1] = unit >> 8;
+        }
+    }
+}
+
+static const char *assemble(const Long_Name *name)
+{
+    static FAT_LFN_Assembler lfn;
+    FAT_Directory_Entry entry = {0};
+
+    memcpy(entry.DIR_Name, short_name, sizeof(short_name));
+
+    fat_lfn_reset(&lfn);
+
+    for (uint32_t i = 0; i < name->count; i++)
+    {
+        fat_lfn_push(&lfn, &name->entries[i]);
+    }
+
+    return fat_lfn_finish(&lfn, &entry);
+}
+
+static uint32_t ascii_units(const char *text, uint16_t *units)
+{
+    uint32_t length = strlen(text);
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        units[i] = (uint8_t)text[i];
+    }
+
+    return length;
+}
+
+static void check_name(const uint16_t *units, uint32_t length, const char *expected)
+{
+    Long_Name name;
+
+    make_long_name(&name, units, length, fat_lfn_checksum(short_name));
+
+    const char *assembled = assemble(&name);
+
+    TEST_CHECK(assembled != NULL);
+
+    if (assembled != NULL && strcmp(assembled, expected) != 0)
+    {
+        fprintf(stderr, "assembled \"%s\", expected \"%s\"\n", assembled, expected);
+        host_test_failures++;
+    }
+}
+
+static void test_ascii(void)
+{
+    uint16_t units[MAX_UNITS];
+
+    check_name(units, ascii_units("Track.wav", units), "Track.wav");
+
+    // Exactly one entry, no terminator & no padding
+    check_name(units, ascii_units("Thirteen.wav!", units), "Thirteen.wav!");
+    check_name(units, ascii_units("Second track, fragmented.wav", units), "Second track, fragmented.wav");
+}
+
+// 255 units take all 20 entries, 19 full ones & 8 units in the last piece
+static void test_longest(void)
+{
+    uint16_t units[MAX_UNITS];
+    char expected[FAT_LFN_BUFFER_SIZE];
+
+    for (uint32_t i = 0; i < FAT_LFN_MAX_CHARS; i++)
+    {
+        units[i] = 'a' + i % 26;
+        expected[i] = 'a' + i % 26;
+    }
+
+    expected[FAT_LFN_MAX_CHARS] = '\0';
+    check_name(units, FAT_LFN_MAX_CHARS, expected);
+
+    // 255 units of 3 byte UTF-8 fill the buffer to the last byte
+    char *out = expected;
+
+    for (uint32_t i = 0; i < FAT_LFN_MAX_CHARS; i++)
+    {
+        units[i] = 0x4E00 + i; // CJK ideographs
+        *out++ = 0xE0 | (units[i] >> 12);
+        *out++ = 0x80 | ((units[i] >> 6) & 0x3F);
+        *out++ = 0x80 | (units[i] & 0x3F);
+    }
+
+    *out = '\0';
+    check_name(units, FAT_LFN_MAX_CHARS, expected);
+
+    // One unit more is not a valid name
+    Long_Name name;
+    units[FAT_LFN_MAX_CHARS] = 'z';
+    make_long_name(&name, units, FAT_LFN_MAX_CHARS + 1, fat_lfn_checksum(short_name));
+    TEST_CHECK(assemble(&name) == NULL);
+}
+
+static void test_non_ascii(void)
+{
+    // "Café – Ünïcödé.wav": 2 & 3 byte UTF-8
+    const uint16_t accents[] = {'C', 'a', 'f', 0xE9, ' ', 0x2013, ' ', 0xDC, 'n', 0xEF, 'c', 0xF6, 'd', 0xE9,
+                                '.', 'w', 'a', 'v'};
+    check_name(accents, sizeof(accents) / sizeof(accents[0]), "Caf\xC3\xA9 \xE2\x80\x93 \xC3\x9Cn\xC3\xAF"
+                                                               "c\xC3\xB6"
+                                                               "d\xC3\xA9.wav");
+
+    // U+1F3B5 as a surrogate pair within an entry
+    const uint16_t note[] = {'S', 'o', 'n', 'g', ' ', 0xD83C, 0xDFB5, '.', 'w', 'a', 'v'};
+    check_name(note, sizeof(note) / sizeof(note[0]), "Song \xF0\x9F\x8E\xB5.wav");
+
+    // Same pair split across two entries: high half is unit 13 of the first piece, low half unit 1 of the second
+    uint16_t split[MAX_UNITS];
+    uint32_t length = ascii_units("Twelve units", split);
+    split[length++] = 0xD83C;
+    split[length++] = 0xDFB5;
+    length += ascii_units(" & more.wav", &split[length]);
+    check_name(split, length, "Twelve units\xF0\x9F\x8E\xB5 & more.wav");
+
+    // Halves on their own become U+FFFD
+    const uint16_t lone[] = {'a', 0xDFB5, 'b', 0xD83C, 'c', 0xD83C};
+    check_name(lone, sizeof(lone) / sizeof(lone[0]), "a\xEF\xBF\xBD"
+                                                     "b\xEF\xBF\xBD"
+                                                     "c\xEF\xBF\xBD");
+}
+
+// Sequences that don't belong to the short entry after them leave just the short name
+static void test_dropped(void)
+{
+    uint16_t units[MAX_UNITS];
+    uint32_t length = ascii_units("A long name over two entries.wav", units);
+    Long_Name name;
+
+    // Every entry carries the checksum of some other short name, e.g. renamed by a tool unaware of long names
+    make_long_name(&name, units, length, fat_lfn_checksum(short_name) + 1);
+    TEST_CHECK(assemble(&name) == NULL);
+
+    // Only one of the entries is off
+    make_long_name(&name, units, length, fat_lfn_checksum(short_name));
+    name.entries[1].LDIR_Chksum++;
+    TEST_CHECK(assemble(&name) == NULL);
+
+    // An entry missing in the middle
+    make_long_name(&name, units, length, fat_lfn_checksum(short_name));
+    name.entries[1] = name.entries[2];
+    name.count--;
+    TEST_CHECK(assemble(&name) == NULL);
+
+    // Ordinal 1 never arrives
+    make_long_name(&name, units, length, fat_lfn_checksum(short_name));
+    name.count--;
+    TEST_CHECK(assemble(&name) == NULL);
+
+    // An orphaned last piece in front of a full sequence doesn't spoil it
+    Long_Name orphan;
+    make_long_name(&orphan, units, length, fat_lfn_checksum(short_name));
+    memmove(&orphan.entries[1], &orphan.entries[0], orphan.count * sizeof(orphan.entries[0]));
+    orphan.count++;
+    const char *assembled = assemble(&orphan);
+    TEST_CHECK(assembled != NULL && strcmp(assembled, "A long name over two entries.wav") == 0);
+}
+
+int main(void)
+{
+    test_ascii();
+    test_longest();
+    test_non_ascii();
+    test_dropped();
+
+    return host_test_result();
+}
@@ -0,0 +1,93 @@
+// fat_lookup & fat_open on the test image, with names that share a hash & length with names in the directory
+// & a long name running over from one cluster of the root directory into the next.
+
+#include <string.h>
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "fat/fat_lookup.h"
+
+#define CROSSING_NAME "A name long enough to run from one directory sector into the next, which sits in another cluster.txt"
+
+static esp_err_t lookup(const char *name, FAT_Lookup_Entry *entry)
+{
+    return fat_lookup(fat_get_root_cluster(), name, strlen(name), entry);
+}
+
+static void test_names(void)
+{
+    FAT_Lookup_Entry entry;
+    FAT_Lookup_Entry other;
+
+    TEST_CHECK_EQUAL(ESP_OK, lookup("FIRST.WAV", &entry));
+    TEST_CHECK_EQUAL(ESP_OK, lookup("first.wav", &other));
+    TEST_CHECK_EQUAL(entry.first_cluster, other.first_cluster);
+
+    TEST_CHECK_EQUAL(ESP_OK, lookup("o62w41.txt", &entry));
+    TEST_CHECK_EQUAL(ESP_OK, lookup("LOOKUP~1.TXT", &other));
+    TEST_CHECK_EQUAL(entry.first_cluster, other.first_cluster);
+
+    TEST_CHECK_EQUAL(ESP_OK, lookup(CROSSING_NAME, &entry));
+    TEST_CHECK_EQUAL(ESP_OK, lookup("ANAMEL~1.TXT", &other));
+    TEST_CHECK_EQUAL(entry.first_cluster, other.first_cluster);
+
+    TEST_CHECK_EQUAL(ESP_ERR_NOT_FOUND, lookup("missing.wav", &entry));
+}
+
+// Same FNV-1a hash & length as a name in the directory, only reading the name back tells them apart
+static void test_collisions(void)
+{
+    FAT_Lookup_Entry entry;
+    FAT_Lookup_Stats before;
+    FAT_Lookup_Stats after;
+
+    fat_lookup_get_stats(&before);
+
+    TEST_CHECK_EQUAL(ESP_OK, lookup("dki9rc.txt", &entry));
+    TEST_CHECK_EQUAL(ESP_ERR_NOT_FOUND, lookup("d8fmxw.txt", &entry)); // Short name DKI9RC.TXT
+    TEST_CHECK_EQUAL(ESP_ERR_NOT_FOUND, lookup("0lwv00.txt", &entry)); // Long name o62w41.txt
+
+    fat_lookup_get_stats(&after);
+
+    TEST_CHECK_EQUAL(2, after.collisions - before.collisions);
+}
+
+static void test_open(void)
+{
+    FAT_File file;
+    uint8_t data[32];
+    uint32_t length;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_open(&file, "/album with a long name/Second track, fragmented.wav"));
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_read(&file, data, 4, &length));
+    TEST_CHECK(memcmp(data, "RIFF", 4) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_open(&file, CROSSING_NAME));
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_read(&file, data, sizeof(data), &length));
+    TEST_CHECK(length == 17 && memcmp(data, "Long, long name\r\n", 17) == 0);
+
+    TEST_CHECK_EQUAL(ESP_ERR_NOT_FOUND, fat_open(&file, "Album With A Long Name/d8fmxw.txt"));
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, fat_open(&file, "Album With A Long Name"));
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File image;
+    static Block_Device device;
+
+    if (argc < 2 || blockdev_file_open(&image, argv[1], true, &device) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+    test_names();
+    test_collisions();
+    test_open();
+
+    return host_test_result();
+}
@@ -0,0 +1,150 @@
+// fat_init on a copy of the test image in memory, as it is & with a broken boot sector: a partition past the end
+// of the device, no sectors per cluster & sectors the size the FAT layer doesn't use.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "fat/fat.h"
+
+typedef struct
+{
+    uint8_t *data;
+    uint32_t sector_count;
+} Memory_Device;
+
+static esp_err_t memory_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    Memory_Device *memory = (Memory_Device *)context;
+
+    if (sector >= memory->sector_count || count > memory->sector_count - sector)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(destination, &memory->data[(size_t)sector * BLOCKDEV_SECTOR_SIZE], (size_t)count * BLOCKDEV_SECTOR_SIZE);
+
+    return ESP_OK;
+}
+
+static esp_err_t memory_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return memory_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t memory_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t memory_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static uint32_t memory_sector_size(void *context)
+{
+    return BLOCKDEV_SECTOR_SIZE;
+}
+
+static uint32_t memory_sector_count(void *context)
+{
+    return ((Memory_Device *)context)->sector_count;
+}
+
+static const Block_Device_Ops memory_ops = {
+    .read = memory_read,
+    .read_many = memory_read_many,
+    .write = memory_write,
+    .write_many = memory_write_many,
+    .sector_size = memory_sector_size,
+    .sector_count = memory_sector_count,
+};
+
+static uint8_t *load_image(const char *path, uint32_t *sector_count)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *data = malloc(length);
+
+    if (data != NULL && fread(data, 1, length, file) != (size_t)length)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(file);
+    *sector_count = length / BLOCKDEV_SECTOR_SIZE;
+
+    return data;
+}
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void write_u32(uint8_t *data, uint32_t value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <image>\n", argv[0]);
+        return 2;
+    }
+
+    Memory_Device memory;
+    Block_Device device = {.ops = &memory_ops, .context = &memory};
+
+    memory.data = load_image(argv[1], &memory.sector_count);
+
+    if (memory.data == NULL)
+    {
+        fprintf(stderr, "Could not load %s\n", argv[1]);
+        return 2;
+    }
+
+    uint8_t *partition_lba = &memory.data[FAT_BOOT_CODE_LEN + FAT_PARTITION_LBA_START_INDEX];
+    uint8_t *boot_sector = &memory.data[(size_t)read_u32(partition_lba) * BLOCKDEV_SECTOR_SIZE];
+    uint8_t sectors_per_cluster = boot_sector[FAT_BOOT_SECTORS_PER_CLUSTER];
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+    // The read error comes back, rather than the MBR still in the buffer passing for a boot sector
+    uint32_t lba = read_u32(partition_lba);
+
+    write_u32(partition_lba, memory.sector_count + 8);
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, fat_init(&device));
+    write_u32(partition_lba, lba);
+
+    boot_sector[FAT_BOOT_SECTORS_PER_CLUSTER] = 0;
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, fat_init(&device));
+    boot_sector[FAT_BOOT_SECTORS_PER_CLUSTER] = sectors_per_cluster;
+
+    boot_sector[FAT_BOOT_SECTOR_BYTES_PER_SECTOR + 1] = 1024 >> 8;
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_STATE, fat_init(&device));
+    boot_sector[FAT_BOOT_SECTOR_BYTES_PER_SECTOR + 1] = BLOCKDEV_SECTOR_SIZE >> 8;
+
+    // Still mounts once it is put back
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+    free(memory.data);
+
+    return host_test_result();
+}
@@ -0,0 +1,143 @@
+// fat_read_bytes through blockdev_file against the test image read straight from the file: starts & ends at
+// every few bytes of a sector, so reads inside one sector, across a boundary, with a head, whole sectors in the
+// middle & a tail, ending on the image's last byte & of nothing at all.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+
+#define GUARD_BYTE 0xA5
+#define MAX_READ (4 * BLOCKDEV_SECTOR_SIZE)
+
+static uint8_t *load_image(const char *path, uint32_t *length)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *data = malloc(*length);
+
+    if (data != NULL && fread(data, 1, *length, file) != *length)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+// Reads `size` bytes at `address` into the middle of a guarded buffer, false if they differ from the image or
+// anything around them was written
+static bool read_matches(const uint8_t *image, uint64_t address, uint32_t size)
+{
+    static uint8_t buffer[MAX_READ + 2 * BLOCKDEV_SECTOR_SIZE];
+    uint8_t *destination = &buffer[BLOCKDEV_SECTOR_SIZE];
+
+    memset(buffer, GUARD_BYTE, sizeof(buffer));
+
+    if (fat_read_bytes(destination, size, address) != ESP_OK)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < sizeof(buffer); i++)
+    {
+        bool is_read = i >= BLOCKDEV_SECTOR_SIZE && i < BLOCKDEV_SECTOR_SIZE + size;
+
+        if (buffer[i] != (is_read ? image[address + i - BLOCKDEV_SECTOR_SIZE] : GUARD_BYTE))
+        {
+            fprintf(stderr, "%u bytes at %llu: differs at %d\n", (unsigned int)size, (unsigned long long)address,
+                    (int)i - BLOCKDEV_SECTOR_SIZE);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// A few sectors from `first`, the MBR, FATs & root directory near the start have data in every sector
+static uint32_t sweep(const uint8_t *image, uint64_t first)
+{
+    const uint32_t sizes[] = {0, 1, 7, 100, 505, 511, 512, 513, 1000, 1024, 1537, MAX_READ - 3, MAX_READ};
+    uint32_t mismatches = 0;
+
+    for (uint32_t offset = 0; offset < 2 * BLOCKDEV_SECTOR_SIZE; offset += 3)
+    {
+        for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            mismatches += !read_matches(image, first + offset, sizes[i]);
+        }
+    }
+
+    return mismatches;
+}
+
+static void test_cases(const uint8_t *image, uint32_t length)
+{
+    // Within one sector, unaligned on both ends & up to its last byte
+    TEST_CHECK(read_matches(image, 3, 100));
+    TEST_CHECK(read_matches(image, 500, 12));
+
+    // Across one boundary, no whole sector in between
+    TEST_CHECK(read_matches(image, 510, 4));
+    TEST_CHECK(read_matches(image, 2 * BLOCKDEV_SECTOR_SIZE + 1, BLOCKDEV_SECTOR_SIZE));
+
+    // Head, whole sectors & tail
+    TEST_CHECK(read_matches(image, 300, 3 * BLOCKDEV_SECTOR_SIZE + 77));
+
+    // Aligned start with a tail, head with an aligned end
+    TEST_CHECK(read_matches(image, BLOCKDEV_SECTOR_SIZE, BLOCKDEV_SECTOR_SIZE + 1));
+    TEST_CHECK(read_matches(image, BLOCKDEV_SECTOR_SIZE - 1, BLOCKDEV_SECTOR_SIZE + 1));
+
+    // Nothing, wherever it is, doesn't touch the destination
+    TEST_CHECK(read_matches(image, 0, 0));
+    TEST_CHECK(read_matches(image, 777, 0));
+
+    // Up to the last byte of the device, the sector after it is never asked for
+    TEST_CHECK(read_matches(image, length - 100, 100));
+    TEST_CHECK(read_matches(image, length - 3 * BLOCKDEV_SECTOR_SIZE - 5, 3 * BLOCKDEV_SECTOR_SIZE + 5));
+
+    TEST_CHECK_EQUAL(0, sweep(image, 0));
+    TEST_CHECK_EQUAL(0, sweep(image, fat_cluster_to_sector(fat_get_root_cluster()) * (uint64_t)BLOCKDEV_SECTOR_SIZE));
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File file;
+    static Block_Device device;
+    uint32_t length;
+    uint8_t *image;
+
+    if (argc < 2 || (image = load_image(argv[1], &length)) == NULL)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    // Read through the file descriptor, then the mapping
+    for (int use_mmap = 0; use_mmap < 2; use_mmap++)
+    {
+        TEST_CHECK_EQUAL(ESP_OK, blockdev_file_open(&file, argv[1], use_mmap, &device));
+        TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+        test_cases(image, length);
+
+        blockdev_file_close(&file);
+    }
+
+    free(image);
+
+    return host_test_result();
+}
@@ -0,0 +1,173 @@
+// track_index_scan over the scan image (make_scan_image.py): 10000 files in 111 directories, half of them tracks.
+// Checks every track is counted, either in the index or as missed past TRACK_INDEX_MAX_TRACKS, that a directory
+// which can't be read fails the scan, then times scans cold (caches just reset) & warm, with the sectors read.
+//
+//   bench_track_index <scan image> <tracks on it> [passes]
+
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_lookup.h"
+#include "library/track_index.h"
+
+#define DIRECTORIES 111
+
+// Passes reads on to the image, counts the sectors & fails any read that touches `failing_sector`
+typedef struct
+{
+    Block_Device image;
+    uint32_t sectors_read;
+    uint32_t failing_sector; // 0 for none, the MBR is only read by fat_init
+} Counting_Device;
+
+static esp_err_t counting_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    Counting_Device *counting = (Counting_Device *)context;
+
+    if (counting->failing_sector != 0 && sector <= counting->failing_sector && counting->failing_sector < sector + count)
+    {
+        return ESP_FAIL;
+    }
+
+    counting->sectors_read += count;
+
+    return blockdev_read_many(&counting->image, sector, count, destination);
+}
+
+static esp_err_t counting_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return counting_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t counting_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t counting_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static uint32_t counting_sector_size(void *context)
+{
+    return blockdev_sector_size(&((Counting_Device *)context)->image);
+}
+
+static uint32_t counting_sector_count(void *context)
+{
+    return blockdev_sector_count(&((Counting_Device *)context)->image);
+}
+
+static const Block_Device_Ops counting_ops = {
+    .read = counting_read,
+    .read_many = counting_read_many,
+    .write = counting_write,
+    .write_many = counting_write_many,
+    .sector_size = counting_sector_size,
+    .sector_count = counting_sector_count,
+};
+
+static int compare_hashes(const void *a, const void *b)
+{
+    uint32_t left = *(const uint32_t *)a;
+    uint32_t right = *(const uint32_t *)b;
+
+    return left < right ? -1 : left > right;
+}
+
+// Everything is found & every entry is a different WAV
+static void test_scan(uint32_t expected_tracks)
+{
+    uint32_t expected_count = expected_tracks < TRACK_INDEX_MAX_TRACKS ? expected_tracks : TRACK_INDEX_MAX_TRACKS;
+
+    TEST_CHECK_EQUAL(ESP_OK, track_index_scan());
+    TEST_CHECK_EQUAL(expected_count, track_index_count());
+    TEST_CHECK_EQUAL(expected_tracks - expected_count, track_index_missed_count());
+
+    uint32_t count = track_index_count();
+    uint32_t *hashes = malloc(sizeof(uint32_t) * (count + 1));
+    uint32_t duplicates = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        TEST_CHECK_EQUAL(TRACK_FORMAT_WAV, track_index_get(i)->format);
+        hashes[i] = track_index_get(i)->path_hash;
+    }
+
+    qsort(hashes, count, sizeof(uint32_t), compare_hashes);
+
+    for (uint32_t i = 1; i < count; i++)
+    {
+        duplicates += hashes[i] == hashes[i - 1];
+    }
+
+    TEST_CHECK_EQUAL(0, duplicates);
+
+    free(hashes);
+}
+
+// An album that can't be read fails the scan rather than leaving its tracks out quietly
+static void test_failing_directory(Counting_Device *counting)
+{
+    FAT_Lookup_Entry entry;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_lookup(fat_get_root_cluster(), "ARTIST03", 8, &entry));
+    TEST_CHECK_EQUAL(ESP_OK, fat_lookup(entry.first_cluster, "Album number 07", 15, &entry));
+
+    counting->failing_sector = fat_cluster_to_sector(entry.first_cluster);
+    TEST_CHECK_EQUAL(ESP_FAIL, track_index_scan());
+    counting->failing_sector = 0;
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File file;
+    static Counting_Device counting;
+    Block_Device device = {.ops = &counting_ops, .context = &counting};
+
+    if (argc < 3 || blockdev_file_open(&file, argv[1], true, &counting.image) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <scan image> <tracks on it> [passes]\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t expected_tracks = (uint32_t)atoi(argv[2]);
+    uint32_t passes = argc > 3 ? (uint32_t)atoi(argv[3]) : 20;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, track_index_init());
+
+    test_failing_directory(&counting);
+
+    // Cold: a fresh mount, nothing of the directories cached
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    counting.sectors_read = 0;
+
+    uint64_t start = host_test_now_ns();
+    track_index_scan();
+    uint64_t cold_ns = host_test_now_ns() - start;
+    uint32_t cold_sectors = counting.sectors_read;
+
+    test_scan(expected_tracks);
+
+    counting.sectors_read = 0;
+    start = host_test_now_ns();
+
+    for (uint32_t i = 0; i < passes; i++)
+    {
+        track_index_scan();
+    }
+
+    uint64_t warm_ns = passes == 0 ? 0 : (host_test_now_ns() - start) / passes;
+
+    printf("%d directories, %u tracks: %u indexed, %u missed past %d\n", DIRECTORIES, (unsigned int)expected_tracks,
+           (unsigned int)track_index_count(), (unsigned int)track_index_missed_count(), TRACK_INDEX_MAX_TRACKS);
+    printf("Cold scan: %.2f ms, %u sectors read\n", cold_ns / 1e6, (unsigned int)cold_sectors);
+    printf("Warm scan: %.2f ms, %u sectors read, average of %u\n", warm_ns / 1e6,
+           passes == 0 ? 0 : (unsigned int)(counting.sectors_read / passes), (unsigned int)passes);
+
+    return host_test_result();
+}
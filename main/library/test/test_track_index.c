@@ -0,0 +1,211 @@
+// track_index_load_or_scan on a copy of the test image: the first boot scans & saves the index, the next one loads
+// it. A renamed root entry, a track added in a subdirectory & a volume without a free cluster count each bring the
+// scan back. Whether it scanned shows in the reads of the album's directory, which only a scan goes into.
+//
+//   test_track_index <test image>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "fat/fat_lookup.h"
+#include "library/track_index.h"
+
+#define ALBUM_NAME "Album With A Long Name"
+
+// Passes everything on to the image, counting reads of one sector
+typedef struct
+{
+    Block_Device image;
+    uint32_t watched_sector;
+    uint32_t watched_reads;
+} Watching_Device;
+
+static Watching_Device watching;
+
+static esp_err_t watching_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    if (sector <= watching.watched_sector && watching.watched_sector < sector + count)
+    {
+        watching.watched_reads++;
+    }
+
+    return blockdev_read_many(&watching.image, sector, count, destination);
+}
+
+static esp_err_t watching_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    return watching_read_many(context, sector, 1, destination);
+}
+
+static esp_err_t watching_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    return blockdev_write_many(&watching.image, sector, count, source);
+}
+
+static esp_err_t watching_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    return blockdev_write(&watching.image, sector, source);
+}
+
+static uint32_t watching_sector_size(void *context)
+{
+    return blockdev_sector_size(&watching.image);
+}
+
+static uint32_t watching_sector_count(void *context)
+{
+    return blockdev_sector_count(&watching.image);
+}
+
+static const Block_Device_Ops watching_ops = {
+    .read = watching_read,
+    .read_many = watching_read_many,
+    .write = watching_write,
+    .write_many = watching_write_many,
+    .sector_size = watching_sector_size,
+    .sector_count = watching_sector_count,
+};
+
+static const Block_Device device = {.ops = &watching_ops, .context = &watching};
+
+static bool copy_file(const char *from, const char *to)
+{
+    FILE *source = fopen(from, "rb");
+    FILE *destination = fopen(to, "wb");
+    static uint8_t buffer[64 * 1024];
+    bool is_copied = source != NULL && destination != NULL;
+    size_t length;
+
+    while (is_copied && (length = fread(buffer, 1, sizeof(buffer), source)) > 0)
+    {
+        is_copied = fwrite(buffer, 1, length, destination) == length;
+    }
+
+    if (source != NULL)
+    {
+        fclose(source);
+    }
+
+    if (destination != NULL)
+    {
+        fclose(destination);
+    }
+
+    return is_copied;
+}
+
+// Mounts afresh, so nothing is cached, & tells whether the index had to be scanned
+static bool boot_scans(void)
+{
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+
+    watching.watched_reads = 0;
+    TEST_CHECK_EQUAL(ESP_OK, track_index_load_or_scan());
+
+    return watching.watched_reads > 0;
+}
+
+// Renames the entry `short_name` in the root directory's first sector to `new_name`, behind the FAT layer's back
+static void rename_root_entry(const char *short_name, const char *new_name)
+{
+    uint8_t block[BLOCKDEV_SECTOR_SIZE];
+    uint32_t sector = fat_cluster_to_sector(fat_get_root_cluster());
+    bool is_found = false;
+
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_read(&watching.image, sector, block));
+
+    for (uint32_t offset = 0; offset < BLOCKDEV_SECTOR_SIZE; offset += FAT_CLUSTER_ENTRY_LENGTH)
+    {
+        if (memcmp(&block[offset], short_name, 11) == 0)
+        {
+            memcpy(&block[offset], new_name, 11);
+            is_found = true;
+        }
+    }
+
+    TEST_CHECK(is_found);
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_write(&watching.image, sector, block));
+}
+
+// FSInfo's free cluster count set to unknown, as on a volume nothing ever counted
+static void forget_free_count(void)
+{
+    uint8_t block[BLOCKDEV_SECTOR_SIZE];
+
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_read(&watching.image, 0, block));
+
+    uint32_t partition_lba = extract_uint32_le(block, FAT_BOOT_CODE_LEN + FAT_PARTITION_LBA_START_INDEX);
+
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_read(&watching.image, partition_lba, block));
+
+    uint32_t fsinfo_sector = partition_lba + extract_uint16_le(block, FAT_BOOT_FSINFO_SECTOR);
+
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_read(&watching.image, fsinfo_sector, block));
+    insert_uint32_le(block, FAT_FSINFO_FREE_COUNT, FAT_FSINFO_UNKNOWN);
+    TEST_CHECK_EQUAL(ESP_OK, blockdev_write(&watching.image, fsinfo_sector, block));
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File file;
+    char path[4096];
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    // The index & the changes go into a copy, the other tests share the image
+    snprintf(path, sizeof(path), "%s.track_index", argv[1]);
+
+    if (!copy_file(argv[1], path) || blockdev_file_open(&file, path, false, &watching.image) != ESP_OK)
+    {
+        fprintf(stderr, "Could not copy %s to %s\n", argv[1], path);
+        return 2;
+    }
+
+    FAT_Lookup_Entry album;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, track_index_init());
+    TEST_CHECK_EQUAL(ESP_OK, fat_lookup(fat_get_root_cluster(), ALBUM_NAME, strlen(ALBUM_NAME), &album));
+
+    watching.watched_sector = fat_cluster_to_sector(album.first_cluster);
+
+    // No index yet, then the saved one
+    TEST_CHECK(boot_scans());
+    TEST_CHECK_EQUAL(3, track_index_count());
+    TEST_CHECK(!boot_scans());
+    TEST_CHECK_EQUAL(3, track_index_count());
+
+    // A root entry renamed
+    rename_root_entry("NOTES   TXT", "NOTEZ   TXT");
+    TEST_CHECK(boot_scans());
+    TEST_CHECK(!boot_scans());
+
+    // A track added to the album takes clusters, the free count changes
+    FAT_File track;
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, fat_file_create(&track, album.first_cluster, "FOURTH.WAV", 4 * BLOCKDEV_SECTOR_SIZE));
+    TEST_CHECK(boot_scans());
+    TEST_CHECK_EQUAL(4, track_index_count());
+    TEST_CHECK(!boot_scans());
+    TEST_CHECK_EQUAL(4, track_index_count());
+
+    // Nothing to tell a change below the root by, every boot scans
+    forget_free_count();
+    TEST_CHECK(boot_scans());
+    TEST_CHECK(boot_scans());
+    TEST_CHECK_EQUAL(4, track_index_count());
+
+    blockdev_file_close(&file);
+    remove(path);
+
+    return host_test_result();
+}
@@ -0,0 +1,403 @@
+#include "track_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "utils.h"
+#include "fat/fat_dir.h"
+#include "fat/fat_file.h"
+
+typedef struct
+{
+    uint32_t path_hash; // Of the directory being walked
+    uint32_t depth;
+} Scan_Context;
+
+// What the root directory looks like right now
+typedef struct
+{
+    uint32_t directory_hash;
+    uint32_t file_cluster; // Index file, if there is one
+    uint32_t file_size;
+    bool has_file;
+} Root_State;
+
+static const char *TAG = "TRACK_INDEX";
+
+static Track_Entry *tracks = NULL;
+static uint32_t track_count = 0;
+
+// Tracks past TRACK_INDEX_MAX_TRACKS, counted so the index can tell it is short of some
+static uint32_t missed_count = 0;
+
+// Scan statistics, only for the log
+static uint32_t directory_count = 0;
+
+// First directory read that failed, the walk stops there
+static esp_err_t scan_error = ESP_OK;
+
+// Index file handle & its header sector
+static FAT_File index_file;
+static uint8_t header_block[BLOCKDEV_SECTOR_SIZE];
+
+esp_err_t track_index_init(void)
+{
+    if (tracks == NULL)
+    {
+        tracks = malloc(sizeof(Track_Entry) * TRACK_INDEX_MAX_TRACKS);
+
+        if (tracks == NULL)
+        {
+            ESP_LOGE(TAG, "No memory for %d tracks", TRACK_INDEX_MAX_TRACKS);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    track_count = 0;
+
+    return ESP_OK;
+}
+
+Track_Format track_index_format_from_name(const char *name)
+{
+    const char *extension = strrchr(name, '.');
+
+    if (extension == NULL)
+    {
+        return TRACK_FORMAT_UNKNOWN;
+    }
+
+    if (strcasecmp(extension, ".WAV") == 0)
+    {
+        return TRACK_FORMAT_WAV;
+    }
+
+    return TRACK_FORMAT_UNKNOWN;
+}
+
+static uint32_t hash_child(uint32_t parent_hash, const char *name)
+{
+    uint32_t hash = utils_hash_fnv1a(parent_hash, (const uint8_t *)"/", 1);
+
+    return utils_hash_fnv1a(hash, (const uint8_t *)name, strlen(name));
+}
+
+static bool scan_entry(const FAT_Dir_Item *item, void *arg)
+{
+    Scan_Context *context = (Scan_Context *)arg;
+    const FAT_Directory_Entry *entry = item->entry;
+
+    if (entry->DIR_Attr & DIRECTORY)
+    {
+        if (fat_dir_is_dot_entry(entry))
+        {
+            return true;
+        }
+
+        if (context->depth + 1 >= TRACK_INDEX_MAX_DEPTH)
+        {
+            ESP_LOGW(TAG, "Too deep, skipping %s", item->name);
+            return true;
+        }
+
+        Scan_Context child = {
+            .path_hash = hash_child(context->path_hash, item->name),
+            .depth = context->depth + 1,
+        };
+
+        directory_count++;
+        esp_err_t err = fat_dir_iterate(fat_dir_entry_cluster(entry), scan_entry, &child);
+
+        if (err != ESP_OK && scan_error == ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to read directory %s: %s", item->name, esp_err_to_name(err));
+            scan_error = err;
+        }
+
+        return scan_error == ESP_OK;
+    }
+
+    Track_Format format = track_index_format_from_name(item->name);
+
+    if (format == TRACK_FORMAT_UNKNOWN)
+    {
+        return true;
+    }
+
+    // Walk on anyway, only to count what is left out
+    if (track_count == TRACK_INDEX_MAX_TRACKS)
+    {
+        missed_count++;
+        return true;
+    }
+
+    Track_Entry *track = &tracks[track_count++];
+    track->path_hash = hash_child(context->path_hash, item->name);
+    track->first_cluster = fat_dir_entry_cluster(entry);
+    track->size = entry->DIR_FileSize;
+    track->format = format;
+
+    return true;
+}
+
+esp_err_t track_index_scan(void)
+{
+    if (tracks == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    track_count = 0;
+    missed_count = 0;
+    directory_count = 1;
+    scan_error = ESP_OK;
+
+    Scan_Context root = {
+        .path_hash = UTILS_FNV1A_INIT,
+        .depth = 0,
+    };
+
+    esp_err_t err = fat_dir_iterate(fat_get_root_cluster(), scan_entry, &root);
+
+    ESP_LOGI(TAG, "Scanned %d directories, found %d tracks in %d ms",
+             (unsigned int)directory_count, (unsigned int)(track_count + missed_count),
+             (unsigned int)((esp_timer_get_time() - start) / 1000));
+
+    if (missed_count > 0)
+    {
+        ESP_LOGW(TAG, "Index full, %d tracks left out past %d", (unsigned int)missed_count, TRACK_INDEX_MAX_TRACKS);
+    }
+
+    return err != ESP_OK ? err : scan_error;
+}
+
+uint32_t track_index_count(void)
+{
+    return track_count;
+}
+
+uint32_t track_index_missed_count(void)
+{
+    return missed_count;
+}
+
+const Track_Entry *track_index_get(uint32_t index)
+{
+    if (index >= track_count)
+    {
+        return NULL;
+    }
+
+    return &tracks[index];
+}
+
+static bool hash_root_entry(const FAT_Dir_Item *item, void *arg)
+{
+    Root_State *state = (Root_State *)arg;
+
+    if (strcmp(item->name, TRACK_INDEX_FILE_NAME) == 0)
+    {
+        state->has_file = true;
+        state->file_cluster = fat_dir_entry_cluster(item->entry);
+        state->file_size = item->entry->DIR_FileSize;
+        return true;
+    }
+
+    // Hosts bump the access date on plain reads, it must not count as a change
+    FAT_Directory_Entry entry = *item->entry;
+    entry.DIR_LstAccDate = 0;
+
+    state->directory_hash = utils_hash_fnv1a(state->directory_hash, (const uint8_t *)&entry, sizeof(entry));
+
+    return true;
+}
+
+static uint32_t hash_tracks(void)
+{
+    return utils_hash_fnv1a(UTILS_FNV1A_INIT, (const uint8_t *)tracks, track_count * sizeof(Track_Entry));
+}
+
+static esp_err_t track_index_load(const Root_State *root, const Track_Index_File_Header *expected)
+{
+    if (root->file_size != TRACK_INDEX_FILE_SIZE)
+    {
+        ESP_LOGW(TAG, "%s has the wrong size, delete it to have it made again", TRACK_INDEX_FILE_NAME);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fat_file_open_cluster(&index_file, root->file_cluster, root->file_size);
+
+    uint32_t bytes_read = 0;
+
+    if (err == ESP_OK)
+    {
+        err = fat_file_read(&index_file, header_block, BLOCKDEV_SECTOR_SIZE, &bytes_read);
+    }
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    Track_Index_File_Header *header = (Track_Index_File_Header *)header_block;
+
+    if (header->magic != expected->magic || header->version != expected->version ||
+        header->entry_size != expected->entry_size || header->volume_serial != expected->volume_serial ||
+        header->free_count != expected->free_count || header->directory_hash != expected->directory_hash ||
+        header->track_count > TRACK_INDEX_MAX_TRACKS)
+    {
+        ESP_LOGI(TAG, "Saved index is stale");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t tracks_hash = header->tracks_hash;
+
+    track_count = header->track_count;
+    missed_count = header->missed_count;
+    err = fat_file_read(&index_file, (uint8_t *)tracks, track_count * sizeof(Track_Entry), &bytes_read);
+
+    if (err != ESP_OK || hash_tracks() != tracks_hash)
+    {
+        ESP_LOGW(TAG, "Saved index is corrupted");
+        track_count = 0;
+        missed_count = 0;
+        return err != ESP_OK ? err : ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t track_index_save(const Root_State *root, Track_Index_File_Header *header)
+{
+    esp_err_t err;
+
+    if (root->has_file)
+    {
+        if (root->file_size != TRACK_INDEX_FILE_SIZE)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        err = fat_file_open_cluster(&index_file, root->file_cluster, root->file_size);
+    }
+    else
+    {
+        err = fat_file_create(&index_file, fat_get_root_cluster(), TRACK_INDEX_FILE_NAME, TRACK_INDEX_FILE_SIZE);
+    }
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // Creating the file took clusters, the count has to be the one after it
+    header->free_count = fat_get_free_count();
+    header->track_count = track_count;
+    header->missed_count = missed_count;
+    header->tracks_hash = hash_tracks();
+
+    // Entries first & the header last, an interrupted save leaves a header that does not match
+    uint32_t bytes_written;
+    err = fat_file_seek(&index_file, BLOCKDEV_SECTOR_SIZE);
+
+    if (err == ESP_OK)
+    {
+        err = fat_file_write(&index_file, (const uint8_t *)tracks, track_count * sizeof(Track_Entry), &bytes_written);
+    }
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    memset(header_block, 0, sizeof(header_block));
+    memcpy(header_block, header, sizeof(*header));
+
+    err = fat_file_seek(&index_file, 0);
+
+    if (err == ESP_OK)
+    {
+        err = fat_file_write(&index_file, header_block, BLOCKDEV_SECTOR_SIZE, &bytes_written);
+    }
+
+    return err;
+}
+
+esp_err_t track_index_load_or_scan(void)
+{
+    if (tracks == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    Root_State root = {
+        .directory_hash = UTILS_FNV1A_INIT,
+    };
+
+    esp_err_t err = fat_dir_iterate(fat_get_root_cluster(), hash_root_entry, &root);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    Track_Index_File_Header header = {
+        .magic = TRACK_INDEX_FILE_MAGIC,
+        .version = TRACK_INDEX_FILE_VERSION,
+        .entry_size = sizeof(Track_Entry),
+        .volume_serial = fat_get_volume_serial(),
+        .free_count = fat_get_free_count(),
+        .directory_hash = root.directory_hash,
+    };
+
+    // Files added or removed below the root only show in the free count, without one the walk is the only way to know
+    bool is_checkable = header.free_count != FAT_FSINFO_UNKNOWN;
+
+    if (is_checkable && root.has_file && track_index_load(&root, &header) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Loaded %d tracks from %s in %d ms", (unsigned int)track_count, TRACK_INDEX_FILE_NAME,
+                 (unsigned int)((esp_timer_get_time() - start) / 1000));
+
+        if (missed_count > 0)
+        {
+            ESP_LOGW(TAG, "Index full, %d tracks left out past %d", (unsigned int)missed_count, TRACK_INDEX_MAX_TRACKS);
+        }
+
+        return ESP_OK;
+    }
+
+    err = track_index_scan();
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (!is_checkable)
+    {
+        ESP_LOGI(TAG, "No free cluster count on the volume, the index is scanned on every boot");
+        return ESP_OK;
+    }
+
+    int64_t save_start = esp_timer_get_time();
+
+    err = track_index_save(&root, &header);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to save the index: %s", esp_err_to_name(err));
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Saved %d tracks to %s in %d ms", (unsigned int)track_count, TRACK_INDEX_FILE_NAME,
+             (unsigned int)((esp_timer_get_time() - save_start) / 1000));
+
+    return ESP_OK;
+}
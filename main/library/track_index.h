@@ -0,0 +1,95 @@
+#ifndef TRACK_INDEX_H
+#define TRACK_INDEX_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "blockdev/blockdev.h"
+
+/**
+ * Every playable file on the card, found by walking the whole directory tree.
+ * Entries are kept small, names are not stored - a file is told apart by the hash of its path.
+ */
+
+// Most tracks the index will hold, each costs sizeof(Track_Entry) of RAM & of the index file.
+// Boards with the memory to spare can build with a bigger one, tracks past it are counted but left out
+#ifndef TRACK_INDEX_MAX_TRACKS
+#define TRACK_INDEX_MAX_TRACKS 4096
+#endif
+
+// Deepest directory nesting that is still walked
+#define TRACK_INDEX_MAX_DEPTH 8
+
+/**
+ * The scan result is kept on the card in the root directory, so a boot with nothing changed skips the walk.
+ * It is trusted as long as the volume serial, the FSInfo free cluster count & the root directory's entries
+ * (names, sizes, write times) are the same as when it was saved. A volume without a free count is always scanned.
+ *
+ * Only the root's entries are compared, nothing below it is read. A subdirectory's write time is the one it got
+ * when it was made, hosts don't update it when files inside change. So within a subdirectory, a file renamed or
+ * replaced by one taking as many clusters goes unnoticed. Delete TRACK_INDEX_FILE_NAME to have the index rebuilt.
+ */
+#define TRACK_INDEX_FILE_NAME "TRACKS.IDX"
+#define TRACK_INDEX_FILE_MAGIC 0x58444954 // "TIDX"
+#define TRACK_INDEX_FILE_VERSION 2
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size; // sizeof(Track_Entry), a layout change makes the file stale
+    uint32_t volume_serial;
+    uint32_t free_count;
+    uint32_t directory_hash; // Root directory entries, minus the index file itself
+    uint32_t track_count;
+    uint32_t missed_count; // Tracks the index had no room for
+    uint32_t tracks_hash;  // Over the entries, catches a half written file
+} Track_Index_File_Header;
+
+// Header takes a sector of its own, entries follow
+#define TRACK_INDEX_FILE_SIZE (BLOCKDEV_SECTOR_SIZE + TRACK_INDEX_MAX_TRACKS * sizeof(Track_Entry))
+
+typedef enum
+{
+    TRACK_FORMAT_UNKNOWN = 0,
+    TRACK_FORMAT_WAV,
+} Track_Format;
+
+typedef struct
+{
+    uint32_t path_hash; // FNV-1a of "/DIR/FILE.EXT"
+    uint32_t first_cluster;
+    uint32_t size;
+    uint8_t format; // Track_Format
+} Track_Entry;
+
+/**
+ * Allocate room for the index, must be called before anything else.
+ */
+esp_err_t track_index_init(void);
+
+/**
+ * Walk every directory of the volume from the root & collect the tracks.
+ * The FAT must be initialized. A directory that can't be read fails the scan, the index would be missing its tracks.
+ */
+esp_err_t track_index_scan(void);
+
+/**
+ * Load the index file when it is still valid, otherwise scan & save the result for the next boot.
+ * A failed save is only logged, the index in RAM is good either way.
+ */
+esp_err_t track_index_load_or_scan(void);
+
+uint32_t track_index_count(void);
+
+// Tracks found once the index was full, they can't be played. 0 when every track made it in
+uint32_t track_index_missed_count(void);
+
+// NULL when out of range
+const Track_Entry *track_index_get(uint32_t index);
+
+// Format from a file name's extension
+Track_Format track_index_format_from_name(const char *name);
+
+#endif
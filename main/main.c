@@ -7,9 +7,20 @@
 
 #include "sd/sd.h"
 #include "fat/fat.h"
+#include "library/track_index.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_i2s.h"
+#include "player/player.h"
+#include "task_monitor.h"
 
 #define BLINK_GPIO 2
 
+// Log SD read throughput after init
+#define SD_RUN_BENCHMARK 0
+
+// Seconds between logs of every task's CPU load & stack use, 0 for none
+#define TASK_MONITOR_PERIOD_S 10
+
 static const char *TAG = "example";
 
 static uint8_t s_led_state = 0;
@@ -22,8 +33,22 @@ static void configure_led(void)
     gpio_set_direction(BLINK_GPIO, GPIO_MODE_OUTPUT);
 }
 
-static void blink_led(void)
+// Lit while playing, blinking while paused, off when stopped
+static void show_state(void)
 {
+    Player_Status status;
+
+    player_get_status(&status);
+
+    if (status.state == PLAYER_STATE_PAUSED)
+    {
+        s_led_state = !s_led_state;
+    }
+    else
+    {
+        s_led_state = status.state == PLAYER_STATE_PLAYING;
+    }
+
     gpio_set_level(BLINK_GPIO, s_led_state);
 }
 
@@ -33,16 +58,40 @@ void app_main(void)
 
     if (op_status == ESP_OK)
     {
-        fat_init();
+#if SD_RUN_BENCHMARK
+        sd_benchmark(0, 64);
+#endif
+        if (fat_init(sd_get_block_device()) == ESP_OK && track_index_init() == ESP_OK)
+        {
+            track_index_load_or_scan();
+
+            // Every WAV of the index, one after the other
+            if (player_init(audio_sink_i2s_get()) == ESP_OK)
+            {
+                player_play(0);
+            }
+        }
     }
 
     configure_led();
-    
-    while (1)
+
+    // Commands come in through the player's queue, all that's left here is showing what it's doing
+    for (uint32_t seconds = 1;; seconds++)
     {
-        blink_led();
-        /* Toggle the LED state */
-        s_led_state = !s_led_state;
+        show_state();
         vTaskDelay(1000 / portTICK_PERIOD_MS);
+
+        if (audio_output_is_playing())
+        {
+            player_log_status();
+            audio_output_log_stats();
+        }
+
+#if TASK_MONITOR_PERIOD_S
+        if (seconds % TASK_MONITOR_PERIOD_S == 0)
+        {
+            task_monitor_log();
+        }
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "player.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "fat/fat_file.h"
+#include "library/track_index.h"
+#include "audio/wav.h"
+#include "audio/audio_output.h"
+
+// Entries handed to audio output, in order, enough for the one playing & the two it may have opened ahead
+#define PLAYER_HISTORY 4
+
+// No such entry
+#define PLAYER_NO_TRACK UINT32_MAX
+
+static const char *TAG = "PLAYER";
+
+static QueueHandle_t command_queue = NULL;
+static TaskHandle_t player_handle = NULL;
+
+static atomic_uint sent = 0;
+static atomic_uint handled = 0;
+
+static uint32_t history[PLAYER_HISTORY];
+static atomic_uint history_count = 0;
+static uint32_t started = 0; // History count of the track audio output was last started on
+
+static uint32_t next_entry = 0; // Where the search for the track after the last opened one starts
+
+static Player_Status status;
+
+// Next WAV entry from `entry` on, walking by `step`
+static uint32_t find_track(uint32_t entry, int32_t step)
+{
+    while (entry < track_index_count())
+    {
+        if (track_index_get(entry)->format == TRACK_FORMAT_WAV)
+        {
+            return entry;
+        }
+
+        entry += step;
+    }
+
+    return PLAYER_NO_TRACK;
+}
+
+static esp_err_t open_entry(uint32_t entry, FAT_File *file, WAV_Info *info)
+{
+    const Track_Entry *track = track_index_get(entry);
+    esp_err_t err = fat_file_open_cluster(file, track->first_cluster, track->size);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    err = wav_parse(file, info);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    history[atomic_load(&history_count) % PLAYER_HISTORY] = entry;
+    atomic_fetch_add(&history_count, 1);
+    next_entry = entry + 1;
+
+    return ESP_OK;
+}
+
+// Hands out the following tracks to audio output, from its producer task. Files that won't parse are skipped
+static bool open_next_track(FAT_File *file, WAV_Info *info)
+{
+    for (uint32_t entry = find_track(next_entry, 1); entry != PLAYER_NO_TRACK; entry = find_track(entry + 1, 1))
+    {
+        if (open_entry(entry, file, info) == ESP_OK)
+        {
+            return true;
+        }
+
+        ESP_LOGW(TAG, "Skipping entry %d, not a WAV we can play", (unsigned int)entry);
+    }
+
+    return false;
+}
+
+// Entry audio output is playing right now, or stopped on last
+static uint32_t current_track(void)
+{
+    Audio_Output_Stats stats;
+
+    if (atomic_load(&history_count) == 0)
+    {
+        return PLAYER_NO_TRACK;
+    }
+
+    audio_output_get_stats(&stats);
+
+    uint32_t count = started + (stats.tracks > 0 ? stats.tracks - 1 : 0);
+
+    return history[count % PLAYER_HISTORY];
+}
+
+// Play `entry` from `position_ms` into it, whatever was playing fades out first.
+// The producer is idle from then on, the history is ours until the start
+static esp_err_t play_entry(uint32_t entry, uint32_t position_ms)
+{
+    FAT_File file;
+    WAV_Info info;
+
+    audio_output_fade_out();
+
+    if (entry == PLAYER_NO_TRACK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = open_entry(entry, &file, &info);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint64_t frame = (uint64_t)position_ms * info.sample_rate / 1000;
+    uint64_t offset = frame * info.block_align;
+
+    // Past the end plays nothing of it, audio output goes straight on to the next track
+    if (offset > info.data_size)
+    {
+        offset = info.data_size - info.data_size % info.block_align;
+    }
+
+    err = fat_file_seek(&file, info.data_offset + (uint32_t)offset);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    started = atomic_load(&history_count) - 1;
+
+    return audio_output_start(&file, &info);
+}
+
+static esp_err_t handle_command(const Player_Command *command)
+{
+    uint32_t current = current_track();
+
+    switch (command->type)
+    {
+    case PLAYER_COMMAND_PLAY:
+        return play_entry(find_track(command->argument, 1), 0);
+
+    case PLAYER_COMMAND_PAUSE:
+        if (!audio_output_is_playing())
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        audio_output_pause();
+        return ESP_OK;
+
+    case PLAYER_COMMAND_RESUME:
+        if (!audio_output_is_playing())
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        audio_output_resume();
+        return ESP_OK;
+
+    case PLAYER_COMMAND_NEXT:
+        return play_entry(find_track(current == PLAYER_NO_TRACK ? 0 : current + 1, 1), 0);
+
+    case PLAYER_COMMAND_PREV:
+        // Walking down from 0 wraps past the end of the index & finds nothing
+        return play_entry(current == PLAYER_NO_TRACK ? PLAYER_NO_TRACK : find_track(current - 1, -1), 0);
+
+    case PLAYER_COMMAND_SEEK:
+        // In place while it plays, the track is only started over once it ended
+        if (audio_output_seek(command->argument) == ESP_OK)
+        {
+            return ESP_OK;
+        }
+
+        return play_entry(current, command->argument);
+
+    case PLAYER_COMMAND_STOP:
+        audio_output_fade_out();
+        return ESP_OK;
+
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static void player_task(void *arg)
+{
+    Player_Command command;
+
+    while (1)
+    {
+        xQueueReceive(command_queue, &command, portMAX_DELAY);
+
+        esp_err_t err = handle_command(&command);
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - command.sent_at);
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Command %d (%d) failed: %s", command.type, (unsigned int)command.argument, esp_err_to_name(err));
+            status.failed++;
+        }
+
+        status.last_latency_us = latency;
+
+        if (latency > status.max_latency_us)
+        {
+            status.max_latency_us = latency;
+        }
+
+        status.handled++;
+        atomic_fetch_add(&handled, 1);
+    }
+}
+
+esp_err_t player_init(const Audio_Sink *sink)
+{
+    esp_err_t err = audio_output_init(sink);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    audio_output_set_next_track(open_next_track);
+
+    command_queue = xQueueCreate(PLAYER_QUEUE_LENGTH, sizeof(Player_Command));
+
+    if (command_queue == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreatePinnedToCore(player_task, "player", PLAYER_STACK, NULL, PLAYER_PRIORITY, &player_handle, PLAYER_CORE) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t player_send(Player_Command_Type type, uint32_t argument)
+{
+    Player_Command command = {
+        .type = type,
+        .argument = argument,
+        .sent_at = esp_timer_get_time(),
+    };
+
+    if (xQueueSend(command_queue, &command, pdMS_TO_TICKS(PLAYER_SEND_TIMEOUT_MS)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    atomic_fetch_add(&sent, 1);
+
+    return ESP_OK;
+}
+
+esp_err_t player_play(uint32_t track)
+{
+    return player_send(PLAYER_COMMAND_PLAY, track);
+}
+
+esp_err_t player_pause(void)
+{
+    return player_send(PLAYER_COMMAND_PAUSE, 0);
+}
+
+esp_err_t player_resume(void)
+{
+    return player_send(PLAYER_COMMAND_RESUME, 0);
+}
+
+esp_err_t player_next(void)
+{
+    return player_send(PLAYER_COMMAND_NEXT, 0);
+}
+
+esp_err_t player_prev(void)
+{
+    return player_send(PLAYER_COMMAND_PREV, 0);
+}
+
+esp_err_t player_seek(uint32_t position_ms)
+{
+    return player_send(PLAYER_COMMAND_SEEK, position_ms);
+}
+
+esp_err_t player_stop(void)
+{
+    return player_send(PLAYER_COMMAND_STOP, 0);
+}
+
+void player_wait_idle(void)
+{
+    while (atomic_load(&handled) != atomic_load(&sent))
+    {
+        vTaskDelay(1);
+    }
+}
+
+void player_get_status(Player_Status *out)
+{
+    *out = status;
+
+    out->track = current_track();
+
+    if (!audio_output_is_playing())
+    {
+        out->state = PLAYER_STATE_STOPPED;
+    }
+    else
+    {
+        out->state = audio_output_is_paused() ? PLAYER_STATE_PAUSED : PLAYER_STATE_PLAYING;
+    }
+}
+
+void player_log_status(void)
+{
+    static const char *state_names[] = {"stopped", "playing", "paused"};
+    Player_Status current;
+
+    player_get_status(&current);
+
+    ESP_LOGI(TAG, "%s, entry %d, commands: %d (%d failed), latency: %d us, max: %d us", state_names[current.state],
+             (int)current.track, (unsigned int)current.handled, (unsigned int)current.failed, (unsigned int)current.last_latency_us,
+             (unsigned int)current.max_latency_us);
+}
+
+esp_err_t player_run_script(const char *script)
+{
+    static const struct
+    {
+        const char *name;
+        Player_Command_Type type;
+    } commands[] = {
+        {"play", PLAYER_COMMAND_PLAY},
+        {"pause", PLAYER_COMMAND_PAUSE},
+        {"resume", PLAYER_COMMAND_RESUME},
+        {"next", PLAYER_COMMAND_NEXT},
+        {"prev", PLAYER_COMMAND_PREV},
+        {"seek", PLAYER_COMMAND_SEEK},
+        {"stop", PLAYER_COMMAND_STOP},
+    };
+
+    const char *at = script;
+
+    while (*at != '\0')
+    {
+        char word[8];
+        uint32_t length = 0;
+
+        at += strspn(at, " \t\r\n;");
+
+        while (*at != '\0' && strchr(" \t\r\n;", *at) == NULL)
+        {
+            if (length < sizeof(word) - 1)
+            {
+                word[length++] = *at;
+            }
+
+            at++;
+        }
+
+        word[length] = '\0';
+
+        if (length == 0)
+        {
+            break;
+        }
+
+        // Argument, if any, up to the end of the step
+        char *end;
+        uint32_t argument = strtoul(at, &end, 10);
+
+        at = end;
+
+        if (strcasecmp(word, "wait") == 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(argument));
+            continue;
+        }
+
+        uint32_t i = 0;
+
+        while (i < sizeof(commands) / sizeof(commands[0]) && strcasecmp(word, commands[i].name) != 0)
+        {
+            i++;
+        }
+
+        if (i == sizeof(commands) / sizeof(commands[0]))
+        {
+            ESP_LOGE(TAG, "Unknown command in script: %s", word);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        esp_err_t err = player_send(commands[i].type, argument);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        player_wait_idle();
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,105 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include <esp_err.h>
+#include "stdbool.h"
+#include "stdint.h"
+
+#include "audio/audio_sink.h"
+#include "task_layout.h"
+
+/**
+ * The control plane: a task working through a queue of commands, so buttons, a console or a test script
+ * never touch the audio tasks directly. It plays the WAVs of the track index in order, handing them to
+ * audio output one after the other, which streams them from the card through the PCM ring to the sink.
+ *
+ * Commands are handled one at a time in the order they were sent. The task blocks on the queue, so a command
+ * starts the moment the previous one is done. None takes longer than a fade (AUDIO_GAIN_RAMP_MS), opening a
+ * track & priming the ring: the worst seen is kept in the status.
+ */
+
+// Commands waiting to be handled, a sender blocks for at most PLAYER_SEND_TIMEOUT_MS when it's full
+#define PLAYER_QUEUE_LENGTH 8
+#define PLAYER_SEND_TIMEOUT_MS 100
+
+// Between the audio tasks: above the card reads, below the sink feed. On the audio core, it opens the sink
+#define PLAYER_STACK 4096
+#define PLAYER_PRIORITY 8
+#define PLAYER_CORE TASK_CORE_AUDIO
+
+typedef enum
+{
+    PLAYER_COMMAND_PLAY = 0, // Argument is the track index entry to play, the first WAV from there on
+    PLAYER_COMMAND_PAUSE,
+    PLAYER_COMMAND_RESUME,
+    PLAYER_COMMAND_NEXT,
+    PLAYER_COMMAND_PREV,
+    PLAYER_COMMAND_SEEK, // Argument is the position in ms, playing on from there
+    PLAYER_COMMAND_STOP,
+} Player_Command_Type;
+
+typedef struct
+{
+    uint8_t type; // Player_Command_Type
+    uint32_t argument;
+    int64_t sent_at;
+} Player_Command;
+
+typedef enum
+{
+    PLAYER_STATE_STOPPED = 0,
+    PLAYER_STATE_PLAYING,
+    PLAYER_STATE_PAUSED,
+} Player_State;
+
+typedef struct
+{
+    Player_State state;
+    uint32_t track;           // Track index entry being handed to the sink, or the last one played
+    uint32_t handled;         // Commands since init
+    uint32_t failed;          // Of those, the ones that could not be carried out, e.g. next on the last track
+    uint32_t last_latency_us; // From sending the last command to it being done
+    uint32_t max_latency_us;
+} Player_Status;
+
+/**
+ * Start the player task & audio output on `sink`. The track index must be loaded.
+ */
+esp_err_t player_init(const Audio_Sink *sink);
+
+/**
+ * Queue a command, ESP_ERR_TIMEOUT when the queue stayed full for PLAYER_SEND_TIMEOUT_MS.
+ */
+esp_err_t player_send(Player_Command_Type type, uint32_t argument);
+
+esp_err_t player_play(uint32_t track);
+
+esp_err_t player_pause(void);
+
+esp_err_t player_resume(void);
+
+esp_err_t player_next(void);
+
+esp_err_t player_prev(void);
+
+esp_err_t player_seek(uint32_t position_ms);
+
+esp_err_t player_stop(void);
+
+/**
+ * Block until every command sent so far was handled.
+ */
+void player_wait_idle(void);
+
+void player_get_status(Player_Status *status);
+
+void player_log_status(void);
+
+/**
+ * Run a sequence of commands, one per line or separated by ';', each one waited for before the next:
+ * "play 0; wait 500; pause; wait 100; resume; seek 90000; next; prev; stop".
+ * `wait <ms>` only sleeps. For tests & the console, ESP_ERR_INVALID_ARG on a command it doesn't know.
+ */
+esp_err_t player_run_script(const char *script);
+
+#endif
@@ -0,0 +1,278 @@
+// player_run_script on the player image (make_player_image.py): play, pause, resume, next, prev, seek & stop, one
+// step of the script at a time. After each one the player's state & entry are checked, so is where the PCM handed to
+// the sink got to: the last frames written at full gain are looked up in the tracks, which never repeat. Every
+// command has to be done within a fade out, opening a track & priming the ring.
+//
+//   test_player_script <player image>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "library/track_index.h"
+#include "audio/wav.h"
+#include "audio/audio_gain.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_file.h"
+#include "player/player.h"
+
+#define TRACKS 3
+#define FRAME_SIZE 4 // 16 bit stereo, written as it is
+#define FRAMES_PER_MS 44.1
+
+#define CAPTURE_SIZE (4 * 1024 * 1024)
+
+// Frames compared to find where the output is, & how far back from its end to look for them at full gain
+#define LOCATE_FRAMES 16
+#define LOCATE_MAX_BACK 4096
+
+// What's written runs ahead of what's played by the sink's buffers, & the script's waits are only kept to a tick
+#define POSITION_TOLERANCE_MS 60
+
+// A fade out, rounded up to the host's 10 ms ticks, opening the track & priming the ring
+#define MAX_LATENCY_US ((4 * AUDIO_GAIN_RAMP_MS + 3 * portTICK_PERIOD_MS) * 1000)
+
+// Passes everything on to a null file sink, which keeps the time, & keeps a copy of what was written
+typedef struct
+{
+    Audio_Sink_File file;
+    Audio_Sink file_sink;
+    uint8_t *data;
+    atomic_uint length;
+} Capture;
+
+typedef struct
+{
+    const char *script;
+    Player_State state;
+    uint32_t track;
+    bool is_relative; // Position from where the previous step got to, rather than into the track
+    uint32_t position_ms;
+} Step;
+
+static Capture capture;
+static uint8_t *pcm[TRACKS];
+static uint32_t frames[TRACKS];
+
+static esp_err_t capture_open(void *context, const Audio_Format *format, audio_sink_sent_callback on_sent, void *arg)
+{
+    return audio_sink_open(&capture.file_sink, format, on_sent, arg);
+}
+
+static esp_err_t capture_write(void *context, const uint8_t *source, uint32_t size, uint32_t *written)
+{
+    esp_err_t err = audio_sink_write(&capture.file_sink, source, size, written);
+    uint32_t length = atomic_load(&capture.length);
+
+    if (err == ESP_OK && length + *written <= CAPTURE_SIZE)
+    {
+        memcpy(&capture.data[length], source, *written);
+        atomic_store(&capture.length, length + *written);
+    }
+
+    return err;
+}
+
+static void capture_close(void *context)
+{
+    audio_sink_close(&capture.file_sink);
+}
+
+static uint32_t capture_buffer_size(void *context)
+{
+    return audio_sink_buffer_size(&capture.file_sink);
+}
+
+static const Audio_Sink_Ops capture_ops = {
+    .open = capture_open,
+    .write = capture_write,
+    .close = capture_close,
+    .buffer_size = capture_buffer_size,
+};
+
+// PCM of every track straight off the image, in index order
+static void read_tracks(void)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < track_index_count() && count < TRACKS; i++)
+    {
+        const Track_Entry *track = track_index_get(i);
+        FAT_File file;
+        WAV_Info info;
+        uint32_t bytes_read;
+
+        TEST_CHECK_EQUAL(TRACK_FORMAT_WAV, track->format);
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_open_cluster(&file, track->first_cluster, track->size));
+        TEST_CHECK_EQUAL(ESP_OK, wav_parse(&file, &info));
+        TEST_CHECK_EQUAL(FRAME_SIZE, info.block_align);
+
+        pcm[count] = malloc(info.data_size);
+        frames[count] = info.data_size / FRAME_SIZE;
+        TEST_CHECK_EQUAL(ESP_OK, fat_file_read(&file, pcm[count], info.data_size, &bytes_read));
+        TEST_CHECK_EQUAL(info.data_size, bytes_read);
+
+        count++;
+    }
+
+    TEST_CHECK_EQUAL(TRACKS, count);
+}
+
+static bool find_frames(const uint8_t *window, uint32_t *track, uint32_t *frame)
+{
+    for (uint32_t i = 0; i < TRACKS; i++)
+    {
+        for (uint32_t f = 0; f + LOCATE_FRAMES <= frames[i]; f++)
+        {
+            if (memcmp(&pcm[i][f * FRAME_SIZE], window, LOCATE_FRAMES * FRAME_SIZE) == 0)
+            {
+                *track = i;
+                *frame = f;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Track & frame the output got to: the last run of LOCATE_FRAMES as they are in a track, i.e. not in a fade, &
+// the frames written after it
+static bool locate(uint32_t *track, uint32_t *frame)
+{
+    uint32_t end = atomic_load(&capture.length);
+
+    end -= end % FRAME_SIZE;
+
+    for (uint32_t back = 0; back < LOCATE_MAX_BACK && (back + LOCATE_FRAMES) * FRAME_SIZE <= end; back++)
+    {
+        if (find_frames(&capture.data[end - (back + LOCATE_FRAMES) * FRAME_SIZE], track, frame))
+        {
+            *frame += LOCATE_FRAMES + back;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Run one step & check where the player is after it, returns the position in ms
+static uint32_t run_step(const Step *step, uint32_t previous_ms, bool was_playing)
+{
+    Player_Status status;
+    uint32_t track = UINT32_MAX;
+    uint32_t frame = 0;
+    uint32_t length = atomic_load(&capture.length);
+
+    player_get_status(&status);
+
+    uint32_t handled = status.handled;
+
+    TEST_CHECK_EQUAL(ESP_OK, player_run_script(step->script));
+
+    player_get_status(&status);
+    TEST_CHECK_EQUAL(step->state, status.state);
+    TEST_CHECK_EQUAL(step->track, status.track);
+    TEST_CHECK(status.last_latency_us <= MAX_LATENCY_US);
+
+    // Paused or stopped all along, nothing more reached the sink
+    if (!was_playing && step->state != PLAYER_STATE_PLAYING)
+    {
+        TEST_CHECK_EQUAL(length, atomic_load(&capture.length));
+    }
+
+    TEST_CHECK(locate(&track, &frame));
+    TEST_CHECK_EQUAL(step->track, track);
+
+    uint32_t position_ms = (uint32_t)(frame / FRAMES_PER_MS);
+    uint32_t expected_ms = step->is_relative ? previous_ms + step->position_ms : step->position_ms;
+
+    TEST_CHECK(position_ms + POSITION_TOLERANCE_MS >= expected_ms && position_ms <= expected_ms + POSITION_TOLERANCE_MS);
+
+    printf("%-20s entry %u at %u ms (expected %u)", step->script, (unsigned int)track, (unsigned int)position_ms,
+           (unsigned int)expected_ms);
+
+    if (status.handled != handled)
+    {
+        printf(", command done in %u us", (unsigned int)status.last_latency_us);
+    }
+
+    printf("\n");
+
+    return position_ms;
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File image;
+    static Block_Device device;
+    static Audio_Sink sink = {.ops = &capture_ops, .context = &capture};
+
+    // After each step: what the player says & where the output is
+    static const Step steps[] = {
+        {"play 0; wait 300", PLAYER_STATE_PLAYING, 0, false, 300},
+        {"pause; wait 50", PLAYER_STATE_PAUSED, 0, true, 0},
+        {"wait 200", PLAYER_STATE_PAUSED, 0, true, 0},
+        {"resume; wait 300", PLAYER_STATE_PLAYING, 0, true, 300},
+        {"next; wait 300", PLAYER_STATE_PLAYING, 1, false, 300},
+        {"prev; wait 300", PLAYER_STATE_PLAYING, 0, false, 300},
+        {"seek 1500; wait 200", PLAYER_STATE_PLAYING, 0, false, 1700},
+        {"stop", PLAYER_STATE_STOPPED, 0, true, 0},
+        {"wait 100", PLAYER_STATE_STOPPED, 0, true, 0},
+    };
+
+    if (argc < 2 || blockdev_file_open(&image, argv[1], true, &device) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <player image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, fat_init(&device));
+    TEST_CHECK_EQUAL(ESP_OK, track_index_init());
+    TEST_CHECK_EQUAL(ESP_OK, track_index_scan());
+
+    read_tracks();
+
+    capture.data = malloc(CAPTURE_SIZE);
+    audio_sink_file_init(&capture.file, NULL, &capture.file_sink);
+    TEST_CHECK_EQUAL(ESP_OK, player_init(&sink));
+
+    uint32_t position_ms = 0;
+    bool is_playing = false;
+
+    for (uint32_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+    {
+        position_ms = run_step(&steps[i], position_ms, is_playing);
+        is_playing = steps[i].state == PLAYER_STATE_PLAYING;
+    }
+
+    Player_Status status;
+
+    player_get_status(&status);
+    TEST_CHECK_EQUAL(0, status.failed);
+    TEST_CHECK(status.max_latency_us <= MAX_LATENCY_US);
+
+    printf("Slowest command: %u us, bound %u us\n", (unsigned int)status.max_latency_us, (unsigned int)MAX_LATENCY_US);
+
+    // Nothing is sent for a script that doesn't parse
+    TEST_CHECK_EQUAL(ESP_ERR_INVALID_ARG, player_run_script("rewind 10"));
+
+    player_get_status(&status);
+    TEST_CHECK_EQUAL(7, status.handled);
+
+    for (uint32_t i = 0; i < TRACKS; i++)
+    {
+        free(pcm[i]);
+    }
+
+    free(capture.data);
+    blockdev_file_close(&image);
+
+    return host_test_result();
+}
@@ -1,6 +1,12 @@
 #include "sd.h"
+#include "sd_crc.h"
 
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 #define SD_CS 5
 #define SD_MOSI 23
@@ -13,23 +19,93 @@
 #define CMD_55_ID 55
 #define CMD_41_ID 41
 #define CMD_17_ID 17 // 0x51: Read single block
+#define CMD_18_ID 18 // 0x52: Read multiple blocks
+#define CMD_12_ID 12 // 0x4C: Stop transmission, ends CMD18
+#define CMD_59_ID 59 // 0x7B: CRC on/off
+#define CMD_9_ID 9   // 0x49: Send CSD
+#define CMD_24_ID 24 // 0x58: Write single block
+#define CMD_25_ID 25 // 0x59: Write multiple blocks
+#define CMD_16_ID 16 // 0x50: Set block length, SDSC only
 
 #define CMD_0_BODY 0x00
 #define CMD_8_BODY 0x1AA
 #define CMD_58_BODY 0x00
 #define CMD_55_BODY 0x00
 #define CMD_41_BODY 0x40000000 // HCS to 1, for SDHC/SDXC support
+#define CMD_12_BODY 0x00
+#define CMD_59_BODY_CRC_ON 0x01
+#define CMD_9_BODY 0x00
+#define CMD_16_BODY SD_BLOCK_SIZE
+
+#define CSD_LENGTH 16
+
+#define SD_BUSY_RETRIES 1000 // How many bytes to read while the card holds MISO low
+
+#define SD_INIT_CLOCK_HZ 100000 // Initialize at low clock speed (100 kHz)
+
+// Clock speeds tried after init, lowest to highest
+static const uint32_t sd_clock_ladder[] = {
+    400 * 1000,
+    1 * 1000 * 1000,
+    5 * 1000 * 1000,
+    10 * 1000 * 1000,
+    20 * 1000 * 1000,
+    26 * 1000 * 1000,
+};
+
+#define SD_CLOCK_LADDER_LENGTH (sizeof(sd_clock_ladder) / sizeof(sd_clock_ladder[0]))
 
 void sd_warmup(void);
 esp_err_t sd_spi_init(void);
+static esp_err_t sd_set_clock(uint32_t clock_hz);
+static esp_err_t sd_read_block_once(uint32_t block_address, uint8_t *destination);
+static esp_err_t sd_read_data_packet(uint8_t *destination, uint32_t length);
 
 static const char *TAG = "SD";
 static spi_device_handle_t spi;
 
-// Initialized to an invalid byte
-static uint8_t current_byte = 0xff;
+// OCR CCS: SDHC/SDXC cards take block numbers as data addresses, SDSC ones byte addresses
+static bool block_addressing = false;
+
+// DMA capable scratch space for bulk reads, the card wants MOSI high while we read
+DMA_ATTR static uint8_t dma_rx_buffer[SD_DMA_BUFFER_SIZE];
+DMA_ATTR static uint8_t dma_tx_dummy[SD_DMA_BUFFER_SIZE];
+DMA_ATTR static uint8_t dma_tx_buffer[SD_DMA_BUFFER_SIZE]; // Writes from buffers DMA can't reach
+
+// Bulk reads can be turned off to compare against the old byte per transaction path
+static bool bulk_reads_enabled = true;
+
+// Async stream state, transactions must outlive the queue so they live here
+static bool stream_active = false;
+static bool stream_pending = false;
+static uint8_t *stream_destination = NULL;
+static spi_transaction_t stream_payload;
+static spi_transaction_t stream_crc;
+
+// Clock drop asked for while a stream had the bus, re-adding the device would drop its queued transfers
+static bool stream_clock_pending = false;
+
+// Current position on the clock ladder, -1 while still on the init clock
+static int32_t clock_step = -1;
+
+// Fingerprints of the verify blocks, taken on the init clock
+static uint32_t verify_hashes[SD_CLOCK_VERIFY_BLOCKS];
+
+// Read errors within the current window of reads
+static uint32_t window_reads = 0;
+static uint32_t window_errors = 0;
+
+// Card checks command CRCs & we check data CRCs, set once CMD59 is accepted
+static bool crc_enabled = false;
+
+// Card capacity in 512 byte sectors from the CSD, 0 when unknown
+static uint32_t sector_count = 0;
+
+// Block device users may live in different tasks, only one of them gets to talk to the card at a time
+static SemaphoreHandle_t blockdev_lock = NULL;
 
-static uint16_t read_block_size = SDHC_SDXC_BLOCK_SIZE;
+// Every command sent since boot, handy to see how chatty a read path is
+static uint32_t command_count = 0;
 
 bool sd_is_idle_state(uint8_t *response)
 {
@@ -61,71 +137,92 @@ esp_err_t sd_send_command(uint8_t cmd, uint32_t arg)
     command[3] = (arg >> 8) & 0xFF;
     command[4] = arg & 0xFF;
 
-    // CRC, required only by a few, so better to just hardcode for them
-    switch (cmd)
-    {
-    case 0:
-        command[5] = 0x95;
-        break;
-    case 8:
-        command[5] = 0x87;
-        break;
-    default:
-    case 58:
-        command[5] = 0xff;
-    }
+    // CRC, only checked by the card for CMD0/CMD8 unless CRC mode is on, always sent anyway
+    command[5] = sd_crc7_command(command, 5);
 
     spi_transaction_t t = {
         .length = 6 * 8,
         .tx_buffer = command,
     };
 
+    command_count++;
+
     return spi_device_transmit(spi, &t);
 }
 
-esp_err_t sd_read_byte(uint8_t *response)
+uint32_t sd_get_command_count(void)
 {
-    uint8_t dummy = 0xFF;
+    return command_count;
+}
 
+esp_err_t sd_read_byte(uint8_t *response)
+{
+    // Data lives inside the transaction itself, no DMA setup or interrupt for a single byte
     spi_transaction_t r = {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
         .length = 8, // these are bits
-        .tx_buffer = &dummy,
-        .rx_buffer = response,
+        .tx_data = {0xFF},
     };
 
-    return spi_device_transmit(spi, &r);
+    esp_err_t err = spi_device_polling_transmit(spi, &r);
+
+    *response = r.rx_data[0];
+
+    return err;
 }
 
-// Read till we get a valid byte
-static bool read_valid_byte()
+// Read X bytes as they come, one transaction per byte
+static esp_err_t sd_read_raw_bytewise(uint8_t *target, uint32_t count)
 {
-    // XXX we could check if MISO is high without doing reads?
-    sd_read_byte(&current_byte);
-
-    if (current_byte != 0xff)
+    for (uint32_t i = 0; i < count; i++)
     {
-        return true;
+        esp_err_t err = sd_read_byte(&target[i]);
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGI(TAG, "ESP_ERR %d", (uint8_t)err);
+            return err;
+        }
     }
 
-    return false;
+    return ESP_OK;
 }
 
-esp_err_t sd_read_bytes(uint8_t *target, uint32_t count)
+/**
+ * Read X bytes as they come, without waiting for a valid byte first.
+ * Clocks out 0xFF & receives into the DMA buffer, one transaction per `SD_DMA_BUFFER_SIZE` bytes.
+ * When the target itself is fit for DMA the data lands there directly, no copy.
+ */
+static esp_err_t sd_read_raw(uint8_t *target, uint32_t count)
 {
-
-    if (!utils_retry(read_valid_byte))
+    // Tiny reads fit into the transaction itself
+    if (!bulk_reads_enabled || count <= 4)
     {
-        ESP_LOGE(TAG, "Failed to read a valid byte!");
-        return ESP_FAIL;
+        return sd_read_raw_bytewise(target, count);
     }
 
-    target[0] = current_byte;
+    uint32_t index = 0;
 
-    // Read the rest
-    for (uint32_t i = 1; i < count; i++)
+    while (index < count)
     {
+        uint32_t chunk = count - index;
+
+        if (chunk > SD_DMA_BUFFER_SIZE)
+        {
+            chunk = SD_DMA_BUFFER_SIZE;
+        }
+
+        // DMA wants internal RAM, word aligned address & length, otherwise the driver bounces it anyway
+        uint8_t *chunk_target = &target[index];
+        bool is_direct = esp_ptr_dma_capable(chunk_target) && ((uintptr_t)chunk_target % 4) == 0 && (chunk % 4) == 0;
+
+        spi_transaction_t r = {
+            .length = chunk * 8, // these are bits
+            .tx_buffer = dma_tx_dummy,
+            .rx_buffer = is_direct ? chunk_target : dma_rx_buffer,
+        };
 
-        esp_err_t err = sd_read_byte(&current_byte);
+        esp_err_t err = spi_device_transmit(spi, &r);
 
         if (err != ESP_OK)
         {
@@ -133,7 +230,42 @@ esp_err_t sd_read_bytes(uint8_t *target, uint32_t count)
             return err;
         }
 
-        target[i] = current_byte;
+        if (!is_direct)
+        {
+            memcpy(chunk_target, dma_rx_buffer, sizeof(uint8_t) * chunk);
+        }
+
+        index += chunk;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sd_read_bytes(uint8_t *target, uint32_t count)
+{
+    // Responses come within 8 bytes, a data token can take the card's whole access time
+    int64_t deadline = esp_timer_get_time() + SD_READ_TIMEOUT_US;
+
+    do
+    {
+        esp_err_t err = sd_read_byte(&target[0]);
+
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    } while (target[0] == 0xFF && esp_timer_get_time() < deadline);
+
+    if (target[0] == 0xFF)
+    {
+        ESP_LOGE(TAG, "Failed to read a valid byte!");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Read the rest
+    if (count > 1)
+    {
+        return sd_read_raw(&target[1], count - 1);
     }
 
     return ESP_OK;
@@ -192,6 +324,28 @@ static bool read_byte_is_idle()
     return response == 0x01;
 }
 
+// CMD16: 512 byte blocks, what everything above the driver takes a sector to be
+static esp_err_t sd_set_block_length(void)
+{
+    esp_err_t err = sd_send_command(CMD_16_ID, CMD_16_BODY);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint8_t r1 = 0xFF;
+    err = sd_read_bytes(&r1, 1);
+
+    if (err != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Card refused %d byte blocks: %d", SD_BLOCK_SIZE, r1);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t sd_init_card(void)
 {
     esp_err_t err = ESP_OK;
@@ -248,10 +402,9 @@ esp_err_t sd_init_card(void)
 
         CMD58_OCR *c = (CMD58_OCR *)&ocr;
 
-        // The default
-        read_block_size = SDHC_SDXC_BLOCK_SIZE;
+        block_addressing = c->card_capacity_status == 1;
 
-        if (c->card_capacity_status == 1)
+        if (block_addressing)
         {
             ESP_LOGI(TAG, "High/Extended capacity card.");
         }
@@ -290,17 +443,22 @@ esp_err_t sd_init_card(void)
                 ESP_LOGI(TAG, "Card voltage OK");
             }
 
-            if (!sd_ready_card())
+            // Takes as many ACMD41s as a newer card
+            if (!utils_retry_times(sd_ready_card, 10))
             {
                 return ESP_FAIL;
             }
 
-            read_block_size = SDSC_BLOCK_SIZE;
-
-            return ESP_OK;
+            block_addressing = false;
         }
     }
 
+    // High capacity cards have fixed 512 byte blocks, a standard capacity one may default to its READ_BL_LEN
+    if (!block_addressing)
+    {
+        return sd_set_block_length();
+    }
+
     return ESP_OK;
 }
 
@@ -322,36 +480,226 @@ void sd_warmup(void)
 
 esp_err_t sd_init()
 {
+    if (blockdev_lock == NULL)
+    {
+        blockdev_lock = xSemaphoreCreateMutex();
+    }
+
     // Configure the bus
     sd_spi_init();
 
     // Get the SD card itself into a functional state
     esp_err_t err = sd_init_card();
 
-    // Reattach device for higher clock speeds
+    // Find the fastest clock the wiring can take
     if (err == ESP_OK)
     {
-        ESP_LOGI(TAG, "Card init success - bumping bus speed.");
+#if SD_CRC_MODE
+        sd_enable_crc();
+#endif
 
-        spi_bus_remove_device(spi);
+        sd_read_csd();
 
-        // XXX Go higher speeds on PCB, breadboard works on 1 Mhz
-        spi_device_interface_config_t dev_cfg = {
-            .mode = 0, // SPI mode 0
-            .spics_io_num = SD_CS,
-            .clock_speed_hz = 1 * 100 * 1000, // 100 kHz
-            .queue_size = 3,
-        };
 
-        // Attach the SD card to the SPI bus
-        return spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi);
+        ESP_LOGI(TAG, "Card init success - negotiating bus speed.");
+
+        return sd_negotiate_clock();
     }
 
     return err;
 }
 
+esp_err_t sd_enable_crc(void)
+{
+    esp_err_t err = sd_send_command(CMD_59_ID, CMD_59_BODY_CRC_ON);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint8_t r1 = 0xFF;
+    err = sd_read_bytes(&r1, 1);
+
+    if (err != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGW(TAG, "Card refused CRC mode: %d", r1);
+        return ESP_FAIL;
+    }
+
+    crc_enabled = true;
+
+    ESP_LOGI(TAG, "CRC mode on.");
+
+    return ESP_OK;
+}
+
+esp_err_t sd_read_csd(void)
+{
+    esp_err_t err = sd_send_command(CMD_9_ID, CMD_9_BODY);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint8_t r1 = 0xFF;
+    err = sd_read_bytes(&r1, 1);
+
+    if (err != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGW(TAG, "Bad response to CSD command (9): %d", r1);
+        return ESP_FAIL;
+    }
+
+    // CSD comes as a regular data packet, only shorter
+    uint8_t csd[CSD_LENGTH];
+    err = sd_read_data_packet(csd, CSD_LENGTH);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // CSD_STRUCTURE in the top 2 bits tells the layout
+    if ((csd[0] >> 6) == 1)
+    {
+        // Version 2 (SDHC/SDXC): capacity = (C_SIZE + 1) * 512 KB
+        uint32_t c_size = ((csd[7] & 0x3F) << 16) | (csd[8] << 8) | csd[9];
+        sector_count = (c_size + 1) * 1024;
+    }
+    else
+    {
+        // Version 1 (SDSC): capacity = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+        uint32_t read_bl_len = csd[5] & 0x0F;
+        uint32_t c_size = ((csd[6] & 0x03) << 10) | (csd[7] << 2) | (csd[8] >> 6);
+        uint32_t c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        uint64_t bytes = ((uint64_t)(c_size + 1) << (c_size_mult + 2)) << read_bl_len;
+        sector_count = bytes / SD_BLOCK_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Card has %d sectors", (unsigned int)sector_count);
+
+    return ESP_OK;
+}
+
+uint32_t sd_get_sector_count(void)
+{
+    return sector_count;
+}
+
+// The card as an SPI device, the same on every clock but for the clock itself
+static spi_device_interface_config_t sd_device_config(uint32_t clock_hz)
+{
+    spi_device_interface_config_t dev_cfg = {
+        .mode = 0, // SPI mode 0
+        .spics_io_num = SD_CS,
+        .clock_speed_hz = clock_hz,
+        .queue_size = 3,
+        .cs_ena_posttrans = 8,
+        .cs_ena_pretrans = 8
+    };
+
+    return dev_cfg;
+}
+
+// Reattach the device with a new clock, no transactions may be in flight
+static esp_err_t sd_set_clock(uint32_t clock_hz)
+{
+    spi_bus_remove_device(spi);
+
+    spi_device_interface_config_t dev_cfg = sd_device_config(clock_hz);
+
+    // Attach the SD card to the SPI bus
+    return spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi);
+}
+
+// FNV-1a, enough to tell if a block came back the same
+static uint32_t sd_block_hash(const uint8_t *block)
+{
+    return utils_hash_fnv1a(UTILS_FNV1A_INIT, block, SD_BLOCK_SIZE);
+}
+
+// Read the verify blocks a few times & check they match what we got on the init clock
+static bool sd_verify_clock(void)
+{
+    uint8_t block[SD_BLOCK_SIZE];
+
+    for (uint32_t pass = 0; pass < SD_CLOCK_VERIFY_PASSES; pass++)
+    {
+        for (uint32_t i = 0; i < SD_CLOCK_VERIFY_BLOCKS; i++)
+        {
+            if (sd_read_block_once(i, block) != ESP_OK || sd_block_hash(block) != verify_hashes[i])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+esp_err_t sd_negotiate_clock(void)
+{
+    uint8_t block[SD_BLOCK_SIZE];
+
+    // Take reference reads on the init clock, nothing should go wrong this slow
+    for (uint32_t i = 0; i < SD_CLOCK_VERIFY_BLOCKS; i++)
+    {
+        esp_err_t err = sd_read_block_once(i, block);
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to read verify block %d on init clock", (unsigned int)i);
+            return err;
+        }
+
+        verify_hashes[i] = sd_block_hash(block);
+    }
+
+    int32_t best_step = -1;
+
+    for (int32_t step = 0; step < (int32_t)SD_CLOCK_LADDER_LENGTH; step++)
+    {
+        esp_err_t err = sd_set_clock(sd_clock_ladder[step]);
+
+        if (err != ESP_OK || !sd_verify_clock())
+        {
+            ESP_LOGW(TAG, "%d Hz is not stable", (unsigned int)sd_clock_ladder[step]);
+            break;
+        }
+
+        best_step = step;
+    }
+
+    // Settle on the last clock that passed, or fall back to the init clock
+    uint32_t clock_hz = best_step < 0 ? SD_INIT_CLOCK_HZ : sd_clock_ladder[best_step];
+    esp_err_t err = sd_set_clock(clock_hz);
+
+    if (err != ESP_OK || !sd_verify_clock())
+    {
+        ESP_LOGE(TAG, "Card unreadable on %d Hz", (unsigned int)clock_hz);
+        return ESP_FAIL;
+    }
+
+    clock_step = best_step;
+    window_reads = 0;
+    window_errors = 0;
+
+    ESP_LOGI(TAG, "Bus clock set to %d Hz", (unsigned int)clock_hz);
+
+    return ESP_OK;
+}
+
+uint32_t sd_get_clock_hz(void)
+{
+    return clock_step < 0 ? SD_INIT_CLOCK_HZ : sd_clock_ladder[clock_step];
+}
+
 esp_err_t sd_spi_init()
 {
+    sd_crc_init();
+
     gpio_pullup_en(SD_MOSI);
     gpio_pullup_en(SD_MISO);
     gpio_pullup_en(SD_SCK);
@@ -363,21 +711,17 @@ esp_err_t sd_spi_init()
         .sclk_io_num = SD_SCK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 64,
+        .max_transfer_sz = SD_DMA_BUFFER_SIZE,
+        .isr_cpu_id = SD_SPI_ISR_CPU,
     };
 
+    memset(dma_tx_dummy, 0xFF, sizeof(dma_tx_dummy));
+
     // Initialize the SPI bus
     ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO));
 
     // SPI device configuration
-    spi_device_interface_config_t dev_cfg = {
-        .mode = 0, // SPI mode 0
-        .spics_io_num = SD_CS,
-        .clock_speed_hz = 100000, // Initialize at low clock speed (100 kHz)
-        .queue_size = 3,
-        .cs_ena_posttrans = 8,
-        .cs_ena_pretrans = 8
-    };
+    spi_device_interface_config_t dev_cfg = sd_device_config(SD_INIT_CLOCK_HZ);
 
     // Attach the SD card to the SPI bus
     ESP_ERROR_CHECK(spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi));
@@ -385,48 +729,811 @@ esp_err_t sd_spi_init()
     return ESP_OK;
 }
 
-esp_err_t sd_read_block(uint32_t block_address, uint8_t *destination)
+/**
+ * Count a finished read, when errors pile up within a window of reads drop down a step on the clock ladder.
+ * Returns the status it was given so calls can be wrapped.
+ */
+static esp_err_t sd_track_read(esp_err_t status)
 {
-    // Convert block address into byte address
-    esp_err_t op_status = sd_send_command(CMD_17_ID, block_address << 9);
+    window_reads++;
 
-    if (op_status != ESP_OK)
+    if (status != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to send read command (17)");
-        return ESP_FAIL;
+        window_errors++;
     }
 
-    uint8_t buffer;
-    op_status = sd_read_bytes(&buffer, 1);
-
-    if (op_status != ESP_OK)
+    if (window_errors >= SD_CLOCK_ERROR_THRESHOLD)
     {
-        ESP_LOGE(TAG, "No response from slave (17)");
-        return ESP_FAIL;
-    }
+        window_reads = 0;
+        window_errors = 0;
 
-    if (buffer == 0x00)
-    {
-        uint8_t temp_dest[read_block_size + READ_EXTRA_LENGTH];
+        // Already as slow as it gets
+        if (clock_step < 0)
+        {
+            return status;
+        }
+
+        clock_step--;
 
-        // We will have a start block + CRC
-        op_status = sd_read_bytes(temp_dest, read_block_size + READ_EXTRA_LENGTH);
+        uint32_t clock_hz = sd_get_clock_hz();
 
-        if (temp_dest[0] != READ_START_TOKEN)
+        ESP_LOGW(TAG, "Too many read errors, dropping bus clock to %d Hz", (unsigned int)clock_hz);
+
+        if (stream_active)
         {
-            ESP_LOGE(TAG, "Read error: %d", temp_dest[0]);
-            return ESP_FAIL;
+            stream_clock_pending = true;
         }
         else
         {
-            // Don't return start token & CRC from the read operation
-            memcpy(destination, &temp_dest[1], sizeof(uint8_t) * read_block_size);
+            sd_set_clock(clock_hz);
         }
+    }
+    else if (window_reads >= SD_CLOCK_ERROR_WINDOW)
+    {
+        window_reads = 0;
+        window_errors = 0;
+    }
 
-        ESP_LOGI(TAG, "Read block %d", (unsigned int)block_address);
+    return status;
+}
 
-        return op_status;
+// Compare a received block against the CRC16 the card sent along (big endian)
+static esp_err_t sd_check_data_crc(const uint8_t *block, uint32_t length, const uint8_t *crc)
+{
+    if (!crc_enabled)
+    {
+        return ESP_OK;
+    }
+
+    uint16_t expected = (crc[0] << 8) | crc[1];
+
+    if (sd_crc16(block, length) != expected)
+    {
+        ESP_LOGW(TAG, "Data CRC mismatch");
+        return ESP_ERR_INVALID_CRC;
     }
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * Read a single data packet: wait for the start token, then `length` bytes of data & the CRC.
+ * The data goes straight into the destination, the token & CRC are dropped.
+ */
+static esp_err_t sd_read_data_packet(uint8_t *destination, uint32_t length)
+{
+    uint8_t token;
+    esp_err_t op_status = sd_read_bytes(&token, 1);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    if (token != READ_START_TOKEN)
+    {
+        ESP_LOGE(TAG, "Read error: %d", token);
+        return ESP_FAIL;
+    }
+
+    op_status = sd_read_raw(destination, length);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    // Read separately, keeps the block transfer word sized so the driver does not bounce it
+    uint8_t crc[READ_EXTRA_LENGTH - 1];
+    op_status = sd_read_raw(crc, sizeof(crc));
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    return sd_check_data_crc(destination, length, crc);
+}
+
+// Data commands address SDHC/SDXC cards by block & SDSC ones by byte, those never get past 4 GB anyway
+static uint32_t sd_data_address(uint32_t block)
+{
+    return block_addressing ? block : block << 9;
+}
+
+static esp_err_t sd_read_block_once(uint32_t block_address, uint8_t *destination)
+{
+    esp_err_t op_status = sd_send_command(CMD_17_ID, sd_data_address(block_address));
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send read command (17)");
+        return ESP_FAIL;
+    }
+
+    uint8_t buffer;
+    op_status = sd_read_bytes(&buffer, 1);
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "No response from slave (17)");
+        return ESP_FAIL;
+    }
+
+    if (buffer != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to read command (17): %d", buffer);
+        return ESP_FAIL;
+    }
+
+    op_status = sd_read_data_packet(destination, SD_BLOCK_SIZE);
+
+    ESP_LOGD(TAG, "Read block %d", (unsigned int)block_address);
+
+    return op_status;
+}
+
+esp_err_t sd_read_block(uint32_t block_address, uint8_t *destination)
+{
+    esp_err_t op_status = ESP_FAIL;
+
+    // Corrupted data is worth another go, anything else is not
+    for (uint32_t attempt = 0; attempt < SD_CRC_RETRIES; attempt++)
+    {
+        op_status = sd_track_read(sd_read_block_once(block_address, destination));
+
+        if (op_status != ESP_ERR_INVALID_CRC)
+        {
+            break;
+        }
+    }
+
+    return op_status;
+}
+
+// Ends a CMD18 stream, the card answers with R1b & may keep MISO low while busy
+static esp_err_t sd_stop_transmission(void)
+{
+    esp_err_t op_status = sd_send_command(CMD_12_ID, CMD_12_BODY);
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send stop command (12)");
+        return ESP_FAIL;
+    }
+
+    // The byte right after CMD12 is a stuff byte, it has to be thrown away
+    uint8_t stuff;
+    sd_read_byte(&stuff);
+
+    uint8_t r1 = 0xFF;
+    op_status = sd_read_bytes(&r1, 1);
+
+    if (op_status != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to stop command (12): %d", r1);
+        return ESP_FAIL;
+    }
+
+    // Wait for the card to release the busy signal
+    for (uint32_t i = 0; i < SD_BUSY_RETRIES; i++)
+    {
+        uint8_t busy = 0x00;
+        sd_read_byte(&busy);
+
+        if (busy != 0x00)
+        {
+            return ESP_OK;
+        }
+    }
+
+    ESP_LOGE(TAG, "Card stayed busy after stop command (12)");
+    return ESP_FAIL;
+}
+
+// `blocks_read` tells how many blocks made it intact, so a failed stream can be resumed
+static esp_err_t sd_read_blocks_once(uint32_t start_block, uint32_t count, uint8_t *destination, uint32_t *blocks_read)
+{
+    *blocks_read = 0;
+
+    if (count == 0)
+    {
+        return ESP_OK;
+    }
+
+    // Not worth the extra CMD12 for a single block
+    if (count == 1)
+    {
+        esp_err_t op_status = sd_read_block_once(start_block, destination);
+        *blocks_read = op_status == ESP_OK ? 1 : 0;
+        return op_status;
+    }
+
+    esp_err_t op_status = sd_send_command(CMD_18_ID, sd_data_address(start_block));
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send read command (18)");
+        return ESP_FAIL;
+    }
+
+    uint8_t r1 = 0xFF;
+    op_status = sd_read_bytes(&r1, 1);
+
+    if (op_status != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to read command (18): %d", r1);
+        return ESP_FAIL;
+    }
+
+    // Card streams one data packet per block until told to stop
+    for (uint32_t i = 0; i < count; i++)
+    {
+        op_status = sd_read_data_packet(&destination[i * SD_BLOCK_SIZE], SD_BLOCK_SIZE);
+
+        if (op_status != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to read block %d of %d", (unsigned int)(start_block + i), (unsigned int)count);
+            // Still have to stop the stream, otherwise the card keeps sending
+            sd_stop_transmission();
+            return op_status;
+        }
+
+        *blocks_read = i + 1;
+    }
+
+    op_status = sd_stop_transmission();
+
+    ESP_LOGD(TAG, "Read blocks %d-%d", (unsigned int)start_block, (unsigned int)(start_block + count - 1));
+
+    return op_status;
+}
+
+esp_err_t sd_read_blocks(uint32_t start_block, uint32_t count, uint8_t *destination)
+{
+    esp_err_t op_status = ESP_FAIL;
+    uint32_t done = 0;
+
+    // On a CRC mismatch pick the stream up again from the corrupted block,
+    // only failing the same block over & over counts towards the retries
+    uint32_t failures = 0;
+
+    while (failures < SD_CRC_RETRIES)
+    {
+        uint32_t blocks_read = 0;
+
+        op_status = sd_track_read(sd_read_blocks_once(start_block + done, count - done,
+                                                      &destination[done * SD_BLOCK_SIZE], &blocks_read));
+        done += blocks_read;
+
+        if (op_status != ESP_ERR_INVALID_CRC)
+        {
+            break;
+        }
+
+        failures = blocks_read > 0 ? 1 : failures + 1;
+    }
+
+    return op_status;
+}
+
+// Wait for the card to let go of MISO after a write, programming a block takes a while
+static esp_err_t sd_wait_write_done(void)
+{
+    int64_t deadline = esp_timer_get_time() + SD_WRITE_TIMEOUT_US;
+
+    do
+    {
+        uint8_t busy = 0x00;
+        sd_read_byte(&busy);
+
+        if (busy != 0x00)
+        {
+            return ESP_OK;
+        }
+    } while (esp_timer_get_time() < deadline);
+
+    ESP_LOGE(TAG, "Card stayed busy after write");
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * Send a single data packet: gap byte & token, the block, its CRC16. Then check the data response.
+ * Does not wait for the card to finish programming.
+ */
+static esp_err_t sd_write_data_packet(uint8_t token, const uint8_t *source)
+{
+    spi_transaction_t start = {
+        .flags = SPI_TRANS_USE_TXDATA,
+        .length = 2 * 8,
+        .tx_data = {0xFF, token},
+    };
+
+    esp_err_t op_status = spi_device_polling_transmit(spi, &start);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    // Same deal as reads, DMA straight from the source when it allows it
+    bool is_direct = esp_ptr_dma_capable(source) && ((uintptr_t)source % 4) == 0;
+
+    if (!is_direct)
+    {
+        memcpy(dma_tx_buffer, source, SD_BLOCK_SIZE);
+    }
+
+    spi_transaction_t payload = {
+        .length = SD_BLOCK_SIZE * 8,
+        .tx_buffer = is_direct ? source : dma_tx_buffer,
+    };
+
+    op_status = spi_device_transmit(spi, &payload);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    // The card ignores the CRC unless CRC mode is on, send a real one anyway
+    uint16_t crc = sd_crc16(source, SD_BLOCK_SIZE);
+
+    // CRC & the data response that follows right after it
+    spi_transaction_t tail = {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = 3 * 8,
+        .tx_data = {crc >> 8, crc & 0xFF, 0xFF},
+    };
+
+    op_status = spi_device_polling_transmit(spi, &tail);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    uint8_t response = tail.rx_data[2];
+
+    if (response == 0xFF)
+    {
+        sd_read_bytes(&response, 1);
+    }
+
+    switch (response & WRITE_RESPONSE_MASK)
+    {
+    case WRITE_RESPONSE_ACCEPTED:
+        return ESP_OK;
+    case WRITE_RESPONSE_CRC_ERROR:
+        ESP_LOGW(TAG, "Card rejected block CRC");
+        return ESP_ERR_INVALID_CRC;
+    default:
+        ESP_LOGE(TAG, "Write error: %d", response);
+        return ESP_FAIL;
+    }
+}
+
+static esp_err_t sd_write_block_once(uint32_t block_address, const uint8_t *source)
+{
+    esp_err_t op_status = sd_send_command(CMD_24_ID, sd_data_address(block_address));
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send write command (24)");
+        return ESP_FAIL;
+    }
+
+    uint8_t r1 = 0xFF;
+    op_status = sd_read_bytes(&r1, 1);
+
+    if (op_status != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to write command (24): %d", r1);
+        return ESP_FAIL;
+    }
+
+    op_status = sd_write_data_packet(WRITE_START_TOKEN, source);
+
+    // Card is busy programming even when it refused the block
+    esp_err_t busy_status = sd_wait_write_done();
+
+    ESP_LOGD(TAG, "Wrote block %d", (unsigned int)block_address);
+
+    return op_status != ESP_OK ? op_status : busy_status;
+}
+
+esp_err_t sd_write_block(uint32_t block_address, const uint8_t *source)
+{
+    esp_err_t op_status = ESP_FAIL;
+
+    for (uint32_t attempt = 0; attempt < SD_CRC_RETRIES; attempt++)
+    {
+        op_status = sd_write_block_once(block_address, source);
+
+        if (op_status != ESP_ERR_INVALID_CRC)
+        {
+            break;
+        }
+    }
+
+    return op_status;
+}
+
+// Ends a CMD25 stream, the card goes busy one byte after the stop token
+static esp_err_t sd_stop_write_transmission(void)
+{
+    spi_transaction_t stop = {
+        .flags = SPI_TRANS_USE_TXDATA,
+        .length = 2 * 8,
+        .tx_data = {WRITE_MULTI_STOP_TOKEN, 0xFF},
+    };
+
+    esp_err_t op_status = spi_device_polling_transmit(spi, &stop);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    return sd_wait_write_done();
+}
+
+// `blocks_written` tells how many blocks the card accepted, so a failed stream can be resumed
+static esp_err_t sd_write_blocks_once(uint32_t start_block, uint32_t count, const uint8_t *source, uint32_t *blocks_written)
+{
+    *blocks_written = 0;
+
+    if (count == 0)
+    {
+        return ESP_OK;
+    }
+
+    if (count == 1)
+    {
+        esp_err_t op_status = sd_write_block_once(start_block, source);
+        *blocks_written = op_status == ESP_OK ? 1 : 0;
+        return op_status;
+    }
+
+    esp_err_t op_status = sd_send_command(CMD_25_ID, sd_data_address(start_block));
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send write command (25)");
+        return ESP_FAIL;
+    }
+
+    uint8_t r1 = 0xFF;
+    op_status = sd_read_bytes(&r1, 1);
+
+    if (op_status != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to write command (25): %d", r1);
+        return ESP_FAIL;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        op_status = sd_write_data_packet(WRITE_MULTI_START_TOKEN, &source[i * SD_BLOCK_SIZE]);
+
+        if (op_status == ESP_OK)
+        {
+            op_status = sd_wait_write_done();
+        }
+
+        if (op_status != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to write block %d of %d", (unsigned int)(start_block + i), (unsigned int)count);
+            sd_stop_write_transmission();
+            return op_status;
+        }
+
+        *blocks_written = i + 1;
+    }
+
+    op_status = sd_stop_write_transmission();
+
+    ESP_LOGD(TAG, "Wrote blocks %d-%d", (unsigned int)start_block, (unsigned int)(start_block + count - 1));
+
+    return op_status;
+}
+
+esp_err_t sd_write_blocks(uint32_t start_block, uint32_t count, const uint8_t *source)
+{
+    esp_err_t op_status = ESP_FAIL;
+    uint32_t done = 0;
+
+    // Same policy as reads: resume from the rejected block, give up when it keeps failing
+    uint32_t failures = 0;
+
+    while (failures < SD_CRC_RETRIES)
+    {
+        uint32_t blocks_written = 0;
+
+        op_status = sd_write_blocks_once(start_block + done, count - done,
+                                         &source[done * SD_BLOCK_SIZE], &blocks_written);
+        done += blocks_written;
+
+        if (op_status != ESP_ERR_INVALID_CRC)
+        {
+            break;
+        }
+
+        failures = blocks_written > 0 ? 1 : failures + 1;
+    }
+
+    return op_status;
+}
+
+esp_err_t sd_stream_start(uint32_t start_block)
+{
+    if (stream_active)
+    {
+        ESP_LOGE(TAG, "Stream already active");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Block device users wait until the stream stops, their commands would land in the middle of it
+    xSemaphoreTake(blockdev_lock, portMAX_DELAY);
+
+    esp_err_t op_status = sd_send_command(CMD_18_ID, sd_data_address(start_block));
+
+    if (op_status != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send read command (18)");
+        xSemaphoreGive(blockdev_lock);
+        return ESP_FAIL;
+    }
+
+    uint8_t r1 = 0xFF;
+    op_status = sd_read_bytes(&r1, 1);
+
+    if (op_status != ESP_OK || r1 != 0x00)
+    {
+        ESP_LOGE(TAG, "Bad response to read command (18): %d", r1);
+        xSemaphoreGive(blockdev_lock);
+        return ESP_FAIL;
+    }
+
+    stream_active = true;
+
+    return ESP_OK;
+}
+
+esp_err_t sd_stream_submit(uint8_t *destination)
+{
+    // Token polling needs the bus, the previous block must be collected first
+    if (!stream_active || stream_pending)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t token;
+    esp_err_t op_status = sd_read_bytes(&token, 1);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    if (token != READ_START_TOKEN)
+    {
+        ESP_LOGE(TAG, "Read error: %d", token);
+        return sd_track_read(ESP_FAIL);
+    }
+
+    // Block goes straight into the destination, CRC rides along in the transaction itself
+    stream_payload = (spi_transaction_t){
+        .length = SD_BLOCK_SIZE * 8,
+        .tx_buffer = dma_tx_dummy,
+        .rx_buffer = destination,
+    };
+
+    stream_crc = (spi_transaction_t){
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = (READ_EXTRA_LENGTH - 1) * 8,
+        .tx_data = {0xFF, 0xFF},
+    };
+
+    op_status = spi_device_queue_trans(spi, &stream_payload, portMAX_DELAY);
+
+    if (op_status != ESP_OK)
+    {
+        return op_status;
+    }
+
+    op_status = spi_device_queue_trans(spi, &stream_crc, portMAX_DELAY);
+
+    if (op_status != ESP_OK)
+    {
+        // The payload is already on the bus, it still has to be collected
+        spi_transaction_t *done;
+        spi_device_get_trans_result(spi, &done, portMAX_DELAY);
+        return op_status;
+    }
+
+    stream_destination = destination;
+    stream_pending = true;
+
+    return ESP_OK;
+}
+
+esp_err_t sd_stream_wait(uint8_t **destination, TickType_t ticks_to_wait)
+{
+    if (!stream_pending)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Transactions complete in order, the CRC is always the last one
+    spi_transaction_t *done = NULL;
+
+    while (done != &stream_crc)
+    {
+        esp_err_t op_status = spi_device_get_trans_result(spi, &done, ticks_to_wait);
+
+        if (op_status != ESP_OK)
+        {
+            // Timed out, the transfer is still pending & can be waited on again
+            return op_status;
+        }
+    }
+
+    stream_pending = false;
+
+    if (destination != NULL)
+    {
+        *destination = stream_destination;
+    }
+
+    return sd_track_read(sd_check_data_crc(stream_destination, SD_BLOCK_SIZE, stream_crc.rx_data));
+}
+
+esp_err_t sd_stream_stop(void)
+{
+    if (!stream_active)
+    {
+        return ESP_OK;
+    }
+
+    // Can't talk to the card while our transfers are still queued
+    if (stream_pending)
+    {
+        sd_stream_wait(NULL, portMAX_DELAY);
+    }
+
+    stream_active = false;
+
+    esp_err_t op_status = sd_stop_transmission();
+
+    if (stream_clock_pending)
+    {
+        stream_clock_pending = false;
+        sd_set_clock(sd_get_clock_hz());
+    }
+
+    xSemaphoreGive(blockdev_lock);
+
+    return op_status;
+}
+
+// Time `count` blocks read with the supplied read mode, returns KB/s
+static uint32_t sd_benchmark_run(uint32_t start_block, uint32_t count, uint8_t *buffer, bool bulk)
+{
+    bulk_reads_enabled = bulk;
+
+    int64_t start = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (sd_read_block(start_block + i, buffer) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Benchmark read failed");
+            break;
+        }
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    bulk_reads_enabled = true;
+
+    if (elapsed <= 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)(((int64_t)count * SD_BLOCK_SIZE * 1000000 / elapsed) / 1024);
+}
+
+void sd_benchmark(uint32_t start_block, uint32_t count)
+{
+    uint8_t buffer[SD_BLOCK_SIZE];
+
+    uint32_t bytewise = sd_benchmark_run(start_block, count, buffer, false);
+    uint32_t bulk = sd_benchmark_run(start_block, count, buffer, true);
+
+    ESP_LOGI(TAG, "Read %d blocks - byte per transaction: %d KB/s, bulk DMA: %d KB/s",
+             (unsigned int)count, (unsigned int)bytewise, (unsigned int)bulk);
+
+    // CRC16 kernel on its own, a megabyte worth of blocks
+    uint32_t crc_blocks = (1024 * 1024) / SD_BLOCK_SIZE;
+    volatile uint16_t crc = 0;
+
+    int64_t start = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < crc_blocks; i++)
+    {
+        crc ^= sd_crc16(buffer, SD_BLOCK_SIZE);
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "CRC16: %d us per MB", (unsigned int)elapsed);
+}
+
+///////// Block Device /////////
+
+static esp_err_t sd_blockdev_read(void *context, uint32_t sector, uint8_t *destination)
+{
+    xSemaphoreTake(blockdev_lock, portMAX_DELAY);
+    esp_err_t err = sd_read_block(sector, destination);
+    xSemaphoreGive(blockdev_lock);
+
+    return err;
+}
+
+static esp_err_t sd_blockdev_read_many(void *context, uint32_t sector, uint32_t count, uint8_t *destination)
+{
+    xSemaphoreTake(blockdev_lock, portMAX_DELAY);
+    esp_err_t err = sd_read_blocks(sector, count, destination);
+    xSemaphoreGive(blockdev_lock);
+
+    return err;
+}
+
+static esp_err_t sd_blockdev_write(void *context, uint32_t sector, const uint8_t *source)
+{
+    xSemaphoreTake(blockdev_lock, portMAX_DELAY);
+    esp_err_t err = sd_write_block(sector, source);
+    xSemaphoreGive(blockdev_lock);
+
+    return err;
+}
+
+static esp_err_t sd_blockdev_write_many(void *context, uint32_t sector, uint32_t count, const uint8_t *source)
+{
+    xSemaphoreTake(blockdev_lock, portMAX_DELAY);
+    esp_err_t err = sd_write_blocks(sector, count, source);
+    xSemaphoreGive(blockdev_lock);
+
+    return err;
+}
+
+static uint32_t sd_blockdev_sector_size(void *context)
+{
+    return SD_BLOCK_SIZE;
+}
+
+static uint32_t sd_blockdev_sector_count(void *context)
+{
+    return sector_count;
+}
+
+static const Block_Device_Ops sd_blockdev_ops = {
+    .read = sd_blockdev_read,
+    .read_many = sd_blockdev_read_many,
+    .write = sd_blockdev_write,
+    .write_many = sd_blockdev_write_many,
+    .sector_size = sd_blockdev_sector_size,
+    .sector_count = sd_blockdev_sector_count,
+};
+
+static const Block_Device sd_blockdev = {
+    .ops = &sd_blockdev_ops,
+    .context = NULL,
+};
+
+const Block_Device *sd_get_block_device(void)
+{
+    return &sd_blockdev;
+}
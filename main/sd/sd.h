@@ -5,9 +5,11 @@
 #include "driver/gpio.h"
 #include <string.h>
 #include "utils.h"
+#include "blockdev/blockdev.h"
+#include "task_layout.h"
 
-#define SDHC_SDXC_BLOCK_SIZE 512
-#define SDSC_BLOCK_SIZE 256
+// Data block size on every card, standard capacity ones are set to it with CMD16
+#define SD_BLOCK_SIZE 512
 
 #define READ_START_TOKEN 0xFE
 #define READ_TOKEN_OK 0xFE
@@ -15,6 +17,45 @@
 
 #define READ_EXTRA_LENGTH 3 // When reading we always get 3 extra bytes: start token + CRC
 
+#define WRITE_START_TOKEN 0xFE       // CMD24, single block
+#define WRITE_MULTI_START_TOKEN 0xFC // CMD25, every block of the stream
+#define WRITE_MULTI_STOP_TOKEN 0xFD  // Ends a CMD25 stream
+
+// Data response after every written block: xxx0sss1, sss = 010 accepted, 101 CRC error, 110 write error
+#define WRITE_RESPONSE_MASK 0x1F
+#define WRITE_RESPONSE_ACCEPTED 0x05
+#define WRITE_RESPONSE_CRC_ERROR 0x0B
+
+// SDHC/SDXC cards send a read's data token within 100 ms, SDSC ones usually far sooner
+#define SD_READ_TIMEOUT_US 100000
+
+// Cards may hold MISO low for up to 250 ms while programming, give them some slack
+#define SD_WRITE_TIMEOUT_US 500000
+
+// Clock negotiation: blocks from 0 up read back & compared on every ladder step
+#define SD_CLOCK_VERIFY_BLOCKS 4
+#define SD_CLOCK_VERIFY_PASSES 2
+
+// Clock is dropped a step when this many reads fail within a window of reads
+#define SD_CLOCK_ERROR_THRESHOLD 4
+#define SD_CLOCK_ERROR_WINDOW 256
+
+// SPI interrupt on the I/O core, with the tasks waiting on the card. Anywhere when the cores aren't split
+#if TASK_LAYOUT_IS_SPLIT
+#define SD_SPI_ISR_CPU ESP_INTR_CPU_AFFINITY_0
+#else
+#define SD_SPI_ISR_CPU ESP_INTR_CPU_AFFINITY_AUTO
+#endif
+
+// Turn on CMD59 CRC mode after init: commands & data blocks get checked on both ends
+#define SD_CRC_MODE 1
+
+// How many times a block with a bad CRC is read again before giving up
+#define SD_CRC_RETRIES 3
+
+// Largest single SPI transaction, bulk reads are chunked to this
+#define SD_DMA_BUFFER_SIZE SD_BLOCK_SIZE
+
 typedef struct
 {
     volatile uint16_t reserved : 15;
@@ -41,6 +82,30 @@ esp_err_t sd_init();
 
 esp_err_t sd_init_card(void);
 
+/**
+ * Send CMD59 to turn CRC checking on. From then on received blocks are checked against their CRC16,
+ * a mismatch comes back as ESP_ERR_INVALID_CRC & is retried by the synchronous reads.
+ */
+esp_err_t sd_enable_crc(void);
+
+/**
+ * Read the CSD register (CMD9) & work out the card capacity from it.
+ */
+esp_err_t sd_read_csd(void);
+
+// Card capacity in 512 byte sectors, 0 if the CSD could not be read
+uint32_t sd_get_sector_count(void);
+
+/**
+ * Step the bus clock up from 400 kHz to 26 MHz, verifying a few known blocks on every step.
+ * Settles on the highest clock that read them back intact.
+ * Reads keep counting errors afterwards & drop down a step when they pile up.
+ */
+esp_err_t sd_negotiate_clock(void);
+
+// The bus clock currently in use
+uint32_t sd_get_clock_hz(void);
+
 ///////// SD Communication /////////
 
 // Sends an SD SPI commabdm the whole 48 bits
@@ -55,8 +120,8 @@ esp_err_t sd_read_byte(uint8_t *response);
 
 /**
  * Tries to read X bytes into the supplied buffer.
- * Will retry for a valid byte.
- * Returns status of operation.
+ * Polls for the first byte that isn't 0xFF for up to `SD_READ_TIMEOUT_US`, the rest follow as they come.
+ * Returns status of operation, ESP_ERR_TIMEOUT when the card never answered.
  */
 esp_err_t sd_read_bytes(uint8_t *target, uint32_t count);
 
@@ -94,4 +159,83 @@ bool sd_ready_card();
 
 esp_err_t sd_read_block(uint32_t block_address, uint8_t *destination);
 
+/**
+ * Read `count` contiguous blocks starting at `start_block` with a single CMD18,
+ * the stream is ended with CMD12. Destination must fit `count` whole blocks.
+ * Costs two commands no matter the count, compared to one per block with `sd_read_block`.
+ */
+esp_err_t sd_read_blocks(uint32_t start_block, uint32_t count, uint8_t *destination);
+
+/**
+ * Write a single block with CMD24 & wait for the card to finish programming it.
+ * With CRC mode on a rejected block is sent again, same as reads.
+ */
+esp_err_t sd_write_block(uint32_t block_address, const uint8_t *source);
+
+/**
+ * Write `count` contiguous blocks with a single CMD25, ended with the stop token.
+ * Source must hold `count` whole blocks. Falls back to `sd_write_block` for a single one.
+ */
+esp_err_t sd_write_blocks(uint32_t start_block, uint32_t count, const uint8_t *source);
+
+///////// SD Async Streaming /////////
+
+/**
+ * Asynchronous multi-block reads built on the SPI transaction queue.
+ * The bus shifts block N+1 into its buffer while the caller works on block N:
+ *
+ *   sd_stream_start(block);
+ *   sd_stream_submit(buffers[0]);
+ *   while (playing)
+ *   {
+ *       sd_stream_wait(&done, portMAX_DELAY);
+ *       sd_stream_submit(next_buffer);
+ *       process(done);
+ *   }
+ *   sd_stream_stop();
+ *
+ * Only one block can be in flight at a time & no other SD calls are allowed while it is.
+ * The stream holds the block device from start to stop, its users in other tasks wait for it, so start & stop
+ * must be called from the same task. A clock drop from read errors on the way waits for the stop too.
+ * Buffers are DMA'd into directly, they must be DMA capable & word aligned.
+ */
+
+// Issue CMD18, the card starts streaming from `start_block`
+esp_err_t sd_stream_start(uint32_t start_block);
+
+/**
+ * Wait for the next block's start token, then queue its transfer into the destination & return.
+ * Returns ESP_ERR_INVALID_STATE if a previous block has not been waited for.
+ */
+esp_err_t sd_stream_submit(uint8_t *destination);
+
+/**
+ * Wait for the submitted block to land. Returns ESP_ERR_TIMEOUT if it hasn't in time,
+ * in which case it can be waited on again. ESP_ERR_INVALID_CRC if the block arrived corrupted,
+ * the stream has moved on by then so it is up to the caller to restart it from that block. The filled buffer is handed back through `destination`.
+ */
+esp_err_t sd_stream_wait(uint8_t **destination, TickType_t ticks_to_wait);
+
+// Collect anything still in flight & end the stream with CMD12
+esp_err_t sd_stream_stop(void);
+
+/**
+ * Reads `count` blocks one by one, first with a transaction per byte & then with bulk DMA transfers.
+ * Logs the throughput of both.
+ */
+void sd_benchmark(uint32_t start_block, uint32_t count);
+
+/**
+ * Amount of commands sent to the card since boot.
+ */
+uint32_t sd_get_command_count(void);
+
+///////// Block Device /////////
+
+/**
+ * The card as a block device, for the FAT layer. Only usable after `sd_init`.
+ * Its ops are serialized with a mutex, so it can be shared between tasks.
+ */
+const Block_Device *sd_get_block_device(void);
+
 #endif
\ No newline at end of file
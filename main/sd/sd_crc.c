@@ -0,0 +1,91 @@
+#include "sd_crc.h"
+
+#define CRC7_POLYNOMIAL 0x09
+#define CRC16_POLYNOMIAL 0x1021
+
+// Slice-by-4, table N is the effect of a byte followed by N zero bytes
+#define CRC16_SLICES 4
+
+static uint8_t crc7_table[256];
+static uint16_t crc16_table[CRC16_SLICES][256];
+
+static bool is_initialized = false;
+
+void sd_crc_init(void)
+{
+    if (is_initialized)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        // CRC7 is kept in the top 7 bits of a byte while it is being built
+        uint8_t crc7 = i;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc7 = (crc7 & 0x80) ? (crc7 << 1) ^ (CRC7_POLYNOMIAL << 1) : crc7 << 1;
+        }
+
+        crc7_table[i] = crc7;
+
+        uint16_t crc16 = i << 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc16 = (crc16 & 0x8000) ? (crc16 << 1) ^ CRC16_POLYNOMIAL : crc16 << 1;
+        }
+
+        crc16_table[0][i] = crc16;
+    }
+
+    for (uint32_t slice = 1; slice < CRC16_SLICES; slice++)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint16_t previous = crc16_table[slice - 1][i];
+            crc16_table[slice][i] = (previous << 8) ^ crc16_table[0][previous >> 8];
+        }
+    }
+
+    is_initialized = true;
+}
+
+uint8_t sd_crc7_command(const uint8_t *data, size_t length)
+{
+    uint8_t crc = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = crc7_table[crc ^ data[i]];
+    }
+
+    // CRC sits in the top 7 bits, the end bit is always 1
+    return crc | 0x01;
+}
+
+uint16_t sd_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0;
+    size_t i = 0;
+
+    for (; i + CRC16_SLICES <= length; i += CRC16_SLICES)
+    {
+        uint8_t x0 = (crc >> 8) ^ data[i];
+        uint8_t x1 = (crc & 0xFF) ^ data[i + 1];
+
+        crc = crc16_table[3][x0] ^
+              crc16_table[2][x1] ^
+              crc16_table[1][data[i + 2]] ^
+              crc16_table[0][data[i + 3]];
+    }
+
+    // Leftovers a byte at a time
+    for (; i < length; i++)
+    {
+        crc = (crc << 8) ^ crc16_table[0][(crc >> 8) ^ data[i]];
+    }
+
+    return crc;
+}
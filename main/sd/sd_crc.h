@@ -0,0 +1,29 @@
+#ifndef SD_CRC_H
+#define SD_CRC_H
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "stddef.h"
+
+/**
+ * CRCs used by the SD protocol.
+ * CRC7 (x^7 + x^3 + 1) protects commands, CRC16-CCITT (x^16 + x^12 + x^5 + 1) protects data blocks.
+ * Both are table driven, tables are built once by `sd_crc_init`.
+ */
+
+// Build the lookup tables, must be called before any of the below
+void sd_crc_init(void);
+
+/**
+ * CRC7 of the first 5 bytes of a command, already shifted & with the end bit set,
+ * ready to be sent as the last byte of the command.
+ */
+uint8_t sd_crc7_command(const uint8_t *data, size_t length);
+
+/**
+ * CRC16-CCITT of a data block, initial value 0.
+ * Works on 4 bytes per step using sliced tables.
+ */
+uint16_t sd_crc16(const uint8_t *data, size_t length);
+
+#endif
@@ -0,0 +1,140 @@
+// CRC7/CRC16 of sd_crc.c against a bit by bit reference, then CRC16 throughput: bitwise, one table & sliced.
+//
+//   bench_sd_crc [MB]
+
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "sd/sd_crc.h"
+
+#define BLOCK_SIZE 512
+#define BENCH_BUFFER_SIZE (1024 * 1024)
+
+static uint16_t crc16_table[256];
+
+static uint16_t crc16_bitwise(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+// What sd_crc16 was before slicing, a table lookup per byte
+static uint16_t crc16_bytewise(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(crc >> 8) ^ data[i]]);
+    }
+
+    return crc;
+}
+
+static void test_crc7(void)
+{
+    // Well known command CRCs: CMD0, CMD8 with 0x1AA, CMD17 block 0
+    const uint8_t cmd0[] = {0x40, 0x00, 0x00, 0x00, 0x00};
+    const uint8_t cmd8[] = {0x48, 0x00, 0x00, 0x01, 0xAA};
+    const uint8_t cmd17[] = {0x51, 0x00, 0x00, 0x00, 0x00};
+
+    TEST_CHECK_EQUAL(0x95, sd_crc7_command(cmd0, sizeof(cmd0)));
+    TEST_CHECK_EQUAL(0x87, sd_crc7_command(cmd8, sizeof(cmd8)));
+    TEST_CHECK_EQUAL(0x55, sd_crc7_command(cmd17, sizeof(cmd17)));
+}
+
+// Every length up to a block & a bit, from every alignment, so the sliced loop & its leftovers both get hit
+static void test_crc16(const uint8_t *data)
+{
+    // A block of 0xFF has a well known CRC16 of 0x7FA1
+    uint8_t ones[BLOCK_SIZE];
+
+    for (size_t i = 0; i < sizeof(ones); i++)
+    {
+        ones[i] = 0xFF;
+    }
+
+    TEST_CHECK_EQUAL(0x7FA1, sd_crc16(ones, sizeof(ones)));
+
+    uint32_t mismatches = 0;
+
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        for (size_t length = 0; length <= BLOCK_SIZE + 8; length++)
+        {
+            if (sd_crc16(&data[offset], length) != crc16_bitwise(&data[offset], length))
+            {
+                mismatches++;
+            }
+        }
+    }
+
+    TEST_CHECK_EQUAL(0, mismatches);
+}
+
+// MB/s of a CRC16 over `mb` megabytes, a block at a time as sd.c does it
+static double bench(uint16_t (*crc16)(const uint8_t *, size_t), const uint8_t *data, uint32_t mb, uint16_t *sink)
+{
+    uint64_t start = host_test_now_ns();
+
+    for (uint32_t pass = 0; pass < mb; pass++)
+    {
+        for (size_t i = 0; i < BENCH_BUFFER_SIZE; i += BLOCK_SIZE)
+        {
+            *sink += crc16(&data[i], BLOCK_SIZE);
+        }
+    }
+
+    uint64_t elapsed = host_test_now_ns() - start;
+
+    return elapsed == 0 ? 0 : (double)mb * 1e9 / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t mb = argc > 1 ? (uint32_t)atoi(argv[1]) : 16;
+    uint8_t *data = malloc(BENCH_BUFFER_SIZE);
+    uint32_t state = 1;
+
+    for (size_t i = 0; i < BENCH_BUFFER_SIZE; i++)
+    {
+        state = state * 1103515245 + 12345;
+        data[i] = state >> 16;
+    }
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint8_t byte = i;
+        crc16_table[i] = crc16_bitwise(&byte, 1);
+    }
+
+    sd_crc_init();
+
+    test_crc7();
+    test_crc16(data);
+
+    uint16_t sink = 0;
+
+    // The bitwise reference is slow, a fraction of the data is plenty to time it
+    double bitwise = bench(crc16_bitwise, data, mb / 8 > 0 ? mb / 8 : 1, &sink);
+    double bytewise = bench(crc16_bytewise, data, mb, &sink);
+    double sliced = bench(sd_crc16, data, mb, &sink);
+
+    printf("CRC16 MB/s: bitwise %.0f, table per byte %.0f, slice-by-4 %.0f (%.1fx) [%04x]\n", bitwise, bytewise,
+           sliced, bytewise > 0 ? sliced / bytewise : 0, sink);
+
+    free(data);
+
+    return host_test_result();
+}
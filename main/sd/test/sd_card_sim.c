@@ -0,0 +1,549 @@
+#include "sd_card_sim.h"
+
+#include <string.h>
+#include "driver/spi_master.h"
+
+#include "sd/sd.h"
+
+// Bytes the card has lined up to shift out on MISO: a data block, its token & CRC & a few thousand bytes of latency
+#define SIM_OUTPUT_SIZE 8192
+
+#define R1_IDLE 0x01
+#define R1_ILLEGAL_COMMAND 0x04
+#define R1_CRC_ERROR 0x08
+#define R1_ADDRESS_ERROR 0x20
+#define R1_PARAMETER_ERROR 0x40
+
+// A version 1 card's block length out of reset, as a 2 GB one with READ_BL_LEN 10
+#define SIM_V1_BLOCK_LENGTH 1024
+
+#define OCR_BASE 0x80FF8000 // Powered up, 2.7-3.6 V
+#define OCR_CCS 0x40000000
+
+typedef enum
+{
+    SIM_COMMAND = 0,   // Waiting for the next command
+    SIM_STREAMING,     // CMD18 going, a block follows the last until CMD12
+    SIM_WRITE_TOKEN,   // CMD24/CMD25 accepted, waiting for a start token
+    SIM_WRITE_DATA,    // Taking in a block & its CRC
+} Sim_State;
+
+static SD_Card_Sim *card = NULL;
+
+static Sim_State state = SIM_COMMAND;
+static bool is_idle = true;
+static bool is_app_command = false;
+static bool is_crc_mode = false;
+static uint32_t block_length = SD_BLOCK_SIZE;
+
+static uint8_t command[6];
+static uint32_t command_length = 0;
+
+static uint8_t output[SIM_OUTPUT_SIZE];
+static uint32_t output_head = 0;
+static uint32_t output_count = 0;
+
+static uint32_t stream_block = 0;
+static uint32_t write_block = 0;
+static bool is_multi_write = false;
+static uint8_t write_buffer[SD_BLOCK_SIZE + 2];
+static uint32_t write_length = 0;
+
+// A transaction queued with spi_device_queue_trans, its result is picked up later
+static spi_transaction_t *queued[8];
+static uint32_t queued_head = 0;
+static uint32_t queued_count = 0;
+
+static uint8_t crc7(const uint8_t *data, uint32_t length)
+{
+    uint8_t crc = 0;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            uint8_t in = ((data[i] >> bit) & 1) ^ ((crc >> 6) & 1);
+            crc = (uint8_t)((crc << 1) & 0x7F);
+
+            if (in)
+            {
+                crc ^= 0x09;
+            }
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t crc16(const uint8_t *data, uint32_t length)
+{
+    uint16_t crc = 0;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static void put(uint8_t byte)
+{
+    if (output_count < SIM_OUTPUT_SIZE)
+    {
+        output[(output_head + output_count) % SIM_OUTPUT_SIZE] = byte;
+        output_count++;
+    }
+}
+
+static void put_many(uint8_t byte, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        put(byte);
+    }
+}
+
+// Token, payload & CRC16 of a data packet, after the card's access time
+static void put_data_packet(const uint8_t *data, uint32_t length, bool is_corrupted)
+{
+    uint16_t crc = crc16(data, length);
+
+    put_many(0xFF, card->read_latency);
+    put(READ_START_TOKEN);
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        // The CRC was taken over the good data, like a bit flipped on the wire
+        put(is_corrupted && i == length / 2 ? data[i] ^ 0x10 : data[i]);
+    }
+
+    put(crc >> 8);
+    put(crc & 0xFF);
+}
+
+static void put_block(uint32_t block)
+{
+    card->blocks_read++;
+
+    bool is_corrupted = (card->max_clock_hz != 0 && card->clock_hz > card->max_clock_hz) ||
+                        (card->corrupt_every != 0 && card->blocks_read % card->corrupt_every == 0);
+
+    put_data_packet(&card->image[(size_t)block * SD_BLOCK_SIZE], SD_BLOCK_SIZE, is_corrupted);
+}
+
+static uint32_t reset_block_length(void)
+{
+    return card->is_version_1 ? SIM_V1_BLOCK_LENGTH : SD_BLOCK_SIZE;
+}
+
+// Block a data command's argument points at, false with an address error queued when it's out of range.
+// Only 512 byte blocks are simulated, any other block length is refused with a parameter error
+static bool data_block(uint32_t argument, uint32_t *block)
+{
+    if (block_length != SD_BLOCK_SIZE)
+    {
+        put(R1_PARAMETER_ERROR);
+        return false;
+    }
+
+    if (card->is_high_capacity)
+    {
+        *block = argument;
+    }
+    else
+    {
+        *block = argument / SD_BLOCK_SIZE;
+
+        if (argument % SD_BLOCK_SIZE != 0)
+        {
+            *block = card->sector_count;
+        }
+    }
+
+    if (*block >= card->sector_count)
+    {
+        card->address_errors++;
+        put(R1_ADDRESS_ERROR);
+        return false;
+    }
+
+    return true;
+}
+
+static void put_csd(void)
+{
+    uint8_t csd[16] = {0};
+
+    if (card->is_high_capacity)
+    {
+        // CSD 2.0: (C_SIZE + 1) * 512 KB
+        uint32_t c_size = card->sector_count / 1024 - 1;
+
+        csd[0] = 0x40;
+        csd[7] = (c_size >> 16) & 0x3F;
+        csd[8] = (c_size >> 8) & 0xFF;
+        csd[9] = c_size & 0xFF;
+    }
+    else
+    {
+        // CSD 1.0 with 512 byte blocks & C_SIZE_MULT 7: (C_SIZE + 1) * 512 blocks
+        uint32_t c_size = card->sector_count / 512 - 1;
+
+        csd[5] = 9;
+        csd[6] = (c_size >> 10) & 0x03;
+        csd[7] = (c_size >> 2) & 0xFF;
+        csd[8] = (c_size & 0x03) << 6;
+        csd[9] = 0x03;
+        csd[10] = 0x80;
+    }
+
+    put(0x00);
+    put_data_packet(csd, sizeof(csd), false);
+}
+
+static void handle_command(void)
+{
+    uint8_t index = command[0] & 0x3F;
+    uint32_t argument = (command[1] << 24) | (command[2] << 16) | (command[3] << 8) | command[4];
+    bool is_app = is_app_command;
+    uint32_t block;
+
+    card->commands[index]++;
+    card->command_total++;
+    is_app_command = false;
+
+    // CMD12 cuts a stream short, whatever was still lined up is gone
+    if (index == 12)
+    {
+        output_count = 0;
+        state = SIM_COMMAND;
+
+        put(0xFF); // Stuff byte
+        put(0x00);
+        put_many(0x00, card->busy_bytes);
+        return;
+    }
+
+    output_count = 0;
+    put(0xFF); // NCR, the response comes a byte after the command
+
+    // Without CRC mode only CMD0 & CMD8 are checked
+    bool is_checked = is_crc_mode || index == 0 || index == 8;
+
+    if (is_checked && (crc7(command, 5) << 1 | 1) != command[5])
+    {
+        put(R1_CRC_ERROR | (is_idle ? R1_IDLE : 0));
+        return;
+    }
+
+    uint8_t r1 = is_idle ? R1_IDLE : 0x00;
+
+    switch (is_app ? 0x40 | index : index)
+    {
+    case 0:
+        is_idle = true;
+        block_length = reset_block_length();
+        put(R1_IDLE);
+        break;
+
+    case 8:
+        // Version 1 cards predate CMD8
+        if (card->is_version_1)
+        {
+            put(R1_ILLEGAL_COMMAND | r1);
+            break;
+        }
+
+        put(r1);
+        put(0x00);
+        put(0x00);
+        put((argument >> 8) & 0x0F);
+        put(argument & 0xFF);
+        break;
+
+    case 55:
+        is_app_command = true;
+        put(r1);
+        break;
+
+    case 0x40 | 41:
+        is_idle = false;
+        put(0x00);
+        break;
+
+    case 58:
+    {
+        uint32_t ocr = OCR_BASE | (card->is_high_capacity ? OCR_CCS : 0);
+
+        put(r1);
+        put(ocr >> 24);
+        put((ocr >> 16) & 0xFF);
+        put((ocr >> 8) & 0xFF);
+        put(ocr & 0xFF);
+        break;
+    }
+
+    case 59:
+        is_crc_mode = argument & 1;
+        put(r1);
+        break;
+
+    case 9:
+        put_csd();
+        break;
+
+    case 16:
+        // Only 512 is simulated, anything else sticks but stops data commands
+        block_length = argument;
+        put(argument == SD_BLOCK_SIZE ? r1 : R1_PARAMETER_ERROR | r1);
+        break;
+
+    case 17:
+        if (data_block(argument, &block))
+        {
+            put(0x00);
+            put_block(block);
+        }
+        break;
+
+    case 18:
+        if (data_block(argument, &block))
+        {
+            put(0x00);
+            put_block(block);
+            stream_block = block + 1;
+            state = SIM_STREAMING;
+        }
+        break;
+
+    case 24:
+    case 25:
+        if (data_block(argument, &block))
+        {
+            put(0x00);
+            write_block = block;
+            is_multi_write = index == 25;
+            state = SIM_WRITE_TOKEN;
+        }
+        break;
+
+    default:
+        put(R1_ILLEGAL_COMMAND | r1);
+        break;
+    }
+}
+
+static void take_write_byte(uint8_t mosi)
+{
+    if (state == SIM_WRITE_TOKEN)
+    {
+        if (mosi == WRITE_START_TOKEN || mosi == WRITE_MULTI_START_TOKEN)
+        {
+            state = SIM_WRITE_DATA;
+            write_length = 0;
+        }
+        else if (mosi == WRITE_MULTI_STOP_TOKEN && is_multi_write)
+        {
+            state = SIM_COMMAND;
+            put(0xFF);
+            put_many(0x00, card->busy_bytes);
+        }
+
+        return;
+    }
+
+    write_buffer[write_length++] = mosi;
+
+    if (write_length < sizeof(write_buffer))
+    {
+        return;
+    }
+
+    uint16_t crc = (write_buffer[SD_BLOCK_SIZE] << 8) | write_buffer[SD_BLOCK_SIZE + 1];
+    bool is_in_range = write_block < card->sector_count;
+
+    state = is_multi_write ? SIM_WRITE_TOKEN : SIM_COMMAND;
+
+    if (is_crc_mode && crc16(write_buffer, SD_BLOCK_SIZE) != crc)
+    {
+        put(0xE0 | WRITE_RESPONSE_CRC_ERROR);
+    }
+    else if (!is_in_range)
+    {
+        put(0xE0 | 0x0D); // Write error
+    }
+    else
+    {
+        memcpy(&card->image[(size_t)write_block * SD_BLOCK_SIZE], write_buffer, SD_BLOCK_SIZE);
+        card->blocks_written++;
+        write_block++;
+        put(0xE0 | WRITE_RESPONSE_ACCEPTED);
+    }
+
+    put_many(0x00, card->busy_bytes);
+}
+
+// One byte each way, MOSI in & MISO out
+static uint8_t exchange(uint8_t mosi)
+{
+    if (output_count == 0 && state == SIM_STREAMING)
+    {
+        if (stream_block < card->sector_count)
+        {
+            put_block(stream_block++);
+        }
+        else
+        {
+            put(R1_ADDRESS_ERROR);
+            state = SIM_COMMAND;
+        }
+    }
+
+    uint8_t miso = 0xFF;
+
+    if (output_count > 0)
+    {
+        miso = output[output_head];
+        output_head = (output_head + 1) % SIM_OUTPUT_SIZE;
+        output_count--;
+    }
+
+    if (state == SIM_WRITE_TOKEN || state == SIM_WRITE_DATA)
+    {
+        take_write_byte(mosi);
+    }
+    else if (command_length > 0 || (mosi & 0xC0) == 0x40)
+    {
+        command[command_length++] = mosi;
+
+        if (command_length == sizeof(command))
+        {
+            command_length = 0;
+            handle_command();
+        }
+    }
+
+    return miso;
+}
+
+static esp_err_t transfer(spi_transaction_t *transaction)
+{
+    const uint8_t *tx = (transaction->flags & SPI_TRANS_USE_TXDATA) ? transaction->tx_data : transaction->tx_buffer;
+    uint8_t *rx = (transaction->flags & SPI_TRANS_USE_RXDATA) ? transaction->rx_data : transaction->rx_buffer;
+
+    if (card == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    card->bytes_clocked += transaction->length / 8;
+
+    for (size_t i = 0; i < transaction->length / 8; i++)
+    {
+        uint8_t miso = exchange(tx != NULL ? tx[i] : 0xFF);
+
+        if (rx != NULL)
+        {
+            rx[i] = miso;
+        }
+    }
+
+    return ESP_OK;
+}
+
+void sd_card_sim_insert(SD_Card_Sim *inserted)
+{
+    card = inserted;
+    state = SIM_COMMAND;
+    is_idle = true;
+    is_app_command = false;
+    is_crc_mode = false;
+    block_length = reset_block_length();
+    command_length = 0;
+    output_count = 0;
+    queued_count = 0;
+}
+
+///////// spi_master /////////
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle)
+{
+    if (card != NULL)
+    {
+        card->clock_hz = dev_config->clock_speed_hz;
+        card->cs_setup = dev_config->cs_ena_pretrans;
+        card->cs_hold = dev_config->cs_ena_posttrans;
+    }
+
+    *handle = (spi_device_handle_t)&card;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    return transfer(trans_desc);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    return transfer(trans_desc);
+}
+
+// Done on the spot, only the result waits in the queue
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait)
+{
+    if (queued_count == sizeof(queued) / sizeof(queued[0]))
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t err = transfer(trans_desc);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    queued[(queued_head + queued_count) % 8] = trans_desc;
+    queued_count++;
+
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+                                      TickType_t ticks_to_wait)
+{
+    if (queued_count == 0)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *trans_desc = queued[queued_head];
+    queued_head = (queued_head + 1) % 8;
+    queued_count--;
+
+    return ESP_OK;
+}
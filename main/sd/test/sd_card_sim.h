@@ -0,0 +1,46 @@
+#ifndef SD_CARD_SIM_H
+#define SD_CARD_SIM_H
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * An SD card in SPI mode on the host's SPI bus, byte for byte: commands & their R1/R3/R7 responses, data tokens,
+ * CRC7/CRC16 (checked once CMD59 turned CRC mode on), CMD18 streams ended by CMD12, CMD24/CMD25 writes & busy.
+ * It implements the spi_master calls, so the real sd.c talks to it unchanged. CRCs are computed bit by bit,
+ * independent of sd_crc.c.
+ *
+ * A high capacity card takes block numbers as data addresses, a standard capacity one byte addresses.
+ * Data always moves in 512 byte blocks, a card set to another block length refuses data commands.
+ * An address past the end is answered with an address error & no data, as a real card would.
+ */
+
+typedef struct
+{
+    uint8_t *image;          // sector_count * 512 bytes, read & written in place
+    uint32_t sector_count;   // Multiple of 1024
+    bool is_high_capacity;   // SDHC/SDXC (OCR CCS set), otherwise SDSC
+    bool is_version_1;       // An old SDSC card: no CMD8 & 1024 byte blocks until CMD16 sets 512
+    uint32_t read_latency;   // 0xFF bytes before a read's data token, up to 7000, 1 byte ~ 0.3 us at 26 MHz
+    uint32_t busy_bytes;     // 0x00 bytes a write or CMD12 keeps MISO low for
+    uint32_t max_clock_hz;   // Above this every data block gets a bit flipped on the wire, 0 for no limit
+    uint32_t corrupt_every;  // Flip a bit in every Nth data block read, 0 for never
+
+    // Counted by the card
+    uint32_t commands[64];   // Per command index
+    uint32_t command_total;
+    uint32_t blocks_read;    // Data blocks sent, complete or not
+    uint32_t blocks_written; // Accepted & stored
+    uint32_t address_errors;
+    uint64_t bytes_clocked;  // Both ways at once, so the bus time at clock_hz is bytes_clocked * 8 / clock_hz
+    uint32_t clock_hz;       // Current bus clock
+    uint32_t cs_setup;       // Current CS setup & hold, in bit times, as the device was added with
+    uint32_t cs_hold;
+} SD_Card_Sim;
+
+/**
+ * Put `card` in the slot, powered up & in its idle state. It stays in until another one is inserted.
+ */
+void sd_card_sim_insert(SD_Card_Sim *card);
+
+#endif
@@ -0,0 +1,318 @@
+// sd.c against a simulated card on the SPI bus: both addressing modes, single & multi-block reads & writes,
+// the async stream, CRC retries, plus how many commands a megabyte of reads costs each way.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "host_test.h"
+#include "sd/sd.h"
+#include "sd_card_sim.h"
+
+#define CARD_SECTORS 16384 // 8 MB, plenty to tell block from byte addressing apart
+#define MB_BLOCKS ((1024 * 1024) / SD_BLOCK_SIZE)
+#define READ_CHUNK 16 // Blocks per sd_read_blocks, what the FAT layer asks for on a contiguous run
+
+static uint8_t *make_image(void)
+{
+    uint8_t *image = malloc((size_t)CARD_SECTORS * SD_BLOCK_SIZE);
+    uint32_t state = 1;
+
+    // Every block differs, so reading the wrong one can't go unnoticed
+    for (size_t i = 0; i < (size_t)CARD_SECTORS * SD_BLOCK_SIZE; i++)
+    {
+        state = state * 1103515245 + 12345;
+        image[i] = state >> 16;
+    }
+
+    return image;
+}
+
+static const uint8_t *sector(const SD_Card_Sim *card, uint32_t block)
+{
+    return &card->image[(size_t)block * SD_BLOCK_SIZE];
+}
+
+static void test_reads(SD_Card_Sim *card)
+{
+    static uint8_t buffer[READ_CHUNK * SD_BLOCK_SIZE];
+
+    // A spread of blocks, the last one included
+    const uint32_t blocks[] = {0, 1, 7, 513, 4097, CARD_SECTORS - READ_CHUNK, CARD_SECTORS - 1};
+
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+    {
+        TEST_CHECK_EQUAL(ESP_OK, sd_read_block(blocks[i], buffer));
+        TEST_CHECK(memcmp(buffer, sector(card, blocks[i]), SD_BLOCK_SIZE) == 0);
+
+        uint32_t count = CARD_SECTORS - blocks[i] < READ_CHUNK ? CARD_SECTORS - blocks[i] : READ_CHUNK;
+
+        memset(buffer, 0, sizeof(buffer));
+        TEST_CHECK_EQUAL(ESP_OK, sd_read_blocks(blocks[i], count, buffer));
+        TEST_CHECK(memcmp(buffer, sector(card, blocks[i]), count * SD_BLOCK_SIZE) == 0);
+    }
+
+    TEST_CHECK_EQUAL(0, card->address_errors);
+}
+
+static void test_writes(SD_Card_Sim *card)
+{
+    uint8_t data[4 * SD_BLOCK_SIZE];
+    uint8_t back[sizeof(data)];
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    uint32_t block = 3001;
+    uint8_t after[SD_BLOCK_SIZE];
+
+    memcpy(after, sector(card, block + 4), sizeof(after));
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_write_block(block, data));
+    TEST_CHECK(memcmp(sector(card, block), data, SD_BLOCK_SIZE) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_write_blocks(block, 4, data));
+    TEST_CHECK(memcmp(sector(card, block), data, sizeof(data)) == 0);
+    TEST_CHECK(memcmp(sector(card, block + 4), after, sizeof(after)) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_blocks(block, 4, back));
+    TEST_CHECK(memcmp(back, data, sizeof(data)) == 0);
+
+    TEST_CHECK_EQUAL(0, card->address_errors);
+}
+
+// A megabyte read block by block & in chunks, counted on the card's side. Bus bytes past the data itself are
+// commands, responses, tokens, CRCs & the card's access time
+static void test_command_count(SD_Card_Sim *card)
+{
+    static uint8_t buffer[READ_CHUNK * SD_BLOCK_SIZE];
+
+    uint32_t before = card->command_total;
+    uint64_t bytes_before = card->bytes_clocked;
+
+    for (uint32_t i = 0; i < MB_BLOCKS; i++)
+    {
+        sd_read_block(i, buffer);
+    }
+
+    uint32_t single = card->command_total - before;
+    uint64_t single_bytes = card->bytes_clocked - bytes_before;
+
+    before = card->command_total;
+    uint32_t cmd18_before = card->commands[18];
+    uint32_t cmd12_before = card->commands[12];
+    uint32_t sent_before = sd_get_command_count();
+    bytes_before = card->bytes_clocked;
+
+    for (uint32_t i = 0; i < MB_BLOCKS; i += READ_CHUNK)
+    {
+        sd_read_blocks(i, READ_CHUNK, buffer);
+    }
+
+    uint32_t multi = card->command_total - before;
+    uint32_t sent = sd_get_command_count() - sent_before;
+    uint64_t multi_bytes = card->bytes_clocked - bytes_before;
+
+    printf("Per MB: %u commands & %llu bus bytes of overhead with CMD17, %u & %llu with CMD18 in %d block runs\n",
+           (unsigned int)single, (unsigned long long)(single_bytes - MB_BLOCKS * SD_BLOCK_SIZE),
+           (unsigned int)multi, (unsigned long long)(multi_bytes - MB_BLOCKS * SD_BLOCK_SIZE), READ_CHUNK);
+
+    TEST_CHECK_EQUAL(MB_BLOCKS, single);
+    TEST_CHECK_EQUAL(2 * MB_BLOCKS / READ_CHUNK, multi);
+    TEST_CHECK_EQUAL(MB_BLOCKS / READ_CHUNK, card->commands[18] - cmd18_before);
+    TEST_CHECK_EQUAL(MB_BLOCKS / READ_CHUNK, card->commands[12] - cmd12_before);
+    TEST_CHECK_EQUAL(multi, sent);
+    TEST_CHECK(multi_bytes < single_bytes);
+}
+
+// The async stream double buffered like the player does it, from a block past the first few so the address counts
+static void test_stream(SD_Card_Sim *card)
+{
+    static uint8_t buffers[2][SD_BLOCK_SIZE];
+    const uint32_t start_block = 777;
+    const uint32_t count = 40;
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_start(start_block));
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_submit(buffers[0]));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t *done = NULL;
+
+        TEST_CHECK_EQUAL(ESP_OK, sd_stream_wait(&done, portMAX_DELAY));
+        TEST_CHECK(done == buffers[i % 2]);
+
+        // Copy out before the next block lands in the other buffer, as a caller would
+        uint8_t block[SD_BLOCK_SIZE];
+        memcpy(block, done, sizeof(block));
+
+        if (i + 1 < count)
+        {
+            TEST_CHECK_EQUAL(ESP_OK, sd_stream_submit(buffers[(i + 1) % 2]));
+        }
+
+        TEST_CHECK(memcmp(block, sector(card, start_block + i), sizeof(block)) == 0);
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_stop());
+    TEST_CHECK_EQUAL(0, card->address_errors);
+
+    // The card is back to taking commands
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_block(start_block, buffers[0]));
+    TEST_CHECK(memcmp(buffers[0], sector(card, start_block), SD_BLOCK_SIZE) == 0);
+}
+
+// Every 5th block comes over with a flipped bit: the stream resumes from it & the data still comes out right
+static void test_crc_retry(SD_Card_Sim *card)
+{
+    static uint8_t buffer[READ_CHUNK * SD_BLOCK_SIZE];
+
+    card->corrupt_every = 5;
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_blocks(100, READ_CHUNK, buffer));
+    TEST_CHECK(memcmp(buffer, sector(card, 100), sizeof(buffer)) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_block(200, buffer));
+    TEST_CHECK(memcmp(buffer, sector(card, 200), SD_BLOCK_SIZE) == 0);
+
+    card->corrupt_every = 0;
+}
+
+// A slow card: ~0.5 ms at 26 MHz before every data token, far more polls than a response ever takes
+static void test_slow_card(SD_Card_Sim *card)
+{
+    static uint8_t buffer[READ_CHUNK * SD_BLOCK_SIZE];
+
+    card->read_latency = 1500;
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_block(42, buffer));
+    TEST_CHECK(memcmp(buffer, sector(card, 42), SD_BLOCK_SIZE) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_read_blocks(42, READ_CHUNK, buffer));
+    TEST_CHECK(memcmp(buffer, sector(card, 42), sizeof(buffer)) == 0);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_start(42));
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_submit(buffer));
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_wait(NULL, portMAX_DELAY));
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_stop());
+    TEST_CHECK(memcmp(buffer, sector(card, 42), SD_BLOCK_SIZE) == 0);
+
+    card->read_latency = 2;
+}
+
+typedef struct
+{
+    uint8_t block[SD_BLOCK_SIZE];
+    esp_err_t status;
+    atomic_bool is_done;
+} Blockdev_Read;
+
+static void *blockdev_reader(void *arg)
+{
+    Blockdev_Read *read = (Blockdev_Read *)arg;
+
+    read->status = blockdev_read(sd_get_block_device(), 300, read->block);
+    atomic_store(&read->is_done, true);
+
+    return NULL;
+}
+
+// A block device read from another task waits for the stream to stop, then gets its block. Read errors piling
+// up mid stream only drop the clock once it has
+static void test_stream_exclusive(SD_Card_Sim *card)
+{
+    static uint8_t buffer[SD_BLOCK_SIZE];
+    static Blockdev_Read read;
+    pthread_t reader;
+
+    uint32_t clock_hz = card->clock_hz;
+
+    atomic_store(&read.is_done, false);
+    card->corrupt_every = 1;
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_start(500));
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_submit(buffer));
+
+    pthread_create(&reader, NULL, blockdev_reader, &read);
+    usleep(20 * 1000);
+    TEST_CHECK(!atomic_load(&read.is_done));
+
+    // The card corrupts a block as it is submitted, the one after the last wait here comes over clean
+    for (uint32_t i = 0; i < SD_CLOCK_ERROR_THRESHOLD; i++)
+    {
+        if (i + 1 == SD_CLOCK_ERROR_THRESHOLD)
+        {
+            card->corrupt_every = 0;
+        }
+
+        TEST_CHECK_EQUAL(ESP_ERR_INVALID_CRC, sd_stream_wait(NULL, portMAX_DELAY));
+        TEST_CHECK_EQUAL(ESP_OK, sd_stream_submit(buffer));
+    }
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_wait(NULL, portMAX_DELAY));
+    TEST_CHECK_EQUAL(clock_hz, card->clock_hz);
+    TEST_CHECK(!atomic_load(&read.is_done));
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_stream_stop());
+    pthread_join(reader, NULL);
+
+    TEST_CHECK(card->clock_hz < clock_hz);
+    TEST_CHECK_EQUAL(ESP_OK, read.status);
+    TEST_CHECK(memcmp(read.block, sector(card, 300), SD_BLOCK_SIZE) == 0);
+
+    // Back up the ladder for whatever comes next
+    TEST_CHECK_EQUAL(ESP_OK, sd_negotiate_clock());
+    TEST_CHECK_EQUAL(26 * 1000 * 1000, card->clock_hz);
+}
+
+static void test_card(bool is_high_capacity, bool is_version_1)
+{
+    SD_Card_Sim card = {
+        .image = make_image(),
+        .sector_count = CARD_SECTORS,
+        .is_high_capacity = is_high_capacity,
+        .is_version_1 = is_version_1,
+        .read_latency = 2,
+        .busy_bytes = 4,
+    };
+
+    printf("%s card\n", is_high_capacity ? "SDHC" : is_version_1 ? "Version 1 SDSC" : "SDSC");
+
+    sd_card_sim_insert(&card);
+
+    TEST_CHECK_EQUAL(ESP_OK, sd_init());
+    TEST_CHECK_EQUAL(CARD_SECTORS, sd_get_sector_count());
+    TEST_CHECK_EQUAL(is_high_capacity ? 0 : 1, card.commands[16]);
+    TEST_CHECK_EQUAL(SD_BLOCK_SIZE, blockdev_sector_size(sd_get_block_device()));
+
+    // The clock ladder re-adds the device, with nothing but the clock changed
+    TEST_CHECK_EQUAL(26 * 1000 * 1000, card.clock_hz);
+    TEST_CHECK_EQUAL(8, card.cs_setup);
+    TEST_CHECK_EQUAL(8, card.cs_hold);
+
+    test_reads(&card);
+    test_writes(&card);
+    test_command_count(&card);
+    test_stream(&card);
+    test_crc_retry(&card);
+    test_slow_card(&card);
+    test_stream_exclusive(&card);
+
+    TEST_CHECK_EQUAL(8, card.cs_setup);
+    TEST_CHECK_EQUAL(8, card.cs_hold);
+
+    free(card.image);
+}
+
+int main(void)
+{
+    test_card(true, false);
+    test_card(false, false);
+    test_card(false, true);
+
+    return host_test_result();
+}
@@ -0,0 +1,31 @@
+#ifndef TASK_LAYOUT_H
+#define TASK_LAYOUT_H
+
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+/**
+ * Which core each task & interrupt runs on. The priorities stay with each module, highest first they are:
+ * audio consumer 12, file sink clock 10 (host only), player 8, audio producer 6, FAT prefetch 5, app_main 1.
+ *
+ * Split, core 0 gets the card: the audio producer, FAT prefetch & the SPI interrupt, next to app_main & the
+ * WiFi/BT stacks should they ever run. Core 1 gets the sound: the consumer feeding I2S, its interrupt & the
+ * player. A long card read or a busy core 0 can then never hold the consumer off its CPU, priorities or not.
+ * The I2S driver puts its interrupt on the core that opens the channel, which is why the player, that starts
+ * tracks & so opens the sink, sits on the audio core too.
+ *
+ * Unsplit, or on a single core chip, every task may run anywhere & only the priorities tell them apart.
+ */
+#define TASK_LAYOUT_SPLIT_CORES 1
+
+#if TASK_LAYOUT_SPLIT_CORES && !CONFIG_FREERTOS_UNICORE
+#define TASK_LAYOUT_IS_SPLIT 1
+#define TASK_CORE_IO 0
+#define TASK_CORE_AUDIO 1
+#else
+#define TASK_LAYOUT_IS_SPLIT 0
+#define TASK_CORE_IO tskNO_AFFINITY
+#define TASK_CORE_AUDIO tskNO_AFFINITY
+#endif
+
+#endif
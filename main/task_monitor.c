@@ -0,0 +1,103 @@
+#include "task_monitor.h"
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "TASK_MONITOR";
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+
+// This & the last call's snapshot, taking turns
+static TaskStatus_t snapshots[2][TASK_MONITOR_MAX_TASKS];
+static UBaseType_t snapshot_counts[2] = {0, 0};
+static configRUN_TIME_COUNTER_TYPE snapshot_times[2] = {0, 0};
+static uint32_t current = 0;
+
+// Run time the task had at the last call, 0 for one that's new since
+static configRUN_TIME_COUNTER_TYPE previous_run_time(const TaskStatus_t *task)
+{
+    uint32_t previous = current ^ 1;
+
+    for (UBaseType_t i = 0; i < snapshot_counts[previous]; i++)
+    {
+        if (snapshots[previous][i].xTaskNumber == task->xTaskNumber)
+        {
+            return snapshots[previous][i].ulRunTimeCounter;
+        }
+    }
+
+    return 0;
+}
+
+// Share of one core since the last call, in tenths of a percent
+static uint32_t task_load(const TaskStatus_t *task, configRUN_TIME_COUNTER_TYPE elapsed)
+{
+    if (elapsed == 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)((uint64_t)(task->ulRunTimeCounter - previous_run_time(task)) * 1000 / elapsed);
+}
+
+void task_monitor_log(void)
+{
+    TaskStatus_t *tasks = snapshots[current];
+    UBaseType_t count = uxTaskGetSystemState(tasks, TASK_MONITOR_MAX_TASKS, &snapshot_times[current]);
+
+    if (count == 0)
+    {
+        ESP_LOGW(TAG, "More than %d tasks, raise TASK_MONITOR_MAX_TASKS", TASK_MONITOR_MAX_TASKS);
+        return;
+    }
+
+    snapshot_counts[current] = count;
+
+    // Each core runs for all of it, so every core's tasks add up to 100 %
+    configRUN_TIME_COUNTER_TYPE elapsed = snapshot_times[current] - snapshot_times[current ^ 1];
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        BaseType_t core = xTaskGetCoreID(tasks[i].xHandle);
+        uint32_t load = task_load(&tasks[i], elapsed);
+        uint32_t stack_free = tasks[i].usStackHighWaterMark;
+
+        ESP_LOGI(TAG, "%-16s core %c, priority %2d, load %3d.%d %%, stack free %5d bytes", tasks[i].pcTaskName,
+                 core == tskNO_AFFINITY ? '*' : (char)('0' + core), (unsigned int)tasks[i].uxCurrentPriority,
+                 (unsigned int)(load / 10), (unsigned int)(load % 10), (unsigned int)stack_free);
+
+        if (stack_free < TASK_MONITOR_STACK_MARGIN)
+        {
+            ESP_LOGW(TAG, "%s came within %d bytes of its stack's end", tasks[i].pcTaskName, (unsigned int)stack_free);
+        }
+    }
+
+    // What's left: a core that's rarely idle is one long card read away from an underrun
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+
+        for (UBaseType_t i = 0; i < count; i++)
+        {
+            if (tasks[i].xHandle == idle)
+            {
+                uint32_t load = task_load(&tasks[i], elapsed);
+
+                ESP_LOGI(TAG, "Core %d: %d.%d %% idle", (int)core, (unsigned int)(load / 10), (unsigned int)(load % 10));
+            }
+        }
+    }
+
+    current ^= 1;
+}
+
+#else
+
+void task_monitor_log(void)
+{
+    ESP_LOGW(TAG, "Needs CONFIG_FREERTOS_USE_TRACE_FACILITY & CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/**
+ * Per task CPU load & stack use at run time, to see how much headroom is left before the audio underruns.
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY & CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, see sdkconfig.defaults.
+ */
+
+// Tasks looked at, IDF's own (idle, timers, ipc) included
+#define TASK_MONITOR_MAX_TASKS 24
+
+// Least free stack a task may have had at its deepest before it's warned about, in bytes
+#define TASK_MONITOR_STACK_MARGIN 512
+
+/**
+ * Log each task's load since the last call (since boot the first time), its core, priority & stack high
+ * water mark, then every core's idle share.
+ */
+void task_monitor_log(void);
+
+#endif
@@ -47,6 +47,14 @@ uint32_t extract_uint32_le(uint8_t *arr, uint32_t index)
     return (arr[index + 3] << 24) | (arr[index + 2] << 16) | (arr[index + 1] << 8) | arr[index];
 }
 
+void insert_uint32_le(uint8_t *arr, uint32_t index, uint32_t value)
+{
+    arr[index] = value & 0xFF;
+    arr[index + 1] = (value >> 8) & 0xFF;
+    arr[index + 2] = (value >> 16) & 0xFF;
+    arr[index + 3] = (value >> 24) & 0xFF;
+}
+
 uint16_t extract_uint16_le(uint8_t *arr, uint32_t index)
 {
     return (arr[index + 1] << 8) | arr[index];
@@ -77,4 +85,14 @@ void log_uint8_array(const char *tag, const uint8_t *array, uint32_t size)
 
     // Log the entire buffer at once
     ESP_LOGI(tag, "%s", buffer);
+}
+
+uint32_t utils_hash_fnv1a(uint32_t hash, const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return hash;
 }
\ No newline at end of file
@@ -26,6 +26,13 @@ uint16_t extract_uint16_le(uint8_t *arr, uint32_t index);
 
 uint8_t extract_uint8_le(uint8_t *arr, uint32_t index);
 
+void insert_uint32_le(uint8_t *arr, uint32_t index, uint32_t value);
+
 void log_uint8_array(const char *tag, const uint8_t *array, uint32_t size);
 
+#define UTILS_FNV1A_INIT 2166136261u
+
+// FNV-1a, carry the returned hash into the next call to hash data piece by piece
+uint32_t utils_hash_fnv1a(uint32_t hash, const uint8_t *data, uint32_t length);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "library/track_index.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_file.h"
+#include "player/player.h"
+
+/**
+ * app_main for the host: mounts a disk image instead of the card & plays into a WAV file instead of I2S.
+ * The sink keeps the same pace as the DAC, so it takes as long as the music & the stats mean the same thing.
+ *
+ *   host_player <image> [output.wav]
+ *
+ * The image is only read, the track index is scanned rather than loaded or saved.
+ */
+
+static const char *TAG = "HOST_PLAYER";
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <image> [output.wav]\n", argv[0]);
+        return 2;
+    }
+
+    static Block_Device_File image;
+    static Block_Device device;
+    static Audio_Sink_File sink_file;
+    static Audio_Sink sink;
+
+    if (blockdev_file_open(&image, argv[1], true, &device) != ESP_OK)
+    {
+        return 1;
+    }
+
+    int64_t started_at = esp_timer_get_time();
+
+    if (fat_init(&device) != ESP_OK || track_index_init() != ESP_OK || track_index_scan() != ESP_OK)
+    {
+        return 1;
+    }
+
+    ESP_LOGI(TAG, "Mounted & indexed %d tracks in %d us", (unsigned int)track_index_count(),
+             (unsigned int)(esp_timer_get_time() - started_at));
+
+    audio_sink_file_init(&sink_file, argc > 2 ? argv[2] : NULL, &sink);
+
+    if (player_init(&sink) != ESP_OK)
+    {
+        return 1;
+    }
+
+    player_play(0);
+    player_wait_idle();
+
+    while (audio_output_is_playing())
+    {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        player_log_status();
+        audio_output_log_stats();
+    }
+
+    blockdev_file_close(&image);
+
+    return 0;
+}
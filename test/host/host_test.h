@@ -0,0 +1,84 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Bare bones checks for the host tests: a failed check is reported & counted, the test goes on,
+ * `host_test_result` turns the count into main's exit code.
+ */
+
+static int host_test_failures = 0;
+
+#define TEST_CHECK(condition)                                                            \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            host_test_failures++;                                                        \
+        }                                                                                \
+    } while (0)
+
+// Same, with the two values printed when they differ
+#define TEST_CHECK_EQUAL(expected, actual)                                                                 \
+    do                                                                                                     \
+    {                                                                                                      \
+        long long expected_ = (long long)(expected);                                                       \
+        long long actual_ = (long long)(actual);                                                           \
+        if (expected_ != actual_)                                                                          \
+        {                                                                                                  \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+            host_test_failures++;                                                                          \
+        }                                                                                                  \
+    } while (0)
+
+static inline int host_test_result(void)
+{
+    if (host_test_failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", host_test_failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
+
+// Monotonic clock in ns, for the benchmarks
+static inline uint64_t host_test_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Cycle counter for cycles per sample figures: the TSC on x86, which ticks at a fixed rate close to the
+ * nominal clock rather than the core's, elsewhere ns. HOST_TEST_CYCLE_UNIT says which for the printouts.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define HOST_TEST_CYCLE_UNIT "cycles"
+
+static inline uint64_t host_test_cycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define HOST_TEST_CYCLE_UNIT "ns"
+
+static inline uint64_t host_test_cycles(void)
+{
+    return host_test_now_ns();
+}
+#endif
+
+#endif
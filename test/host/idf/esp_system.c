@@ -0,0 +1,66 @@
+#include <pthread.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static struct timespec started_at;
+static pthread_once_t started_once = PTHREAD_ONCE_INIT;
+
+static void mark_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &started_at);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+
+    pthread_once(&started_once, mark_start);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)(now.tv_sec - started_at.tv_sec) * 1000000 + (now.tv_nsec - started_at.tv_nsec) / 1000;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:
+        return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:
+        return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:
+        return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_INVALID_MAC:
+        return "ESP_ERR_INVALID_MAC";
+    case ESP_ERR_NOT_FINISHED:
+        return "ESP_ERR_NOT_FINISHED";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,487 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+// Threads get at least this much stack, glibc's own minimum is too tight for printf from a task
+#define HOST_TASK_MIN_STACK (64 * 1024)
+
+struct QueueDefinition
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size; // 0 for semaphores
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t *items;
+    TaskHandle_t holder; // Recursive mutexes, the task that has it & how many times over
+    UBaseType_t depth;
+};
+
+struct tskTaskControlBlock
+{
+    pthread_t thread;
+    TaskFunction_t function;
+    void *arg;
+    const char *name;
+    UBaseType_t priority;
+    BaseType_t core_id;
+
+    pthread_mutex_t notify_lock;
+    pthread_cond_t notified;
+    uint32_t notify_count;
+};
+
+static __thread TaskHandle_t current_task = NULL;
+
+// Absolute CLOCK_MONOTONIC time `ticks` from now, for the timed waits
+static struct timespec deadline_after(TickType_t ticks)
+{
+    struct timespec deadline;
+    uint64_t ns = (uint64_t)ticks * (1000000000 / configTICK_RATE_HZ);
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec += ns % 1000000000;
+
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    return deadline;
+}
+
+static void init_condition(pthread_cond_t *condition)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(condition, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * Wait on `condition` until `ready` says so or the ticks run out, with `lock` held.
+ * Returns whether it became ready.
+ */
+static bool wait_until(pthread_mutex_t *lock, pthread_cond_t *condition, TickType_t ticks,
+                       bool (*ready)(void *), void *context)
+{
+    struct timespec deadline = deadline_after(ticks == portMAX_DELAY ? 0 : ticks);
+
+    while (!ready(context))
+    {
+        if (ticks == 0)
+        {
+            return false;
+        }
+
+        if (ticks == portMAX_DELAY)
+        {
+            pthread_cond_wait(condition, lock);
+        }
+        else if (pthread_cond_timedwait(condition, lock, &deadline) == ETIMEDOUT)
+        {
+            return ready(context);
+        }
+    }
+
+    return true;
+}
+
+///////// Tasks /////////
+
+static TaskHandle_t new_task(const char *name, UBaseType_t priority, BaseType_t core_id)
+{
+    TaskHandle_t task = calloc(1, sizeof(struct tskTaskControlBlock));
+
+    if (task == NULL)
+    {
+        return NULL;
+    }
+
+    task->name = name;
+    task->priority = priority;
+    task->core_id = core_id;
+
+    pthread_mutex_init(&task->notify_lock, NULL);
+    init_condition(&task->notified);
+
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    current_task = (TaskHandle_t)arg;
+    current_task->function(current_task->arg);
+
+    // Returning from a task function is a bug on FreeRTOS, treat it like deleting itself
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id)
+{
+    TaskHandle_t task = new_task(name, priority, core_id);
+
+    if (task == NULL)
+    {
+        return pdFAIL;
+    }
+
+    task->function = function;
+    task->arg = arg;
+
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack_depth > HOST_TASK_MIN_STACK ? stack_depth : HOST_TASK_MIN_STACK);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    int failed = pthread_create(&task->thread, &attr, task_entry, task);
+
+    pthread_attr_destroy(&attr);
+
+    if (failed)
+    {
+        free(task);
+        return pdFAIL;
+    }
+
+    if (created != NULL)
+    {
+        *created = task;
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_depth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != xTaskGetCurrentTaskHandle())
+    {
+        abort();
+    }
+
+    // The handle stays valid, other tasks may still hold it
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec deadline = deadline_after(ticks);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+    {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((uint64_t)esp_timer_get_time() * configTICK_RATE_HZ / 1000000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (current_task == NULL)
+    {
+        current_task = new_task("main", 1, tskNO_AFFINITY);
+        current_task->thread = pthread_self();
+    }
+
+    return current_task;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task != NULL ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    return (task != NULL ? task : xTaskGetCurrentTaskHandle())->core_id;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->notify_lock);
+    task->notify_count++;
+    pthread_cond_broadcast(&task->notified);
+    pthread_mutex_unlock(&task->notify_lock);
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+
+    if (higher_priority_task_woken != NULL)
+    {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+static bool has_notification(void *context)
+{
+    return ((TaskHandle_t)context)->notify_count > 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    pthread_mutex_lock(&task->notify_lock);
+
+    uint32_t count = 0;
+
+    if (wait_until(&task->notify_lock, &task->notified, ticks_to_wait, has_notification, task))
+    {
+        count = task->notify_count;
+        task->notify_count = clear_count_on_exit ? 0 : count - 1;
+    }
+
+    pthread_mutex_unlock(&task->notify_lock);
+
+    return count;
+}
+
+///////// Queues & semaphores /////////
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct QueueDefinition));
+
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+
+    queue->items = item_size > 0 ? malloc((size_t)length * item_size) : NULL;
+
+    if (item_size > 0 && queue->items == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    queue->length = length;
+    queue->item_size = item_size;
+
+    pthread_mutex_init(&queue->lock, NULL);
+    init_condition(&queue->changed);
+
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->items);
+    free(queue);
+}
+
+static bool has_room(void *context)
+{
+    QueueHandle_t queue = (QueueHandle_t)context;
+
+    return queue->count < queue->length;
+}
+
+static bool has_items(void *context)
+{
+    return ((QueueHandle_t)context)->count > 0;
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, bool to_front)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    if (!wait_until(&queue->lock, &queue->changed, ticks_to_wait, has_room, queue))
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+
+    UBaseType_t slot;
+
+    if (to_front)
+    {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        slot = queue->head;
+    }
+    else
+    {
+        slot = (queue->head + queue->count) % queue->length;
+    }
+
+    if (queue->item_size > 0)
+    {
+        memcpy(&queue->items[slot * queue->item_size], item, queue->item_size);
+    }
+
+    queue->count++;
+
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL)
+    {
+        *higher_priority_task_woken = pdFALSE;
+    }
+
+    return queue_send(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    if (!wait_until(&queue->lock, &queue->changed, ticks_to_wait, has_items, queue))
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+
+    if (queue->item_size > 0 && item != NULL)
+    {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    queue->count = 0;
+    queue->head = 0;
+
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+
+    // Created given, unlike a binary semaphore
+    if (mutex != NULL)
+    {
+        xSemaphoreGive(mutex);
+    }
+
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return xSemaphoreCreateMutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks_to_wait)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    pthread_mutex_lock(&mutex->lock);
+    bool is_held = mutex->holder == self;
+    pthread_mutex_unlock(&mutex->lock);
+
+    // Only the holder changes the depth, nobody else gets past the take while it is held
+    if (is_held)
+    {
+        mutex->depth++;
+        return pdTRUE;
+    }
+
+    if (xSemaphoreTake(mutex, ticks_to_wait) != pdTRUE)
+    {
+        return pdFALSE;
+    }
+
+    pthread_mutex_lock(&mutex->lock);
+    mutex->holder = self;
+    mutex->depth = 1;
+    pthread_mutex_unlock(&mutex->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_lock(&mutex->lock);
+
+    if (mutex->holder != xTaskGetCurrentTaskHandle())
+    {
+        pthread_mutex_unlock(&mutex->lock);
+        return pdFALSE;
+    }
+
+    bool is_released = --mutex->depth == 0;
+
+    if (is_released)
+    {
+        mutex->holder = NULL;
+    }
+
+    pthread_mutex_unlock(&mutex->lock);
+
+    return is_released ? xSemaphoreGive(mutex) : pdTRUE;
+}
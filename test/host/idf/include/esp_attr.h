@@ -0,0 +1,11 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+// No IRAM or DMA capable regions on the host, only the alignment is kept
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define DMA_ATTR WORD_ALIGNED_ATTR DRAM_ATTR
+
+#endif
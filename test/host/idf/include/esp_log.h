@@ -0,0 +1,32 @@
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "esp_err.h"
+
+/**
+ * Same line format as the device, "I (1234) TAG: message". Debug & verbose lines are type checked but never printed.
+ */
+
+uint32_t esp_log_timestamp(void);
+
+#define ESP_HOST_LOG(letter, tag, format, ...) \
+    printf(letter " (%" PRIu32 ") %s: " format "\n", esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_HOST_LOG("I", tag, format, ##__VA_ARGS__)
+
+#define ESP_LOGD(tag, format, ...)                            \
+    do                                                        \
+    {                                                         \
+        if (0)                                                \
+        {                                                     \
+            ESP_HOST_LOG("D", tag, format, ##__VA_ARGS__);    \
+        }                                                     \
+    } while (0)
+
+#define ESP_LOGV(tag, format, ...) ESP_LOGD(tag, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef ESP_MEMORY_UTILS_H
+#define ESP_MEMORY_UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Any host memory will do for the simulated bus
+static inline bool esp_ptr_dma_capable(const void *pointer)
+{
+    return pointer != NULL;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+/**
+ * Just enough FreeRTOS for the host build: tasks are pthreads, priorities & cores are recorded but not
+ * enforced, every task may run at the same time as any other. Code that only works because one task
+ * can't preempt another will show up here.
+ */
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES 25
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portNUM_PROCESSORS 1
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FREERTOS_SEMPHR_H
+#define FREERTOS_SEMPHR_H
+
+#include "freertos/queue.h"
+
+// Semaphores are queues of empty items, as in FreeRTOS itself. Mutexes don't inherit priorities
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+// Taken again by the task holding it only counts, it is given back once given as many times
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex);
+
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+#define xSemaphoreTake(semaphore, ticks_to_wait) xQueueReceive(semaphore, NULL, ticks_to_wait)
+#define xSemaphoreGive(semaphore) xQueueSend(semaphore, NULL, 0)
+#define xSemaphoreGiveFromISR(semaphore, woken) xQueueSendFromISR(semaphore, NULL, woken)
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+// `stack_depth` is in bytes like on IDF, the thread gets at least that much
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id);
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created);
+
+// Only a task deleting itself (NULL) is supported
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+TickType_t xTaskGetTickCount(void);
+
+// Threads that weren't created as tasks, e.g. the test's main, get a handle on first use
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+const char *pcTaskGetName(TaskHandle_t task);
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+#endif
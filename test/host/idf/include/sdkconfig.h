@@ -0,0 +1,11 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+// The host build's configuration, what `idf.py --preview set-target linux` would generate for this project
+
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_FREERTOS_UNICORE 1
+
+#endif
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Build the disk image the player is driven on by scripts: three WAV tracks of two seconds each in the root, long
+enough to pause, resume & seek within one while it plays. Same pseudo random walk as the test image's tracks, so
+any few frames of the output tell which track & where in it they came from.
+
+Then an hour long track to seek in, 8 bit mono at 44.1 kHz to keep it to 159 MB: noise, a different block of it
+every 1.5 s.
+
+Uses the FAT32 writer of make_test_image.py, so the layout is just as reproducible.
+
+    make_player_image.py <image>
+"""
+
+import random
+import struct
+import sys
+
+from make_test_image import Fat32Image, wav
+
+TRACK_FRAMES = 2 * 44100
+LONG_FRAMES = 3600 * 44100
+LONG_BLOCK = 65521  # Frames, prime so the blocks never line up with sectors
+TOTAL_SECTORS = 327680
+
+
+def long_wav(frames):
+    """8-bit mono PCM, the same block of noise over & over, every time with all its values moved up by one."""
+    block = random.Random(24).randbytes(LONG_BLOCK)
+    samples = bytearray()
+
+    for index in range((frames + LONG_BLOCK - 1) // LONG_BLOCK):
+        shift = index % 256
+        samples += block.translate(bytes((value + shift) & 0xFF for value in range(256)))
+
+    del samples[frames:]
+
+    fmt = struct.pack('<HHIIHH', 1, 1, 44100, 44100, 1, 8)
+
+    return (b'RIFF' + struct.pack('<I', 4 + 8 + len(fmt) + 8 + len(samples)) + b'WAVE' +
+            b'fmt ' + struct.pack('<I', len(fmt)) + fmt + b'data' + struct.pack('<I', len(samples)) + samples)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+
+    image = Fat32Image(TOTAL_SECTORS)
+
+    image.add_file(image.root, b'ONE     WAV', wav(TRACK_FRAMES, 11))
+    image.add_file(image.root, b'TWO     WAV', wav(TRACK_FRAMES, 12))
+    image.add_file(image.root, b'THREE   WAV', wav(TRACK_FRAMES, 13))
+    image.add_file(image.root, b'HOUR    WAV', long_wav(LONG_FRAMES), 'An hour long.wav')
+
+    image.save(sys.argv[1])
+
+
+if __name__ == '__main__':
+    main()
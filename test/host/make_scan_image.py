@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""
+Build the disk image the track index scan is timed on: 10000 files in 111 directories, the root, 10 artists &
+10 albums in each. Every album holds 50 one-frame WAV tracks under long names & 50 text files under 8.3 names.
+
+Uses the FAT32 writer of make_test_image.py, so the layout is just as reproducible.
+
+    make_scan_image.py <image>
+"""
+
+import sys
+
+from make_test_image import Fat32Image, wav
+
+ARTISTS = 10
+ALBUMS = 10
+TRACKS = 50  # Per album, as many text files again
+FILE_COUNT = ARTISTS * ALBUMS * TRACKS * 2
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+
+    image = Fat32Image()
+    track = wav(1, 1)
+
+    for artist_index in range(ARTISTS):
+        artist = image.add_directory(image.root, b'ARTIST%02d   ' % artist_index)
+
+        for album_index in range(ALBUMS):
+            album = image.add_directory(artist, b'ALBUM~%02d   ' % album_index, 'Album number %02d' % album_index)
+
+            for index in range(TRACKS):
+                image.add_file(album, b'TRACK~%02dWAV' % index, track, 'Track %02d of the album.wav' % index)
+                image.add_file(album, b'NOTE%04dTXT' % index, b'Not a track\r\n')
+
+    image.save(sys.argv[1])
+
+
+if __name__ == '__main__':
+    main()
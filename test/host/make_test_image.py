@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""
+Build the disk image the host tests play from: an MBR with a single FAT32 partition holding a few short WAV
+tracks, one of them in a subdirectory behind a long file name & one fragmented, plus files that aren't audio:
+a note & FRAGMENT.BIN, split into a piece per cluster with a byte pattern to check reads against. And a few text
+files for name lookups.
+
+Written by hand rather than with mkfs.fat & mtools, so the layout is the same everywhere & nothing needs root.
+
+    make_test_image.py <image>
+"""
+
+import math
+import struct
+import sys
+
+SECTOR = 512
+TOTAL_SECTORS = 32768
+PARTITION_LBA = 2048
+SECTORS_PER_CLUSTER = 1
+RESERVED_SECTORS = 32
+FAT_COUNT = 2
+VOLUME_SERIAL = 0x1234ABCD
+
+END_OF_CHAIN = 0x0FFFFFFF
+ATTR_DIRECTORY = 0x10
+ATTR_ARCHIVE = 0x20
+ATTR_LONG_NAME = 0x0F
+
+
+class Fat32Image:
+    def __init__(self, total_sectors=TOTAL_SECTORS):
+        self.total_sectors = total_sectors
+        partition_sectors = total_sectors - PARTITION_LBA
+        clusters = partition_sectors // SECTORS_PER_CLUSTER
+        self.sectors_per_fat = (clusters * 4 + SECTOR - 1) // SECTOR
+        self.data_lba = PARTITION_LBA + RESERVED_SECTORS + FAT_COUNT * self.sectors_per_fat
+        self.cluster_count = (total_sectors - self.data_lba) // SECTORS_PER_CLUSTER
+
+        self.image = bytearray(total_sectors * SECTOR)
+        self.fat = [0] * (self.cluster_count + 2)
+        self.fat[0] = 0x0FFFFFF8
+        self.fat[1] = END_OF_CHAIN
+        self.next_free = 2
+
+        self.root = self.allocate(1)[0]
+        self.directories = {self.root: []}
+
+    def allocate(self, count, gap_every=0):
+        """Chain `count` free clusters, leaving a free one after every `gap_every` to fragment the file."""
+        chain = []
+
+        while len(chain) < count:
+            cluster = self.next_free
+
+            while self.fat[cluster] != 0:
+                cluster += 1
+
+            chain.append(cluster)
+            self.fat[cluster] = END_OF_CHAIN
+            self.next_free = cluster + (2 if gap_every and len(chain) % gap_every == 0 else 1)
+
+        for cluster, following in zip(chain, chain[1:]):
+            self.fat[cluster] = following
+
+        return chain
+
+    def chain(self, first):
+        clusters = [first]
+
+        while self.fat[clusters[-1]] < 0x0FFFFFF8:
+            clusters.append(self.fat[clusters[-1]])
+
+        return clusters
+
+    def write_chain(self, clusters, data):
+        size = SECTORS_PER_CLUSTER * SECTOR
+
+        for i, cluster in enumerate(clusters):
+            chunk = data[i * size:(i + 1) * size]
+            offset = (self.data_lba + (cluster - 2) * SECTORS_PER_CLUSTER) * SECTOR
+            self.image[offset:offset + len(chunk)] = chunk
+
+    @staticmethod
+    def short_entry(short_name, attributes, cluster, size):
+        return short_name + struct.pack('<BBBHHHHHHHI', attributes, 0, 0, 0, 0, 0, cluster >> 16, 0x6000, 0x5821,
+                                        cluster & 0xFFFF, size)
+
+    @staticmethod
+    def checksum(short_name):
+        total = 0
+
+        for byte in short_name:
+            total = (((total & 1) << 7) | (total >> 1)) + byte & 0xFF
+
+        return total
+
+    def entries(self, name, short_name, attributes, cluster, size):
+        """Directory entries for a file: long name entries, last one first, when the name isn't 8.3 itself."""
+        entries = []
+
+        if name is not None:
+            units = name.encode('utf-16-le')
+            chars = [units[i:i + 2] for i in range(0, len(units), 2)]
+            count = math.ceil(len(chars) / 13)
+
+            if len(chars) % 13:
+                chars += [b'\0\0'] + [b'\xff\xff'] * (count * 13 - len(chars) - 1)
+
+            checksum = self.checksum(short_name)
+
+            for order in range(count, 0, -1):
+                part = chars[(order - 1) * 13:order * 13]
+                entries.append(bytes([order | (0x40 if order == count else 0)]) + b''.join(part[0:5]) +
+                               bytes([ATTR_LONG_NAME, 0, checksum]) + b''.join(part[5:11]) + b'\0\0' +
+                               b''.join(part[11:13]))
+
+        entries.append(self.short_entry(short_name, attributes, cluster, size))
+
+        return entries
+
+    def add_file(self, directory, short_name, data, long_name=None, gap_every=0):
+        clusters = self.allocate(max(1, math.ceil(len(data) / (SECTORS_PER_CLUSTER * SECTOR))), gap_every)
+        self.write_chain(clusters, data)
+        self.directories[directory] += self.entries(long_name, short_name, ATTR_ARCHIVE, clusters[0], len(data))
+
+    def add_directory(self, parent, short_name, long_name=None):
+        cluster = self.allocate(1)[0]
+        parent_cluster = 0 if parent == self.root else parent
+
+        self.directories[cluster] = [
+            self.short_entry(b'.          ', ATTR_DIRECTORY, cluster, 0),
+            self.short_entry(b'..         ', ATTR_DIRECTORY, parent_cluster, 0),
+        ]
+        self.directories[parent] += self.entries(long_name, short_name, ATTR_DIRECTORY, cluster, 0)
+
+        return cluster
+
+    def save(self, path):
+        cluster_size = SECTORS_PER_CLUSTER * SECTOR
+
+        # Directories grow over as many clusters as their entries need, with room for one more entry
+        for directory, entries in self.directories.items():
+            data = b''.join(entries)
+            needed = (len(data) + 32 + cluster_size - 1) // cluster_size
+            clusters = self.chain(directory)
+
+            if len(clusters) < needed:
+                extra = self.allocate(needed - len(clusters))
+                self.fat[clusters[-1]] = extra[0]
+                clusters += extra
+
+            self.write_chain(clusters, data + bytes(needed * cluster_size - len(data)))
+
+        partition_sectors = self.total_sectors - PARTITION_LBA
+
+        mbr = bytearray(SECTOR)
+        mbr[446 + 4] = 0x0C  # FAT32 LBA
+        struct.pack_into('<II', mbr, 446 + 8, PARTITION_LBA, partition_sectors)
+        mbr[510:512] = b'\x55\xaa'
+        self.image[0:SECTOR] = mbr
+
+        boot = bytearray(SECTOR)
+        boot[0:11] = b'\xEB\x58\x90MSWIN4.1'
+        struct.pack_into('<HBHBHHBHHHII', boot, 11, SECTOR, SECTORS_PER_CLUSTER, RESERVED_SECTORS, FAT_COUNT, 0, 0,
+                         0xF8, 0, 63, 255, PARTITION_LBA, partition_sectors)
+        struct.pack_into('<IHHIHH', boot, 36, self.sectors_per_fat, 0, 0, self.root, 1, 6)
+        boot[66] = 0x29
+        struct.pack_into('<I', boot, 67, VOLUME_SERIAL)
+        boot[71:90] = b'NO NAME    FAT32   '
+        boot[510:512] = b'\x55\xaa'
+        self.image[PARTITION_LBA * SECTOR:(PARTITION_LBA + 1) * SECTOR] = boot
+
+        free = sum(1 for entry in self.fat[2:] if entry == 0)
+        fsinfo = bytearray(SECTOR)
+        struct.pack_into('<I', fsinfo, 0, 0x41615252)
+        struct.pack_into('<III', fsinfo, 484, 0x61417272, free, self.next_free)
+        fsinfo[510:512] = b'\x55\xaa'
+        self.image[(PARTITION_LBA + 1) * SECTOR:(PARTITION_LBA + 2) * SECTOR] = fsinfo
+
+        fat = b''.join(struct.pack('<I', entry) for entry in self.fat)
+
+        for i in range(FAT_COUNT):
+            offset = (PARTITION_LBA + RESERVED_SECTORS + i * self.sectors_per_fat) * SECTOR
+            self.image[offset:offset + len(fat)] = fat
+
+        with open(path, 'wb') as image:
+            image.write(self.image)
+
+
+def wav(frames, seed, sample_rate=44100):
+    """16-bit stereo PCM of a pseudo random walk that never hits 0, so a test can tell where it starts."""
+    state = seed
+    samples = bytearray()
+
+    for _ in range(frames * 2):
+        state = (state * 1103515245 + 12345) & 0x7FFFFFFF
+        samples += struct.pack('<h', ((state >> 8) & 0x3FFF) + 1)
+
+    fmt = struct.pack('<HHIIHH', 1, 2, sample_rate, sample_rate * 4, 4, 16)
+
+    return (b'RIFF' + struct.pack('<I', 4 + 8 + len(fmt) + 8 + len(samples)) + b'WAVE' +
+            b'fmt ' + struct.pack('<I', len(fmt)) + fmt + b'data' + struct.pack('<I', len(samples)) + samples)
+
+
+def pattern(length):
+    """Bytes a test can work out from their position alone, different in every sector."""
+    return bytes((i ^ (i >> 9)) & 0xFF for i in range(length))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+
+    image = Fat32Image()
+
+    image.add_file(image.root, b'FIRST   WAV', wav(11025, 1))
+    image.add_file(image.root, b'NOTES   TXT', b'Not a track\r\n')
+    image.add_file(image.root, b'FRAGMENTBIN', pattern(800 * SECTOR - 100), gap_every=1)
+
+    # Names with the same FNV-1a hash & length as "d8fmxw.txt" & "0lwv00.txt", a short & a long one
+    image.add_file(image.root, b'DKI9RC  TXT', b'Short name\r\n')
+    image.add_file(image.root, b'LOOKUP~1TXT', b'Long name\r\n', 'o62w41.txt')
+
+    album = image.add_directory(image.root, b'ALBUM~1    ', 'Album With A Long Name')
+
+    # Root entries 9-16 are its long name, over the end of the root's first cluster into its second
+    image.add_file(image.root, b'ANAMEL~1TXT', b'Long, long name\r\n',
+                   'A name long enough to run from one directory sector into the next, which sits in another cluster.txt')
+    image.add_file(album, b'SECOND~1WAV', wav(8820, 2), 'Second track, fragmented.wav', gap_every=7)
+    image.add_file(album, b'THIRD   WAV', wav(4410, 3))
+
+    image.save(sys.argv[1])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "host_test.h"
+#include "blockdev/blockdev_file.h"
+#include "fat/fat.h"
+#include "fat/fat_file.h"
+#include "fat/fat_prefetch.h"
+#include "library/track_index.h"
+#include "audio/wav.h"
+#include "audio/audio_output.h"
+#include "audio/audio_sink_file.h"
+#include "player/player.h"
+
+/**
+ * The whole pipeline on the test image: FAT, track index, player, audio output & the file sink.
+ * 16 bit stereo at 44.1 kHz goes through untouched, so the sink must get every track's PCM back to back,
+ * byte for byte, with nothing but silence around it.
+ */
+
+#define OUTPUT_PATH "test_playback.wav"
+#define WAV_HEADER_LENGTH 44
+#define EXPECTED_TRACKS 3
+
+// Every WAV of the index read straight off the image, in index order
+static uint8_t *read_tracks(uint32_t *length)
+{
+    uint8_t *pcm = NULL;
+    uint32_t tracks = 0;
+
+    *length = 0;
+
+    for (uint32_t i = 0; i < track_index_count(); i++)
+    {
+        const Track_Entry *track = track_index_get(i);
+        FAT_File file;
+        WAV_Info info;
+        uint32_t bytes_read;
+
+        if (track->format != TRACK_FORMAT_WAV)
+        {
+            continue;
+        }
+
+        TEST_CHECK(fat_file_open_cluster(&file, track->first_cluster, track->size) == ESP_OK);
+        TEST_CHECK(wav_parse(&file, &info) == ESP_OK);
+
+        pcm = realloc(pcm, *length + info.data_size);
+        TEST_CHECK(fat_file_read(&file, &pcm[*length], info.data_size, &bytes_read) == ESP_OK);
+        TEST_CHECK_EQUAL(info.data_size, bytes_read);
+
+        *length += info.data_size;
+        tracks++;
+    }
+
+    TEST_CHECK_EQUAL(EXPECTED_TRACKS, tracks);
+
+    return pcm;
+}
+
+static uint8_t *read_output(uint32_t *length)
+{
+    FILE *file = fopen(OUTPUT_PATH, "rb");
+
+    TEST_CHECK(file != NULL);
+
+    if (file == NULL)
+    {
+        *length = 0;
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file) - WAV_HEADER_LENGTH;
+    fseek(file, WAV_HEADER_LENGTH, SEEK_SET);
+
+    uint8_t *pcm = malloc(*length);
+    TEST_CHECK(fread(pcm, 1, *length, file) == *length);
+    fclose(file);
+
+    return pcm;
+}
+
+static bool is_silent(const uint8_t *pcm, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (pcm[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    static Block_Device_File image;
+    static Block_Device device;
+    static Audio_Sink_File sink_file;
+    static Audio_Sink sink;
+
+    if (argc < 2 || blockdev_file_open(&image, argv[1], true, &device) != ESP_OK)
+    {
+        fprintf(stderr, "usage: %s <test image>\n", argv[0]);
+        return 2;
+    }
+
+    TEST_CHECK(fat_init(&device) == ESP_OK);
+    TEST_CHECK(track_index_init() == ESP_OK);
+    TEST_CHECK(track_index_scan() == ESP_OK);
+
+    uint32_t expected_length;
+    uint8_t *expected = read_tracks(&expected_length);
+
+    audio_sink_file_init(&sink_file, OUTPUT_PATH, &sink);
+    TEST_CHECK(player_init(&sink) == ESP_OK);
+
+    FAT_Prefetch_Stats before;
+    fat_prefetch_get_stats(&before);
+
+    TEST_CHECK(player_play(0) == ESP_OK);
+    player_wait_idle();
+
+    while (audio_output_is_playing())
+    {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+
+    Audio_Output_Stats stats;
+    audio_output_get_stats(&stats);
+
+    TEST_CHECK_EQUAL(EXPECTED_TRACKS, stats.tracks);
+    TEST_CHECK_EQUAL(0, stats.underruns);
+
+    // Playback reads on sequentially, past the first reads of a track its sectors come from the read-ahead
+    FAT_Prefetch_Stats prefetch;
+    fat_prefetch_get_stats(&prefetch);
+
+    uint32_t hits = prefetch.hits - before.hits;
+    uint32_t misses = prefetch.misses - before.misses;
+
+    printf("Read-ahead during playback: %u sectors hit, %u missed\n", (unsigned int)hits, (unsigned int)misses);
+    TEST_CHECK(hits > misses);
+
+    uint32_t played_length;
+    uint8_t *played = read_output(&played_length);
+
+    // The sink plays silence until the ring is primed, the test tracks never start with a zero sample
+    uint32_t start = 0;
+
+    while (start < played_length && played[start] == 0)
+    {
+        start++;
+    }
+
+    start -= start % 4;
+
+    TEST_CHECK(played_length - start >= expected_length);
+
+    if (played_length - start >= expected_length)
+    {
+        TEST_CHECK(memcmp(&played[start], expected, expected_length) == 0);
+        TEST_CHECK(is_silent(&played[start + expected_length], played_length - start - expected_length));
+    }
+
+    free(expected);
+    free(played);
+
+    return host_test_result();
+}
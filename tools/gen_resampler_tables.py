@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+# Generates main/audio/resampler_tables.h, the windowed sinc prototypes of the resampler's quality tiers.
+# Run from the repo root after changing a tier: python3 tools/gen_resampler_tables.py
+import math
+
+OVERSAMPLE = 128  # Table points per input sample, written out as RESAMPLER_TABLE_OVERSAMPLE
+
+# name, zero crossings per side, cutoff (fraction of the input Nyquist), Kaiser beta
+TIERS = [
+    ("low", 4, 0.80, 5.0),
+    ("medium", 8, 0.90, 7.0),
+    ("high", 16, 0.95, 9.0),
+]
+
+
+def bessel_i0(x):
+    total, term, k = 1.0, 1.0, 1
+    while term > 1e-12 * total:
+        term *= (x / (2 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def half_filter(zero_crossings, cutoff, beta):
+    # Right half of h(t) = cutoff * sinc(cutoff * t) * kaiser(t / zero_crossings), t in input samples.
+    # The extra point past the end is 0, so interpolating next to the edge needs no check
+    points = []
+    for i in range(zero_crossings * OVERSAMPLE + 2):
+        t = i / OVERSAMPLE
+        if t >= zero_crossings:
+            points.append(0.0)
+            continue
+        x = cutoff * t
+        sinc = 1.0 if x == 0 else math.sin(math.pi * x) / (math.pi * x)
+        window = bessel_i0(beta * math.sqrt(1 - (t / zero_crossings) ** 2)) / bessel_i0(beta)
+        points.append(cutoff * sinc * window)
+    return points
+
+
+def main():
+    out = [
+        "// Generated by tools/gen_resampler_tables.py, don't edit",
+        "#ifndef RESAMPLER_TABLES_H",
+        "#define RESAMPLER_TABLES_H",
+        "",
+        "#include \"stdint.h\"",
+        "",
+        "#define RESAMPLER_TABLE_OVERSAMPLE %d" % OVERSAMPLE,
+        "",
+    ]
+    for name, zero_crossings, cutoff, beta in TIERS:
+        points = half_filter(zero_crossings, cutoff, beta)
+        # Q28: Q15 alone caps the noise floor at ~75 dB, the headroom keeps long stretched sums inside 64 bits
+        values = [round(p * (1 << 28)) for p in points]
+        out.append("// %d zero crossings, cutoff %.2f, Kaiser beta %.1f. Q28" % (zero_crossings, cutoff, beta))
+        out.append("#define RESAMPLER_%s_ZERO_CROSSINGS %d" % (name.upper(), zero_crossings))
+        out.append("static const int32_t resampler_%s_table[%d] = {" % (name, len(values)))
+        for i in range(0, len(values), 8):
+            out.append("    " + ", ".join("%d" % v for v in values[i:i + 8]) + ",")
+        out.append("};")
+        out.append("")
+    out.append("#endif")
+    with open("main/audio/resampler_tables.h", "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()